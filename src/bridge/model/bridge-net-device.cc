@@ -205,7 +205,7 @@ Ptr<NetDevice> BridgeNetDevice::GetLearnedState (Mac48Address source)
   if (m_enableLearning)
     {
       Time now = Simulator::Now ();
-      std::map<Mac48Address, LearnedState>::iterator iter =
+      HashMap<Mac48Address, LearnedState, Mac48AddressHash>::iterator iter =
         m_learnState.find (source);
       if (iter != m_learnState.end ())
         {
@@ -24,7 +24,7 @@
 #include "ns3/bridge-channel.h"
 #include <stdint.h>
 #include <string>
-#include <map>
+#include "ns3/hash-map.h"
 
 namespace ns3 {
 
@@ -140,7 +140,7 @@ private:
     Ptr<NetDevice> associatedPort;
     Time expirationTime;
   };
-  std::map<Mac48Address, LearnedState> m_learnState;
+  HashMap<Mac48Address, LearnedState, Mac48AddressHash> m_learnState;
   Ptr<Node> m_node;
   Ptr<BridgeChannel> m_channel;
   std::vector< Ptr<NetDevice> > m_ports;
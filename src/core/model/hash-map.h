@@ -0,0 +1,646 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_HASH_MAP_H
+#define NS3_HASH_MAP_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup hash
+ * ns3::HashMap and ns3::HashSet declarations and implementations.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup hash
+ *
+ * \brief Open addressing hash table, the implementation of
+ * ns3::HashMap and ns3::HashSet.
+ *
+ * The values are stored in a single array, probed linearly from the
+ * slot given by the hash of their key, so that a lookup usually reads
+ * a single cache line instead of following the pointers of a tree or
+ * of a bucket list. Erased values leave a tombstone behind them, so
+ * erasing never moves the other values: only an insertion which grows
+ * the table invalidates the iterators. The table grows when three
+ * quarters of the slots are in use.
+ *
+ * The hash function object must spread the keys over all the bits of
+ * its result, e.g. by using the ns3::Hash functions; the table mixes
+ * the bits once more before using them as an index.
+ *
+ * \tparam Value the type of the stored values
+ * \tparam Key the type of the keys
+ * \tparam KeyOf function object returning the key of a value
+ * \tparam HashFn function object returning the size_t hash of a key
+ * \tparam KeyEqual function object comparing two keys
+ */
+template <typename Value, typename Key, typename KeyOf, typename HashFn, typename KeyEqual>
+class HashTable
+{
+  /// The state of a slot
+  enum State
+  {
+    EMPTY,    //!< never used since the last rehash
+    FULL,     //!< holds a value
+    DELETED   //!< tombstone of an erased value
+  };
+  /// A slot of the table
+  struct Slot
+  {
+    Slot () : m_state (EMPTY), m_value () {}
+    uint8_t m_state;  //!< the State of the slot
+    Value m_value;    //!< the value, if the slot is FULL
+  };
+
+public:
+  typedef Key key_type;       //!< the type of the keys
+  typedef Value value_type;   //!< the type of the stored values
+  typedef std::size_t size_type; //!< the type of sizes
+
+  class const_iterator;
+
+  /// Forward iterator over the values of the table
+  class iterator
+  {
+public:
+    iterator () : m_slot (0), m_end (0) {}
+    value_type & operator* () const { return m_slot->m_value; }
+    value_type * operator-> () const { return &m_slot->m_value; }
+    iterator & operator++ () { m_slot = Skip (m_slot + 1, m_end); return *this; }
+    iterator operator++ (int) { iterator tmp = *this; ++*this; return tmp; }
+    bool operator== (const iterator &o) const { return m_slot == o.m_slot; }
+    bool operator!= (const iterator &o) const { return m_slot != o.m_slot; }
+private:
+    friend class HashTable;
+    friend class const_iterator;
+    iterator (Slot *slot, Slot *end) : m_slot (slot), m_end (end) {}
+    Slot *m_slot; //!< the current slot
+    Slot *m_end;  //!< past the last slot
+  };
+
+  /// Forward iterator over the values of a const table
+  class const_iterator
+  {
+public:
+    const_iterator () : m_slot (0), m_end (0) {}
+    const_iterator (const iterator &o) : m_slot (o.m_slot), m_end (o.m_end) {}
+    const value_type & operator* () const { return m_slot->m_value; }
+    const value_type * operator-> () const { return &m_slot->m_value; }
+    const_iterator & operator++ () { m_slot = Skip (m_slot + 1, m_end); return *this; }
+    const_iterator operator++ (int) { const_iterator tmp = *this; ++*this; return tmp; }
+    bool operator== (const const_iterator &o) const { return m_slot == o.m_slot; }
+    bool operator!= (const const_iterator &o) const { return m_slot != o.m_slot; }
+private:
+    friend class HashTable;
+    const_iterator (const Slot *slot, const Slot *end) : m_slot (slot), m_end (end) {}
+    const Slot *m_slot; //!< the current slot
+    const Slot *m_end;  //!< past the last slot
+  };
+
+  HashTable ();
+
+  /// \returns an iterator to the first value, in no particular order
+  iterator begin (void);
+  /// \returns an iterator past the last value
+  iterator end (void);
+  /// \returns an iterator to the first value, in no particular order
+  const_iterator begin (void) const;
+  /// \returns an iterator past the last value
+  const_iterator end (void) const;
+
+  /// \returns the number of values
+  size_type size (void) const;
+  /// \returns true if the table holds no value
+  bool empty (void) const;
+
+  /**
+   * \param key a key
+   * \returns an iterator to the value with this key, or end ()
+   */
+  iterator find (const key_type &key);
+  /**
+   * \param key a key
+   * \returns an iterator to the value with this key, or end ()
+   */
+  const_iterator find (const key_type &key) const;
+  /**
+   * \param key a key
+   * \returns 1 if a value has this key, 0 otherwise
+   */
+  size_type count (const key_type &key) const;
+
+  /**
+   * \brief Insert a value, unless a value with the same key is present.
+   * \param value the value
+   * \returns an iterator to the value with the key of value, and true
+   * if value was inserted
+   */
+  std::pair<iterator, bool> insert (const value_type &value);
+
+  /**
+   * \param key a key
+   * \returns the number of values erased, 0 or 1
+   */
+  size_type erase (const key_type &key);
+  /**
+   * \brief Erase a value. The other iterators remain valid.
+   * \param it an iterator to the value
+   */
+  void erase (iterator it);
+  /**
+   * \brief Erase a range of values.
+   * \param first the first value erased
+   * \param last the value past the last one erased
+   */
+  void erase (iterator first, iterator last);
+  /// Erase all the values, keeping the allocated slots
+  void clear (void);
+
+  /**
+   * \brief Allocate enough slots to hold n values without growing.
+   * \param n a number of values
+   */
+  void reserve (size_type n);
+  /**
+   * \param other the table to swap contents with
+   */
+  void swap (HashTable &other);
+
+protected:
+  /**
+   * \param key a key
+   * \returns the value with this key, inserting a value made by
+   * make (key) if there is none
+   */
+  template <typename Make>
+  value_type & FindOrInsert (const key_type &key, Make make);
+
+private:
+  /**
+   * \param slot a slot
+   * \param end past the last slot
+   * \returns the first FULL slot from slot on, or end
+   */
+  template <typename S>
+  static S * Skip (S *slot, S *end);
+  /**
+   * \param key a key
+   * \returns the first slot to probe for key
+   */
+  size_type Index (const key_type &key) const;
+  /**
+   * \param key a key
+   * \returns the index of the slot holding key, or the size of m_slots
+   */
+  size_type Lookup (const key_type &key) const;
+  /**
+   * \param key a key which is not in the table
+   * \returns the index of the slot where a value with key can be stored
+   */
+  size_type FreeSlot (const key_type &key) const;
+  /**
+   * \param bits the log2 of the new number of slots
+   */
+  void Rehash (uint32_t bits);
+  /// Grow the table, if needed, before a value is inserted
+  void Prepare (void);
+
+  std::vector<Slot> m_slots; //!< the slots, a power of two of them
+  size_type m_size;          //!< the number of FULL slots
+  size_type m_used;          //!< the number of FULL and DELETED slots
+  uint32_t m_bits;           //!< log2 of the number of slots
+  HashFn m_hash;             //!< the hash function
+  KeyEqual m_equal;          //!< the key comparison
+  KeyOf m_keyOf;             //!< the key of a value
+};
+
+/**
+ * \ingroup hash
+ * \brief The key of a std::pair, i.e. its first member.
+ */
+template <typename Pair>
+struct HashMapKeyOf
+{
+  /**
+   * \param value a pair
+   * \returns its first member
+   */
+  const typename Pair::first_type & operator() (const Pair &value) const
+  {
+    return value.first;
+  }
+};
+
+/**
+ * \ingroup hash
+ * \brief The key of a set value, i.e. the value itself.
+ */
+template <typename Key>
+struct HashSetKeyOf
+{
+  /**
+   * \param value a value
+   * \returns the value
+   */
+  const Key & operator() (const Key &value) const
+  {
+    return value;
+  }
+};
+
+/**
+ * \ingroup hash
+ *
+ * \brief Associative container, a drop-in replacement for std::map
+ * when the order of the keys does not matter, implemented by an
+ * ns3::HashTable.
+ *
+ * Unlike std::map, the values are std::pair<Key, T> whose key must
+ * not be modified through an iterator, and inserting a key may
+ * invalidate all the iterators.
+ *
+ * \tparam Key the type of the keys
+ * \tparam T the type of the mapped values
+ * \tparam HashFn function object returning the size_t hash of a key
+ * \tparam KeyEqual function object comparing two keys
+ */
+template <typename Key, typename T, typename HashFn, typename KeyEqual = std::equal_to<Key> >
+class HashMap
+  : public HashTable<std::pair<Key, T>, Key, HashMapKeyOf<std::pair<Key, T> >, HashFn, KeyEqual>
+{
+public:
+  typedef T mapped_type; //!< the type of the mapped values
+
+  /**
+   * \param key a key
+   * \returns the value mapped to key, default-constructed and
+   * inserted if key was not in the map
+   */
+  T & operator[] (const Key &key)
+  {
+    return this->FindOrInsert (key, &HashMap::MakeValue).second;
+  }
+
+private:
+  /**
+   * \param key a key
+   * \returns a value with this key and a default-constructed mapped value
+   */
+  static std::pair<Key, T> MakeValue (const Key &key)
+  {
+    return std::pair<Key, T> (key, T ());
+  }
+};
+
+/**
+ * \ingroup hash
+ *
+ * \brief Set container, a drop-in replacement for std::set when the
+ * order of the keys does not matter, implemented by an ns3::HashTable.
+ *
+ * \tparam Key the type of the keys
+ * \tparam HashFn function object returning the size_t hash of a key
+ * \tparam KeyEqual function object comparing two keys
+ */
+template <typename Key, typename HashFn, typename KeyEqual = std::equal_to<Key> >
+class HashSet
+  : public HashTable<Key, Key, HashSetKeyOf<Key>, HashFn, KeyEqual>
+{
+};
+
+} // namespace ns3
+
+/*************************************************
+ **  Implementation of the templates
+ ************************************************/
+
+namespace ns3 {
+
+template <typename V, typename K, typename O, typename H, typename E>
+HashTable<V, K, O, H, E>::HashTable ()
+  : m_size (0),
+    m_used (0),
+    m_bits (0)
+{
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+template <typename S>
+S *
+HashTable<V, K, O, H, E>::Skip (S *slot, S *end)
+{
+  while (slot != end && slot->m_state != FULL)
+    {
+      slot++;
+    }
+  return slot;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::iterator
+HashTable<V, K, O, H, E>::begin (void)
+{
+  if (m_slots.empty ())
+    {
+      return iterator ();
+    }
+  Slot *end = &m_slots[0] + m_slots.size ();
+  return iterator (Skip (&m_slots[0], end), end);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::iterator
+HashTable<V, K, O, H, E>::end (void)
+{
+  if (m_slots.empty ())
+    {
+      return iterator ();
+    }
+  Slot *end = &m_slots[0] + m_slots.size ();
+  return iterator (end, end);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::const_iterator
+HashTable<V, K, O, H, E>::begin (void) const
+{
+  if (m_slots.empty ())
+    {
+      return const_iterator ();
+    }
+  const Slot *end = &m_slots[0] + m_slots.size ();
+  return const_iterator (Skip (&m_slots[0], end), end);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::const_iterator
+HashTable<V, K, O, H, E>::end (void) const
+{
+  if (m_slots.empty ())
+    {
+      return const_iterator ();
+    }
+  const Slot *end = &m_slots[0] + m_slots.size ();
+  return const_iterator (end, end);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::size (void) const
+{
+  return m_size;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+bool
+HashTable<V, K, O, H, E>::empty (void) const
+{
+  return m_size == 0;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::Index (const K &key) const
+{
+  // Fibonacci hashing: the high bits of the product depend on all the
+  // bits of the hash
+  uint32_t hash = static_cast<uint32_t> (m_hash (key));
+  return (hash * 2654435769U) >> (32 - m_bits);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::Lookup (const K &key) const
+{
+  if (m_size == 0)
+    {
+      return m_slots.size ();
+    }
+  size_type mask = m_slots.size () - 1;
+  for (size_type i = Index (key); ; i = (i + 1) & mask)
+    {
+      const Slot &slot = m_slots[i];
+      if (slot.m_state == EMPTY)
+        {
+          return m_slots.size ();
+        }
+      if (slot.m_state == FULL && m_equal (m_keyOf (slot.m_value), key))
+        {
+          return i;
+        }
+    }
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::FreeSlot (const K &key) const
+{
+  size_type mask = m_slots.size () - 1;
+  size_type i = Index (key);
+  while (m_slots[i].m_state == FULL)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::iterator
+HashTable<V, K, O, H, E>::find (const K &key)
+{
+  size_type i = Lookup (key);
+  if (i == m_slots.size ())
+    {
+      return end ();
+    }
+  return iterator (&m_slots[i], &m_slots[0] + m_slots.size ());
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::const_iterator
+HashTable<V, K, O, H, E>::find (const K &key) const
+{
+  size_type i = Lookup (key);
+  if (i == m_slots.size ())
+    {
+      return end ();
+    }
+  return const_iterator (&m_slots[i], &m_slots[0] + m_slots.size ());
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::count (const K &key) const
+{
+  return Lookup (key) == m_slots.size () ? 0 : 1;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::Prepare (void)
+{
+  if (m_slots.empty ())
+    {
+      Rehash (3);
+    }
+  else if ((m_used + 1) * 4 > m_slots.size () * 3)
+    {
+      // Only grow if the tombstones are not the reason for the rehash
+      Rehash ((m_size + 1) * 2 > m_slots.size () ? m_bits + 1 : m_bits);
+    }
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+std::pair<typename HashTable<V, K, O, H, E>::iterator, bool>
+HashTable<V, K, O, H, E>::insert (const V &value)
+{
+  size_type i = Lookup (m_keyOf (value));
+  if (i != m_slots.size ())
+    {
+      return std::make_pair (iterator (&m_slots[i], &m_slots[0] + m_slots.size ()), false);
+    }
+  Prepare ();
+  i = FreeSlot (m_keyOf (value));
+  Slot &slot = m_slots[i];
+  if (slot.m_state == EMPTY)
+    {
+      m_used++;
+    }
+  slot.m_state = FULL;
+  slot.m_value = value;
+  m_size++;
+  return std::make_pair (iterator (&slot, &m_slots[0] + m_slots.size ()), true);
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+template <typename Make>
+V &
+HashTable<V, K, O, H, E>::FindOrInsert (const K &key, Make make)
+{
+  size_type i = Lookup (key);
+  if (i != m_slots.size ())
+    {
+      return m_slots[i].m_value;
+    }
+  return *insert (make (key)).first;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+typename HashTable<V, K, O, H, E>::size_type
+HashTable<V, K, O, H, E>::erase (const K &key)
+{
+  size_type i = Lookup (key);
+  if (i == m_slots.size ())
+    {
+      return 0;
+    }
+  erase (iterator (&m_slots[i], &m_slots[0] + m_slots.size ()));
+  return 1;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::erase (iterator it)
+{
+  Slot *slot = it.m_slot;
+  slot->m_state = DELETED;
+  slot->m_value = V ();  // release what the value holds
+  m_size--;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::erase (iterator first, iterator last)
+{
+  while (first != last)
+    {
+      erase (first++);
+    }
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::clear (void)
+{
+  for (typename std::vector<Slot>::iterator i = m_slots.begin (); i != m_slots.end (); i++)
+    {
+      if (i->m_state == FULL)
+        {
+          i->m_value = V ();
+        }
+      i->m_state = EMPTY;
+    }
+  m_size = 0;
+  m_used = 0;
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::reserve (size_type n)
+{
+  uint32_t bits = 3;
+  while ((static_cast<size_type> (1) << bits) * 3 < n * 4)
+    {
+      bits++;
+    }
+  if (bits > m_bits)
+    {
+      Rehash (bits);
+    }
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::Rehash (uint32_t bits)
+{
+  std::vector<Slot> old (static_cast<size_type> (1) << bits);
+  old.swap (m_slots);
+  m_bits = bits;
+  m_used = m_size;
+  for (typename std::vector<Slot>::iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (i->m_state == FULL)
+        {
+          Slot &slot = m_slots[FreeSlot (m_keyOf (i->m_value))];
+          slot.m_state = FULL;
+          slot.m_value = i->m_value;
+        }
+    }
+}
+
+template <typename V, typename K, typename O, typename H, typename E>
+void
+HashTable<V, K, O, H, E>::swap (HashTable &other)
+{
+  m_slots.swap (other.m_slots);
+  std::swap (m_size, other.m_size);
+  std::swap (m_used, other.m_used);
+  std::swap (m_bits, other.m_bits);
+  std::swap (m_hash, other.m_hash);
+  std::swap (m_equal, other.m_equal);
+}
+
+} // namespace ns3
+
+#endif /* NS3_HASH_MAP_H */
@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+
+#include "ns3/test.h"
+#include "ns3/hash-map.h"
+#include "ns3/hash.h"
+
+namespace ns3 {
+
+/**
+ * Hash of an integer, with the default hash function
+ */
+struct IntegerHash
+{
+  size_t operator () (uint32_t x) const
+  {
+    return Hash32 ((const char *)&x, sizeof (x));
+  }
+};
+
+/**
+ * Worst possible hash, to exercise the probing
+ */
+struct ConstantHash
+{
+  size_t operator () (uint32_t x) const
+  {
+    return 7;
+  }
+};
+
+/**
+ * Compare a HashMap with a std::map through random insertions and erasures
+ */
+template <typename HashFn>
+class HashMapTestCase : public TestCase
+{
+public:
+  HashMapTestCase (std::string name);
+private:
+  virtual void DoRun (void);
+};
+
+template <typename HashFn>
+HashMapTestCase<HashFn>::HashMapTestCase (std::string name)
+  : TestCase ("HashMap against std::map with " + name)
+{
+}
+
+template <typename HashFn>
+void
+HashMapTestCase<HashFn>::DoRun (void)
+{
+  typedef HashMap<uint32_t, uint32_t, HashFn> Map;
+  Map map;
+  std::map<uint32_t, uint32_t> ref;
+  NS_TEST_ASSERT_MSG_EQ (map.empty (), true, "New map not empty");
+  NS_TEST_ASSERT_MSG_EQ ((map.find (1) == map.end ()), true, "Key found in a new map");
+
+  uint32_t x = 1;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      x = x * 1103515245 + 12345;
+      uint32_t key = (x >> 16) % 500;
+      if ((x >> 8) % 3 == 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (map.erase (key), ref.erase (key), "Wrong erase of " << key);
+        }
+      else
+        {
+          bool inserted = map.insert (std::make_pair (key, i)).second;
+          NS_TEST_ASSERT_MSG_EQ (inserted, ref.insert (std::make_pair (key, i)).second, "Wrong insert of " << key);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (map.size (), ref.size (), "Wrong size");
+  uint32_t seen = 0;
+  for (typename Map::const_iterator i = map.begin (); i != map.end (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (ref[i->first], i->second, "Wrong value of " << i->first);
+      seen++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (seen, ref.size (), "Wrong number of values iterated");
+
+  // Erasing while iterating does not invalidate the iterator
+  for (typename Map::iterator i = map.begin (); i != map.end (); i++)
+    {
+      if (i->first % 2)
+        {
+          map.erase (i);
+        }
+    }
+  for (std::map<uint32_t, uint32_t>::const_iterator i = ref.begin (); i != ref.end (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (map.count (i->first), ((i->first % 2) ? 0 : 1), "Wrong erase while iterating");
+    }
+
+  map[1000] = 5;
+  map[1000]++;
+  NS_TEST_ASSERT_MSG_EQ (map.find (1000)->second, 6, "Wrong value through operator []");
+  map.clear ();
+  NS_TEST_ASSERT_MSG_EQ ((map.size () == 0 && map.begin () == map.end ()), true, "Values left after clear");
+}
+
+/**
+ * HashSet test
+ */
+class HashSetTestCase : public TestCase
+{
+public:
+  HashSetTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+HashSetTestCase::HashSetTestCase ()
+  : TestCase ("HashSet insertion, lookup and growth")
+{
+}
+
+void
+HashSetTestCase::DoRun (void)
+{
+  HashSet<uint32_t, IntegerHash> set;
+  set.reserve (100);
+  for (uint32_t i = 0; i < 10000; i += 3)
+    {
+      set.insert (i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (set.insert (3).second, false, "Duplicate inserted");
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      found += set.count (i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (found, set.size (), "Wrong keys found");
+  NS_TEST_ASSERT_MSG_EQ (found, 3334, "Wrong number of keys");
+}
+
+/**
+ * HashMap test suite
+ */
+class HashMapTestSuite : public TestSuite
+{
+public:
+  HashMapTestSuite ();
+};
+
+HashMapTestSuite::HashMapTestSuite ()
+  : TestSuite ("hash-map", UNIT)
+{
+  AddTestCase (new HashMapTestCase<IntegerHash> ("the default hash"), QUICK);
+  AddTestCase (new HashMapTestCase<ConstantHash> ("a constant hash"), QUICK);
+  AddTestCase (new HashSetTestCase, QUICK);
+}
+
+static HashMapTestSuite g_hashMapTestSuite;
+
+}  // namespace ns3
@@ -116,5 +116,11 @@ FlowMonitorHelper::InstallAll ()
   return m_flowMonitor;
 }
 
+void
+FlowMonitorHelper::EnablePeriodicExport (std::string fileName, Time interval)
+{
+  GetMonitor ()->EnablePeriodicExport (Create<OutputStreamWrapper> (fileName, std::ios::out), interval);
+}
+
 
 } // namespace ns3
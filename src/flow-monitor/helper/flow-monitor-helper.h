@@ -79,6 +79,15 @@ public:
    */
   Ptr<FlowClassifier> GetClassifier ();
 
+  /**
+   * \brief Export the flows of the FlowMonitor periodically to a CSV file
+   * \param fileName name of the file to write
+   * \param interval the time between two exports
+   *
+   * \see FlowMonitor::EnablePeriodicExport
+   */
+  void EnablePeriodicExport (std::string fileName, Time interval);
+
 private:
   ObjectFactory m_monitorFactory;       //!< Object factory
   Ptr<FlowMonitor> m_flowMonitor;       //!< the FlowMonitor object
@@ -23,6 +23,7 @@
 
 #include "ns3/simple-ref-count.h"
 #include <ostream>
+#include <functional>
 
 namespace ns3 {
 
@@ -38,6 +39,22 @@ typedef uint32_t FlowId;
  */
 typedef uint32_t FlowPacketId;
 
+/**
+ * \ingroup flow-monitor
+ * \brief Hash function class for flow identifiers
+ */
+class FlowIdHash : public std::unary_function<FlowId, size_t>
+{
+public:
+  /**
+   * \param flowId the flow identifier to hash
+   * \returns the identifier itself, whose bits ns3::HashMap mixes
+   */
+  size_t operator() (FlowId flowId) const
+  {
+    return flowId;
+  }
+};
 
 /// \ingroup flow-monitor
 /// Provides a method to translate raw packet data into abstract
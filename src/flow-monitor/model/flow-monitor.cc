@@ -24,6 +24,7 @@
 #include "ns3/double.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
@@ -73,6 +74,12 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("FlowEvictionTimeout", ("The time after which a flow without any packet sent, received "
+                                           "or in flight is removed from the monitor once exported, "
+                                           "see EnablePeriodicExport.  Zero means that flows are never removed."),
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&FlowMonitor::m_flowEvictionTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -93,6 +100,8 @@ void
 FlowMonitor::DoDispose (void)
 {
   m_classifier = 0;
+  m_exportStream = 0;
+  Simulator::Cancel (m_exportEvent);
   for (uint32_t i = 0; i < m_flowProbes.size (); i++)
     {
       m_flowProbes[i]->Dispose ();
@@ -101,10 +110,125 @@ FlowMonitor::DoDispose (void)
   Object::DoDispose ();
 }
 
+FlowMonitor::TrackedFlow::TrackedFlow ()
+  : stats (0),
+    queued (false),
+    m_head (0),
+    m_n (0)
+{
+}
+
+uint32_t
+FlowMonitor::TrackedFlow::GetN (void) const
+{
+  return m_n;
+}
+
+FlowMonitor::TrackedPacket &
+FlowMonitor::TrackedFlow::Get (uint32_t i)
+{
+  return m_ring[(m_head + i) & (m_ring.size () - 1)];
+}
+
+FlowMonitor::TrackedPacket *
+FlowMonitor::TrackedFlow::Find (FlowPacketId packetId)
+{
+  if (m_n == 0)
+    {
+      return 0;
+    }
+  FlowPacketId oldest = Get (0).packetId;
+  FlowPacketId offset = packetId - oldest;
+  uint32_t low = 0;
+  uint32_t high = m_n;
+  while (low < high)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (Get (middle).packetId - oldest < offset)
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  if (low == m_n)
+    {
+      return 0;
+    }
+  TrackedPacket &tracked = Get (low);
+  return (tracked.packetId == packetId && tracked.inFlight) ? &tracked : 0;
+}
+
+FlowMonitor::TrackedPacket &
+FlowMonitor::TrackedFlow::Add (FlowPacketId packetId)
+{
+  // An identifier which is not after the newest one, counting from the
+  // oldest one, was used again: the packets up to its previous use can
+  // no longer be told apart from the new ones
+  while (m_n > 0)
+    {
+      TrackedPacket &oldest = Get (0);
+      if (packetId - oldest.packetId > Get (m_n - 1).packetId - oldest.packetId)
+        {
+          break;
+        }
+      if (oldest.inFlight)
+        {
+          stats->lostPackets++;
+        }
+      m_head = (m_head + 1) & (m_ring.size () - 1);
+      m_n--;
+    }
+  if (m_n == m_ring.size ())
+    {
+      // Leave out the packets no longer in flight, which a lost packet
+      // at the head would otherwise keep for MaxPerHopDelay, and keep
+      // the ring at most half full
+      uint32_t inFlight = 0;
+      for (uint32_t i = 0; i < m_n; i++)
+        {
+          inFlight += Get (i).inFlight;
+        }
+      size_t size = 4;
+      while (size < 2 * inFlight)
+        {
+          size *= 2;
+        }
+      std::vector<TrackedPacket> ring (size);
+      uint32_t n = 0;
+      for (uint32_t i = 0; i < m_n; i++)
+        {
+          if (Get (i).inFlight)
+            {
+              ring[n++] = Get (i);
+            }
+        }
+      m_ring.swap (ring);
+      m_head = 0;
+      m_n = n;
+    }
+  m_n++;
+  TrackedPacket &tracked = Get (m_n - 1);
+  tracked.packetId = packetId;
+  return tracked;
+}
+
+void
+FlowMonitor::TrackedFlow::Trim (void)
+{
+  while (m_n > 0 && !m_ring[m_head].inFlight)
+    {
+      m_head = (m_head + 1) & (m_ring.size () - 1);
+      m_n--;
+    }
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
-  std::map<FlowId, FlowStats>::iterator iter;
+  FlowStatsMap::iterator iter;
   iter = m_flowStats.find (flowId);
   if (iter == m_flowStats.end ())
     {
@@ -139,16 +263,28 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  TrackedFlow &flow = m_trackedFlows[flowId];
+  if (flow.stats == 0)
+    {
+      // the nodes of m_flowStats stay in place until the flow is evicted
+      flow.stats = &GetStatsForFlow (flowId);
+    }
+  TrackedPacket &tracked = flow.Add (packetId);
+  tracked.inFlight = true;
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
+  if (!flow.queued)
+    {
+      m_flowChecks.push (std::make_pair (now, flowId));
+      flow.queued = true;
+    }
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowStats &stats = *flow.stats;
   stats.txBytes += packetSize;
   stats.txPackets++;
   if (stats.txPackets == 1)
@@ -166,19 +302,19 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  TrackedFlowMap::iterator flow = m_trackedFlows.find (flowId);
+  TrackedPacket *tracked = flow == m_trackedFlows.end () ? 0 : flow->second.Find (packetId);
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->timesForwarded++;
+  tracked->lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -190,8 +326,9 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  TrackedFlowMap::iterator flow = m_trackedFlows.find (flowId);
+  TrackedPacket *tracked = flow == m_trackedFlows.end () ? 0 : flow->second.Find (packetId);
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
@@ -199,10 +336,10 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowStats &stats = *flow->second.stats;
   stats.delaySum += delay;
   stats.delayHistogram.AddValue (delay.GetSeconds ());
   if (stats.rxPackets > 0 )
@@ -238,12 +375,14 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += tracked->timesForwarded;
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  // we don't need to track this packet anymore
+  tracked->inFlight = false;
+  flow->second.Trim ();
 }
 
 void
@@ -268,14 +407,16 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  TrackedFlowMap::iterator flow = m_trackedFlows.find (flowId);
+  TrackedPacket *tracked = flow == m_trackedFlows.end () ? 0 : flow->second.Find (packetId);
+  if (tracked != 0)
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      tracked->inFlight = false;
+      flow->second.Trim ();
     }
 }
 
@@ -285,30 +426,35 @@ FlowMonitor::GetFlowStats () const
   return m_flowStats;
 }
 
+void
+FlowMonitor::AddLostPacket (FlowId flowId, TrackedPacket &packet)
+{
+  // packet is considered lost, add it to the loss statistics
+  FlowStatsMap::iterator flow = m_flowStats.find (flowId);
+  NS_ASSERT (flow != m_flowStats.end ());
+  flow->second.lostPackets++;
+
+  // we won't track it anymore
+  packet.inFlight = false;
+}
 
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  for (TrackedFlowMap::iterator iter = m_trackedFlows.begin (); iter != m_trackedFlows.end (); iter++)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      TrackedFlow &flow = iter->second;
+      for (uint32_t i = 0; i < flow.GetN (); i++)
         {
-          // packet is considered lost, add it to the loss statistics
-          std::map<FlowId, FlowStats>::iterator
-            flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
+          TrackedPacket &packet = flow.Get (i);
+          if (packet.inFlight && now - packet.lastSeenTime >= maxDelay)
+            {
+              AddLostPacket (iter->first, packet);
+            }
         }
+      flow.Trim ();
     }
 }
 
@@ -321,7 +467,49 @@ FlowMonitor::CheckForLostPackets ()
 void
 FlowMonitor::PeriodicCheckForLostPackets ()
 {
-  CheckForLostPackets ();
+  Time now = Simulator::Now ();
+
+  // A flow is queued when a packet enters it, and queued again, by the
+  // time its remaining packets in flight were last seen, after each
+  // check.  Forwarding a packet only makes the time of its flow earlier
+  // than needed, so every packet is found lost by the first check after
+  // it was last seen MaxPerHopDelay ago.
+  while (!m_flowChecks.empty () && now - m_flowChecks.top ().first >= m_maxPerHopDelay)
+    {
+      FlowId flowId = m_flowChecks.top ().second;
+      m_flowChecks.pop ();
+      TrackedFlowMap::iterator iter = m_trackedFlows.find (flowId);
+      if (iter == m_trackedFlows.end ())
+        {
+          // evicted by Export ()
+          continue;
+        }
+      TrackedFlow &flow = iter->second;
+      flow.queued = false;
+      Time earliest = now;
+      for (uint32_t i = 0; i < flow.GetN (); i++)
+        {
+          TrackedPacket &packet = flow.Get (i);
+          if (!packet.inFlight)
+            {
+              continue;
+            }
+          if (now - packet.lastSeenTime >= m_maxPerHopDelay)
+            {
+              AddLostPacket (flowId, packet);
+            }
+          else
+            {
+              earliest = std::min (earliest, packet.lastSeenTime);
+              flow.queued = true;
+            }
+        }
+      flow.Trim ();
+      if (flow.queued)
+        {
+          m_flowChecks.push (std::make_pair (earliest, flowId));
+        }
+    }
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
@@ -388,6 +576,109 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  if (m_exportStream != 0)
+    {
+      Export ();
+    }
+}
+
+void
+FlowMonitor::EnablePeriodicExport (Ptr<OutputStreamWrapper> stream, Time interval)
+{
+  NS_ASSERT_MSG (interval.IsStrictlyPositive (), "The export interval must be positive");
+  m_exportStream = stream;
+  m_exportInterval = interval;
+  *m_exportStream->GetStream () << "timeNs,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,"
+                                << "timesForwarded,delaySumNs,jitterSumNs,evicted\n";
+  Simulator::Cancel (m_exportEvent);
+  m_exportEvent = Simulator::Schedule (interval, &FlowMonitor::PeriodicExport, this);
+}
+
+void
+FlowMonitor::PeriodicExport ()
+{
+  Export ();
+  m_exportEvent = Simulator::Schedule (m_exportInterval, &FlowMonitor::PeriodicExport, this);
+}
+
+void
+FlowMonitor::Export ()
+{
+  Time now = Simulator::Now ();
+  std::ostream &os = *m_exportStream->GetStream ();
+
+  for (FlowStatsMap::iterator flow = m_flowStats.begin (); flow != m_flowStats.end (); )
+    {
+      FlowId id = flow->first;
+      const FlowStats &stats = flow->second;
+      ExportedStatsMap::iterator exported = m_exportedStats.find (id);
+      if (exported == m_exportedStats.end ())
+        {
+          ExportedStats zero;
+          zero.txBytes = 0;
+          zero.rxBytes = 0;
+          zero.txPackets = 0;
+          zero.rxPackets = 0;
+          zero.lostPackets = 0;
+          zero.timesForwarded = 0;
+          zero.delaySum = Seconds (0);
+          zero.jitterSum = Seconds (0);
+          exported = m_exportedStats.insert (std::make_pair (id, zero)).first;
+        }
+      ExportedStats &previous = exported->second;
+
+      bool evict = false;
+      if (!m_flowEvictionTimeout.IsZero ())
+        {
+          Time lastSeen = std::max (stats.timeLastTxPacket, stats.timeLastRxPacket);
+          TrackedFlowMap::const_iterator tracked = m_trackedFlows.find (id);
+          evict = now - lastSeen >= m_flowEvictionTimeout
+            && (tracked == m_trackedFlows.end () || tracked->second.GetN () == 0);
+        }
+      bool changed = stats.txPackets != previous.txPackets || stats.rxPackets != previous.rxPackets
+        || stats.lostPackets != previous.lostPackets || stats.timesForwarded != previous.timesForwarded;
+      if (changed || evict)
+        {
+          // Times as integer nanoseconds, and differences of the
+          // rounded sums, so that the lines add up to the exact totals
+          os << now.GetNanoSeconds () << ',' << id
+             << ',' << stats.txPackets - previous.txPackets
+             << ',' << stats.txBytes - previous.txBytes
+             << ',' << stats.rxPackets - previous.rxPackets
+             << ',' << stats.rxBytes - previous.rxBytes
+             << ',' << stats.lostPackets - previous.lostPackets
+             << ',' << stats.timesForwarded - previous.timesForwarded
+             << ',' << stats.delaySum.GetNanoSeconds () - previous.delaySum.GetNanoSeconds ()
+             << ',' << stats.jitterSum.GetNanoSeconds () - previous.jitterSum.GetNanoSeconds ()
+             << ',' << evict << '\n';
+        }
+
+      if (evict)
+        {
+          m_flowStats.erase (flow++);
+          m_exportedStats.erase (exported);
+          m_trackedFlows.erase (id);
+          for (std::vector< Ptr<FlowProbe> >::iterator probe = m_flowProbes.begin ();
+               probe != m_flowProbes.end (); probe++)
+            {
+              (*probe)->RemoveStats (id);
+            }
+          continue;
+        }
+      if (changed)
+        {
+          previous.txBytes = stats.txBytes;
+          previous.rxBytes = stats.rxBytes;
+          previous.txPackets = stats.txPackets;
+          previous.rxPackets = stats.rxPackets;
+          previous.lostPackets = stats.lostPackets;
+          previous.timesForwarded = stats.timesForwarded;
+          previous.delaySum = stats.delaySum;
+          previous.jitterSum = stats.jitterSum;
+        }
+      flow++;
+    }
+  os.flush ();
 }
 
 void
@@ -405,7 +696,7 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, int indent, bool enableHist
   indent += 2;
   INDENT (indent); os << "<FlowStats>\n";
   indent += 2;
-  for (std::map<FlowId, FlowStats>::const_iterator flowI = m_flowStats.begin ();
+  for (FlowStatsMap::const_iterator flowI = m_flowStats.begin ();
        flowI != m_flowStats.end (); flowI++)
     {
 
@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <map>
+#include <queue>
+#include <functional>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -31,6 +33,8 @@
 #include "ns3/histogram.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/hash-map.h"
+#include "ns3/output-stream-wrapper.h"
 
 namespace ns3 {
 
@@ -240,6 +244,23 @@ public:
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /// Write to a stream, every interval and when the monitor stops,
+  /// what changed in the statistics of each flow since the previous
+  /// export, one CSV line per flow which changed:
+  ///
+  /// timeNs,flowId,txPackets,txBytes,rxPackets,rxBytes,lostPackets,timesForwarded,delaySumNs,jitterSumNs,evicted
+  ///
+  /// where timeNs, delaySumNs and jitterSumNs are integer nanoseconds.
+  /// Summing the lines of a flow gives its totals, the sums of delays
+  /// and jitters rounded to nanoseconds.  If the FlowEvictionTimeout
+  /// attribute is not zero, the flows which have been idle for that
+  /// long, with no packet in flight, are removed from the monitor and
+  /// from its probes once exported, with evicted set to 1, so that
+  /// the memory used by long simulations stays bounded.
+  /// \param stream the output stream
+  /// \param interval the time between two exports
+  void EnablePeriodicExport (Ptr<OutputStreamWrapper> stream, Time interval);
+
 
 protected:
 
@@ -251,17 +272,88 @@ private:
   /// Structure to represent a single tracked packet data
   struct TrackedPacket
   {
+    FlowPacketId packetId; //!< the packet identifier within its flow
+    bool inFlight; //!< false once the packet was received, dropped or lost
+    uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
     Time firstSeenTime; //!< absolute time when the packet was first seen by a probe
     Time lastSeenTime; //!< absolute time when the packet was last seen by a probe
-    uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+  };
+
+  /**
+   * The packets of a flow in flight, in the order they were first seen.
+   *
+   * Packet identifiers increase within a flow, so the packets are kept
+   * in a ring buffer, sorted by the difference between their identifier
+   * and the identifier of the oldest one, which is still meaningful when
+   * the identifiers wrap around.  Packets received or dropped before
+   * older ones are only marked as no longer in flight, until the packets
+   * in front of them go too, or until the ring is full and they are
+   * removed to make room.  Once the identifiers wrap around to the
+   * oldest packets still tracked, e.g. after 2^16 IPv4 packets behind a
+   * lost one, those packets are removed, and counted as lost if they
+   * are still in flight.
+   */
+  class TrackedFlow
+  {
+public:
+    TrackedFlow ();
+    /// \returns the number of packets in the ring, in flight or not
+    uint32_t GetN (void) const;
+    /// \param i the index of the packet, from the oldest one
+    /// \returns the packet
+    TrackedPacket & Get (uint32_t i);
+    /// \param packetId the packet identifier
+    /// \returns the packet in flight with this identifier, or zero
+    TrackedPacket * Find (FlowPacketId packetId);
+    /// \param packetId the packet identifier
+    /// \returns the packet with this identifier, added after the
+    /// others once the packets tracked since the last use of the
+    /// identifier are removed
+    TrackedPacket & Add (FlowPacketId packetId);
+    /// Remove the oldest packets which are no longer in flight
+    void Trim (void);
+
+    FlowStats *stats; //!< the statistics of the flow, in m_flowStats
+    bool queued; //!< true while the flow is in the queue of the periodic check
+private:
+    std::vector<TrackedPacket> m_ring; //!< the packets, m_ring.size () is 0 or a power of 2
+    uint32_t m_head; //!< the index of the oldest packet in m_ring
+    uint32_t m_n; //!< the number of packets in m_ring
   };
 
   /// FlowId --> FlowStats
-  std::map<FlowId, FlowStats> m_flowStats;
+  typedef std::map<FlowId, FlowStats> FlowStatsMap;
+  FlowStatsMap m_flowStats; //!< the statistics of the flows
+
+  /// FlowId --> packets of the flow in flight
+  typedef HashMap<FlowId, TrackedFlow, FlowIdHash> TrackedFlowMap;
+  TrackedFlowMap m_trackedFlows; //!< Tracked packets
+
+  /// The time by which all the packets of a flow in flight were last
+  /// seen at the earliest, and the flow
+  typedef std::pair<Time, FlowId> FlowCheck;
+  /// The flows with packets in flight, the earliest FlowCheck first
+  std::priority_queue<FlowCheck, std::vector<FlowCheck>, std::greater<FlowCheck> > m_flowChecks;
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// The statistics of a flow as of the previous export
+  struct ExportedStats
+  {
+    uint64_t txBytes; //!< transmitted bytes
+    uint64_t rxBytes; //!< received bytes
+    uint32_t txPackets; //!< transmitted packets
+    uint32_t rxPackets; //!< received packets
+    uint32_t lostPackets; //!< lost packets
+    uint32_t timesForwarded; //!< number of forwardings
+    Time delaySum; //!< sum of the delays
+    Time jitterSum; //!< sum of the jitters
+  };
+  /// FlowId --> statistics as of the previous export
+  typedef HashMap<FlowId, ExportedStats, FlowIdHash> ExportedStatsMap;
+  ExportedStatsMap m_exportedStats; //!< Statistics exported
+  Ptr<OutputStreamWrapper> m_exportStream; //!< the stream of the periodic export
+  Time m_exportInterval; //!< the time between two exports
+  EventId m_exportEvent; //!< the next periodic export
+  Time m_flowEvictionTimeout; //!< idle time after which exported flows are evicted
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   std::vector< Ptr<FlowProbe> > m_flowProbes; //!< all the FlowProbes
 
@@ -282,7 +374,21 @@ private:
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
-  /// Periodic function to check for lost packets and prune statistics
+  /// Account for a packet lost by its flow
+  /// \param flowId the Flow identification
+  /// \param packet the packet lost
+  void AddLostPacket (FlowId flowId, TrackedPacket &packet);
+
+  /// Write what changed in the flows since the previous export, and
+  /// evict the idle flows
+  void Export ();
+
+  /// Periodic function exporting the flows
+  void PeriodicExport ();
+
+  /// Periodic function to check for lost packets and prune statistics.
+  /// Only the flows with a packet in flight which may have been last
+  /// seen MaxPerHopDelay ago are checked.
   void PeriodicCheckForLostPackets ();
 };
 
@@ -92,6 +92,11 @@ public:
   /// \returns the partial flow statistics
   Stats GetStats () const;
 
+  /// Forget the statistics of a flow, e.g. once the FlowMonitor
+  /// evicted it
+  /// \param flowId the flow Identifier
+  void RemoveStats (FlowId flowId);
+
   /// Serializes the results to an std::ostream in XML format
   /// \param os the output stream
   /// \param indent number of spaces to use as base indentation level
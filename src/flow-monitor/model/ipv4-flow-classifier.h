@@ -26,6 +26,7 @@
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
+#include "ns3/hash-map.h"
 
 namespace ns3 {
 
@@ -49,6 +50,15 @@ public:
     uint16_t destinationPort;       //!< Destination port
   };
 
+  /// Hash function class for FiveTuple
+  class FiveTupleHash : public std::unary_function<FiveTuple, size_t>
+  {
+public:
+    /// \param tuple the tuple to hash
+    /// \returns the Murmur3 hash of the tuple fields
+    size_t operator () (const FiveTuple &tuple) const;
+  };
+
   Ipv4FlowClassifier ();
 
   /// \brief try to classify the packet into flow-id and packet-id
@@ -71,7 +81,7 @@ public:
 private:
 
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
+  HashMap<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
 
 };
 
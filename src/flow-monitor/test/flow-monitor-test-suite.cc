@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+
+namespace ns3 {
+
+/**
+ * Probe reporting the packet events chosen by the test
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * Check the accounting of received, dropped and lost packets, when
+ * packets leave their flow out of order and packet identifiers wrap
+ * around
+ */
+class FlowMonitorTrackingTestCase : public TestCase
+{
+public:
+  FlowMonitorTrackingTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorTrackingTestCase::FlowMonitorTrackingTestCase ()
+  : TestCase ("Tracking of the packets in flight")
+{
+}
+
+void
+FlowMonitorTrackingTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (2)));
+  Ptr<FlowProbe> probe = CreateObject<FlowMonitorTestProbe> (monitor);
+  monitor->StartRightNow ();
+
+  // Flow 1: identifiers wrap around, packets leave out of order
+  monitor->ReportFirstTx (probe, 1, 65534, 100);
+  monitor->ReportFirstTx (probe, 1, 65535, 100);
+  monitor->ReportFirstTx (probe, 1, 0, 100);
+  monitor->ReportFirstTx (probe, 1, 1, 100);
+  monitor->ReportFirstTx (probe, 1, 5, 100);
+  monitor->ReportLastRx (probe, 1, 0, 100);
+  monitor->ReportLastRx (probe, 1, 65534, 100);
+  monitor->ReportDrop (probe, 1, 1, 100, 0);
+  // Unknown, already received and already dropped packets are ignored
+  monitor->ReportLastRx (probe, 1, 7, 100);
+  monitor->ReportLastRx (probe, 1, 65534, 100);
+  monitor->ReportForwarding (probe, 1, 1, 100);
+
+  // Flow 2: the oldest packet is lost by the periodic check, the packet
+  // forwarded recently is lost only when the monitor stops
+  monitor->ReportFirstTx (probe, 2, 10, 100);
+  monitor->ReportFirstTx (probe, 2, 11, 100);
+  monitor->ReportFirstTx (probe, 2, 12, 100);
+  Simulator::Schedule (Seconds (1), &FlowMonitor::ReportLastRx, monitor, probe, 2, 11, 100);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitor::ReportForwarding, monitor, probe, 2, 12, 100);
+
+  // Flow 3: a packet lost behind an older one forwarded recently is
+  // found by the periodic check too
+  monitor->ReportFirstTx (probe, 3, 20, 100);
+  Simulator::Schedule (Seconds (0.5), &FlowMonitor::ReportFirstTx, monitor, probe, 3, 21, 100);
+  Simulator::Schedule (Seconds (1.5), &FlowMonitor::ReportForwarding, monitor, probe, 3, 20, 100);
+  Simulator::Stop (Seconds (3.6));
+  Simulator::Run ();
+
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[2].rxPackets, 1, "Wrong received packets of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (stats[2].lostPackets, 1, "The oldest packet of flow 2 should be lost");
+  NS_TEST_EXPECT_MSG_EQ (stats[3].lostPackets, 1, "Packet 21 of flow 3 should be lost");
+
+  monitor->StopRightNow ();
+  stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.size (), 3, "Wrong number of flows");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].txPackets, 5, "Wrong transmitted packets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].rxPackets, 2, "Wrong received packets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].timesForwarded, 0, "Wrong forwarding count of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 3, "Packets 1, 65535 and 5 of flow 1 should be lost");
+  NS_TEST_EXPECT_MSG_EQ (stats[2].lostPackets, 2, "Packets 10 and 12 of flow 2 should be lost");
+  NS_TEST_EXPECT_MSG_EQ (stats[3].lostPackets, 2, "Packets 20 and 21 of flow 3 should be lost");
+
+  // Nothing is left in flight
+  monitor->CheckForLostPackets (Seconds (0));
+  stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets + stats[2].lostPackets + stats[3].lostPackets, 7,
+                         "Packets lost twice");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the packets of a flow are still tracked after their
+ * 16-bit identifiers wrap around behind a lost packet
+ */
+class FlowMonitorWrapTestCase : public TestCase
+{
+public:
+  FlowMonitorWrapTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorWrapTestCase::FlowMonitorWrapTestCase ()
+  : TestCase ("Identifiers wrapping around behind a lost packet")
+{
+}
+
+void
+FlowMonitorWrapTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = CreateObject<FlowMonitorTestProbe> (monitor);
+  monitor->StartRightNow ();
+
+  // Packet 5 is lost early on, then 70000 packets follow with ten of
+  // them in flight at a time, well within MaxPerHopDelay
+  const uint32_t packets = 70000;
+  const uint32_t window = 10;
+  monitor->ReportFirstTx (probe, 1, 5, 100);
+  for (uint32_t i = 1; i <= packets + window; i++)
+    {
+      if (i <= packets)
+        {
+          monitor->ReportFirstTx (probe, 1, (5 + i) & 0xffff, 100);
+        }
+      if (i > window)
+        {
+          monitor->ReportLastRx (probe, 1, (5 + i - window) & 0xffff, 100);
+        }
+    }
+
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].txPackets, packets + 1, "Wrong transmitted packets");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].rxPackets, packets, "Packets received after the wrap-around were not tracked");
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 1, "The packet whose identifier was used again should be lost");
+
+  monitor->StopRightNow ();
+  stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats[1].lostPackets, 1, "Packets lost twice");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Check that the lines of the periodic export add up to the totals
+ * of each flow, and that idle flows are evicted
+ */
+class FlowMonitorExportTestCase : public TestCase
+{
+public:
+  FlowMonitorExportTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorExportTestCase::FlowMonitorExportTestCase ()
+  : TestCase ("Periodic export and eviction of the flows")
+{
+}
+
+void
+FlowMonitorExportTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("FlowEvictionTimeout", TimeValue (Seconds (2)));
+  Ptr<FlowProbe> probe = CreateObject<FlowMonitorTestProbe> (monitor);
+  std::ostringstream os;
+  monitor->EnablePeriodicExport (Create<OutputStreamWrapper> (&os), Seconds (1));
+  monitor->StartRightNow ();
+
+  // Flow 1 sends at 0.5 s only, flow 2 until 4.5 s, with delays which
+  // six significant digits would round
+  for (uint16_t i = 0; i < 5; i++)
+    {
+      Time t = Seconds (0.5 + i);
+      if (i == 0)
+        {
+          Simulator::Schedule (t, &FlowMonitor::ReportFirstTx, monitor, probe, 1, 100, 200);
+          Simulator::Schedule (t, &FlowMonitor::ReportLastRx, monitor, probe, 1, 100, 200);
+          Simulator::Schedule (t, &FlowProbe::AddPacketStats, probe, 1, 200, Seconds (0));
+        }
+      Simulator::Schedule (t, &FlowMonitor::ReportFirstTx, monitor, probe, 2, i, 100);
+      Simulator::Schedule (t + NanoSeconds (1000001 * (i + 1)), &FlowMonitor::ReportLastRx,
+                           monitor, probe, 2, i, 100);
+    }
+  Simulator::Stop (Seconds (5.2));
+  Simulator::Run ();
+  monitor->StopRightNow ();
+
+  std::istringstream is (os.str ());
+  std::string line;
+  std::getline (is, line);
+  NS_TEST_ASSERT_MSG_EQ (line.substr (0, 14), "timeNs,flowId,", "Wrong CSV header");
+  uint32_t lines[3] = {0, 0, 0};
+  uint32_t rxPackets[3] = {0, 0, 0};
+  uint64_t rxBytes[3] = {0, 0, 0};
+  uint32_t evicted[3] = {0, 0, 0};
+  int64_t delaySum[3] = {0, 0, 0};
+  int64_t jitterSum[3] = {0, 0, 0};
+  while (std::getline (is, line))
+    {
+      std::replace (line.begin (), line.end (), ',', ' ');
+      std::istringstream fields (line);
+      int64_t time, delaySum_, jitterSum_;
+      uint32_t flowId, txPackets, rxPackets_, lostPackets, timesForwarded, evicted_;
+      uint64_t txBytes, rxBytes_;
+      fields >> time >> flowId >> txPackets >> txBytes >> rxPackets_ >> rxBytes_
+             >> lostPackets >> timesForwarded >> delaySum_ >> jitterSum_ >> evicted_;
+      NS_TEST_ASSERT_MSG_EQ ((flowId == 1 || flowId == 2), true, "Unknown flow in " << line);
+      lines[flowId]++;
+      rxPackets[flowId] += rxPackets_;
+      rxBytes[flowId] += rxBytes_;
+      evicted[flowId] += evicted_;
+      delaySum[flowId] += delaySum_;
+      jitterSum[flowId] += jitterSum_;
+      if (evicted_)
+        {
+          NS_TEST_EXPECT_MSG_EQ (time, 3000000000LL, "Flow " << flowId << " evicted at the wrong time");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (lines[1], 2, "Flow 1 should be exported once, then evicted");
+  NS_TEST_EXPECT_MSG_EQ (rxPackets[1], 1, "Wrong received packets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (rxBytes[1], 200, "Wrong received bytes of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (evicted[1], 1, "Flow 1 should be evicted");
+  NS_TEST_EXPECT_MSG_EQ (lines[2], 5, "Flow 2 should be exported once per interval");
+  NS_TEST_EXPECT_MSG_EQ (rxPackets[2], 5, "Wrong received packets of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (rxBytes[2], 500, "Wrong received bytes of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (evicted[2], 0, "Flow 2 should not be evicted");
+
+  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (delaySum[2], 15000015, "Wrong delay sum of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (delaySum[2], stats[2].delaySum.GetNanoSeconds (), "Delay sums do not add up");
+  NS_TEST_EXPECT_MSG_EQ (jitterSum[2], 4000004, "Wrong jitter sum of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (jitterSum[2], stats[2].jitterSum.GetNanoSeconds (), "Jitter sums do not add up");
+  NS_TEST_EXPECT_MSG_EQ (stats.size (), 1, "Flow 1 should be removed from the monitor");
+  NS_TEST_EXPECT_MSG_EQ (probe->GetStats ().count (1), 0, "Flow 1 should be removed from the probe");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * FlowMonitor test suite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowMonitorTrackingTestCase, QUICK);
+  AddTestCase (new FlowMonitorWrapTestCase, QUICK);
+  AddTestCase (new FlowMonitorExportTestCase, QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite;
+
+} // namespace ns3
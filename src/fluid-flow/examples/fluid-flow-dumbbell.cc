@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// A foreground TCP transfer shares a bottleneck with background traffic
+// modelled as elastic fluid flows.
+//
+//   sender ---------- router ---------- receiver
+//            100Mbps           10Mbps
+//              1ms              10ms
+//
+// The fluid flows go from the router to the receiver.  The bottleneck
+// is shared max-min fairly, or TCP-fairly, between them; the foreground
+// transfer gets what the fluid flows leave, and its packets wait in the
+// router queue behind the fluid packets.
+
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/fluid-flow-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FluidFlowDumbbell");
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nFlows = 4;
+  double maxUtilization = 0.8;
+  bool tcpFair = false;
+  double duration = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("nFlows", "Number of background fluid flows", nFlows);
+  cmd.AddValue ("maxUtilization", "Fraction of a link the fluid flows can take", maxUtilization);
+  cmd.AddValue ("tcpFair", "Share the links TCP-fairly rather than max-min fairly", tcpFair);
+  cmd.AddValue ("duration", "Duration of the simulation, in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer access = p2p.Install (nodes.Get (0), nodes.Get (1));
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  NetDeviceContainer bottleneck = p2p.Install (nodes.Get (1), nodes.Get (2));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (access);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (bottleneck);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 9;
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), port));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+  sourceApps.Start (Seconds (0));
+  sourceApps.Stop (Seconds (duration));
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (2));
+  sinkApps.Start (Seconds (0));
+  sinkApps.Stop (Seconds (duration));
+
+  FluidFlowHelper fluid;
+  fluid.SetManagerAttribute ("MaxUtilization", DoubleValue (maxUtilization));
+  if (tcpFair)
+    {
+      fluid.SetManagerAttribute ("Sharing", EnumValue (FluidFlowManager::TCP_FAIR));
+    }
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      // Stagger the start of the flows, to see the foreground transfer
+      // adapt to the growing background load
+      fluid.SetFlowAttribute ("StartTime", TimeValue (Seconds (duration * i / (nFlows + 1))));
+      fluid.Install (nodes.Get (1), interfaces.GetAddress (1));
+    }
+
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+
+  Ptr<FluidFlowManager> manager = fluid.GetManager ();
+  std::cout << "Background load of the bottleneck: "
+            << manager->GetLoad (bottleneck.Get (0)).GetBitRate () / 1e6 << " Mbps" << std::endl;
+  for (uint32_t i = 0; i < manager->GetNFlows (); i++)
+    {
+      std::cout << "Fluid flow " << i << ": "
+                << manager->GetFlow (i)->GetRate ().GetBitRate () / 1e6 << " Mbps" << std::endl;
+    }
+  Ptr<PacketSink> packetSink = DynamicCast<PacketSink> (sinkApps.Get (0));
+  std::cout << "Foreground throughput: "
+            << packetSink->GetTotalRx () * 8 / duration / 1e6 << " Mbps" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
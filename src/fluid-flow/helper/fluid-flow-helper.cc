@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fluid-flow-helper.h"
+
+namespace ns3 {
+
+FluidFlowHelper::FluidFlowHelper ()
+{
+  m_managerFactory.SetTypeId ("ns3::FluidFlowManager");
+  m_flowFactory.SetTypeId ("ns3::FluidFlow");
+}
+
+void
+FluidFlowHelper::SetManagerAttribute (std::string name, const AttributeValue &value)
+{
+  NS_ASSERT_MSG (m_manager == 0, "The manager is already created");
+  m_managerFactory.Set (name, value);
+}
+
+void
+FluidFlowHelper::SetFlowAttribute (std::string name, const AttributeValue &value)
+{
+  m_flowFactory.Set (name, value);
+}
+
+Ptr<FluidFlow>
+FluidFlowHelper::Install (Ptr<Node> node, Ipv4Address destination)
+{
+  Ptr<FluidFlow> flow = m_flowFactory.Create<FluidFlow> ();
+  flow->SetNode (node);
+  flow->SetDestination (destination);
+  GetManager ()->AddFlow (flow);
+  return flow;
+}
+
+Ptr<FluidFlowManager>
+FluidFlowHelper::GetManager (void)
+{
+  if (m_manager == 0)
+    {
+      m_manager = m_managerFactory.Create<FluidFlowManager> ();
+    }
+  return m_manager;
+}
+
+} // namespace ns3
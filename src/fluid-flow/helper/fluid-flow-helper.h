@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_FLOW_HELPER_H
+#define FLUID_FLOW_HELPER_H
+
+#include <string>
+
+#include "ns3/object-factory.h"
+#include "ns3/attribute.h"
+#include "ns3/node.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/fluid-flow.h"
+#include "ns3/fluid-flow-manager.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup fluid-flow
+ * \brief Create fluid flows, all managed by the same FluidFlowManager
+ */
+class FluidFlowHelper
+{
+public:
+  FluidFlowHelper ();
+
+  /**
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   *
+   * Set an attribute of the manager.  It must be called before the first
+   * flow is installed.
+   */
+  void SetManagerAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   *
+   * Set an attribute of the flows installed afterwards.
+   */
+  void SetFlowAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Create a fluid flow from a node to an IPv4 address, and let the
+   * manager handle it.
+   *
+   * \param node the node the flow originates from
+   * \param destination the IPv4 address the flow is sent to
+   * \returns the flow
+   */
+  Ptr<FluidFlow> Install (Ptr<Node> node, Ipv4Address destination);
+
+  /**
+   * \returns the manager of the flows installed
+   */
+  Ptr<FluidFlowManager> GetManager (void);
+
+private:
+  ObjectFactory m_managerFactory;
+  ObjectFactory m_flowFactory;
+  Ptr<FluidFlowManager> m_manager;
+};
+
+} // namespace ns3
+
+#endif /* FLUID_FLOW_HELPER_H */
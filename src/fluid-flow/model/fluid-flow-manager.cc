@@ -0,0 +1,378 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/queue.h"
+#include "ns3/socket.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "fluid-flow-manager.h"
+
+NS_LOG_COMPONENT_DEFINE ("FluidFlowManager");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FluidFlowManager)
+  ;
+
+TypeId
+FluidFlowManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidFlowManager")
+    .SetParent<Object> ()
+    .AddConstructor<FluidFlowManager> ()
+    .AddAttribute ("Sharing", "How the capacity of a link is shared between the flows crossing it.",
+                   EnumValue (FluidFlowManager::MAX_MIN),
+                   MakeEnumAccessor (&FluidFlowManager::m_sharing),
+                   MakeEnumChecker (FluidFlowManager::MAX_MIN, "MaxMin",
+                                    FluidFlowManager::TCP_FAIR, "TcpFair"))
+    .AddAttribute ("MaxUtilization",
+                   "The fraction of the capacity of a link which can be given to the fluid flows, "
+                   "the rest being left to the packets.",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&FluidFlowManager::m_maxUtilization),
+                   MakeDoubleChecker<double> (0.0, 0.99))
+    .AddAttribute ("MeanPacketSize", "The mean size of the packets making up the fluid flows, in bytes.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&FluidFlowManager::m_meanPacketSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+FluidFlowManager::FluidFlowManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidFlowManager::~FluidFlowManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FluidFlowManager::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Ptr<FluidFlow> >::iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      (*i)->SetDataRateChangedCallback (MakeNullCallback<void> ());
+    }
+  m_flows.clear ();
+  m_loads.clear ();
+  Object::DoDispose ();
+}
+
+void
+FluidFlowManager::AddFlow (Ptr<FluidFlow> flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+  NS_ASSERT_MSG (flow->GetNode () != 0, "Fluid flow without a node");
+  m_flows.push_back (flow);
+  flow->SetDataRateChangedCallback (MakeCallback (&FluidFlowManager::Update, this));
+
+  Time now = Simulator::Now ();
+  Time start = flow->GetStartTime () > now ? flow->GetStartTime () - now : Seconds (0);
+  Simulator::ScheduleWithContext (flow->GetNode ()->GetId (), start,
+                                  &FluidFlowManager::Update, Ptr<FluidFlowManager> (this));
+  if (!flow->GetStopTime ().IsZero () && flow->GetStopTime () > now)
+    {
+      Simulator::ScheduleWithContext (flow->GetNode ()->GetId (), flow->GetStopTime () - now,
+                                      &FluidFlowManager::Update, Ptr<FluidFlowManager> (this));
+    }
+}
+
+uint32_t
+FluidFlowManager::GetNFlows (void) const
+{
+  return m_flows.size ();
+}
+
+Ptr<FluidFlow>
+FluidFlowManager::GetFlow (uint32_t i) const
+{
+  NS_ASSERT (i < m_flows.size ());
+  return m_flows[i];
+}
+
+Ptr<Node>
+FluidFlowManager::FindNode (Ptr<Channel> channel, Ipv4Address address) const
+{
+  if (channel == 0)
+    {
+      return 0;
+    }
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      Ptr<Node> node = channel->GetDevice (i)->GetNode ();
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      if (ipv4 != 0 && ipv4->GetInterfaceForAddress (address) >= 0)
+        {
+          return node;
+        }
+    }
+  return 0;
+}
+
+bool
+FluidFlowManager::FindPath (Ptr<FluidFlow> flow) const
+{
+  NS_LOG_FUNCTION (this << flow);
+  flow->m_path.clear ();
+  flow->m_rtt = Seconds (0);
+  Ipv4Address destination = flow->GetDestination ();
+  Ptr<Node> node = flow->GetNode ();
+  Time delay = Seconds (0);
+  // Bound the number of hops, in case the routes loop
+  for (uint32_t hops = 0; hops < 255; hops++)
+    {
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4 != 0, "Fluid flow through node " << node->GetId () << " without IPv4");
+      if (ipv4->GetInterfaceForAddress (destination) >= 0)
+        {
+          flow->m_rtt = delay + delay;
+          return true;
+        }
+      Ipv4Header header;
+      header.SetDestination (destination);
+      Socket::SocketErrno sockerr;
+      Ptr<Ipv4Route> route = ipv4->GetRoutingProtocol ()->RouteOutput (0, header, 0, sockerr);
+      if (route == 0)
+        {
+          NS_LOG_LOGIC ("No route to " << destination << " from node " << node->GetId ());
+          return false;
+        }
+      Ptr<NetDevice> device = route->GetOutputDevice ();
+      flow->m_path.push_back (device);
+
+      TimeValue channelDelay;
+      if (device->GetChannel () != 0
+          && device->GetChannel ()->GetAttributeFailSafe ("Delay", channelDelay))
+        {
+          delay += channelDelay.Get ();
+        }
+      Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice> (device);
+      if (p2p != 0)
+        {
+          DataRateValue capacity;
+          p2p->GetAttribute ("DataRate", capacity);
+          delay += Seconds (capacity.Get ().CalculateTxTime (m_meanPacketSize));
+        }
+
+      Ipv4Address next = route->GetGateway ();
+      if (next == Ipv4Address::GetAny ())
+        {
+          next = destination;
+        }
+      node = FindNode (device->GetChannel (), next);
+      if (node == 0)
+        {
+          NS_LOG_LOGIC ("No node owns " << next << " on the channel of " << device);
+          return false;
+        }
+    }
+  NS_LOG_WARN ("Routing loop towards " << destination);
+  return false;
+}
+
+void
+FluidFlowManager::Update (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The links crossed by the active flows, their capacity, and the flows
+  // crossing them
+  std::map<Ptr<PointToPointNetDevice>, uint32_t> index;
+  std::vector<Ptr<PointToPointNetDevice> > devices;
+  std::vector<double> residual;
+  std::vector<double> linkWeight;
+  std::vector<Ptr<FluidFlow> > flows;
+  std::vector<std::vector<uint32_t> > flowLinks;
+  std::vector<double> demand;
+  std::vector<double> weight;
+  for (std::vector<Ptr<FluidFlow> >::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      Ptr<FluidFlow> flow = *i;
+      if (!flow->IsActive () || !FindPath (flow))
+        {
+          flow->SetRate (DataRate (0));
+          continue;
+        }
+      std::vector<uint32_t> links;
+      for (std::vector<Ptr<NetDevice> >::const_iterator j = flow->m_path.begin (); j != flow->m_path.end (); ++j)
+        {
+          Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (*j);
+          if (device == 0)
+            {
+              continue;
+            }
+          std::pair<std::map<Ptr<PointToPointNetDevice>, uint32_t>::iterator, bool> k =
+            index.insert (std::make_pair (device, devices.size ()));
+          if (k.second)
+            {
+              DataRateValue capacity;
+              device->GetAttribute ("DataRate", capacity);
+              devices.push_back (device);
+              residual.push_back (capacity.Get ().GetBitRate () * m_maxUtilization);
+              linkWeight.push_back (0);
+            }
+          links.push_back (k.first->second);
+        }
+      if (links.empty () && flow->IsElastic ())
+        {
+          NS_LOG_WARN ("Elastic fluid flow " << flow << " crosses no point-to-point link");
+          flow->SetRate (DataRate (0));
+          continue;
+        }
+      flows.push_back (flow);
+      flowLinks.push_back (links);
+      demand.push_back (flow->IsElastic () ? std::numeric_limits<double>::infinity ()
+                        : (double)flow->GetDataRate ().GetBitRate ());
+      double rtt = flow->GetRoundTripTime ().GetSeconds ();
+      weight.push_back (m_sharing == TCP_FAIR && rtt > 0 ? 1 / rtt : 1);
+    }
+
+  // Progressive filling: raise the rates of the unfrozen flows in
+  // proportion to their weights until a link is full or a flow gets its
+  // demand, then freeze the flows concerned and go on with the others.
+  std::vector<double> rate (flows.size (), 0);
+  std::vector<bool> frozen (flows.size (), false);
+  uint32_t unfrozen = flows.size ();
+  while (unfrozen > 0)
+    {
+      std::fill (linkWeight.begin (), linkWeight.end (), 0);
+      for (uint32_t f = 0; f < flows.size (); f++)
+        {
+          for (uint32_t j = 0; !frozen[f] && j < flowLinks[f].size (); j++)
+            {
+              linkWeight[flowLinks[f][j]] += weight[f];
+            }
+        }
+      double step = std::numeric_limits<double>::infinity ();
+      for (uint32_t l = 0; l < devices.size (); l++)
+        {
+          if (linkWeight[l] > 0)
+            {
+              step = std::min (step, residual[l] / linkWeight[l]);
+            }
+        }
+      for (uint32_t f = 0; f < flows.size (); f++)
+        {
+          if (!frozen[f])
+            {
+              step = std::min (step, (demand[f] - rate[f]) / weight[f]);
+            }
+        }
+      for (uint32_t f = 0; f < flows.size (); f++)
+        {
+          for (uint32_t j = 0; !frozen[f] && j < flowLinks[f].size (); j++)
+            {
+              residual[flowLinks[f][j]] -= step * weight[f];
+            }
+          if (!frozen[f])
+            {
+              rate[f] += step * weight[f];
+            }
+        }
+      uint32_t before = unfrozen;
+      for (uint32_t f = 0; f < flows.size (); f++)
+        {
+          if (frozen[f])
+            {
+              continue;
+            }
+          bool full = rate[f] >= demand[f] * (1 - 1e-9);
+          for (uint32_t j = 0; !full && j < flowLinks[f].size (); j++)
+            {
+              full = residual[flowLinks[f][j]] <= 1e-6;
+            }
+          if (full)
+            {
+              frozen[f] = true;
+              unfrozen--;
+            }
+        }
+      NS_ASSERT_MSG (unfrozen < before, "Progressive filling does not progress");
+    }
+
+  std::vector<double> load (devices.size (), 0);
+  for (uint32_t f = 0; f < flows.size (); f++)
+    {
+      flows[f]->SetRate (DataRate ((uint64_t)(rate[f] + 0.5)));
+      for (uint32_t j = 0; j < flowLinks[f].size (); j++)
+        {
+          load[flowLinks[f][j]] += rate[f];
+        }
+    }
+
+  // Unload the links which are not crossed anymore, then load the others
+  for (LoadMap::iterator i = m_loads.begin (); i != m_loads.end (); ++i)
+    {
+      if (index.find (i->first) == index.end ())
+        {
+          ApplyLoad (i->first, 0);
+        }
+    }
+  m_loads.clear ();
+  for (uint32_t l = 0; l < devices.size (); l++)
+    {
+      ApplyLoad (devices[l], load[l]);
+      m_loads[devices[l]] = load[l];
+    }
+}
+
+void
+FluidFlowManager::ApplyLoad (Ptr<PointToPointNetDevice> device, double load)
+{
+  NS_LOG_FUNCTION (this << device << load);
+  DataRateValue capacity;
+  device->GetAttribute ("DataRate", capacity);
+  double rho = load / capacity.Get ().GetBitRate ();
+  // M/D/1 queue: mean number of packets waiting, and mean waiting time
+  double waiting = rho * rho / (2 * (1 - rho));
+  double service = capacity.Get ().CalculateTxTime (m_meanPacketSize);
+  device->SetBackgroundDataRate (DataRate ((uint64_t)(load + 0.5)));
+  device->SetBackgroundDelay (Seconds (rho * service / (2 * (1 - rho))));
+  Ptr<Queue> queue = device->GetQueue ();
+  if (queue != 0)
+    {
+      queue->SetBackgroundOccupancy ((uint32_t)(waiting + 0.5),
+                                     (uint32_t)(waiting * m_meanPacketSize + 0.5));
+    }
+}
+
+DataRate
+FluidFlowManager::GetLoad (Ptr<NetDevice> device) const
+{
+  Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice> (device);
+  LoadMap::const_iterator i = m_loads.find (p2p);
+  if (i == m_loads.end ())
+    {
+      return DataRate (0);
+    }
+  return DataRate ((uint64_t)(i->second + 0.5));
+}
+
+} // namespace ns3
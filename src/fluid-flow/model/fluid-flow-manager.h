@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_FLOW_MANAGER_H
+#define FLUID_FLOW_MANAGER_H
+
+#include <map>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/channel.h"
+#include "ns3/point-to-point-net-device.h"
+#include "fluid-flow.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup fluid-flow
+ * \brief Share the links between fluid flows and load the links accordingly
+ *
+ * The manager recomputes the rates of all its flows when one of them
+ * starts, stops or changes its data rate, and when Update is called (e.g.,
+ * after the routes changed).  The capacity of each point-to-point link,
+ * scaled by the MaxUtilization attribute, is shared between the flows
+ * crossing it, either max-min fairly or, for the TCP-fair sharing, in
+ * proportion to the inverse of the round trip time of each flow.  A
+ * constant bit rate flow never gets more than its data rate.
+ *
+ * The load of each link is then applied to the PointToPointNetDevice
+ * transmitting on it: the device transmits packets at the data rate left
+ * by the fluid flows, and delays them by the mean time they would have
+ * waited behind fluid packets, while its Queue counts the mean number of
+ * fluid packets it would hold against its limits.  Both means are those
+ * of an M/D/1 queue fed with packets of MeanPacketSize bytes.  Links
+ * other than point-to-point ones are crossed but not loaded.
+ */
+class FluidFlowManager : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * How the capacity of a link is shared between the flows crossing it
+   */
+  enum Sharing
+  {
+    MAX_MIN,   /**< Equal shares for all flows */
+    TCP_FAIR,  /**< Shares in inverse proportion to the round trip time */
+  };
+
+  FluidFlowManager ();
+  virtual ~FluidFlowManager ();
+
+  /**
+   * Manage a flow: its rate is computed at its start time, and again
+   * at its stop time.
+   *
+   * \param flow the flow
+   */
+  void AddFlow (Ptr<FluidFlow> flow);
+  /**
+   * \returns the number of flows managed
+   */
+  uint32_t GetNFlows (void) const;
+  /**
+   * \param i the index of the flow
+   * \returns the i-th flow managed
+   */
+  Ptr<FluidFlow> GetFlow (uint32_t i) const;
+
+  /**
+   * Recompute the paths and the rates of all the flows, and load the
+   * links accordingly.
+   */
+  void Update (void);
+
+  /**
+   * \param device a device transmitting on a point-to-point link
+   * \returns the rate of the fluid flows transmitted by the device
+   */
+  DataRate GetLoad (Ptr<NetDevice> device) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Follow the routes from the node of the flow to its destination.
+   *
+   * \param flow the flow
+   * \returns true if the destination is reachable
+   */
+  bool FindPath (Ptr<FluidFlow> flow) const;
+  /**
+   * \param channel a channel
+   * \param address an IPv4 address
+   * \returns the node attached to the channel which owns the address,
+   * or zero
+   */
+  Ptr<Node> FindNode (Ptr<Channel> channel, Ipv4Address address) const;
+  /**
+   * Load the device and its queue with the fluid flows it transmits.
+   *
+   * \param device the device
+   * \param load the rate of the fluid flows, in bit/s
+   */
+  void ApplyLoad (Ptr<PointToPointNetDevice> device, double load);
+
+  typedef std::map<Ptr<PointToPointNetDevice>, double> LoadMap;
+
+  std::vector<Ptr<FluidFlow> > m_flows;
+  LoadMap m_loads;
+  Sharing m_sharing;
+  double m_maxUtilization;
+  uint32_t m_meanPacketSize;
+};
+
+} // namespace ns3
+
+#endif /* FLUID_FLOW_MANAGER_H */
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "fluid-flow.h"
+
+NS_LOG_COMPONENT_DEFINE ("FluidFlow");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FluidFlow)
+  ;
+
+TypeId
+FluidFlow::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidFlow")
+    .SetParent<Object> ()
+    .AddConstructor<FluidFlow> ()
+    .AddAttribute ("DataRate",
+                   "The rate the flow asks for. "
+                   "The value zero means that the flow is elastic.",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&FluidFlow::SetDataRate,
+                                         &FluidFlow::GetDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("StartTime", "Time at which the flow starts.",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&FluidFlow::m_startTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("StopTime",
+                   "Time at which the flow stops. "
+                   "The value zero means that the flow never stops.",
+                   TimeValue (TimeStep (0)),
+                   MakeTimeAccessor (&FluidFlow::m_stopTime),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Rate", "The rate allocated to the flow changed",
+                     MakeTraceSourceAccessor (&FluidFlow::m_rateTrace))
+  ;
+  return tid;
+}
+
+FluidFlow::FluidFlow ()
+  : m_node (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidFlow::~FluidFlow ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FluidFlow::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_node = 0;
+  m_path.clear ();
+  m_dataRateChanged = MakeNullCallback<void> ();
+  Object::DoDispose ();
+}
+
+void
+FluidFlow::SetNode (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  m_node = node;
+}
+
+Ptr<Node>
+FluidFlow::GetNode (void) const
+{
+  return m_node;
+}
+
+void
+FluidFlow::SetDestination (Ipv4Address destination)
+{
+  NS_LOG_FUNCTION (this << destination);
+  m_destination = destination;
+}
+
+Ipv4Address
+FluidFlow::GetDestination (void) const
+{
+  return m_destination;
+}
+
+void
+FluidFlow::SetDataRate (DataRate rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  m_dataRate = rate;
+  if (!m_dataRateChanged.IsNull ())
+    {
+      m_dataRateChanged ();
+    }
+}
+
+DataRate
+FluidFlow::GetDataRate (void) const
+{
+  return m_dataRate;
+}
+
+bool
+FluidFlow::IsElastic (void) const
+{
+  return m_dataRate.GetBitRate () == 0;
+}
+
+Time
+FluidFlow::GetStartTime (void) const
+{
+  return m_startTime;
+}
+
+Time
+FluidFlow::GetStopTime (void) const
+{
+  return m_stopTime;
+}
+
+bool
+FluidFlow::IsActive (void) const
+{
+  Time now = Simulator::Now ();
+  return now >= m_startTime && (m_stopTime.IsZero () || now < m_stopTime);
+}
+
+DataRate
+FluidFlow::GetRate (void) const
+{
+  return m_rate;
+}
+
+const std::vector<Ptr<NetDevice> > &
+FluidFlow::GetPath (void) const
+{
+  return m_path;
+}
+
+Time
+FluidFlow::GetRoundTripTime (void) const
+{
+  return m_rtt;
+}
+
+void
+FluidFlow::SetRate (DataRate rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  if (rate != m_rate)
+    {
+      m_rate = rate;
+      m_rateTrace (rate);
+    }
+}
+
+void
+FluidFlow::SetDataRateChangedCallback (Callback<void> callback)
+{
+  m_dataRateChanged = callback;
+}
+
+} // namespace ns3
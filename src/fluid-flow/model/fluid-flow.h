@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_FLOW_H
+#define FLUID_FLOW_H
+
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/node.h"
+#include "ns3/net-device.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \defgroup fluid-flow Fluid flows
+ *
+ * Background traffic modelled as rates rather than as packets.
+ */
+
+/**
+ * \ingroup fluid-flow
+ * \brief A background flow modelled as a rate rather than as packets
+ *
+ * A fluid flow goes from a node to an IPv4 destination, along the path
+ * chosen by the routing protocols of the nodes (e.g., Ipv4GlobalRouting).
+ * It is either constant bit rate, when its DataRate attribute is not zero,
+ * or elastic (a long-lived TCP transfer), taking whatever share of the
+ * path the FluidFlowManager gives it.  The rate actually allocated to the
+ * flow is recomputed by the manager when flows start, stop or change
+ * their data rate.
+ */
+class FluidFlow : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FluidFlow ();
+  virtual ~FluidFlow ();
+
+  /**
+   * \param node the node the flow originates from
+   */
+  void SetNode (Ptr<Node> node);
+  /**
+   * \returns the node the flow originates from
+   */
+  Ptr<Node> GetNode (void) const;
+  /**
+   * \param destination the IPv4 address the flow is sent to
+   */
+  void SetDestination (Ipv4Address destination);
+  /**
+   * \returns the IPv4 address the flow is sent to
+   */
+  Ipv4Address GetDestination (void) const;
+
+  /**
+   * Change the rate the flow asks for.  If the flow is already managed,
+   * the rates of all the flows are recomputed.
+   *
+   * \param rate the rate asked for, or zero for an elastic flow
+   */
+  void SetDataRate (DataRate rate);
+  /**
+   * \returns the rate the flow asks for, zero for an elastic flow
+   */
+  DataRate GetDataRate (void) const;
+  /**
+   * \returns true if the flow takes any rate it is given
+   */
+  bool IsElastic (void) const;
+
+  /**
+   * \returns the time at which the flow starts
+   */
+  Time GetStartTime (void) const;
+  /**
+   * \returns the time at which the flow stops, zero if it never stops
+   */
+  Time GetStopTime (void) const;
+  /**
+   * \returns true if the flow is started and not yet stopped
+   */
+  bool IsActive (void) const;
+
+  /**
+   * \returns the rate allocated to the flow by its manager
+   */
+  DataRate GetRate (void) const;
+  /**
+   * \returns the devices the flow goes through, as of the last rate
+   * computation
+   */
+  const std::vector<Ptr<NetDevice> > & GetPath (void) const;
+  /**
+   * \returns the round trip propagation delay of the path, as of the
+   * last rate computation
+   */
+  Time GetRoundTripTime (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  friend class FluidFlowManager;
+
+  /**
+   * Record the rate allocated by the manager
+   * \param rate the rate allocated
+   */
+  void SetRate (DataRate rate);
+  /**
+   * \param callback invoked when the rate asked for changes
+   */
+  void SetDataRateChangedCallback (Callback<void> callback);
+
+  Ptr<Node> m_node;
+  Ipv4Address m_destination;
+  DataRate m_dataRate;
+  Time m_startTime;
+  Time m_stopTime;
+  DataRate m_rate;
+  std::vector<Ptr<NetDevice> > m_path;
+  Time m_rtt;
+  Callback<void> m_dataRateChanged;
+  TracedCallback<DataRate> m_rateTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLUID_FLOW_H */
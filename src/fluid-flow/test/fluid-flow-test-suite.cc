@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/fluid-flow-helper.h"
+
+namespace ns3 {
+
+/**
+ * Max-min sharing along a line A - B - C, as flows start, stop and change
+ * their data rate
+ */
+class FluidFlowMaxMinTestCase : public TestCase
+{
+public:
+  FluidFlowMaxMinTestCase ();
+private:
+  virtual void DoRun (void);
+  void Check (double f1, double f2, double f3, double loadAb, double loadBc);
+  Ptr<FluidFlow> m_flow[3];
+  Ptr<FluidFlowManager> m_manager;
+  Ptr<PointToPointNetDevice> m_ab;
+  Ptr<PointToPointNetDevice> m_bc;
+};
+
+FluidFlowMaxMinTestCase::FluidFlowMaxMinTestCase ()
+  : TestCase ("Max-min sharing of a line")
+{
+}
+
+void
+FluidFlowMaxMinTestCase::Check (double f1, double f2, double f3, double loadAb, double loadBc)
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_flow[0]->GetRate ().GetBitRate (), f1, 1, "Wrong rate of A -> C at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_flow[1]->GetRate ().GetBitRate (), f2, 1, "Wrong rate of B -> C at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_flow[2]->GetRate ().GetBitRate (), f3, 1, "Wrong rate of A -> B at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_manager->GetLoad (m_ab).GetBitRate (), loadAb, 1, "Wrong load of A - B");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_manager->GetLoad (m_bc).GetBitRate (), loadBc, 1, "Wrong load of B - C");
+  NS_TEST_EXPECT_MSG_EQ (m_ab->GetBackgroundDataRate (), m_manager->GetLoad (m_ab), "Load of A - B not applied");
+  NS_TEST_EXPECT_MSG_EQ (m_bc->GetBackgroundDataRate (), m_manager->GetLoad (m_bc), "Load of B - C not applied");
+}
+
+void
+FluidFlowMaxMinTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer ab = p2p.Install (nodes.Get (0), nodes.Get (1));
+  NetDeviceContainer bc = p2p.Install (nodes.Get (1), nodes.Get (2));
+  m_ab = DynamicCast<PointToPointNetDevice> (ab.Get (0));
+  m_bc = DynamicCast<PointToPointNetDevice> (bc.Get (0));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer abInterfaces = address.Assign (ab);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer bcInterfaces = address.Assign (bc);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  FluidFlowHelper fluid;
+  fluid.SetManagerAttribute ("MaxUtilization", DoubleValue (0.5));
+  fluid.SetManagerAttribute ("MeanPacketSize", UintegerValue (1000));
+  m_manager = fluid.GetManager ();
+  m_flow[0] = fluid.Install (nodes.Get (0), bcInterfaces.GetAddress (1));
+  m_flow[1] = fluid.Install (nodes.Get (1), bcInterfaces.GetAddress (1));
+  fluid.SetFlowAttribute ("DataRate", StringValue ("2Mbps"));
+  fluid.SetFlowAttribute ("StopTime", TimeValue (Seconds (4)));
+  m_flow[2] = fluid.Install (nodes.Get (0), abInterfaces.GetAddress (1));
+
+  // B - C is the bottleneck of the elastic flows, A -> B gets its demand
+  Simulator::Schedule (Seconds (1), &FluidFlowMaxMinTestCase::Check, this, 2.5e6, 2.5e6, 2e6, 4.5e6, 5e6);
+  // B -> C asks for less than its share, A -> C gets the rest of B - C
+  Simulator::Schedule (Seconds (2), &FluidFlow::SetDataRate, m_flow[1], DataRate ("1Mbps"));
+  Simulator::Schedule (Seconds (3), &FluidFlowMaxMinTestCase::Check, this, 3e6, 1e6, 2e6, 5e6, 4e6);
+  // A -> B stops
+  Simulator::Schedule (Seconds (5), &FluidFlowMaxMinTestCase::Check, this, 4e6, 1e6, 0, 4e6, 5e6);
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_flow[0]->GetPath ().size (), 2, "A -> C should cross two links");
+  NS_TEST_EXPECT_MSG_EQ (m_flow[0]->GetPath ()[1], m_bc, "A -> C should cross B - C");
+
+  // B - C is loaded at half its capacity: an M/D/1 queue holds 0.25 packets
+  // on average, and packets wait for 0.5 packet transmissions
+  NS_TEST_EXPECT_MSG_EQ (m_bc->GetQueue ()->GetBackgroundBytes (), 250, "Wrong background occupancy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_bc->GetBackgroundDelay ().GetSeconds (), 400e-6, 1e-9, "Wrong background delay");
+
+  m_flow[0] = m_flow[1] = m_flow[2] = 0;
+  m_manager = 0;
+  m_ab = m_bc = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * TCP-fair sharing of a bottleneck by flows with different round trip times
+ */
+class FluidFlowTcpFairTestCase : public TestCase
+{
+public:
+  FluidFlowTcpFairTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FluidFlowTcpFairTestCase::FluidFlowTcpFairTestCase ()
+  : TestCase ("TCP-fair sharing of a bottleneck")
+{
+}
+
+void
+FluidFlowTcpFairTestCase::DoRun (void)
+{
+  // A and B are connected to C through R
+  NodeContainer nodes;
+  nodes.Create (4);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer ar = p2p.Install (nodes.Get (0), nodes.Get (3));
+  NetDeviceContainer rc = p2p.Install (nodes.Get (3), nodes.Get (2));
+  p2p.SetChannelAttribute ("Delay", StringValue ("9ms"));
+  NetDeviceContainer br = p2p.Install (nodes.Get (1), nodes.Get (3));
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (ar);
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  address.Assign (br);
+  address.SetBase ("10.1.3.0", "255.255.255.0");
+  Ipv4InterfaceContainer rcInterfaces = address.Assign (rc);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  FluidFlowHelper fluid;
+  fluid.SetManagerAttribute ("Sharing", EnumValue (FluidFlowManager::TCP_FAIR));
+  Ptr<FluidFlow> a = fluid.Install (nodes.Get (0), rcInterfaces.GetAddress (1));
+  Ptr<FluidFlow> b = fluid.Install (nodes.Get (1), rcInterfaces.GetAddress (1));
+  Simulator::Run ();
+
+  // Round trip times of 2 * (2 + 2 * 0.08) ms and 2 * (10 + 2 * 0.08) ms
+  NS_TEST_EXPECT_MSG_EQ_TOL (a->GetRoundTripTime ().GetSeconds (), 4320e-6, 1e-8, "Wrong round trip time of A -> C");
+  NS_TEST_EXPECT_MSG_EQ_TOL (b->GetRoundTripTime ().GetSeconds (), 20320e-6, 1e-8, "Wrong round trip time of B -> C");
+  double rateA = a->GetRate ().GetBitRate ();
+  double rateB = b->GetRate ().GetBitRate ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (rateA + rateB, 90e6, 2, "R - C should be full");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rateA / rateB, 20320.0 / 4320.0, 1e-4, "Rates should be inversely proportional to the round trip times");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Packets see the background load of the queue and of the device
+ */
+class FluidFlowPacketTestCase : public TestCase
+{
+public:
+  FluidFlowPacketTestCase ();
+private:
+  virtual void DoRun (void);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  Time m_received;
+};
+
+FluidFlowPacketTestCase::FluidFlowPacketTestCase ()
+  : TestCase ("Packets through a loaded queue and device")
+{
+}
+
+bool
+FluidFlowPacketTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_received = Simulator::Now ();
+  return true;
+}
+
+void
+FluidFlowPacketTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (5));
+  queue->SetBackgroundOccupancy (3, 3000);
+  uint32_t accepted = 0;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      accepted += queue->Enqueue (Create<Packet> (100));
+    }
+  NS_TEST_EXPECT_MSG_EQ (accepted, 2, "Background packets should fill the queue");
+
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  devA->SetDataRate (DataRate ("10Mbps"));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&FluidFlowPacketTestCase::Receive, this));
+
+  // Half of the link is used by the background traffic: 998 + 2 bytes
+  // are transmitted in 1.6 ms, then wait 2 ms more
+  devA->SetBackgroundDataRate (DataRate ("5Mbps"));
+  devA->SetBackgroundDelay (MilliSeconds (2));
+  Simulator::Schedule (Seconds (1), &PointToPointNetDevice::Send, devA,
+                       Create<Packet> (998), devA->GetBroadcast (), 0x800);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_received, Seconds (1) + MicroSeconds (1600) + MilliSeconds (2) + MilliSeconds (1),
+                         "Wrong reception time");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Fluid flow test suite
+ */
+class FluidFlowTestSuite : public TestSuite
+{
+public:
+  FluidFlowTestSuite ();
+};
+
+FluidFlowTestSuite::FluidFlowTestSuite ()
+  : TestSuite ("fluid-flow", UNIT)
+{
+  AddTestCase (new FluidFlowMaxMinTestCase, QUICK);
+  AddTestCase (new FluidFlowTcpFairTestCase, QUICK);
+  AddTestCase (new FluidFlowPacketTestCase, QUICK);
+}
+
+static FluidFlowTestSuite g_fluidFlowTestSuite;
+
+} // namespace ns3
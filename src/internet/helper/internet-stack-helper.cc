@@ -157,7 +157,10 @@
 #include "ns3/packet-socket-factory.h"
 #include "ns3/config.h"
 #include "ns3/simulator.h"
-#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/icmpv4-l4-protocol.h"
+#include "ns3/udp-l4-protocol.h"
 #include "ns3/net-device.h"
 #include "ns3/callback.h"
 #include "ns3/node.h"
@@ -398,9 +401,11 @@ InternetStackHelper::SetTcp (std::string tid, std::string n0, const AttributeVal
 void 
 InternetStackHelper::Install (NodeContainer c) const
 {
+  Factories factories;
+  InitializeFactories (factories);
   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
     {
-      Install (*i);
+      Install (*i, factories);
     }
 }
 
@@ -411,16 +416,26 @@ InternetStackHelper::InstallAll (void) const
 }
 
 void
-InternetStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId)
+InternetStackHelper::InitializeFactories (Factories &factories) const
 {
-  ObjectFactory factory;
-  factory.SetTypeId (typeId);
-  Ptr<Object> protocol = factory.Create <Object> ();
-  node->AggregateObject (protocol);
+  factories.arp.SetTypeId (ArpL3Protocol::GetTypeId ());
+  factories.ipv4.SetTypeId (Ipv4L3Protocol::GetTypeId ());
+  factories.icmpv4.SetTypeId (Icmpv4L4Protocol::GetTypeId ());
+  factories.ipv6.SetTypeId (Ipv6L3Protocol::GetTypeId ());
+  factories.icmpv6.SetTypeId (Icmpv6L4Protocol::GetTypeId ());
+  factories.udp.SetTypeId (UdpL4Protocol::GetTypeId ());
 }
 
 void
 InternetStackHelper::Install (Ptr<Node> node) const
+{
+  Factories factories;
+  InitializeFactories (factories);
+  Install (node, factories);
+}
+
+void
+InternetStackHelper::Install (Ptr<Node> node, const Factories &factories) const
 {
   if (m_ipv4Enabled)
     {
@@ -431,17 +446,19 @@ InternetStackHelper::Install (Ptr<Node> node) const
           return;
         }
 
-      CreateAndAggregateObjectFromTypeId (node, "ns3::ArpL3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv4L3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv4L4Protocol");
+      Ptr<ArpL3Protocol> arp = factories.arp.Create<ArpL3Protocol> ();
+      node->AggregateObject (arp);
+      Ptr<Ipv4> ipv4 = factories.ipv4.Create<Ipv4> ();
+      node->AggregateObject (ipv4);
+      node->AggregateObject (factories.icmpv4.Create<Object> ());
       if (m_ipv4ArpJitterEnabled == false)
         {
-          Ptr<ArpL3Protocol> arp = node->GetObject<ArpL3Protocol> ();
-          NS_ASSERT (arp);
-          arp->SetAttribute ("RequestJitter", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
+          // Each node still creates its own variables, in the same order
+          // as before, so that the automatically assigned stream indices
+          // of the later random variables do not change
+          arp->SetAttribute ("RequestJitter", PointerValue (CreateObject<ConstantRandomVariable> ()));
         }
       // Set routing
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
       Ptr<Ipv4RoutingProtocol> ipv4Routing = m_routing->Create (node);
       ipv4->SetRoutingProtocol (ipv4Routing);
     }
@@ -456,16 +473,15 @@ InternetStackHelper::Install (Ptr<Node> node) const
           return;
         }
 
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv6L3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv6L4Protocol");
+      Ptr<Ipv6> ipv6 = factories.ipv6.Create<Ipv6> ();
+      node->AggregateObject (ipv6);
+      Ptr<Icmpv6L4Protocol> icmpv6 = factories.icmpv6.Create<Icmpv6L4Protocol> ();
+      node->AggregateObject (icmpv6);
       if (m_ipv6NsRsJitterEnabled == false)
         {
-          Ptr<Icmpv6L4Protocol> icmpv6l4 = node->GetObject<Icmpv6L4Protocol> ();
-          NS_ASSERT (icmpv6l4);
-          icmpv6l4->SetAttribute ("SolicitationJitter", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
+          icmpv6->SetAttribute ("SolicitationJitter", PointerValue (CreateObject<ConstantRandomVariable> ()));
         }
       // Set routing
-      Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
       Ptr<Ipv6RoutingProtocol> ipv6Routing = m_routingv6->Create (node);
       ipv6->SetRoutingProtocol (ipv6Routing);
 
@@ -476,7 +492,7 @@ InternetStackHelper::Install (Ptr<Node> node) const
 
   if (m_ipv4Enabled || m_ipv6Enabled)
     {
-      CreateAndAggregateObjectFromTypeId (node, "ns3::UdpL4Protocol");
+      node->AggregateObject (factories.udp.Create<Object> ());
       node->AggregateObject (m_tcpFactory.Create<Object> ());
       Ptr<PacketSocketFactory> factory = CreateObject<PacketSocketFactory> ();
       node->AggregateObject (factory);
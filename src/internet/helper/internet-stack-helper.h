@@ -299,12 +299,33 @@ private:
 
   /**
    * \internal
-   *
-   * \brief create an object from its TypeId and aggregates it to the node
+   * \brief The factories of the protocols aggregated to each node,
+   * resolved once per call to Install
+   */
+  struct Factories
+  {
+    ObjectFactory arp;    //!< ArpL3Protocol factory
+    ObjectFactory ipv4;   //!< Ipv4L3Protocol factory
+    ObjectFactory icmpv4; //!< Icmpv4L4Protocol factory
+    ObjectFactory ipv6;   //!< Ipv6L3Protocol factory
+    ObjectFactory icmpv6; //!< Icmpv6L4Protocol factory
+    ObjectFactory udp;    //!< UdpL4Protocol factory
+  };
+
+  /**
+   * \internal
+   * \brief Resolve the protocol factories and their attributes.
+   * \param factories the factories to set up
+   */
+  void InitializeFactories (Factories &factories) const;
+
+  /**
+   * \internal
+   * \brief Aggregate the stack to a node.
    * \param node the node
-   * \param typeId the object TypeId
+   * \param factories the factories set up by InitializeFactories
    */
-  static void CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId);
+  void Install (Ptr<Node> node, const Factories &factories) const;
 
   /**
    * \internal
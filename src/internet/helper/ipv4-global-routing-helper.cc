@@ -70,6 +70,11 @@ Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
   GlobalRouteManager::BuildGlobalRoutingDatabase ();
   GlobalRouteManager::InitializeRoutes ();
 }
+void 
+Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally (void)
+{
+  GlobalRouteManager::UpdateRoutes ();
+}
 
 
 } // namespace ns3
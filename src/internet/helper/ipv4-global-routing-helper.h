@@ -83,6 +83,20 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Update the routes installed by PopulateRoutingTables(),
+   * RecomputeRoutingTables() or a prior call to this method after a
+   * change of the topology.
+   *
+   * The result is the same as that of RecomputeRoutingTables(), but the
+   * shortest path trees are only recomputed for the routers which may be
+   * affected by the links that changed; the other routers only have their
+   * routes to the changed destinations replaced.  The first call performs
+   * a full computation, keeping the summary of each tree needed by the
+   * next calls.  Routes replaced this way move to the end of the routing
+   * tables, which only matters between overlapping network routes.
+   */
+  static void RecomputeRoutingTablesIncrementally (void);
 private:
   /**
    * \internal
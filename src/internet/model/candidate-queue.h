@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -43,8 +44,11 @@ class SPFVertex;
  *
  * Although a STL priority_queue almost does what we want, the requirement
  * for a Find () operation, the dynamic nature of the data and the derived
- * requirement for a Reorder () operation led us to implement this simple 
- * enhanced priority queue.
+ * requirement for a DecreaseKey () operation led us to implement this
+ * enhanced priority queue: a binary heap, with an index from vertex ID to
+ * heap position.  Vertices at the same distance are popped network
+ * vertices first, then in the order they were pushed (or last had their
+ * distance decreased), just as if the queue were kept sorted.
  */
 class CandidateQueue
 {
@@ -146,6 +150,19 @@ public:
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Move a vertex of the Candidate Queue up after its distance was
+ * decreased.
+ * @internal
+ *
+ * The vertex is then popped after the vertices already at its new
+ * distance, as if it had just been pushed.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, which must be in the queue.
+ */
+  void DecreaseKey (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * @internal
@@ -192,8 +209,49 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+/**
+ * \brief A vertex in the heap, with the order in which it was pushed.
+ */
+  struct Candidate
+  {
+    SPFVertex *m_vertex;  //!< the vertex
+    uint64_t m_order;     //!< order of the last Push or DecreaseKey
+  };
+
+/**
+ * \brief return true if c1 should be popped before c2
+ *
+ * CompareSPFVertex, with ties broken by m_order.
+ *
+ * \param c1 first operand
+ * \param c2 second operand
+ * \return True if c1 should be popped before c2; false otherwise
+ */
+  static bool CompareCandidate (const Candidate &c1, const Candidate &c2);
+
+/**
+ * \brief Move the candidate at index i up the heap to its place.
+ * \param i index of the candidate in m_candidates
+ */
+  void SiftUp (uint32_t i);
+
+/**
+ * \brief Move the candidate at index i down the heap to its place.
+ * \param i index of the candidate in m_candidates
+ */
+  void SiftDown (uint32_t i);
+
+/**
+ * \brief Store a candidate at index i and record its position.
+ * \param i index in m_candidates
+ * \param c the candidate
+ */
+  void Place (uint32_t i, const Candidate &c);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< heap of SPFVertex candidates
   CandidateList_t m_candidates;  //!< SPFVertex candidates
+  std::map<Ipv4Address, uint32_t> m_index; //!< vertex ID to index in m_candidates
+  uint64_t m_nextOrder; //!< order of the next Push or DecreaseKey
 
   /**
    * \brief Stream insertion operator.
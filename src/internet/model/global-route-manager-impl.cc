@@ -26,7 +26,9 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
+#include <set>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -35,6 +37,14 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -423,6 +433,7 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
+    m_linkData (),
     m_extdatabase ()
 {
   NS_LOG_FUNCTION (this);
@@ -446,6 +457,7 @@ GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
     }
   NS_LOG_LOGIC ("clear map");
   m_database.clear ();
+  m_linkData.clear ();
 }
 
 void
@@ -468,9 +480,25 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the transit network records, for GetLSAByLinkData.  Should several
+// LSAs have the same link data, the one with the lowest ID is found.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::pair<LSDBMap_t::iterator, bool> k = m_linkData.insert (LSDBPair_t (lr->GetLinkData (), lsa));
+          if (!k.second && addr < k.first->second->GetLinkStateId ())
+            {
+              k.first->second = lsa;
+            }
+        }
     }
 }
 
@@ -488,6 +516,16 @@ GlobalRouteManagerLSDB::GetNumExtLSAs () const
   return m_extdatabase.size ();
 }
 
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
+    }
+}
+
 GlobalRoutingLSA*
 GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 {
@@ -495,13 +533,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,24 +546,14 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the address of one of its transit network links.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_linkData.find (addr);
+  if (i == m_linkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return 0;
     }
-  return 0;
+  return i->second;
 }
 
 // ---------------------------------------------------------------------------
@@ -537,18 +562,47 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // ---------------------------------------------------------------------------
 
+static GlobalValue g_spfThreads ("GlobalRoutingSpfThreads",
+                                 "The number of threads running the SPF calculations of the routers "
+                                 "in parallel, when global routing tables are built.",
+                                 UintegerValue (1),
+                                 MakeUintegerChecker<uint32_t> (1));
+
+static GlobalValue g_sharedTables ("GlobalRoutingSharedTables",
+                                   "Store the global routes as next hop groups per destination of a "
+                                   "table shared by all the nodes, rather than as one routing table "
+                                   "entry per route.",
+                                   BooleanValue (false),
+                                   MakeBooleanChecker ());
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_ownsLsdb (true),
+    m_root (0),
+    m_jobs (0),
+    m_keepSummaries (false)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb)
+  :
+    m_spfroot (0),
+    m_lsdb (lsdb),
+    m_ownsLsdb (false),
+    m_root (0),
+    m_jobs (0),
+    m_keepSummaries (false)
+{
+  NS_LOG_FUNCTION (this << lsdb);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
@@ -558,11 +612,30 @@ void
 GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
 {
   NS_LOG_FUNCTION (this << lsdb);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
   m_lsdb = lsdb;
+  m_ownsLsdb = true;
+}
+
+static void
+DeleteRoutes (Ptr<Ipv4GlobalRouting> gr, uint32_t nodeId)
+{
+  gr->ClearSharedRoutes ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << nodeId);
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << nodeId);
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< nodeId);
 }
 
 void
@@ -578,20 +651,9 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (router->GetRoutingProtocol (), node->GetId ());
     }
+  m_summaries.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -696,10 +758,28 @@ void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<SPFRoot> roots = FindSPFRoots ();
+  m_summaries.clear ();
+  if (m_keepSummaries)
+    {
+      for (std::vector<SPFRoot>::iterator i = roots.begin (); i != roots.end (); i++)
+        {
+          i->m_summary = &m_summaries[i->m_routerId];
+        }
+    }
+  SPFCalculateAll (roots);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+std::vector<GlobalRouteManagerImpl::SPFRoot>
+GlobalRouteManagerImpl::FindSPFRoots (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<SPFRoot> roots;
 //
 // Walk the list of nodes in the system.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -723,144 +803,1101 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          SPFRoot root;
+          root.m_routerId = rtr->GetRouterId ();
+          root.m_nodeId = node->GetId ();
+          root.m_ipv4 = node->GetObject<Ipv4> ();
+          NS_ASSERT_MSG (root.m_ipv4, 
+                         "GlobalRouteManagerImpl::FindSPFRoots (): "
+                         "GetObject for <Ipv4> interface failed");
+          root.m_routing = rtr->GetRoutingProtocol ();
+          NS_ASSERT (root.m_routing);
+          root.m_summary = 0;
+          root.m_prefixes = 0;
+          root.m_haveNodes = true;
+          roots.push_back (root);
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  return roots;
 }
 
-//
-// This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
-// 16.1 (2) for further details.
-//
-// We're passed a parameter <v> that is a vertex which is already in the SPF
-// tree.  A vertex represents a router node.  We also get a reference to the
-// SPF candidate queue, which is a priority queue containing the shortest paths
-// to the networks we know about.
-//
-// We examine the links in v's LSA and update the list of candidates with any
-// vertices not already on the list.  If a lower-cost path is found to a
-// vertex already on the candidate list, store the new (lower) cost.
-//
 void
-GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
+GlobalRouteManagerImpl::SPFCalculateAll (const std::vector<SPFRoot> &roots)
 {
-  NS_LOG_FUNCTION (this << v << &candidate);
-
-  SPFVertex* w = 0;
-  GlobalRoutingLSA* w_lsa = 0;
-  GlobalRoutingLinkRecord *l = 0;
-  uint32_t distance = 0;
-  uint32_t numRecordsInVertex = 0;
+  NS_LOG_FUNCTION (this << roots.size ());
 //
-// V points to a Router-LSA or Network-LSA
-// Loop over the links in router LSA or attached routers in Network LSA
+// With shared tables, the destinations are numbered once for all the
+// roots, and the routing tables made ready before the threads start (the
+// reference counts of the table are not thread-safe).
 //
-  if (v->GetVertexType () == SPFVertex::VertexRouter)
+  std::vector<SPFRoot> calculations (roots);
+  BooleanValue sharedTables;
+  g_sharedTables.GetValue (sharedTables);
+  Ptr<GlobalRoutePrefixes> prefixes;
+  if (sharedTables.Get ())
     {
-      numRecordsInVertex = v->GetLSA ()->GetNLinkRecords (); 
+      prefixes = BuildSharedPrefixes ();
+      NS_LOG_INFO (prefixes->GetN () << " destinations in the shared tables");
+      for (std::vector<SPFRoot>::iterator i = calculations.begin (); i != calculations.end (); i++)
+        {
+          if (i->m_routing)
+            {
+              i->m_prefixes = PeekPointer (prefixes);
+              i->m_routing->BeginSharedRoutes (prefixes);
+            }
+        }
     }
-  if (v->GetVertexType () == SPFVertex::VertexNetwork)
+//
+// The calculations of different roots share nothing but the LSDB, which they
+// only read, and each one only writes to the routing table (and summary) of
+// its own root.  So they may run in parallel, as long as the node list is not
+// walked (the roots were looked up beforehand) and no object is shared
+// between them.
+//
+  UintegerValue nThreads;
+  g_spfThreads.GetValue (nThreads);
+  uint32_t nWorkers = std::min<uint32_t> (nThreads.Get (), roots.size ());
+#ifdef HAVE_PTHREAD_H
+  if (nWorkers > 1)
     {
-      numRecordsInVertex = v->GetLSA ()->GetNAttachedRouters (); 
+      NS_LOG_INFO ("Running SPF calculations on " << nWorkers << " threads");
+      SystemMutex mutex;
+      SPFJobs jobs;
+      jobs.m_roots = calculations;
+      jobs.m_next = 0;
+      jobs.m_mutex = &mutex;
+      std::vector<GlobalRouteManagerImpl *> workers;
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t i = 0; i < nWorkers; i++)
+        {
+          GlobalRouteManagerImpl *worker = new GlobalRouteManagerImpl (m_lsdb);
+          worker->m_jobs = &jobs;
+          workers.push_back (worker);
+          threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFWorker, worker)));
+          threads.back ()->Start ();
+        }
+      for (uint32_t i = 0; i < nWorkers; i++)
+        {
+          threads[i]->Join ();
+          delete workers[i];
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  (void) nWorkers;
+  for (std::vector<SPFRoot>::const_iterator i = calculations.begin (); i != calculations.end (); i++)
+    {
+      SPFCalculate (*i);
     }
+}
 
-  for (uint32_t i = 0; i < numRecordsInVertex; i++)
+void
+GlobalRouteManagerImpl::SPFWorker (void)
+{
+#ifdef HAVE_PTHREAD_H
+  for (;;)
     {
-// Get w_lsa:  In case of V is Router-LSA
-      if (v->GetVertexType () == SPFVertex::VertexRouter) 
+      uint32_t next;
+      {
+        CriticalSection cs (*m_jobs->m_mutex);
+        next = m_jobs->m_next++;
+      }
+      if (next >= m_jobs->m_roots.size ())
         {
-          NS_LOG_LOGIC ("Examining link " << i << " of " << 
-                        v->GetVertexId () << "'s " <<
-                        v->GetLSA ()->GetNLinkRecords () << " link records");
+          return;
+        }
+      SPFCalculate (m_jobs->m_roots[next]);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+GlobalRouteManagerImpl::SPFRoot
+GlobalRouteManagerImpl::FindSPFRoot (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+  SPFRoot root;
+  root.m_routerId = routerId;
+  root.m_nodeId = 0;
+  root.m_summary = 0;
+  root.m_prefixes = 0;
+  root.m_haveNodes = NodeList::GetNNodes () > 0;
+//
+// Walk the list of nodes looking for the one that has the router ID
+// corresponding to the root vertex.  This is the one we're going to write
+// the routing information to.
 //
-// (a) If this is a link to a stub network, examine the next link in V's LSA.
-// Links to stub networks will be considered in the second stage of the
-// shortest path calculation.
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
 //
-          l = v->GetLSA ()->GetLinkRecord (i);
-          NS_ASSERT (l != 0);
-          if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
-            {
-              NS_LOG_LOGIC ("Found a Stub record to " << l->GetLinkId ());
-              continue;
-            }
+// The router ID is accessible through the GlobalRouter interface, so we need
+// to GetObject for that interface.  If there's no GlobalRouter interface, 
+// the node in question cannot be the router we want, so we continue.
+// 
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
+          continue;
+        }
+      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
+      if (rtr->GetRouterId () == routerId)
+        {
 //
-// (b) Otherwise, W is a transit vertex (router or transit network).  Look up
-// the vertex W's LSA (router-LSA or network-LSA) in Area A's link state
-// database. 
+// Routing information is updated using the Ipv4 interface.  We need to 
+// GetObject for that interface.  If the node is acting as an IP version 4 
+// router, it should absolutely have an Ipv4 interface.
 //
-          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
-            {
+          root.m_nodeId = node->GetId ();
+          root.m_ipv4 = node->GetObject<Ipv4> ();
+          NS_ASSERT_MSG (root.m_ipv4, 
+                         "GlobalRouteManagerImpl::FindSPFRoot (): "
+                         "GetObject for <Ipv4> interface failed");
+          root.m_routing = rtr->GetRoutingProtocol ();
+          NS_ASSERT (root.m_routing);
+          return root;
+        }
+    }
+  NS_LOG_LOGIC ("FindSPFRoot():Can't find root node " << routerId);
+  return root;
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetSPFStatus (GlobalRoutingLSA* lsa) const
+{
+  std::map<GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus>::const_iterator i = m_spfStatus.find (lsa);
+  if (i == m_spfStatus.end ())
+    {
+      return GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED;
+    }
+  return i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetSPFStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_spfStatus[lsa] = status;
+}
+
+GlobalRouteManagerImpl::SPFSummary::SPFSummary ()
+  : m_valid (false),
+    m_stub (false)
+{
+}
+
+const GlobalRouteManagerImpl::SPFSummary::Reached*
+GlobalRouteManagerImpl::SPFSummary::Find (Ipv4Address vertexId) const
+{
+  Reached key;
+  key.m_vertexId = vertexId;
+  std::vector<Reached>::const_iterator i = std::lower_bound (m_reached.begin (), m_reached.end (), key);
+  if (i == m_reached.end () || i->m_vertexId != vertexId)
+    {
+      return 0;
+    }
+  return &*i;
+}
+
+GlobalRouteManagerImpl::LSDBChanges::Edge::Edge (Ipv4Address from, Ipv4Address to, uint32_t cost)
+  : m_from (from),
+    m_to (to),
+    m_cost (cost)
+{
+}
+
+bool
+GlobalRouteManagerImpl::LSDBChanges::Edge::operator< (const Edge &o) const
+{
+  if (m_from != o.m_from)
+    {
+      return m_from < o.m_from;
+    }
+  if (m_to != o.m_to)
+    {
+      return m_to < o.m_to;
+    }
+  return m_cost < o.m_cost;
+}
+
+bool
+GlobalRouteManagerImpl::LSDBChanges::Edge::operator== (const Edge &o) const
+{
+  return m_from == o.m_from && m_to == o.m_to && m_cost == o.m_cost;
+}
+
 //
-// Lookup the link state advertisement of the new link -- we call it <w> in
-// the link state database.
+// Number the vertices of a shortest path tree in the order SPFProcessStubs ()
+// visits them.
 //
-              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
-              NS_ASSERT (w_lsa);
-              NS_LOG_LOGIC ("Found a P2P record from " << 
-                            v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
-            }
-          else if (l->GetLinkType () == 
-                   GlobalRoutingLinkRecord::TransitNetwork)
-            {
-              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
-              NS_ASSERT (w_lsa);
-              NS_LOG_LOGIC ("Found a Transit record from " << 
-                            v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
-            }
-          else 
-            {
-              NS_ASSERT_MSG (0, "illegal Link Type");
-            }
-        }
-// Get w_lsa:  In case of V is Network-LSA
-      if (v->GetVertexType () == SPFVertex::VertexNetwork) 
+static void
+RankVertices (SPFVertex* v, std::map<SPFVertex*, uint32_t> &ranks)
+{
+  uint32_t rank = ranks.size ();
+  ranks[v] = rank;
+  for (uint32_t i = 0; i < v->GetNChildren (); i++)
+    {
+      if (ranks.find (v->GetChild (i)) == ranks.end ())
         {
-          w_lsa = m_lsdb->GetLSAByLinkData 
-              (v->GetLSA ()->GetAttachedRouter (i));
-          if (!w_lsa)
-            {
-              continue;
-            }
-          NS_LOG_LOGIC ("Found a Network LSA from " << 
-                        v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
+          RankVertices (v->GetChild (i), ranks);
         }
+    }
+}
 
-// Note:  w_lsa at this point may be either RouterLSA or NetworkLSA
-//
-// (c) If vertex W is already on the shortest-path tree, examine the next
-// link in the LSA.
+void
+GlobalRouteManagerImpl::SPFRecordSummary (const std::vector<SPFVertex*> &added, bool stub)
+{
+  NS_LOG_FUNCTION (this << added.size () << stub);
+  SPFSummary &summary = *m_root->m_summary;
+  summary.m_valid = true;
+  summary.m_stub = stub;
+  summary.m_reached.clear ();
+  summary.m_exits.clear ();
+  summary.m_exits.push_back (std::vector<SPFVertex::NodeExit_t> ());
+
+  SPFSummary::Reached reached;
+  reached.m_vertexId = m_spfroot->GetVertexId ();
+  reached.m_distance = 0;
+  reached.m_order = 0;
+  reached.m_rank = 0;
+  reached.m_exits = 0;
+  summary.m_reached.push_back (reached);
+  if (stub)
+    {
 //
-// If the link is to a router that is already in the shortest path first tree
-// then we have it covered -- ignore it.
+// The default route of a stub router only depends on its own LSA and on
+// the LSA of the router at the other end of its link.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      GlobalRoutingLSA *rlsa = m_spfroot->GetLSA ();
+      for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
         {
-          NS_LOG_LOGIC ("Skipping ->  LSA "<< 
-                        w_lsa->GetLinkStateId () << " already in SPF tree");
-          continue;
+          GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint ||
+              l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              reached.m_vertexId = l->GetLinkId ();
+              summary.m_reached.push_back (reached);
+            }
         }
-//
-// (d) Calculate the link state cost D of the resulting path from the root to 
-// vertex W.  D is equal to the sum of the link state cost of the (already 
-// calculated) shortest path to vertex V and the advertised cost of the link
-// between vertices V and W.
-//
-      if (v->GetLSA ()->GetLSType () == GlobalRoutingLSA::RouterLSA)
+      std::sort (summary.m_reached.begin (), summary.m_reached.end ());
+      return;
+    }
+
+  std::map<SPFVertex*, uint32_t> ranks;
+  RankVertices (m_spfroot, ranks);
+  std::map<std::vector<SPFVertex::NodeExit_t>, uint32_t> exitIndex;
+  exitIndex[summary.m_exits.front ()] = 0;
+  for (uint32_t i = 0; i < added.size (); i++)
+    {
+      SPFVertex *v = added[i];
+      std::vector<SPFVertex::NodeExit_t> exits;
+      for (uint32_t j = 0; j < v->GetNRootExitDirections (); j++)
         {
-          NS_ASSERT (l != 0);
-          distance = v->GetDistanceFromRoot () + l->GetMetric ();
+          exits.push_back (v->GetRootExitDirection (j));
         }
-      else
+      std::map<std::vector<SPFVertex::NodeExit_t>, uint32_t>::iterator e = exitIndex.find (exits);
+      if (e == exitIndex.end ())
         {
-          distance = v->GetDistanceFromRoot ();
+          e = exitIndex.insert (std::make_pair (exits, summary.m_exits.size ())).first;
+          summary.m_exits.push_back (exits);
         }
+      reached.m_vertexId = v->GetVertexId ();
+      reached.m_distance = v->GetDistanceFromRoot ();
+      reached.m_order = i + 1;
+      reached.m_rank = ranks[v];
+      reached.m_exits = e->second;
+      summary.m_reached.push_back (reached);
+    }
+  std::sort (summary.m_reached.begin (), summary.m_reached.end ());
+}
+
+//
+// Whether two LSAs have the same contents.
+//
+static bool
+SameLSA (GlobalRoutingLSA *a, GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType () ||
+      a->GetLinkStateId () != b->GetLinkStateId () ||
+      a->GetAdvertisingRouter () != b->GetAdvertisingRouter () ||
+      a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask () ||
+      a->GetNLinkRecords () != b->GetNLinkRecords () ||
+      a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType () ||
+          la->GetLinkId () != lb->GetLinkId () ||
+          la->GetLinkData () != lb->GetLinkData () ||
+          la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+//
+// Whether a router LSA (if any) has a link to a transit network.
+//
+static bool
+HasTransitTo (GlobalRoutingLSA *lsa, Ipv4Address network)
+{
+  if (lsa == 0 || lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork && l->GetLinkId () == network)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+//
+// The destinations of the host routes (SPFIntraAddRouter) and of the network
+// routes (SPFIntraAddTransit and SPFIntraAddStub) a vertex adds, once per
+// route added with each exit direction.
+//
+static void
+GetHostDestinations (GlobalRoutingLSA *lsa, std::vector<std::pair<uint32_t, uint32_t> > &dests)
+{
+  if (lsa == 0 || lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+        {
+          dests.push_back (std::make_pair (l->GetLinkData ().Get (), Ipv4Mask::GetOnes ().Get ()));
+        }
+    }
+}
+
+static void
+GetNetworkDestinations (GlobalRoutingLSA *lsa, std::vector<std::pair<uint32_t, uint32_t> > &dests)
+{
+  if (lsa == 0)
+    {
+      return;
+    }
+  if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      Ipv4Mask mask = lsa->GetNetworkLSANetworkMask ();
+      dests.push_back (std::make_pair (lsa->GetLinkStateId ().CombineMask (mask).Get (), mask.Get ()));
+      return;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+        {
+          Ipv4Mask mask (l->GetLinkData ().Get ());
+          dests.push_back (std::make_pair (l->GetLinkId ().CombineMask (mask).Get (), mask.Get ()));
+        }
+    }
+}
+
+Ptr<GlobalRoutePrefixes>
+GlobalRouteManagerImpl::BuildSharedPrefixes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<GlobalRoutePrefixes> prefixes = Create<GlobalRoutePrefixes> ();
+  std::vector<GlobalRoutingLSA*> lsas;
+  m_lsdb->GetLSAs (lsas);
+  std::vector<std::pair<uint32_t, uint32_t> > hosts;
+  std::vector<std::pair<uint32_t, uint32_t> > networks;
+  for (std::vector<GlobalRoutingLSA*>::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      GetHostDestinations (*i, hosts);
+      GetNetworkDestinations (*i, networks);
+    }
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = hosts.begin (); i != hosts.end (); i++)
+    {
+      prefixes->Add (GlobalRoutePrefixes::HOST, Ipv4Address (i->first), Ipv4Mask (i->second));
+    }
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = networks.begin (); i != networks.end (); i++)
+    {
+      prefixes->Add (GlobalRoutePrefixes::NETWORK, Ipv4Address (i->first), Ipv4Mask (i->second));
+    }
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
+      prefixes->Add (GlobalRoutePrefixes::EXTERNAL, extlsa->GetLinkStateId (), extlsa->GetNetworkLSANetworkMask ());
+    }
+  return prefixes;
+}
+
+//
+// Add to dirty the destinations which are in only one of before and after,
+// or more times in one than in the other.
+//
+static void
+DiffDestinations (std::vector<std::pair<uint32_t, uint32_t> > before,
+                  std::vector<std::pair<uint32_t, uint32_t> > after,
+                  std::set<std::pair<uint32_t, uint32_t> > &dirty)
+{
+  std::sort (before.begin (), before.end ());
+  std::sort (after.begin (), after.end ());
+  std::vector<std::pair<uint32_t, uint32_t> > diff;
+  std::set_symmetric_difference (before.begin (), before.end (), after.begin (), after.end (),
+                                 std::back_inserter (diff));
+  dirty.insert (diff.begin (), diff.end ());
+}
+
+void
+GlobalRouteManagerImpl::GetSPFLinks (const GlobalRouteManagerLSDB* lsdb, GlobalRoutingLSA* lsa,
+                                     std::vector<LSDBChanges::Edge> &links)
+{
+  if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint ||
+              l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              links.push_back (LSDBChanges::Edge (lsa->GetLinkStateId (), l->GetLinkId (), l->GetMetric ()));
+            }
+        }
+    }
+  else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+        {
+          GlobalRoutingLSA *w_lsa = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+          if (w_lsa)
+            {
+              links.push_back (LSDBChanges::Edge (lsa->GetLinkStateId (), w_lsa->GetLinkStateId (), 0));
+            }
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::DiffLSDB (const GlobalRouteManagerLSDB* old, LSDBChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << old);
+  typedef LSDBChanges::Prefix_t Prefix_t;
+//
+// Walk both databases in the order of the link state IDs, to find the router
+// and network LSAs which were added, removed or modified.
+//
+  std::vector<GlobalRoutingLSA*> before;
+  std::vector<GlobalRoutingLSA*> after;
+  old->GetLSAs (before);
+  m_lsdb->GetLSAs (after);
+  std::vector<GlobalRoutingLSA*>::const_iterator i = before.begin ();
+  std::vector<GlobalRoutingLSA*>::const_iterator j = after.begin ();
+  while (i != before.end () || j != after.end ())
+    {
+      if (j == after.end () || (i != before.end () && (*i)->GetLinkStateId () < (*j)->GetLinkStateId ()))
+        {
+          changes.m_changed[(*i)->GetLinkStateId ()] = std::make_pair (*i, (GlobalRoutingLSA*)0);
+          i++;
+        }
+      else if (i == before.end () || (*j)->GetLinkStateId () < (*i)->GetLinkStateId ())
+        {
+          changes.m_changed[(*j)->GetLinkStateId ()] = std::make_pair ((GlobalRoutingLSA*)0, *j);
+          j++;
+        }
+      else
+        {
+          if (!SameLSA (*i, *j))
+            {
+              changes.m_changed[(*i)->GetLinkStateId ()] = std::make_pair (*i, *j);
+            }
+          i++;
+          j++;
+        }
+    }
+
+//
+// The links followed by SPFNext which changed are those of the changed LSAs,
+// and those from the networks the changed routers are (or were) attached to,
+// since a network reaches its routers through their LSAs.
+//
+  std::set<Ipv4Address> linked;
+  std::set<Prefix_t> hosts;
+  std::set<Prefix_t> networks;
+  for (std::map<Ipv4Address, std::pair<GlobalRoutingLSA*, GlobalRoutingLSA*> >::const_iterator k = changes.m_changed.begin ();
+       k != changes.m_changed.end (); k++)
+    {
+      linked.insert (k->first);
+      GlobalRoutingLSA *versions[2] = { k->second.first, k->second.second };
+      for (uint32_t v = 0; v < 2; v++)
+        {
+          if (versions[v] == 0 || versions[v]->GetLSType () != GlobalRoutingLSA::RouterLSA)
+            {
+              continue;
+            }
+          for (uint32_t l = 0; l < versions[v]->GetNLinkRecords (); l++)
+            {
+              GlobalRoutingLinkRecord *lr = versions[v]->GetLinkRecord (l);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  linked.insert (lr->GetLinkId ());
+                }
+            }
+        }
+      std::vector<Prefix_t> destsBefore;
+      std::vector<Prefix_t> destsAfter;
+      GetHostDestinations (k->second.first, destsBefore);
+      GetHostDestinations (k->second.second, destsAfter);
+      DiffDestinations (destsBefore, destsAfter, hosts);
+      destsBefore.clear ();
+      destsAfter.clear ();
+      GetNetworkDestinations (k->second.first, destsBefore);
+      GetNetworkDestinations (k->second.second, destsAfter);
+      DiffDestinations (destsBefore, destsAfter, networks);
+    }
+  for (std::set<Ipv4Address>::const_iterator k = linked.begin (); k != linked.end (); k++)
+    {
+      std::vector<LSDBChanges::Edge> linksBefore;
+      std::vector<LSDBChanges::Edge> linksAfter;
+      GlobalRoutingLSA *lsa = old->GetLSA (*k);
+      if (lsa)
+        {
+          GetSPFLinks (old, lsa, linksBefore);
+        }
+      lsa = m_lsdb->GetLSA (*k);
+      if (lsa)
+        {
+          GetSPFLinks (m_lsdb, lsa, linksAfter);
+        }
+      if (linksBefore == linksAfter)
+        {
+          continue;
+        }
+      std::vector<LSDBChanges::Edge> sortedBefore (linksBefore);
+      std::vector<LSDBChanges::Edge> sortedAfter (linksAfter);
+      std::sort (sortedBefore.begin (), sortedBefore.end ());
+      std::sort (sortedAfter.begin (), sortedAfter.end ());
+      std::vector<LSDBChanges::Edge> removed;
+      std::vector<LSDBChanges::Edge> added;
+      std::set_difference (sortedBefore.begin (), sortedBefore.end (), sortedAfter.begin (), sortedAfter.end (),
+                           std::back_inserter (removed));
+      std::set_difference (sortedAfter.begin (), sortedAfter.end (), sortedBefore.begin (), sortedBefore.end (),
+                           std::back_inserter (added));
+      changes.m_removed.insert (changes.m_removed.end (), removed.begin (), removed.end ());
+      changes.m_added.insert (changes.m_added.end (), added.begin (), added.end ());
+//
+// Links that stayed may still be followed in another order, which changes
+// how ties between equal cost paths are broken.
+//
+      for (std::vector<LSDBChanges::Edge>::const_iterator e = removed.begin (); e != removed.end (); e++)
+        {
+          linksBefore.erase (std::find (linksBefore.begin (), linksBefore.end (), *e));
+        }
+      for (std::vector<LSDBChanges::Edge>::const_iterator e = added.begin (); e != added.end (); e++)
+        {
+          linksAfter.erase (std::find (linksAfter.begin (), linksAfter.end (), *e));
+        }
+      if (linksBefore != linksAfter)
+        {
+          changes.m_reordered.insert (*k);
+        }
+    }
+
+//
+// Find which LSAs add routes to the destinations which changed, in the
+// order of the database.
+//
+  for (std::set<Prefix_t>::const_iterator k = hosts.begin (); k != hosts.end (); k++)
+    {
+      changes.m_hosts[*k];
+    }
+  for (std::set<Prefix_t>::const_iterator k = networks.begin (); k != networks.end (); k++)
+    {
+      changes.m_networks[*k];
+    }
+  if (!hosts.empty () || !networks.empty ())
+    {
+      for (j = after.begin (); j != after.end (); j++)
+        {
+          std::vector<Prefix_t> dests;
+          GetHostDestinations (*j, dests);
+          for (std::vector<Prefix_t>::const_iterator d = dests.begin (); d != dests.end (); d++)
+            {
+              LSDBChanges::Advertisers_t::iterator a = changes.m_hosts.find (*d);
+              if (a != changes.m_hosts.end ())
+                {
+                  a->second.push_back (*j);
+                }
+            }
+          dests.clear ();
+          GetNetworkDestinations (*j, dests);
+          for (std::vector<Prefix_t>::const_iterator d = dests.begin (); d != dests.end (); d++)
+            {
+              LSDBChanges::Advertisers_t::iterator a = changes.m_networks.find (*d);
+              if (a != changes.m_networks.end ())
+                {
+                  a->second.push_back (*j);
+                }
+            }
+        }
+    }
+
+//
+// External routes are added for each external LSA in turn; redo those to
+// the destinations whose list of advertising routers changed.
+//
+  std::map<Prefix_t, std::vector<Ipv4Address> > extBefore;
+  std::map<Prefix_t, std::vector<Ipv4Address> > extAfter;
+  LSDBChanges::Advertisers_t extLsas;
+  for (uint32_t k = 0; k < old->GetNumExtLSAs (); k++)
+    {
+      GlobalRoutingLSA *extlsa = old->GetExtLSA (k);
+      Ipv4Mask mask = extlsa->GetNetworkLSANetworkMask ();
+      Prefix_t dest (extlsa->GetLinkStateId ().CombineMask (mask).Get (), mask.Get ());
+      extBefore[dest].push_back (extlsa->GetAdvertisingRouter ());
+      extLsas[dest];
+    }
+  for (uint32_t k = 0; k < m_lsdb->GetNumExtLSAs (); k++)
+    {
+      GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (k);
+      Ipv4Mask mask = extlsa->GetNetworkLSANetworkMask ();
+      Prefix_t dest (extlsa->GetLinkStateId ().CombineMask (mask).Get (), mask.Get ());
+      extAfter[dest].push_back (extlsa->GetAdvertisingRouter ());
+      extLsas[dest].push_back (extlsa);
+    }
+  for (LSDBChanges::Advertisers_t::const_iterator k = extLsas.begin (); k != extLsas.end (); k++)
+    {
+      if (extBefore[k->first] != extAfter[k->first])
+        {
+          changes.m_externals.insert (*k);
+        }
+    }
+}
+
+bool
+GlobalRouteManagerImpl::IsSPFAffected (const SPFRoot &root, const SPFSummary &summary,
+                                       const LSDBChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << root.m_routerId);
+  typedef std::map<Ipv4Address, std::pair<GlobalRoutingLSA*, GlobalRoutingLSA*> >::const_iterator ChangedCI;
+  if (!summary.m_valid)
+    {
+      return true;
+    }
+  if (summary.m_stub)
+    {
+      for (ChangedCI i = changes.m_changed.begin (); i != changes.m_changed.end (); i++)
+        {
+          if (summary.Find (i->first))
+            {
+              return true;
+            }
+        }
+      return false;
+    }
+//
+// Host routes collapsed into the shared network routes would be lost with
+// them.
+//
+  if (root.m_routing && root.m_routing->HasSharedRoutes () && !changes.m_networks.empty ())
+    {
+      for (ChangedCI i = changes.m_changed.begin (); i != changes.m_changed.end (); i++)
+        {
+          if (summary.Find (i->first))
+            {
+              return true;
+            }
+        }
+    }
+//
+// The root exit directions are found in the LSAs of the root, of its
+// neighbours, and of the routers on the networks it is attached to.
+//
+  GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (root.m_routerId);
+  if (rlsa == 0 || changes.m_changed.find (root.m_routerId) != changes.m_changed.end ())
+    {
+      return true;
+    }
+  for (ChangedCI i = changes.m_changed.begin (); i != changes.m_changed.end (); i++)
+    {
+      for (uint32_t j = 0; j < rlsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (j);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint && l->GetLinkId () == i->first)
+            {
+              return true;
+            }
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
+              (l->GetLinkId () == i->first ||
+               HasTransitTo (i->second.first, l->GetLinkId ()) ||
+               HasTransitTo (i->second.second, l->GetLinkId ())))
+            {
+              return true;
+            }
+        }
+    }
+//
+// The tree changes if a link it uses is gone, or if a new link offers a path
+// as short as the one in the tree.  Other changes of links do not even change
+// the order in which vertices are added to the tree.
+//
+  for (std::vector<LSDBChanges::Edge>::const_iterator i = changes.m_removed.begin (); i != changes.m_removed.end (); i++)
+    {
+      const SPFSummary::Reached *from = summary.Find (i->m_from);
+      const SPFSummary::Reached *to = summary.Find (i->m_to);
+      if (from && to && from->m_distance + i->m_cost == to->m_distance)
+        {
+          NS_LOG_LOGIC ("Link from " << i->m_from << " to " << i->m_to << " was in the tree");
+          return true;
+        }
+    }
+  for (std::vector<LSDBChanges::Edge>::const_iterator i = changes.m_added.begin (); i != changes.m_added.end (); i++)
+    {
+      const SPFSummary::Reached *from = summary.Find (i->m_from);
+      if (from == 0 || i->m_to == root.m_routerId)
+        {
+          continue;
+        }
+      const SPFSummary::Reached *to = summary.Find (i->m_to);
+      if (to == 0 || from->m_distance + i->m_cost <= to->m_distance)
+        {
+          NS_LOG_LOGIC ("Link from " << i->m_from << " to " << i->m_to << " joins the tree");
+          return true;
+        }
+    }
+  for (std::set<Ipv4Address>::const_iterator i = changes.m_reordered.begin (); i != changes.m_reordered.end (); i++)
+    {
+      if (summary.Find (*i))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::UpdateSPFRoutes (const SPFRoot &root, const SPFSummary &summary,
+                                         const LSDBChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << root.m_routerId);
+  typedef std::vector<std::pair<std::pair<uint32_t, uint32_t>, GlobalRoutingLSA*> > Sources_t;
+  Ptr<Ipv4GlobalRouting> gr = root.m_routing;
+  if (gr == 0 || summary.m_stub)
+    {
+      return;
+    }
+//
+// Routes to the changed destinations are removed, then added again from
+// every vertex of the tree with a route to them, in the order the SPF
+// calculation would add them.
+//
+  bool reaches = false;
+  for (std::map<Ipv4Address, std::pair<GlobalRoutingLSA*, GlobalRoutingLSA*> >::const_iterator i = changes.m_changed.begin ();
+       i != changes.m_changed.end () && !reaches; i++)
+    {
+      reaches = summary.Find (i->first) != 0;
+    }
+  if (reaches)
+    {
+      for (LSDBChanges::Advertisers_t::const_iterator i = changes.m_hosts.begin (); i != changes.m_hosts.end (); i++)
+        {
+          Ipv4Address dest (i->first.first);
+          gr->RemoveHostRoutesTo (dest);
+          Sources_t sources;
+          for (std::vector<GlobalRoutingLSA*>::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+            {
+              const SPFSummary::Reached *v = summary.Find ((*j)->GetLinkStateId ());
+              if (v && v->m_order > 0)
+                {
+                  sources.push_back (std::make_pair (std::make_pair (0, v->m_order), *j));
+                }
+            }
+          std::stable_sort (sources.begin (), sources.end ());
+          for (Sources_t::const_iterator j = sources.begin (); j != sources.end (); j++)
+            {
+              const SPFSummary::Reached *v = summary.Find (j->second->GetLinkStateId ());
+              const std::vector<SPFVertex::NodeExit_t> &exits = summary.m_exits[v->m_exits];
+              for (uint32_t k = 0; k < exits.size (); k++)
+                {
+                  if (exits[k].second >= 0)
+                    {
+                      gr->AddHostRouteTo (dest, exits[k].first, exits[k].second);
+                    }
+                }
+            }
+        }
+      for (LSDBChanges::Advertisers_t::const_iterator i = changes.m_networks.begin (); i != changes.m_networks.end (); i++)
+        {
+          Ipv4Address network (i->first.first);
+          Ipv4Mask mask (i->first.second);
+          gr->RemoveNetworkRoutesTo (network, mask);
+          // Transit networks add their routes while the tree is built, then
+          // routers add routes to their stubs.
+          Sources_t sources;
+          for (std::vector<GlobalRoutingLSA*>::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+            {
+              const SPFSummary::Reached *v = summary.Find ((*j)->GetLinkStateId ());
+              if (v == 0 || v->m_order == 0)
+                {
+                  continue;
+                }
+              if ((*j)->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+                {
+                  sources.push_back (std::make_pair (std::make_pair (0, v->m_order), *j));
+                }
+              else
+                {
+                  sources.push_back (std::make_pair (std::make_pair (1, v->m_rank), *j));
+                }
+            }
+          std::stable_sort (sources.begin (), sources.end ());
+          for (Sources_t::const_iterator j = sources.begin (); j != sources.end (); j++)
+            {
+              const SPFSummary::Reached *v = summary.Find (j->second->GetLinkStateId ());
+              const std::vector<SPFVertex::NodeExit_t> &exits = summary.m_exits[v->m_exits];
+              for (uint32_t k = 0; k < exits.size (); k++)
+                {
+                  if (exits[k].second >= 0)
+                    {
+                      gr->AddNetworkRouteTo (network, mask, exits[k].first, exits[k].second);
+                    }
+                }
+            }
+        }
+    }
+  for (LSDBChanges::Advertisers_t::const_iterator i = changes.m_externals.begin (); i != changes.m_externals.end (); i++)
+    {
+      Ipv4Address network (i->first.first);
+      Ipv4Mask mask (i->first.second);
+      gr->RemoveASExternalRoutesTo (network, mask);
+      for (std::vector<GlobalRoutingLSA*>::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+        {
+          const SPFSummary::Reached *v = summary.Find ((*j)->GetAdvertisingRouter ());
+          if (v == 0 || v->m_order == 0)
+            {
+              continue;
+            }
+          const std::vector<SPFVertex::NodeExit_t> &exits = summary.m_exits[v->m_exits];
+          for (uint32_t k = 0; k < exits.size (); k++)
+            {
+              if (exits[k].second >= 0)
+                {
+                  gr->AddASExternalRouteTo (network, mask, exits[k].first, exits[k].second);
+                }
+            }
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_keepSummaries)
+    {
+      NS_LOG_INFO ("No SPF calculation to compare with; computing all the routes");
+      m_keepSummaries = true;
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  GlobalRouteManagerLSDB *old = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  LSDBChanges changes;
+  DiffLSDB (old, changes);
+  NS_LOG_INFO (changes.m_changed.size () << " LSAs changed");
+
+  std::vector<SPFRoot> roots = FindSPFRoots ();
+  std::vector<SPFRoot> affected;
+  std::set<Ipv4Address> current;
+  for (std::vector<SPFRoot>::iterator i = roots.begin (); i != roots.end (); i++)
+    {
+      current.insert (i->m_routerId);
+      SPFSummary &summary = m_summaries[i->m_routerId];
+      if (IsSPFAffected (*i, summary, changes))
+        {
+          DeleteRoutes (i->m_routing, i->m_nodeId);
+          i->m_summary = &summary;
+          affected.push_back (*i);
+        }
+      else
+        {
+          UpdateSPFRoutes (*i, summary, changes);
+        }
+    }
+//
+// Routers which no longer take part in routing lose their routes.
+//
+  for (std::map<Ipv4Address, SPFSummary>::iterator i = m_summaries.begin (); i != m_summaries.end (); )
+    {
+      if (current.find (i->first) == current.end ())
+        {
+          SPFRoot gone = FindSPFRoot (i->first);
+          if (gone.m_routing)
+            {
+              DeleteRoutes (gone.m_routing, gone.m_nodeId);
+            }
+          m_summaries.erase (i++);
+        }
+      else
+        {
+          i++;
+        }
+    }
+
+  NS_LOG_INFO ("Running SPF calculations for " << affected.size () << " of " << roots.size () << " routers");
+  SPFCalculateAll (affected);
+  delete old;
+}
+
+//
+// This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
+// 16.1 (2) for further details.
+//
+// We're passed a parameter <v> that is a vertex which is already in the SPF
+// tree.  A vertex represents a router node.  We also get a reference to the
+// SPF candidate queue, which is a priority queue containing the shortest paths
+// to the networks we know about.
+//
+// We examine the links in v's LSA and update the list of candidates with any
+// vertices not already on the list.  If a lower-cost path is found to a
+// vertex already on the candidate list, store the new (lower) cost.
+//
+void
+GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
+{
+  NS_LOG_FUNCTION (this << v << &candidate);
+
+  SPFVertex* w = 0;
+  GlobalRoutingLSA* w_lsa = 0;
+  GlobalRoutingLinkRecord *l = 0;
+  uint32_t distance = 0;
+  uint32_t numRecordsInVertex = 0;
+//
+// V points to a Router-LSA or Network-LSA
+// Loop over the links in router LSA or attached routers in Network LSA
+//
+  if (v->GetVertexType () == SPFVertex::VertexRouter)
+    {
+      numRecordsInVertex = v->GetLSA ()->GetNLinkRecords (); 
+    }
+  if (v->GetVertexType () == SPFVertex::VertexNetwork)
+    {
+      numRecordsInVertex = v->GetLSA ()->GetNAttachedRouters (); 
+    }
+
+  for (uint32_t i = 0; i < numRecordsInVertex; i++)
+    {
+// Get w_lsa:  In case of V is Router-LSA
+      if (v->GetVertexType () == SPFVertex::VertexRouter) 
+        {
+          NS_LOG_LOGIC ("Examining link " << i << " of " << 
+                        v->GetVertexId () << "'s " <<
+                        v->GetLSA ()->GetNLinkRecords () << " link records");
+//
+// (a) If this is a link to a stub network, examine the next link in V's LSA.
+// Links to stub networks will be considered in the second stage of the
+// shortest path calculation.
+//
+          l = v->GetLSA ()->GetLinkRecord (i);
+          NS_ASSERT (l != 0);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+            {
+              NS_LOG_LOGIC ("Found a Stub record to " << l->GetLinkId ());
+              continue;
+            }
+//
+// (b) Otherwise, W is a transit vertex (router or transit network).  Look up
+// the vertex W's LSA (router-LSA or network-LSA) in Area A's link state
+// database. 
+//
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+//
+// Lookup the link state advertisement of the new link -- we call it <w> in
+// the link state database.
+//
+              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
+              NS_ASSERT (w_lsa);
+              NS_LOG_LOGIC ("Found a P2P record from " << 
+                            v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
+            }
+          else if (l->GetLinkType () == 
+                   GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
+              NS_ASSERT (w_lsa);
+              NS_LOG_LOGIC ("Found a Transit record from " << 
+                            v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
+            }
+          else 
+            {
+              NS_ASSERT_MSG (0, "illegal Link Type");
+            }
+        }
+// Get w_lsa:  In case of V is Network-LSA
+      if (v->GetVertexType () == SPFVertex::VertexNetwork) 
+        {
+          w_lsa = m_lsdb->GetLSAByLinkData 
+              (v->GetLSA ()->GetAttachedRouter (i));
+          if (!w_lsa)
+            {
+              continue;
+            }
+          NS_LOG_LOGIC ("Found a Network LSA from " << 
+                        v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
+        }
+
+// Note:  w_lsa at this point may be either RouterLSA or NetworkLSA
+//
+// (c) If vertex W is already on the shortest-path tree, examine the next
+// link in the LSA.
+//
+// If the link is to a router that is already in the shortest path first tree
+// then we have it covered -- ignore it.
+//
+      if (GetSPFStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+        {
+          NS_LOG_LOGIC ("Skipping ->  LSA "<< 
+                        w_lsa->GetLinkStateId () << " already in SPF tree");
+          continue;
+        }
+//
+// (d) Calculate the link state cost D of the resulting path from the root to 
+// vertex W.  D is equal to the sum of the link state cost of the (already 
+// calculated) shortest path to vertex V and the advertised cost of the link
+// between vertices V and W.
+//
+      if (v->GetLSA ()->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          NS_ASSERT (l != 0);
+          distance = v->GetDistanceFromRoot () + l->GetMetric ();
+        }
+      else
+        {
+          distance = v->GetDistanceFromRoot ();
+        }
+
+      NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
-      NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
-
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetSPFStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -872,7 +1909,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetSPFStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -887,7 +1924,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetSPFStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -957,9 +1994,9 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
                 {
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
-// must reorder the priority queue keyed to that cost.
+// must move it up the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.DecreaseKey (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1123,7 +2160,11 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
         }
       else 
         {
-          w->SetRootExitDirection (v->GetRootExitDirection ());
+//
+// A network reached over several equal cost paths has one exit direction
+// for each of them, which the routers beyond it inherit.
+//
+          w->InheritAllRootExitDirections (v);
         }
     }
   else 
@@ -1319,9 +2360,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  Ptr<Ipv4GlobalRouting> gr = m_root->m_routing;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1336,17 +2375,27 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
   return false;
 }
 
-// quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  SPFRoot spfRoot = FindSPFRoot (root);
+  SPFCalculate (spfRoot);
+}
+
+// quagga ospf_spf_calculate
+void
+GlobalRouteManagerImpl::SPFCalculate (const SPFRoot &spfRoot)
+{
+  Ipv4Address root = spfRoot.m_routerId;
+  NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
+  m_root = &spfRoot;
 //
-// Initialize the Link State Database.
+// Initialize the status of the LSAs: none is explored yet.
 //
-  m_lsdb->Initialize ();
+  m_spfStatus.clear ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1366,7 +2415,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetSPFStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1374,15 +2423,28 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // We do not need to calculate SPF for every node in the network if this
 // node has only one interface through which another router can be 
 // reached.  Instead, short-circuit this computation and just install
-// a default route in the CheckForStubNode() method.
+// a default route in the CheckForStubNode() method.  The node list was
+// checked by the main thread, as this may run in an SPF worker thread.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (spfRoot.m_haveNodes && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      if (m_root->m_summary)
+        {
+          SPFRecordSummary (std::vector<SPFVertex*> (), true);
+        }
+      if (m_root->m_prefixes && m_root->m_routing)
+        {
+          // A stub only has its default route
+          m_root->m_routing->ClearSharedRoutes ();
+        }
       delete m_spfroot;
+      m_spfroot = 0;
+      m_root = 0;
       return;
     }
 
+  std::vector<SPFVertex*> added;
   for (;;)
     {
 //
@@ -1427,7 +2489,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetSPFStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1436,6 +2498,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // to now.
 //
       SPFVertexAddParent (v);
+      if (m_root->m_summary)
+        {
+          added.push_back (v);
+        }
 //
 // Note that when there is a choice of vertices closest to the root, network
 // vertices must be chosen before router vertices in order to necessarily
@@ -1494,6 +2560,14 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       ProcessASExternals (m_spfroot, extlsa);
     }
 
+  if (m_root->m_summary)
+    {
+      SPFRecordSummary (added, false);
+    }
+  if (m_root->m_prefixes && m_root->m_routing)
+    {
+      m_root->m_routing->EndSharedRoutes ();
+    }
 //
 // We're all done setting the routing information for the node at the root of
 // the SPF tree.  Delete all of the vertices and corresponding resources.  Go
@@ -1501,6 +2575,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_root = 0;
+  m_spfStatus.clear ();
 }
 
 void
@@ -1555,112 +2631,60 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
 
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
+// The routing information is written to the node of the root of the SPF
+// tree, looked up before the calculation.  If there is no such node, there
+// is nothing to write to.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  Ptr<Ipv4GlobalRouting> gr = m_root->m_routing;
+  if (gr == 0)
+    {
+      return;
+    }
+  uint32_t nodeId = m_root->m_nodeId;
+  NS_LOG_LOGIC ("Setting routes for node " << nodeId);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  if (m_root->m_prefixes)
+    {
+      SPFAddSharedRoutes (GlobalRoutePrefixes::EXTERNAL, tempip, tempmask, v);
+      return;
+    }
 
 //
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
+// The vertex <v> (corresponding to the router advertising the external
+// network) has the next hop addresses and outbound interfaces precalculated
+// for us through which the root node reaches it; we add a route to the
+// external network for each of them.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
-
 // Processing logic from RFC 2328, page 166 and quagga ospf_spf_process_stubs ()
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
@@ -1717,118 +2741,62 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
       return;
     }
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  Its node was looked up
+// before the calculation; if there is no such node, there is nothing to
+// write to.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+  Ptr<Ipv4GlobalRouting> gr = m_root->m_routing;
+  if (gr == 0)
+    {
+      return;
+    }
+  uint32_t nodeId = m_root->m_nodeId;
+  NS_LOG_LOGIC ("Setting routes for node " << nodeId);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+  if (m_root->m_prefixes)
+    {
+      SPFAddSharedRoutes (GlobalRoutePrefixes::NETWORK, tempip, tempmask, v);
+      return;
+    }
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The vertex <v> (corresponding to the node that has the stub network) has
+// an m_nextHop address precalculated for us that is the address to which
+// the root node should send packets to be forwarded to this network.
+// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
+// which the packets should be send for forwarding.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
+// walk through all next-hop-IPs and out-going-interfaces for reaching
+// the stub network gateway 'v' from the root node
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1843,70 +2811,26 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// We have an IP address <a> and the node at the root of the SPF tree, looked
+// up before the calculation.  Look through the interfaces on this node for
+// one that has the IP address we're looking for.  If we find one, return the
+// corresponding interface index, or -1 if not found.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_root->m_ipv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_root->m_routerId);
+      return -1;
+    }
+  int32_t interface = m_root->m_ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1932,71 +2856,32 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_ASSERT_MSG (m_spfroot, 
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  Its node was looked up
+// before the calculation; if there is no such node, there is nothing to
+// write to.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_root->m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      return;
+    }
+  uint32_t nodeId = m_root->m_nodeId;
+  NS_LOG_LOGIC ("Setting routes for node " << nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2005,18 +2890,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << nodeId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2030,46 +2915,40 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
-//
-// Done adding the routes for the selected node.
+// walk through all available exit directions due to ECMP,
+// and add host route for each of the exit direction toward
+// the vertex 'v'
 //
-          return;
+      if (m_root->m_prefixes)
+        {
+          SPFAddSharedRoutes (GlobalRoutePrefixes::HOST, lr->GetLinkData (), Ipv4Mask::GetOnes (), v);
+          continue;
         }
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2077,106 +2956,83 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_ASSERT_MSG (m_spfroot, 
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+// going to write the actual routing table entries.  Its node was looked up
+// before the calculation; if there is no such node, there is nothing to
+// write to.
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = m_root->m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
+      return;
+    }
+  uint32_t nodeId = m_root->m_nodeId;
+  NS_LOG_LOGIC ("setting routes for node " << nodeId);
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to: the network LSA of the transit network.
+//
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  if (m_root->m_prefixes)
+    {
+      SPFAddSharedRoutes (GlobalRoutePrefixes::NETWORK, tempip, tempmask, v);
+      return;
+    }
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-      if (rtr == 0)
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
+}
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+void
+GlobalRouteManagerImpl::SPFAddSharedRoutes (GlobalRoutePrefixes::Kind kind, Ipv4Address network,
+                                            Ipv4Mask mask, SPFVertex* v)
+{
+  NS_LOG_FUNCTION (this << kind << network << mask << v);
+  uint32_t prefix = m_root->m_prefixes->Find (kind, network, mask);
+  NS_ASSERT_MSG (prefix != GlobalRoutePrefixes::NONE,
+                 "GlobalRouteManagerImpl::SPFAddSharedRoutes (): " << network << "/" << mask << " not in the LSDB");
+  std::vector<Ipv4GlobalRouting::NextHop_t> nextHops;
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      if (exit.second >= 0)
+        {
+          nextHops.push_back (Ipv4GlobalRouting::NextHop_t (exit.first, exit.second));
         }
-    } 
+    }
+  NS_LOG_LOGIC ("Node " << m_root->m_nodeId << " adding " << nextHops.size () <<
+                " shared routes to " << network << "/" << mask);
+  m_root->m_routing->AddSharedRoutes (prefix, nextHops);
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -26,11 +26,13 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
+#include "global-route-prefixes.h"
 
 namespace ns3 {
 
@@ -38,6 +40,8 @@ const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
 class Ipv4GlobalRouting;
+class Ipv4;
+class SystemMutex;
 
 /**
  * @brief Vertex used in shortest path first (SPF) computations. See \RFC{2328},
@@ -696,12 +700,21 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Get all the router and network LSAs in the database.
+   * @internal
+   *
+   * @param lsas the LSAs are appended to this vector, sorted by link state
+   * ID.
+   */
+  void GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LSDBMap_t m_linkData; //!< index of the LSAs by the link data of their transit network records
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -758,6 +771,21 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Bring the routes up to date with the current topology, computing
+ * again only what the changes since the last calculation may affect.
+ * @internal
+ *
+ * The LSAs are gathered again and compared with those of the LSDB in use.
+ * The SPF calculation is run again only for the routers whose shortest path
+ * tree the changes may alter; the routes of the other routers are only
+ * updated for the destinations whose LSAs changed.  The first call computes
+ * all the routes, like DeleteGlobalRoutes, BuildGlobalRoutingDatabase and
+ * InitializeRoutes, and from then on a summary of the SPF calculation of
+ * each router is kept to check the changes against.
+ */
+  virtual void UpdateRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  * @internal
@@ -786,8 +814,249 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+/**
+ * @brief Create a Global Route Manager which runs SPF calculations on the
+ * LSDB of another one, without owning it.
+ * @internal
+ *
+ * Each thread computing routes in parallel gets one of these, as the
+ * state of an SPF calculation is kept in the members.
+ *
+ * @param lsdb the LSDB
+ */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb);
+
+/**
+ * @brief What the SPF calculation of a router found, kept so that changes of
+ * the LSDB can be checked against it.
+ * @internal
+ */
+  struct SPFSummary
+  {
+    SPFSummary ();
+
+    /// A vertex of the shortest path tree
+    struct Reached
+    {
+      Ipv4Address m_vertexId;  //!< link state ID of the vertex
+      uint32_t m_distance;     //!< distance from the root
+      uint32_t m_order;        //!< rank in the order vertices were added to the tree
+      uint32_t m_rank;         //!< rank in the order the stubs of vertices were processed
+      uint32_t m_exits;        //!< index of the root exit directions in m_exits
+      bool operator< (const Reached &o) const
+      {
+        return m_vertexId < o.m_vertexId;
+      }
+    };
+
+/**
+ * @param vertexId the link state ID of a vertex
+ * @returns the vertex if it is in the tree, or 0
+ */
+    const Reached* Find (Ipv4Address vertexId) const;
+
+    bool m_valid;   //!< whether the summary describes a calculation
+    bool m_stub;    //!< whether the calculation stopped at CheckForStubNode
+    std::vector<Reached> m_reached;  //!< vertices of the tree, sorted by ID
+    std::vector<std::vector<SPFVertex::NodeExit_t> > m_exits;  //!< distinct root exit directions
+  };
+
+/**
+ * @brief The changes between two versions of the LSDB.
+ * @internal
+ */
+  struct LSDBChanges
+  {
+    /// A link from one vertex to another, as followed by SPFNext
+    struct Edge
+    {
+      Edge (Ipv4Address from, Ipv4Address to, uint32_t cost);
+      bool operator< (const Edge &o) const;
+      bool operator== (const Edge &o) const;
+      Ipv4Address m_from;  //!< link state ID of the vertex the link leaves
+      Ipv4Address m_to;    //!< link state ID of the vertex the link reaches
+      uint32_t m_cost;     //!< cost of the link
+    };
+    /// A destination, as the network address and mask (in host order)
+    typedef std::pair<uint32_t, uint32_t> Prefix_t;
+    /// LSAs adding routes to some destinations, in the order they do
+    typedef std::map<Prefix_t, std::vector<GlobalRoutingLSA*> > Advertisers_t;
+
+    /// old and new versions (0 if missing) of the router and network LSAs that changed
+    std::map<Ipv4Address, std::pair<GlobalRoutingLSA*, GlobalRoutingLSA*> > m_changed;
+    std::vector<Edge> m_removed;         //!< links gone
+    std::vector<Edge> m_added;           //!< links new
+    std::set<Ipv4Address> m_reordered;   //!< vertices whose links are otherwise in a new order
+    Advertisers_t m_hosts;               //!< changed host route destinations, with their routers
+    Advertisers_t m_networks;            //!< changed network route destinations, with their networks and routers
+    Advertisers_t m_externals;           //!< changed external route destinations, with their external LSAs
+  };
+
+/**
+ * @brief The router at the root of an SPF calculation, with the interfaces
+ * of its node used to compute and install its routes.
+ * @internal
+ *
+ * These are looked up before the calculation, so that it does not need to
+ * walk the node list (which may not be done from several threads).
+ */
+  struct SPFRoot
+  {
+    Ipv4Address m_routerId;            //!< router ID of the root
+    uint32_t m_nodeId;                 //!< ID of the node of the root
+    Ptr<Ipv4> m_ipv4;                  //!< Ipv4 of the node, or 0 if not found
+    Ptr<Ipv4GlobalRouting> m_routing;  //!< routing protocol to write routes to, or 0
+    SPFSummary *m_summary;             //!< where to record the calculation, or 0
+    const GlobalRoutePrefixes *m_prefixes;  //!< destinations of the shared routes to write, or 0
+    bool m_haveNodes;                  //!< whether the node list is not empty
+  };
+
+/**
+ * @brief The SPF calculations left to run, shared by the threads which
+ * run them.
+ * @internal
+ */
+  struct SPFJobs
+  {
+    std::vector<SPFRoot> m_roots;  //!< roots of the calculations
+    uint32_t m_next;               //!< index of the next root to calculate
+    SystemMutex *m_mutex;          //!< protects m_next
+  };
+
+/**
+ * @brief Look up the node with the given router ID.
+ * @internal
+ *
+ * @param routerId the router ID
+ * @returns the root, with null interfaces if no node has this router ID
+ */
+  SPFRoot FindSPFRoot (Ipv4Address routerId) const;
+
+/**
+ * @brief Look up the routers for which SPF calculations are run.
+ * @internal
+ *
+ * @returns the roots, in the order of the node list
+ */
+  std::vector<SPFRoot> FindSPFRoots (void) const;
+
+/**
+ * @brief Run the SPF calculations of some routers, on as many threads as
+ * configured.
+ * @internal
+ *
+ * @param roots the roots of the calculations
+ */
+  void SPFCalculateAll (const std::vector<SPFRoot> &roots);
+
+/**
+ * @brief Thread body: run SPF calculations from m_jobs until none are left.
+ * @internal
+ */
+  void SPFWorker (void);
+
+/**
+ * @brief Status of an LSA in the current SPF calculation.
+ * @internal
+ *
+ * The status is not kept in the LSA itself so that the LSDB can be shared
+ * by several calculations running in parallel.
+ *
+ * @param lsa the LSA
+ * @returns its status, LSA_SPF_NOT_EXPLORED if it was never set
+ */
+  GlobalRoutingLSA::SPFStatus GetSPFStatus (GlobalRoutingLSA* lsa) const;
+
+/**
+ * @brief Set the status of an LSA in the current SPF calculation.
+ * @internal
+ *
+ * @param lsa the LSA
+ * @param status the new status
+ */
+  void SetSPFStatus (GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
+
+/**
+ * @brief Record the summary of the current SPF calculation in m_root.
+ * @internal
+ *
+ * @param added the vertices, in the order they were added to the tree
+ * @param stub whether the calculation stopped at CheckForStubNode
+ */
+  void SPFRecordSummary (const std::vector<SPFVertex*> &added, bool stub);
+
+/**
+ * @brief Get the links SPFNext follows from a vertex.
+ * @internal
+ *
+ * @param lsdb the LSDB of the vertex
+ * @param lsa the LSA of the vertex
+ * @param links the links are appended to this vector, in the order SPFNext
+ * follows them
+ */
+  static void GetSPFLinks (const GlobalRouteManagerLSDB* lsdb, GlobalRoutingLSA* lsa,
+                           std::vector<LSDBChanges::Edge> &links);
+
+/**
+ * @brief Compare the LSDB in use with an older one.
+ * @internal
+ *
+ * @param old the older LSDB
+ * @param changes filled with the differences
+ */
+  void DiffLSDB (const GlobalRouteManagerLSDB* old, LSDBChanges &changes) const;
+
+/**
+ * @brief Check whether changes of the LSDB may alter the shortest path tree
+ * of a router.
+ * @internal
+ *
+ * @param root the router
+ * @param summary its last SPF calculation
+ * @param changes the changes of the LSDB since then
+ * @returns true if the SPF calculation must be run again
+ */
+  bool IsSPFAffected (const SPFRoot &root, const SPFSummary &summary, const LSDBChanges &changes) const;
+
+/**
+ * @brief Update the routes of a router to the destinations whose LSAs
+ * changed, when its shortest path tree did not.
+ * @internal
+ *
+ * @param root the router
+ * @param summary its last SPF calculation, still valid
+ * @param changes the changes of the LSDB
+ */
+  void UpdateSPFRoutes (const SPFRoot &root, const SPFSummary &summary, const LSDBChanges &changes) const;
+
+/**
+ * @brief Number all the destinations of the LSDB, for the shared routes.
+ * @internal
+ *
+ * @returns the table of the destinations
+ */
+  Ptr<GlobalRoutePrefixes> BuildSharedPrefixes (void) const;
+
+/**
+ * @brief Add shared routes to a destination through the root exit
+ * directions of a vertex.
+ * @internal
+ *
+ * @param kind the kind of routes
+ * @param network the destination
+ * @param mask its mask
+ * @param v the vertex
+ */
+  void SPFAddSharedRoutes (GlobalRoutePrefixes::Kind kind, Ipv4Address network, Ipv4Mask mask, SPFVertex* v);
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< whether m_lsdb is deleted with this object
+  const SPFRoot* m_root; //!< the router of the current SPF calculation
+  std::map<GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus> m_spfStatus; //!< LSA status in the current SPF calculation
+  SPFJobs* m_jobs; //!< calculations to run, for worker threads
+  bool m_keepSummaries; //!< whether SPF calculations are summarized in m_summaries
+  std::map<Ipv4Address, SPFSummary> m_summaries; //!< last SPF calculation of each router, by router ID
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -809,6 +1078,14 @@ private:
    */
   void SPFCalculate (Ipv4Address root);
 
+  /**
+   * \brief Calculate the shortest path first (SPF) tree
+   *
+   * Equivalent to quagga ospf_spf_calculate
+   * \param root the root node, which must stay valid during the calculation
+   */
+  void SPFCalculate (const SPFRoot &root);
+
   /**
    * \brief Process Stub nodes
    *
@@ -67,6 +67,14 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the forwarding tables,
+ * recomputing the shortest paths only of the routers whose tree may have
+ * changed since the previous update.
+ * @internal
+ */
+  static void UpdateRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
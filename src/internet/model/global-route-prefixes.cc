@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "global-route-prefixes.h"
+
+NS_LOG_COMPONENT_DEFINE ("GlobalRoutePrefixes");
+
+namespace ns3 {
+
+const uint32_t GlobalRoutePrefixes::NONE;
+
+GlobalRoutePrefixes::GlobalRoutePrefixes ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+GlobalRoutePrefixes::Add (Kind kind, Ipv4Address network, Ipv4Mask mask)
+{
+  NS_LOG_FUNCTION (this << kind << network << mask);
+  NS_ASSERT (kind < KINDS);
+  Prefix prefix;
+  prefix.m_network = network.CombineMask (mask).Get ();
+  prefix.m_mask = mask.Get ();
+  prefix.m_kind = kind;
+  Key_t key (kind, std::make_pair (prefix.m_network, prefix.m_mask));
+  std::pair<std::map<Key_t, uint32_t>::iterator, bool> found = m_find.insert (std::make_pair (key, m_prefixes.size ()));
+  if (!found.second)
+    {
+      return found.first->second;
+    }
+  uint32_t index = m_prefixes.size ();
+  m_prefixes.push_back (prefix);
+  uint32_t length = mask.GetPrefixLength ();
+  if (prefix.m_mask == PrefixTrieKeyTraits<uint32_t>::Mask (0xffffffff, length))
+    {
+      m_tries[kind].Insert (prefix.m_network, length, index);
+    }
+  else
+    {
+      m_irregular[kind].push_back (index);
+    }
+  return index;
+}
+
+uint32_t
+GlobalRoutePrefixes::Find (Kind kind, Ipv4Address network, Ipv4Mask mask) const
+{
+  NS_LOG_FUNCTION (this << kind << network << mask);
+  Key_t key (kind, std::make_pair (network.CombineMask (mask).Get (), mask.Get ()));
+  std::map<Key_t, uint32_t>::const_iterator i = m_find.find (key);
+  return i == m_find.end () ? NONE : i->second;
+}
+
+void
+GlobalRoutePrefixes::Lookup (Kind kind, Ipv4Address dest, std::vector<uint32_t> &matches) const
+{
+  NS_LOG_FUNCTION (this << kind << dest);
+  NS_ASSERT (kind < KINDS);
+  uint32_t first = matches.size ();
+  for (std::vector<uint32_t>::const_iterator i = m_irregular[kind].begin (); i != m_irregular[kind].end (); i++)
+    {
+      if ((dest.Get () & m_prefixes[*i].m_mask) == m_prefixes[*i].m_network)
+        {
+          matches.push_back (*i);
+        }
+    }
+  uint32_t irregular = matches.size ();
+  // The trie gives the shortest prefixes first
+  m_tries[kind].Lookup (dest.Get (), matches);
+  std::reverse (matches.begin () + irregular, matches.end ());
+  if (irregular > first)
+    {
+      // Irregular masks are as specific as the number of bits they keep
+      std::vector<std::pair<uint32_t, uint32_t> > bySpecificity;
+      for (uint32_t i = first; i < matches.size (); i++)
+        {
+          uint32_t bits = 0;
+          for (uint32_t mask = m_prefixes[matches[i]].m_mask; mask != 0; mask &= mask - 1)
+            {
+              bits++;
+            }
+          bySpecificity.push_back (std::make_pair (32 - bits, matches[i]));
+        }
+      std::stable_sort (bySpecificity.begin (), bySpecificity.end ());
+      for (uint32_t i = first; i < matches.size (); i++)
+        {
+          matches[i] = bySpecificity[i - first].second;
+        }
+    }
+}
+
+uint32_t
+GlobalRoutePrefixes::GetN (void) const
+{
+  return m_prefixes.size ();
+}
+
+GlobalRoutePrefixes::Kind
+GlobalRoutePrefixes::GetKind (uint32_t i) const
+{
+  NS_ASSERT (i < m_prefixes.size ());
+  return static_cast<Kind> (m_prefixes[i].m_kind);
+}
+
+Ipv4Address
+GlobalRoutePrefixes::GetNetwork (uint32_t i) const
+{
+  NS_ASSERT (i < m_prefixes.size ());
+  return Ipv4Address (m_prefixes[i].m_network);
+}
+
+Ipv4Mask
+GlobalRoutePrefixes::GetMask (uint32_t i) const
+{
+  NS_ASSERT (i < m_prefixes.size ());
+  return Ipv4Mask (m_prefixes[i].m_mask);
+}
+
+} // namespace ns3
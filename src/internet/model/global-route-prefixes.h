@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef GLOBAL_ROUTE_PREFIXES_H
+#define GLOBAL_ROUTE_PREFIXES_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ipv4-address.h"
+#include "prefix-trie.h"
+
+namespace ns3 {
+
+/**
+ * \brief The destinations of the routes computed by the global route
+ * manager, shared by the routing tables of all the nodes.
+ *
+ * Every destination of the link state database is numbered once, so that
+ * an Ipv4GlobalRouting with shared routes only has to store, for each of
+ * these numbers, which of its groups of next hops leads to the destination.
+ * The table is only read once filled, so it may be looked up from the SPF
+ * threads.
+ *
+ * \see Ipv4GlobalRouting::BeginSharedRoutes
+ */
+class GlobalRoutePrefixes : public SimpleRefCount<GlobalRoutePrefixes>
+{
+public:
+  /// The kinds of routes, looked up in this order
+  enum Kind
+  {
+    HOST = 0,      //!< route to a host (mask 255.255.255.255)
+    NETWORK = 1,   //!< route to a network of the area
+    EXTERNAL = 2,  //!< route to an external network
+    KINDS = 3      //!< the number of kinds
+  };
+
+  /// An absent prefix or next hop group
+  static const uint32_t NONE = 0xffffffff;
+
+  GlobalRoutePrefixes ();
+
+  /**
+   * \param kind the kind of routes to the destination
+   * \param network the destination
+   * \param mask its mask
+   * \return the index of the destination, which is added if it was not
+   * there yet.
+   */
+  uint32_t Add (Kind kind, Ipv4Address network, Ipv4Mask mask);
+
+  /**
+   * \param kind the kind of routes to the destination
+   * \param network the destination
+   * \param mask its mask
+   * \return the index of the destination, or NONE.
+   */
+  uint32_t Find (Kind kind, Ipv4Address network, Ipv4Mask mask) const;
+
+  /**
+   * \param kind the kind of routes
+   * \param dest an address
+   * \param matches the indexes of the destinations of that kind which match
+   * dest are appended to this vector, most specific first.
+   */
+  void Lookup (Kind kind, Ipv4Address dest, std::vector<uint32_t> &matches) const;
+
+  /**
+   * \return the number of destinations.
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * \param i the index of a destination
+   * \return the kind of routes to the destination
+   */
+  Kind GetKind (uint32_t i) const;
+
+  /**
+   * \param i the index of a destination
+   * \return the destination
+   */
+  Ipv4Address GetNetwork (uint32_t i) const;
+
+  /**
+   * \param i the index of a destination
+   * \return the mask of the destination
+   */
+  Ipv4Mask GetMask (uint32_t i) const;
+
+private:
+  /// A destination
+  struct Prefix
+  {
+    uint32_t m_network;  //!< the destination, masked
+    uint32_t m_mask;     //!< its mask
+    uint32_t m_kind;     //!< the kind of routes to it
+  };
+
+  /// key of m_find: kind, network, mask
+  typedef std::pair<uint32_t, std::pair<uint32_t, uint32_t> > Key_t;
+
+  std::vector<Prefix> m_prefixes;                    //!< the destinations, by index
+  std::map<Key_t, uint32_t> m_find;                  //!< index of each destination
+  PrefixTrie<uint32_t, uint32_t> m_tries[KINDS];     //!< destinations with a prefix mask, by kind
+  std::vector<uint32_t> m_irregular[KINDS];          //!< destinations with any other mask, by kind
+};
+
+} // namespace ns3
+
+#endif /* GLOBAL_ROUTE_PREFIXES_H */
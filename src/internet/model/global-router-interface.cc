@@ -197,22 +197,7 @@ void
 GlobalRoutingLSA::CopyLinkRecords (const GlobalRoutingLSA& lsa)
 {
   NS_LOG_FUNCTION (this << &lsa);
-  for (ListOfLinkRecords_t::const_iterator i = lsa.m_linkRecords.begin ();
-       i != lsa.m_linkRecords.end (); 
-       i++)
-    {
-      GlobalRoutingLinkRecord *pSrc = *i;
-      GlobalRoutingLinkRecord *pDst = new GlobalRoutingLinkRecord;
-
-      pDst->SetLinkType (pSrc->GetLinkType ());
-      pDst->SetLinkId (pSrc->GetLinkId ());
-      pDst->SetLinkData (pSrc->GetLinkData ());
-      pDst->SetMetric (pSrc->GetMetric ());
-
-      m_linkRecords.push_back (pDst);
-      pDst = 0;
-    }
-
+  m_linkRecords.insert (m_linkRecords.end (), lsa.m_linkRecords.begin (), lsa.m_linkRecords.end ());
   m_attachedRouters = lsa.m_attachedRouters;
 }
 
@@ -226,18 +211,6 @@ void
 GlobalRoutingLSA::ClearLinkRecords (void)
 {
   NS_LOG_FUNCTION (this);
-  for ( ListOfLinkRecords_t::iterator i = m_linkRecords.begin ();
-        i != m_linkRecords.end (); 
-        i++)
-    {
-      NS_LOG_LOGIC ("Free link record");
-
-      GlobalRoutingLinkRecord *p = *i;
-      delete p;
-      p = 0;
-
-      *i = 0;
-    }
   NS_LOG_LOGIC ("Clear list");
   m_linkRecords.clear ();
 }
@@ -246,7 +219,8 @@ uint32_t
 GlobalRoutingLSA::AddLinkRecord (GlobalRoutingLinkRecord* lr)
 {
   NS_LOG_FUNCTION (this << lr);
-  m_linkRecords.push_back (lr);
+  m_linkRecords.push_back (*lr);
+  delete lr;
   return m_linkRecords.size ();
 }
 
@@ -261,18 +235,8 @@ GlobalRoutingLinkRecord *
 GlobalRoutingLSA::GetLinkRecord (uint32_t n) const
 {
   NS_LOG_FUNCTION (this << n);
-  uint32_t j = 0;
-  for ( ListOfLinkRecords_t::const_iterator i = m_linkRecords.begin ();
-        i != m_linkRecords.end (); 
-        i++, j++)
-    {
-      if (j == n) 
-        {
-          return *i;
-        }
-    }
-  NS_ASSERT_MSG (false, "GlobalRoutingLSA::GetLinkRecord (): invalid index");
-  return 0;
+  NS_ASSERT_MSG (n < m_linkRecords.size (), "GlobalRoutingLSA::GetLinkRecord (): invalid index");
+  return const_cast<GlobalRoutingLinkRecord *> (&m_linkRecords[n]);
 }
 
 bool
@@ -364,18 +328,8 @@ Ipv4Address
 GlobalRoutingLSA::GetAttachedRouter (uint32_t n) const
 {
   NS_LOG_FUNCTION (this << n);
-  uint32_t j = 0;
-  for ( ListOfAttachedRouters_t::const_iterator i = m_attachedRouters.begin ();
-        i != m_attachedRouters.end (); 
-        i++, j++)
-    {
-      if (j == n) 
-        {
-          return *i;
-        }
-    }
-  NS_ASSERT_MSG (false, "GlobalRoutingLSA::GetAttachedRouter (): invalid index");
-  return Ipv4Address ("0.0.0.0");
+  NS_ASSERT_MSG (n < m_attachedRouters.size (), "GlobalRoutingLSA::GetAttachedRouter (): invalid index");
+  return m_attachedRouters[n];
 }
 
 void
@@ -433,7 +387,7 @@ GlobalRoutingLSA::Print (std::ostream &os) const
             i != m_linkRecords.end (); 
             i++)
         {
-          GlobalRoutingLinkRecord *p = *i;
+          const GlobalRoutingLinkRecord *p = &*i;
 
           os << "---------- RouterLSA Link Record ----------" << std::endl;
           os << "m_linkType = " << p->m_linkType;
@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/node.h"
@@ -339,6 +340,9 @@ public:
 /**
  * @brief Add a given Global Routing Link Record to the LSA.
  *
+ * The LSA takes ownership of the record: it is copied into the array of
+ * records of the LSA, and freed.
+ *
  * @param lr The Global Routing Link Record to be added.
  * @returns The number of link records in the list.
  */
@@ -354,6 +358,9 @@ public:
 /**
  * @brief Return a pointer to the specified Global Routing Link Record.
  *
+ * The pointer remains valid until link records are added to or cleared
+ * from the LSA.
+ *
  * @param n The LSA number desired.
  * @returns The number of link records in the list.
  */
@@ -518,14 +525,15 @@ private:
 /**
  * A convenience typedef to avoid too much writers cramp.
  */
-  typedef std::list<GlobalRoutingLinkRecord*> ListOfLinkRecords_t;
+  typedef std::vector<GlobalRoutingLinkRecord> ListOfLinkRecords_t;
 
 /**
  * Each Link State Advertisement contains a number of Link Records that
  * describe the kinds of links that are attached to a given node.  We 
  * consider PointToPoint and StubNetwork links.
  *
- * m_linkRecords is an STL list container to hold the Link Records that have
+ * m_linkRecords is an STL vector holding (by value, since the database of
+ * a large topology holds millions of them) the Link Records that have
  * been discovered and prepared for the advertisement.
  *
  * @see GlobalRouting::DiscoverLSAs ()
@@ -540,12 +548,12 @@ private:
 /**
  * A convenience typedef to avoid too much writers cramp.
  */
-  typedef std::list<Ipv4Address> ListOfAttachedRouters_t;
+  typedef std::vector<Ipv4Address> ListOfAttachedRouters_t;
 
 /**
  * Each Network LSA contains a list of attached routers
  *
- * m_attachedRouters is an STL list container to hold the addresses that have
+ * m_attachedRouters is an STL vector to hold the addresses that have
  * been discovered and prepared for the advertisement.
  *
  * @see GlobalRouting::DiscoverLSAs ()
@@ -16,7 +16,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <list>
+#include <map>
 #include "ns3/abort.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
@@ -170,16 +170,12 @@ public:
 
   /**
    * \internal
-   * \brief This class holds the allocated addresses
+   * \brief The allocated addresses, as disjoint and non-adjacent ranges:
+   * the highest address of each range, indexed by its lowest address
    */
-  class Entry
-  {
-public:
-    uint32_t addrLow;  //!< /internal the lowest allocated address
-    uint32_t addrHigh; //!< /internal the highest allocated address
-  };
+  typedef std::map<uint32_t, uint32_t> Entries;
 
-  std::list<Entry> m_entries; //!< /internal contained of allocated addresses
+  Entries m_entries; //!< /internal contained of allocated addresses
   bool m_test; //!< /internal test mode (if true)
 };
 
@@ -361,18 +357,23 @@ Ipv4AddressGeneratorImpl::AddAllocated (const Ipv4Address address)
   uint32_t addr = address.Get ();
 
   NS_ABORT_MSG_UNLESS (addr, "Ipv4AddressGeneratorImpl::Add(): Allocating the broadcast address is not a good idea"); 
- 
-  std::list<Entry>::iterator i;
-
-  for (i = m_entries.begin (); i != m_entries.end (); ++i)
+//
+// The first block starting above the new address, and the block before it,
+// which is the only one that may hold the new address.
+//
+  Entries::iterator next = m_entries.upper_bound (addr);
+  Entries::iterator prev = next;
+  bool hasPrev = next != m_entries.begin ();
+  if (hasPrev)
     {
-      NS_LOG_LOGIC ("examine entry: " << Ipv4Address ((*i).addrLow) << 
-                    " to " << Ipv4Address ((*i).addrHigh));
+      --prev;
+      NS_LOG_LOGIC ("examine entry: " << Ipv4Address (prev->first) <<
+                    " to " << Ipv4Address (prev->second));
 //
 // First things first.  Is there an address collision -- that is, does the
 // new address fall in a previously allocated block of addresses.
 //
-      if (addr >= (*i).addrLow && addr <= (*i).addrHigh)
+      if (addr <= prev->second)
         {
           NS_LOG_LOGIC ("Ipv4AddressGeneratorImpl::Add(): Address Collision: " << Ipv4Address (addr)); 
           if (!m_test) 
@@ -381,63 +382,35 @@ Ipv4AddressGeneratorImpl::AddAllocated (const Ipv4Address address)
             }
           return false;
         }
+    }
 //
-// If the new address is less than the lowest address in the current block,
-// and can't be merged into to the current block, then insert it as a new
-// block before the current block.
-//
-      if (addr < (*i).addrLow - 1)
-        {
-          break;
-        }
-//
-// If the new address fits at the end of the block, look ahead to the next 
-// block and make sure it's not a collision there.  If we won't overlap, then
-// just extend the current block by one address.  We expect that completely
-// filled network ranges will be a fairly rare occurrence, so we don't worry
-// about collapsing address range blocks.
-// 
-      if (addr == (*i).addrHigh + 1)
-        {
-          std::list<Entry>::iterator j = i;
-          ++j;
-
-          if (j != m_entries.end ())
-            {
-              if (addr == (*j).addrLow)
-                {
-                  NS_LOG_LOGIC ("Ipv4AddressGeneratorImpl::Add(): "
-                                "Address Collision: " << Ipv4Address (addr));
-                  if (!m_test)
-                    {
-                      NS_FATAL_ERROR ("Ipv4AddressGeneratorImpl::Add(): Address Collision: " << Ipv4Address (addr));
-                    }
-                  return false;
-                }
-            }
-
-          NS_LOG_LOGIC ("New addrHigh = " << Ipv4Address (addr));
-          (*i).addrHigh = addr;
-          return true;
-        }
-//
-// If we get here, we know that the next lower block of addresses couldn't 
-// have been extended to include this new address since the code immediately 
-// above would have been executed and that next lower block extended upward.
-// So we know it's safe to extend the current block down to includ the new
-// address.
+// Otherwise extend the neighbouring blocks to the new address, merging them
+// if it was the only address between them, or start a new block.
 //
-      if (addr == (*i).addrLow - 1)
-        {
-          NS_LOG_LOGIC ("New addrLow = " << Ipv4Address (addr));
-          (*i).addrLow = addr;
-          return true;
-        }
+  bool extendsPrev = hasPrev && prev->second + 1 == addr;
+  bool extendsNext = next != m_entries.end () && next->first - 1 == addr;
+  if (extendsPrev && extendsNext)
+    {
+      NS_LOG_LOGIC ("Merge blocks at " << Ipv4Address (addr));
+      prev->second = next->second;
+      m_entries.erase (next);
+    }
+  else if (extendsPrev)
+    {
+      NS_LOG_LOGIC ("New addrHigh = " << Ipv4Address (addr));
+      prev->second = addr;
+    }
+  else if (extendsNext)
+    {
+      NS_LOG_LOGIC ("New addrLow = " << Ipv4Address (addr));
+      uint32_t high = next->second;
+      m_entries.erase (next++);
+      m_entries.insert (next, std::make_pair (addr, high));
+    }
+  else
+    {
+      m_entries.insert (prev, std::make_pair (addr, addr));
     }
-
-  Entry entry;
-  entry.addrLow = entry.addrHigh = addr;
-  m_entries.insert (i, entry);
   return true;
 }
 
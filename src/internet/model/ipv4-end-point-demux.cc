@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
@@ -27,8 +28,37 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux")
   ;
 
+Ipv4EndPointDemux::Key::Key (uint16_t localPort, Ipv4Address localAddress,
+                             uint16_t peerPort, Ipv4Address peerAddress)
+  : m_localPort (localPort),
+    m_localAddress (localAddress),
+    m_peerPort (peerPort),
+    m_peerAddress (peerAddress)
+{
+}
+
+bool
+Ipv4EndPointDemux::Key::operator< (const Key &o) const
+{
+  if (m_localPort != o.m_localPort)
+    {
+      return m_localPort < o.m_localPort;
+    }
+  if (m_localAddress != o.m_localAddress)
+    {
+      return m_localAddress < o.m_localAddress;
+    }
+  if (m_peerPort != o.m_peerPort)
+    {
+      return m_peerPort < o.m_peerPort;
+    }
+  return m_peerAddress < o.m_peerAddress;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_ephemeralUsed (m_portFirst, m_portLast),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -36,41 +66,85 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
 }
 
-bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demuxOrder = m_nextOrder++;
+  m_endPoints[endPoint->m_demuxOrder] = endPoint;
+  Index (endPoint);
+  endPoint->m_demux = this;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Key key (endPoint->GetLocalPort (), endPoint->GetLocalAddress (),
+           endPoint->GetPeerPort (), endPoint->GetPeerAddress ());
+  m_index[key].push_back (endPoint);
+  m_ephemeralUsed.SetUsed (key.m_localPort, true);
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Key key (endPoint->GetLocalPort (), endPoint->GetLocalAddress (),
+           endPoint->GetPeerPort (), endPoint->GetPeerAddress ());
+  EndPointIndex::iterator i = m_index.find (key);
+  NS_ASSERT_MSG (i != m_index.end (), "End point " << endPoint << " not indexed");
+  i->second.remove (endPoint);
+  if (i->second.empty ())
     {
-      if ((*i)->GetLocalPort  () == port) 
+      m_index.erase (i);
+      if (!LookupPortLocal (key.m_localPort))
         {
-          return true;
+          m_ephemeralUsed.SetUsed (key.m_localPort, false);
         }
     }
-  return false;
+}
+
+void
+Ipv4EndPointDemux::AddCandidates (const Key &key, Candidates &candidates) const
+{
+  EndPointIndex::const_iterator i = m_index.find (key);
+  if (i == m_index.end ())
+    {
+      return;
+    }
+  for (EndPoints::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+      candidates.push_back (std::make_pair ((*j)->m_demuxOrder, *j));
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  // The wildcards sort first, so the first key with this port, if any,
+  // follows them
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (port, Ipv4Address::GetAny (), 0, Ipv4Address::GetAny ()));
+  return i != m_index.end () && i->first.m_localPort == port;
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (port, addr, 0, Ipv4Address::GetAny ()));
+  return i != m_index.end () && i->first.m_localPort == port && i->first.m_localAddress == addr;
 }
 
 Ipv4EndPoint *
@@ -84,7 +158,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -100,7 +174,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -123,7 +197,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -133,21 +207,15 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (m_index.find (Key (localPort, localAddress, peerPort, peerAddress)) != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -158,15 +226,14 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (endPoint->m_demuxOrder);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -178,9 +245,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv4EndPoint *>::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       ret.push_back (endP);
     }
   return ret;
@@ -205,9 +272,44 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // Only the end points with the local port, a local address which is
+  // the wildcard or the destination (the address of the incoming interface
+  // for a broadcast), and a wildcard or exact peer may match.  They are
+  // looked at in the order they were allocated.
+  Ipv4Address any = Ipv4Address::GetAny ();
+  Ipv4Address local = isBroadcast ? incomingInterfaceAddr : daddr;
+  Candidates candidates;
+  for (uint32_t k = 0; k < 8; k++)
+    {
+      Ipv4Address localAddress = (k & 1) ? local : any;
+      uint16_t peerPort = (k & 2) ? sport : 0;
+      Ipv4Address peerAddress = (k & 4) ? saddr : any;
+      if (((k & 1) && local == any) || ((k & 2) && sport == 0) || ((k & 4) && saddr == any))
+        {
+          continue;
+        }
+      AddCandidates (Key (dport, localAddress, peerPort, peerAddress), candidates);
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  for (Candidates::const_iterator i = candidates.begin (); i != candidates.end (); i++) 
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
                                                  << " sport=" << endP->GetPeerPort ()
@@ -231,20 +333,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -318,34 +406,38 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  Candidates candidates;
+  AddCandidates (Key (dport, daddr, sport, saddr), candidates);
+  if (!candidates.empty ())
+    {
+      /* this is an exact match. */
+      return std::min_element (candidates.begin (), candidates.end ())->second;
+    }
+  // Otherwise the first allocated of the least generic end points with
+  // the local port
   uint32_t genericity = 3;
+  uint64_t order = 0;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (dport, Ipv4Address::GetAny (), 0, Ipv4Address::GetAny ()));
+  for (; i != m_index.end () && i->first.m_localPort == dport; i++)
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (i->first.m_localAddress == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (i->first.m_peerAddress == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if (tmp < genericity) 
+      for (EndPoints::const_iterator j = i->second.begin (); j != i->second.end (); j++)
         {
-          generic = (*i);
-          genericity = tmp;
+          if (tmp < genericity || (tmp == genericity && (*j)->m_demuxOrder < order)) 
+            {
+              generic = (*j);
+              genericity = tmp;
+              order = (*j)->m_demuxOrder;
+            }
         }
     }
   return generic;
@@ -353,22 +445,14 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
-  // Similar to counting up logic in netinet/in_pcb.c
   NS_LOG_FUNCTION (this);
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do 
+  // Same order as counting up from the last port allocated, as in
+  // netinet/in_pcb.c, without probing the ports in use one by one.
+  uint16_t port = m_ephemeralUsed.FindFree (m_ephemeral);
+  if (port == 0)
     {
-      if (count-- < 0)
-        {
-          return 0;
-        }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
-        {
-          port = m_portFirst;
-        }
-    } while (LookupPortLocal (port));
+      return 0;
+    }
   m_ephemeral = port;
   return port;
 }
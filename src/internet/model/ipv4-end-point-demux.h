@@ -23,8 +23,11 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
+#include "port-bitmap.h"
 
 namespace ns3 {
 
@@ -35,9 +38,10 @@ class Ipv4EndPoint;
  *
  * This class serves as a lookup table to match partial or full information
  * about a four-tuple to an ns3::Ipv4EndPoint.  It internally contains a list
- * of endpoints, and has APIs to add and find endpoints in this demux.  This
- * code is shared in common to TCP and UDP protocols in ns3.  This demux
- * sits between ns3's layer four and the socket layer
+ * of endpoints, indexed by their four-tuple so that a lookup only looks at
+ * the endpoints which may match, and has APIs to add and find endpoints in
+ * this demux.  This code is shared in common to TCP and UDP protocols in
+ * ns3.  This demux sits between ns3's layer four and the socket layer
  */
 
 class Ipv4EndPointDemux {
@@ -174,10 +178,89 @@ private:
    */
   uint16_t m_portFirst;
 
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Key of the index of the end points: local port, local
+   * address, peer port and peer address, compared in that order.
+   */
+  struct Key
+  {
+    /**
+     * \brief Constructor.
+     * \param localPort local port
+     * \param localAddress local address
+     * \param peerPort peer port
+     * \param peerAddress peer address
+     */
+    Key (uint16_t localPort, Ipv4Address localAddress, uint16_t peerPort, Ipv4Address peerAddress);
+    /**
+     * \param o the other key
+     * \return true if this key sorts before o
+     */
+    bool operator< (const Key &o) const;
+
+    uint16_t m_localPort;         //!< local port
+    Ipv4Address m_localAddress;   //!< local address
+    uint16_t m_peerPort;          //!< peer port
+    Ipv4Address m_peerAddress;    //!< peer address
+  };
+
+  /**
+   * \brief End points by key, in no particular order.
+   */
+  typedef std::map<Key, EndPoints> EndPointIndex;
+
+  /**
+   * \brief Candidate end points of a lookup, with their rank of allocation.
+   */
+  typedef std::vector<std::pair<uint64_t, Ipv4EndPoint *> > Candidates;
+
+  /**
+   * \brief Add a new end point to the demux.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its current addresses and ports.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the index, before its addresses or
+   * ports change.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Append the end points with a key to a list of candidates.
+   * \param key the key
+   * \param candidates the candidates
+   */
+  void AddCandidates (const Key &key, Candidates &candidates) const;
+
+  /**
+   * \brief The IPv4 end points, by rank of allocation.
+   */
+  std::map<uint64_t, Ipv4EndPoint *> m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by key.
+   */
+  EndPointIndex m_index;
+
+  /**
+   * \brief The ephemeral ports bound by at least one end point.
+   */
+  PortBitmap m_ephemeralUsed;
+
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The rank of the next end point allocated.
    */
-  EndPoints m_endPoints;
+  uint64_t m_nextOrder;
 };
 
 } // namespace ns3
@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \brief A representation of an internet endpoint/connection
@@ -229,6 +230,18 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+  friend class Ipv4EndPointDemux;
+
+  /**
+   * \brief The demux indexing this end point, told when its addresses
+   * or ports change (0 if none).
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief The rank of the allocation of this end point by its demux.
+   */
+  uint64_t m_demuxOrder;
 };
 
 } // namespace ns3
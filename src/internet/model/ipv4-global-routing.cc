@@ -17,6 +17,7 @@
 //
 
 #include <vector>
+#include <algorithm>
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
@@ -58,7 +59,9 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_nextOrder (0),
+    m_nSharedRoutes (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -79,6 +82,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  IndexRoute (m_hostIndex, --m_hostRoutes.end ());
 }
 
 void 
@@ -89,6 +93,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  IndexRoute (m_hostIndex, --m_hostRoutes.end ());
 }
 
 void 
@@ -104,6 +109,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  IndexRoute (m_networkIndex, --m_networkRoutes.end ());
 }
 
 void 
@@ -117,6 +123,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  IndexRoute (m_networkIndex, --m_networkRoutes.end ());
 }
 
 void 
@@ -132,9 +139,65 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  IndexRoute (m_ASexternalIndex, --m_ASexternalRoutes.end ());
 }
 
 
+void
+Ipv4GlobalRouting::IndexRoute (RouteIndexes &indexes, std::list<Ipv4RoutingTableEntry *>::iterator position)
+{
+  Ipv4RoutingTableEntry *route = *position;
+  NS_LOG_FUNCTION (this << route);
+  IndexedRoute indexed (route, m_nextOrder++);
+  indexed.m_position = position;
+  uint32_t mask = route->GetDestNetworkMask ().Get ();
+  uint32_t length = route->GetDestNetworkMask ().GetPrefixLength ();
+  if (mask == PrefixTrieKeyTraits<uint32_t>::Mask (0xffffffff, length))
+    {
+      indexes.m_trie.Insert (route->GetDestNetwork ().Get (), length, indexed);
+    }
+  else
+    {
+      indexes.m_irregular.push_back (indexed);
+    }
+}
+
+void
+Ipv4GlobalRouting::UnindexRoute (RouteIndexes &indexes, Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  IndexedRoute indexed (route, 0);
+  uint32_t length = route->GetDestNetworkMask ().GetPrefixLength ();
+  if (!indexes.m_trie.Remove (route->GetDestNetwork ().Get (), length, indexed))
+    {
+      std::vector<IndexedRoute>::iterator i = std::find (indexes.m_irregular.begin (), indexes.m_irregular.end (), indexed);
+      NS_ASSERT_MSG (i != indexes.m_irregular.end (), "Route " << route << " not indexed");
+      indexes.m_irregular.erase (i);
+    }
+}
+
+void
+Ipv4GlobalRouting::FindRoutes (RouteIndexes const &indexes, Ipv4Address dest,
+                               std::vector<IndexedRoute> &matches) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  indexes.m_trie.Lookup (dest.Get (), matches);
+  for (std::vector<IndexedRoute>::const_iterator i = indexes.m_irregular.begin ();
+       i != indexes.m_irregular.end (); i++)
+    {
+      if (i->m_route->GetDestNetworkMask ().IsMatch (dest, i->m_route->GetDestNetwork ()))
+        {
+          matches.push_back (*i);
+        }
+    }
+  // Matches come out by prefix length; the lookup has always considered
+  // them in the order in which they were added.
+  if (matches.size () > 1)
+    {
+      std::sort (matches.begin (), matches.end ());
+    }
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
@@ -142,75 +205,75 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
+  typedef std::vector<Ipv4RoutingTableEntry> RouteVec_t;
   RouteVec_t allRoutes;
+  std::vector<IndexedRoute> matches;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
+  FindRoutes (m_hostIndex, dest, matches);
+  for (std::vector<IndexedRoute>::const_iterator i = matches.begin (); 
+       i != matches.end (); 
        i++) 
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      NS_ASSERT (i->m_route->IsHost ());
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice (i->m_route->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (*i->m_route);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << i->m_route); 
     }
+  FindSharedRoutes (GlobalRoutePrefixes::HOST, dest, oif, allRoutes);
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      matches.clear ();
+      FindRoutes (m_networkIndex, dest, matches);
+      for (std::vector<IndexedRoute>::const_iterator j = matches.begin (); 
+           j != matches.end (); 
            j++) 
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (j->m_route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (*j->m_route);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << j->m_route);
         }
+      FindSharedRoutes (GlobalRoutePrefixes::NETWORK, dest, oif, allRoutes);
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
+      matches.clear ();
+      FindRoutes (m_ASexternalIndex, dest, matches);
+      for (std::vector<IndexedRoute>::const_iterator k = matches.begin ();
+           k != matches.end ();
            k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          NS_LOG_LOGIC ("Found external route" << k->m_route);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice (k->m_route->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (*k->m_route);
+          break;
+        }
+      if (allRoutes.size () == 0)
+        {
+          FindSharedRoutes (GlobalRoutePrefixes::EXTERNAL, dest, oif, allRoutes);
+          allRoutes.resize (std::min<uint32_t> (allRoutes.size (), 1));
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
@@ -227,14 +290,14 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
         {
           selectIndex = 0;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
+      Ipv4RoutingTableEntry const &route = allRoutes.at (selectIndex); 
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetDestination (route.GetDest ());
       /// \todo handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry->SetSource (m_ipv4->GetAddress (route.GetInterface (), 0).GetLocal ());
+      rtentry->SetGateway (route.GetGateway ());
+      uint32_t interfaceIdx = route.GetInterface ();
       rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
       return rtentry;
     }
@@ -244,6 +307,51 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+void
+Ipv4GlobalRouting::FindSharedRoutes (GlobalRoutePrefixes::Kind kind, Ipv4Address dest, Ptr<NetDevice> oif,
+                                     std::vector<Ipv4RoutingTableEntry> &routes) const
+{
+  NS_LOG_FUNCTION (this << kind << dest << oif);
+  if (m_sharedPrefixes == 0)
+    {
+      return;
+    }
+  std::vector<uint32_t> matches;
+  m_sharedPrefixes->Lookup (kind, dest, matches);
+  for (std::vector<uint32_t>::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      uint32_t group = m_sharedRoutes[*i];
+      if (group == GlobalRoutePrefixes::NONE)
+        {
+          continue;
+        }
+      std::vector<NextHop_t> const &nextHops = m_nextHopGroups[group];
+      for (std::vector<NextHop_t>::const_iterator j = nextHops.begin (); j != nextHops.end (); j++)
+        {
+          if (oif != 0 && oif != m_ipv4->GetNetDevice (j->second))
+            {
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
+            }
+          routes.push_back (GetSharedRoute (*i, *j));
+          NS_LOG_LOGIC (routes.size () << "Found shared route" << routes.back ());
+        }
+    }
+}
+
+Ipv4RoutingTableEntry
+Ipv4GlobalRouting::GetSharedRoute (uint32_t prefix, NextHop_t const &nextHop) const
+{
+  if (m_sharedPrefixes->GetKind (prefix) == GlobalRoutePrefixes::HOST)
+    {
+      return Ipv4RoutingTableEntry::CreateHostRouteTo (m_sharedPrefixes->GetNetwork (prefix),
+                                                       nextHop.first, nextHop.second);
+    }
+  return Ipv4RoutingTableEntry::CreateNetworkRouteTo (m_sharedPrefixes->GetNetwork (prefix),
+                                                      m_sharedPrefixes->GetMask (prefix),
+                                                      nextHop.first, nextHop.second);
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -252,6 +360,7 @@ Ipv4GlobalRouting::GetNRoutes (void) const
   n += m_hostRoutes.size ();
   n += m_networkRoutes.size ();
   n += m_ASexternalRoutes.size ();
+  n += m_nSharedRoutes;
   return n;
 }
 
@@ -300,6 +409,28 @@ Ipv4GlobalRouting::GetRoute (uint32_t index) const
         }
       tmp++;
     }
+  index -= m_ASexternalRoutes.size ();
+  if (index < m_nSharedRoutes)
+    {
+      // The shared routes are only turned into entries when asked for
+      if (m_sharedEntries.empty ())
+        {
+          m_sharedEntries.reserve (m_nSharedRoutes);
+          for (uint32_t i = 0; i < m_sharedRoutes.size (); i++)
+            {
+              if (m_sharedRoutes[i] == GlobalRoutePrefixes::NONE)
+                {
+                  continue;
+                }
+              std::vector<NextHop_t> const &nextHops = m_nextHopGroups[m_sharedRoutes[i]];
+              for (std::vector<NextHop_t>::const_iterator j = nextHops.begin (); j != nextHops.end (); j++)
+                {
+                  m_sharedEntries.push_back (GetSharedRoute (i, *j));
+                }
+            }
+        }
+      return &m_sharedEntries[index];
+    }
   NS_ASSERT (false);
   // quiet compiler.
   return 0;
@@ -318,6 +449,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              UnindexRoute (m_hostIndex, *i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -335,6 +467,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          UnindexRoute (m_networkIndex, *j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -351,6 +484,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          UnindexRoute (m_ASexternalIndex, *k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -358,9 +492,255 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
         }
       tmp++;
     }
+  index -= m_ASexternalRoutes.size ();
+  for (uint32_t i = 0; i < m_sharedRoutes.size (); i++)
+    {
+      if (m_sharedRoutes[i] == GlobalRoutePrefixes::NONE)
+        {
+          continue;
+        }
+      std::vector<NextHop_t> nextHops = m_nextHopGroups[m_sharedRoutes[i]];
+      if (index < nextHops.size ())
+        {
+          NS_LOG_LOGIC ("Removing shared route " << index << " to " << m_sharedPrefixes->GetNetwork (i));
+          nextHops.erase (nextHops.begin () + index);
+          SetSharedNextHops (i, nextHops);
+          return;
+        }
+      index -= nextHops.size ();
+    }
   NS_ASSERT (false);
 }
 
+void
+Ipv4GlobalRouting::RemoveHostRoutesTo (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  RemoveRoutesTo (m_hostIndex, m_hostRoutes, dest, Ipv4Mask::GetOnes ());
+  if (m_sharedPrefixes != 0)
+    {
+      uint32_t prefix = m_sharedPrefixes->Find (GlobalRoutePrefixes::HOST, dest, Ipv4Mask::GetOnes ());
+      if (prefix != GlobalRoutePrefixes::NONE)
+        {
+          SetSharedNextHops (prefix, std::vector<NextHop_t> ());
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::RemoveNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask)
+{
+  NS_LOG_FUNCTION (this << network << networkMask);
+  RemoveRoutesTo (m_networkIndex, m_networkRoutes, network, networkMask);
+  if (m_sharedPrefixes != 0)
+    {
+      uint32_t prefix = m_sharedPrefixes->Find (GlobalRoutePrefixes::NETWORK, network, networkMask);
+      if (prefix != GlobalRoutePrefixes::NONE)
+        {
+          SetSharedNextHops (prefix, std::vector<NextHop_t> ());
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::RemoveASExternalRoutesTo (Ipv4Address network, Ipv4Mask networkMask)
+{
+  NS_LOG_FUNCTION (this << network << networkMask);
+  RemoveRoutesTo (m_ASexternalIndex, m_ASexternalRoutes, network, networkMask);
+  if (m_sharedPrefixes != 0)
+    {
+      uint32_t prefix = m_sharedPrefixes->Find (GlobalRoutePrefixes::EXTERNAL, network, networkMask);
+      if (prefix != GlobalRoutePrefixes::NONE)
+        {
+          SetSharedNextHops (prefix, std::vector<NextHop_t> ());
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::RemoveRoutesTo (RouteIndexes &indexes, std::list<Ipv4RoutingTableEntry *> &routes,
+                                   Ipv4Address network, Ipv4Mask networkMask)
+{
+  NS_LOG_FUNCTION (this << network << networkMask);
+  std::vector<IndexedRoute> matches;
+  FindRoutes (indexes, network, matches);
+  for (std::vector<IndexedRoute>::const_iterator i = matches.begin (); i != matches.end (); i++)
+    {
+      Ipv4RoutingTableEntry *route = i->m_route;
+      if (route->GetDestNetwork () == network && route->GetDestNetworkMask () == networkMask)
+        {
+          UnindexRoute (indexes, route);
+          routes.erase (i->m_position);
+          delete route;
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::BeginSharedRoutes (Ptr<const GlobalRoutePrefixes> prefixes)
+{
+  NS_LOG_FUNCTION (this << prefixes);
+  ClearSharedRoutes ();
+  m_sharedPrefixes = prefixes;
+  m_sharedRoutes.assign (prefixes->GetN (), GlobalRoutePrefixes::NONE);
+}
+
+void
+Ipv4GlobalRouting::AddSharedRoutes (uint32_t prefix, std::vector<NextHop_t> const &nextHops)
+{
+  NS_LOG_FUNCTION (this << prefix << nextHops.size ());
+  NS_ASSERT_MSG (prefix < m_sharedRoutes.size (), "No shared destination " << prefix);
+  if (nextHops.empty ())
+    {
+      return;
+    }
+  uint32_t group = m_sharedRoutes[prefix];
+  m_sharedEntries.clear ();
+  if (group == GlobalRoutePrefixes::NONE)
+    {
+      m_sharedRoutes[prefix] = AddNextHopGroup (nextHops);
+    }
+  else
+    {
+      std::vector<NextHop_t> all = m_nextHopGroups[group];
+      all.insert (all.end (), nextHops.begin (), nextHops.end ());
+      m_sharedRoutes[prefix] = AddNextHopGroup (all);
+    }
+  m_nSharedRoutes += nextHops.size ();
+}
+
+void
+Ipv4GlobalRouting::EndSharedRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_sharedPrefixes == 0)
+    {
+      return;
+    }
+//
+// A host route can go when the network routes to the host (which are only
+// looked up when there is no host route) lead to the same next hops, in
+// the same order.
+//
+  std::vector<uint32_t> matches;
+  std::vector<IndexedRoute> listed;
+  std::vector<NextHop_t> viaNetworks;
+  for (uint32_t i = 0; i < m_sharedRoutes.size (); i++)
+    {
+      if (m_sharedRoutes[i] == GlobalRoutePrefixes::NONE || m_sharedPrefixes->GetKind (i) != GlobalRoutePrefixes::HOST)
+        {
+          continue;
+        }
+      Ipv4Address host = m_sharedPrefixes->GetNetwork (i);
+      listed.clear ();
+      FindRoutes (m_hostIndex, host, listed);
+      FindRoutes (m_networkIndex, host, listed);
+      if (!listed.empty ())
+        {
+          continue;
+        }
+      matches.clear ();
+      viaNetworks.clear ();
+      m_sharedPrefixes->Lookup (GlobalRoutePrefixes::NETWORK, host, matches);
+      for (std::vector<uint32_t>::const_iterator j = matches.begin (); j != matches.end (); j++)
+        {
+          if (m_sharedRoutes[*j] != GlobalRoutePrefixes::NONE)
+            {
+              std::vector<NextHop_t> const &nextHops = m_nextHopGroups[m_sharedRoutes[*j]];
+              viaNetworks.insert (viaNetworks.end (), nextHops.begin (), nextHops.end ());
+            }
+        }
+      if (viaNetworks == m_nextHopGroups[m_sharedRoutes[i]])
+        {
+          NS_LOG_LOGIC ("Host route to " << host << " covered by the network routes");
+          m_nSharedRoutes -= viaNetworks.size ();
+          m_sharedRoutes[i] = GlobalRoutePrefixes::NONE;
+        }
+    }
+//
+// Drop the groups left unused (by collapsed host routes, or replaced while
+// next hops were appended), and the index of the groups.
+//
+  std::vector<uint32_t> renumber (m_nextHopGroups.size (), GlobalRoutePrefixes::NONE);
+  std::vector<std::vector<NextHop_t> > groups;
+  for (uint32_t i = 0; i < m_sharedRoutes.size (); i++)
+    {
+      uint32_t group = m_sharedRoutes[i];
+      if (group == GlobalRoutePrefixes::NONE)
+        {
+          continue;
+        }
+      if (renumber[group] == GlobalRoutePrefixes::NONE)
+        {
+          renumber[group] = groups.size ();
+          groups.push_back (m_nextHopGroups[group]);
+        }
+      m_sharedRoutes[i] = renumber[group];
+    }
+  m_nextHopGroups.swap (groups);
+  std::map<std::vector<NextHop_t>, uint32_t> ().swap (m_nextHopGroupIndex);
+  m_sharedEntries.clear ();
+  NS_LOG_LOGIC (m_nSharedRoutes << " shared routes to " << m_sharedRoutes.size () << " destinations through "
+                << m_nextHopGroups.size () << " groups of next hops");
+}
+
+void
+Ipv4GlobalRouting::ClearSharedRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sharedPrefixes = 0;
+  std::vector<uint32_t> ().swap (m_sharedRoutes);
+  std::vector<std::vector<NextHop_t> > ().swap (m_nextHopGroups);
+  std::map<std::vector<NextHop_t>, uint32_t> ().swap (m_nextHopGroupIndex);
+  std::vector<Ipv4RoutingTableEntry> ().swap (m_sharedEntries);
+  m_nSharedRoutes = 0;
+}
+
+bool
+Ipv4GlobalRouting::HasSharedRoutes (void) const
+{
+  return m_sharedPrefixes != 0;
+}
+
+uint32_t
+Ipv4GlobalRouting::AddNextHopGroup (std::vector<NextHop_t> const &nextHops)
+{
+  std::map<std::vector<NextHop_t>, uint32_t>::iterator i = m_nextHopGroupIndex.find (nextHops);
+  if (i != m_nextHopGroupIndex.end ())
+    {
+      return i->second;
+    }
+  uint32_t group = m_nextHopGroups.size ();
+  m_nextHopGroups.push_back (nextHops);
+  m_nextHopGroupIndex[nextHops] = group;
+  return group;
+}
+
+void
+Ipv4GlobalRouting::SetSharedNextHops (uint32_t prefix, std::vector<NextHop_t> const &nextHops)
+{
+  NS_LOG_FUNCTION (this << prefix << nextHops.size ());
+  uint32_t &group = m_sharedRoutes[prefix];
+  if (group != GlobalRoutePrefixes::NONE)
+    {
+      m_nSharedRoutes -= m_nextHopGroups[group].size ();
+    }
+  group = GlobalRoutePrefixes::NONE;
+  if (!nextHops.empty ())
+    {
+      // The index of the groups is gone once the routes are added, but
+      // there are only a few groups
+      std::vector<std::vector<NextHop_t> >::const_iterator i = std::find (m_nextHopGroups.begin (), m_nextHopGroups.end (), nextHops);
+      group = i - m_nextHopGroups.begin ();
+      if (i == m_nextHopGroups.end ())
+        {
+          m_nextHopGroups.push_back (nextHops);
+        }
+    }
+  m_nSharedRoutes += nextHops.size ();
+  m_sharedEntries.clear ();
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -391,6 +771,13 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostIndex.m_trie.Clear ();
+  m_hostIndex.m_irregular.clear ();
+  m_networkIndex.m_trie.Clear ();
+  m_networkIndex.m_irregular.clear ();
+  m_ASexternalIndex.m_trie.Clear ();
+  m_ASexternalIndex.m_irregular.clear ();
+  ClearSharedRoutes ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
+#include <map>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +30,9 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "prefix-trie.h"
+#include "global-route-prefixes.h"
 
 namespace ns3 {
 
@@ -74,6 +79,10 @@ public:
    * \return the object TypeId
    */
   static TypeId GetTypeId (void);
+
+  /// A next hop of a shared route: the gateway and the interface index
+  typedef std::pair<Ipv4Address, uint32_t> NextHop_t;
+
   /**
    * \brief Construct an empty Ipv4GlobalRouting routing protocol,
    *
@@ -216,6 +225,69 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Remove all the host routes to a destination.
+   * \param dest The destination of the routes to remove.
+   */
+  void RemoveHostRoutesTo (Ipv4Address dest);
+
+  /**
+   * \brief Remove all the network routes to a network.
+   * \param network The network of the routes to remove.
+   * \param networkMask The mask of the routes to remove.
+   */
+  void RemoveNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask);
+
+  /**
+   * \brief Remove all the external routes to a network.
+   * \param network The network of the routes to remove.
+   * \param networkMask The mask of the routes to remove.
+   */
+  void RemoveASExternalRoutesTo (Ipv4Address network, Ipv4Mask networkMask);
+
+  /**
+   * \brief Start replacing the shared routes.
+   *
+   * Besides its own list of routes, the routing table may hold routes to
+   * the destinations of a GlobalRoutePrefixes table shared by all the nodes,
+   * stored as one group number per destination, each group of next hops
+   * being stored once.  This is how the GlobalRouteManager stores the routes
+   * it computes when the "GlobalRoutingSharedTables" global value is set.
+   *
+   * Shared routes are looked up after the routes of the same kind (host,
+   * network or external) of the list, most specific destination first.
+   * They appear after the other routes in GetRoute (), and may be removed
+   * like them.
+   *
+   * \param prefixes the destinations of the routes to come.
+   */
+  void BeginSharedRoutes (Ptr<const GlobalRoutePrefixes> prefixes);
+
+  /**
+   * \brief Add shared routes to a destination.
+   * \param prefix the index of the destination in the shared table.
+   * \param nextHops the next hops to append to those of the destination.
+   */
+  void AddSharedRoutes (uint32_t prefix, std::vector<NextHop_t> const &nextHops);
+
+  /**
+   * \brief Finish adding shared routes.
+   *
+   * The host routes which lead to the same next hops as the network routes
+   * to the host are dropped, since looking them up gives the same result.
+   */
+  void EndSharedRoutes (void);
+
+  /**
+   * \brief Remove all the shared routes.
+   */
+  void ClearSharedRoutes (void);
+
+  /**
+   * \returns true if the routing table holds shared routes.
+   */
+  bool HasSharedRoutes (void) const;
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -258,12 +330,129 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /**
+   * \brief A route in the lookup indexes, with its position in the lists
+   * so that matches can be put back in the order of the lists, and removed
+   * from them.
+   */
+  struct IndexedRoute
+  {
+    IndexedRoute (Ipv4RoutingTableEntry *route, uint64_t order)
+      : m_route (route),
+        m_order (order),
+        m_position ()
+    {
+    }
+    bool operator == (IndexedRoute const &o) const
+    {
+      return m_route == o.m_route;
+    }
+    bool operator < (IndexedRoute const &o) const
+    {
+      return m_order < o.m_order;
+    }
+    Ipv4RoutingTableEntry *m_route;
+    uint64_t m_order;
+    std::list<Ipv4RoutingTableEntry *>::iterator m_position;
+  };
+
+  /// prefix index over a list of routes
+  typedef PrefixTrie<uint32_t, IndexedRoute> RouteIndex;
+
+  /**
+   * \brief Lookup indexes over one of the lists of routes
+   *
+   * Routes with a contiguous mask go in the trie; the (unusual) others are
+   * simply kept aside and checked one by one.
+   */
+  struct RouteIndexes
+  {
+    RouteIndex m_trie;                          //!< routes with a prefix mask
+    std::vector<IndexedRoute> m_irregular;      //!< routes with any other mask
+  };
+
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Add a route to the lookup indexes of its list.
+   * \param indexes the indexes of the list the route was appended to
+   * \param position the position of the route in the list
+   */
+  void IndexRoute (RouteIndexes &indexes, std::list<Ipv4RoutingTableEntry *>::iterator position);
+
+  /**
+   * \brief Remove a route from the lookup indexes of its list.
+   * \param indexes the indexes of the list the route is removed from
+   * \param route the route
+   */
+  void UnindexRoute (RouteIndexes &indexes, Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Find the routes of a list which match a destination.
+   * \param indexes the indexes of the list
+   * \param dest the destination
+   * \param matches the matching routes, in the order of the list
+   */
+  void FindRoutes (RouteIndexes const &indexes, Ipv4Address dest, std::vector<IndexedRoute> &matches) const;
+
+  /**
+   * \brief Remove all the routes of a list to a network.
+   * \param indexes the indexes of the list
+   * \param routes the list
+   * \param network the network of the routes to remove
+   * \param networkMask the mask of the routes to remove
+   */
+  void RemoveRoutesTo (RouteIndexes &indexes, std::list<Ipv4RoutingTableEntry *> &routes,
+                       Ipv4Address network, Ipv4Mask networkMask);
+
+  /**
+   * \brief Find the shared routes of a kind which match a destination.
+   * \param kind the kind of routes
+   * \param dest the destination
+   * \param oif the output device the routes must use, or 0
+   * \param routes the matching routes are appended to this vector, most
+   * specific first.
+   */
+  void FindSharedRoutes (GlobalRoutePrefixes::Kind kind, Ipv4Address dest, Ptr<NetDevice> oif,
+                         std::vector<Ipv4RoutingTableEntry> &routes) const;
+
+  /**
+   * \param prefix the index of a destination in the shared table
+   * \param nextHop a next hop
+   * \return the routing table entry of the shared route.
+   */
+  Ipv4RoutingTableEntry GetSharedRoute (uint32_t prefix, NextHop_t const &nextHop) const;
+
+  /**
+   * \param nextHops a group of next hops
+   * \return the number of the group, which is added if it was not there;
+   * only used while adding shared routes.
+   */
+  uint32_t AddNextHopGroup (std::vector<NextHop_t> const &nextHops);
+
+  /**
+   * \brief Replace the group of next hops of a shared destination.
+   * \param prefix the index of the destination in the shared table
+   * \param nextHops the new next hops, possibly none
+   */
+  void SetSharedNextHops (uint32_t prefix, std::vector<NextHop_t> const &nextHops);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  RouteIndexes m_hostIndex;            //!< Lookup index of m_hostRoutes
+  RouteIndexes m_networkIndex;         //!< Lookup index of m_networkRoutes
+  RouteIndexes m_ASexternalIndex;      //!< Lookup index of m_ASexternalRoutes
+  uint64_t m_nextOrder;                //!< Position of the next route added
+
+  Ptr<const GlobalRoutePrefixes> m_sharedPrefixes;     //!< Destinations of the shared routes, or 0
+  std::vector<uint32_t> m_sharedRoutes;                //!< Next hop group of each shared destination
+  std::vector<std::vector<NextHop_t> > m_nextHopGroups;  //!< Groups of next hops of the shared routes
+  std::map<std::vector<NextHop_t>, uint32_t> m_nextHopGroupIndex;  //!< Number of each group, while adding
+  uint32_t m_nSharedRoutes;                            //!< Number of shared routes
+  mutable std::vector<Ipv4RoutingTableEntry> m_sharedEntries;  //!< Shared routes, built by GetRoute ()
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
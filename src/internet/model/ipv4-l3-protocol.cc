@@ -32,6 +32,9 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/hash.h"
+#include <algorithm>
+#include <cstring>
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -216,21 +219,9 @@ Ipv4L3Protocol::DoDispose (void)
   m_node = 0;
   m_routingProtocol = 0;
 
-  for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-    {
-      it->second = 0;
-    }
-
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
-    {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
-    }
-
+  m_fragmentsTimer.Cancel ();
   m_fragments.clear ();
-  m_fragmentsTimers.clear ();
+  m_fragmentsTimeouts.clear ();
 
   Object::DoDispose ();
 }
@@ -1271,19 +1262,23 @@ Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, uint32_t outIfaceMtu, std::
   return;
 }
 
+size_t
+Ipv4L3Protocol::FragmentsKeyHash::operator () (const FragmentsKey_t &key) const
+{
+  char buf[12];
+  std::memcpy (buf, &key.first, 8);
+  std::memcpy (buf + 8, &key.second, 4);
+  return Hash32 (buf, 12);
+}
+
 bool
 Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint32_t iif)
 {
   NS_LOG_FUNCTION (this << packet << ipHeader << iif);
 
-  uint64_t addressCombination = uint64_t (ipHeader.GetSource ().Get ()) << 32 & uint64_t (ipHeader.GetDestination ().Get ());
-  uint32_t idProto = uint32_t (ipHeader.GetIdentification ()) << 16 & uint32_t (ipHeader.GetProtocol ());
-  std::pair<uint64_t, uint32_t> key;
-  bool ret = false;
-  Ptr<Packet> p = packet->Copy ();
-
-  key.first = addressCombination;
-  key.second = idProto;
+  FragmentsKey_t key;
+  key.first = uint64_t (ipHeader.GetSource ().Get ()) << 32 | uint64_t (ipHeader.GetDestination ().Get ());
+  key.second = uint32_t (ipHeader.GetIdentification ()) << 16 | uint32_t (ipHeader.GetProtocol ());
 
   Ptr<Fragments> fragments;
 
@@ -1292,9 +1287,34 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
+
+      // All the packets share one expiration event, for the first
+      // expiration. The timeout rarely changes, so the expirations are
+      // almost always appended.
+      FragmentsTimeout timeout;
+      timeout.expiration = Simulator::Now () + m_fragmentExpirationTimeout;
+      timeout.key = key;
+      timeout.ipHeader = ipHeader;
+      timeout.iif = iif;
+      FragmentsTimeoutList_t::iterator pos = m_fragmentsTimeouts.end ();
+      while (pos != m_fragmentsTimeouts.begin ())
+        {
+          FragmentsTimeoutList_t::iterator prev = pos;
+          prev--;
+          if (prev->expiration <= timeout.expiration)
+            {
+              break;
+            }
+          pos = prev;
+        }
+      pos = m_fragmentsTimeouts.insert (pos, timeout);
+      fragments->SetTimeout (pos);
+      if (pos == m_fragmentsTimeouts.begin ())
+        {
+          m_fragmentsTimer.Cancel ();
+          m_fragmentsTimer = Simulator::Schedule (m_fragmentExpirationTimeout,
+                                                  &Ipv4L3Protocol::HandleFragmentsTimeout, this);
+        }
     }
   else
     {
@@ -1303,29 +1323,33 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
 
   NS_LOG_LOGIC ("Adding fragment - Size: " << packet->GetSize ( ) << " - Offset: " << (ipHeader.GetFragmentOffset ()) );
 
-  fragments->AddFragment (p, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
+  // The packet is already a copy made by LocalDeliver, so it is kept as is.
+  fragments->AddFragment (packet, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
 
   if ( fragments->IsEntire () )
     {
       packet = fragments->GetPacket ();
-      fragments = 0;
+      NS_LOG_LOGIC ("Removing the expiration of the complete packet at " << Simulator::Now ().GetSeconds ());
+      m_fragmentsTimeouts.erase (fragments->GetTimeout ());
       m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
+      if (m_fragmentsTimeouts.empty ())
         {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
+          m_fragmentsTimer.Cancel ();
         }
-      m_fragmentsTimers.erase (key);
-      ret = true;
+      return true;
     }
 
-  return ret;
+  return false;
 }
 
 Ipv4L3Protocol::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_size (0xffffffff)
 {
   NS_LOG_FUNCTION (this);
+  Hole hole;
+  hole.first = 0;
+  hole.last = m_size;
+  m_holes.push_back (hole);
 }
 
 Ipv4L3Protocol::Fragments::~Fragments ()
@@ -1338,22 +1362,72 @@ Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentO
 {
   NS_LOG_FUNCTION (this << fragment << fragmentOffset << moreFragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  uint32_t first = fragmentOffset;
+  uint32_t last = first + fragment->GetSize ();
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (!moreFragment && m_size == 0xffffffff)
     {
-      if (it->second > fragmentOffset)
+      // The last fragment gives the size of the packet: forget the holes
+      // past its end.
+      m_size = last;
+      std::list<Hole>::iterator hole = m_holes.begin ();
+      while (hole != m_holes.end ())
         {
-          break;
+          if (hole->first >= m_size)
+            {
+              hole = m_holes.erase (hole);
+            }
+          else
+            {
+              hole->last = std::min (hole->last, m_size);
+              hole++;
+            }
         }
     }
-
-  if (it == m_fragments.end ())
+  if (first == last)
     {
-      m_moreFragment = moreFragment;
+      return;
     }
 
-  m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  // Fill the holes the fragment overlaps. The bytes already received are
+  // kept: we do not overwrite the "old" with the "new" because we do not
+  // know when each arrived. This is different from what Linux does.
+  std::list<Hole>::iterator hole = m_holes.begin ();
+  while (hole != m_holes.end () && hole->first < last)
+    {
+      if (hole->last <= first)
+        {
+          hole++;
+          continue;
+        }
+      uint32_t start = std::max (first, hole->first);
+      uint32_t end = std::min (last, hole->last);
+      if (start == first && end == last)
+        {
+          m_fragments[start] = fragment;
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Overlapping fragment, keeping " << start << " - " << end);
+          m_fragments[start] = fragment->CreateFragment (start - first, end - start);
+        }
+      if (hole->first < start)
+        {
+          Hole before;
+          before.first = hole->first;
+          before.last = start;
+          m_holes.insert (hole, before);
+        }
+      if (end < hole->last)
+        {
+          hole->first = end;
+          hole++;
+        }
+      else
+        {
+          hole = m_holes.erase (hole);
+        }
+    }
 }
 
 bool
@@ -1361,29 +1435,7 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  return m_holes.empty ();
 }
 
 Ptr<Packet>
@@ -1391,33 +1443,22 @@ Ipv4L3Protocol::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
-
-  Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
+  if (m_fragments.empty ())
+    {
+      return Create<Packet> ();
+    }
 
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  // The fragments do not overlap: they are appended as they are.
+  std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
+  Ptr<Packet> p = it->second->Copy ();
+  for (it++; it != m_fragments.end () && it->first < m_size; it++)
     {
-      if ( lastEndOffset > it->second )
-        {
-          // The fragments are overlapping.
-          // We do not overwrite the "old" with the "new" because we do not know when each arrived.
-          // This is different from what Linux does.
-          // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
-            {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-              p->AddAtEnd (tempFragment);
-            }
-        }
-      else
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      NS_LOG_LOGIC ("Adding: " << *(it->second) );
+      p->AddAtEnd (it->second);
+    }
+  if (p->GetSize () > m_size)
+    {
+      p->RemoveAtEnd (p->GetSize () - m_size);
     }
 
   return p;
@@ -1427,58 +1468,63 @@ Ptr<Packet>
 Ipv4L3Protocol::Fragments::GetPartialPacket () const
 {
   NS_LOG_FUNCTION (this);
-  
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
 
+  // The complete part of the packet ends at the first hole.
+  uint32_t end = m_holes.empty () ? m_size : m_holes.front ().first;
   Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
-
-  if ( m_fragments.begin ()->second > 0 )
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
+       it != m_fragments.end () && it->first < end; it++)
     {
-      return p;
-    }
-
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
-    {
-      if ( lastEndOffset > it->second )
-        {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-          p->AddAtEnd (tempFragment);
-        }
-      else if ( lastEndOffset == it->second )
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      p->AddAtEnd (it->second);
     }
 
   return p;
 }
 
 void
-Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif)
+Ipv4L3Protocol::Fragments::SetTimeout (FragmentsTimeoutList_t::iterator timeout)
 {
-  NS_LOG_FUNCTION (this << &key << &ipHeader << iif);
+  NS_LOG_FUNCTION (this);
+  m_timeout = timeout;
+}
 
-  MapFragments_t::iterator it = m_fragments.find (key);
-  Ptr<Packet> packet = it->second->GetPartialPacket ();
+Ipv4L3Protocol::FragmentsTimeoutList_t::iterator
+Ipv4L3Protocol::Fragments::GetTimeout (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_timeout;
+}
+
+void
+Ipv4L3Protocol::HandleFragmentsTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
 
-  // if we have at least 8 bytes, we can send an ICMP.
-  if ( packet->GetSize () > 8 )
+  Time now = Simulator::Now ();
+  while (!m_fragmentsTimeouts.empty () && m_fragmentsTimeouts.front ().expiration <= now)
     {
-      Ptr<Icmpv4L4Protocol> icmp = GetIcmp ();
-      icmp->SendTimeExceededTtl (ipHeader, packet);
-    }
-  m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
+      FragmentsTimeout timeout = m_fragmentsTimeouts.front ();
+      m_fragmentsTimeouts.pop_front ();
+      MapFragments_t::iterator it = m_fragments.find (timeout.key);
+      NS_ASSERT_MSG (it != m_fragments.end (), "IPv4 fragment timeout reached for non-existent fragments");
+      Ptr<Packet> packet = it->second->GetPartialPacket ();
+      // clear the buffers
+      m_fragments.erase (it);
 
-  // clear the buffers
-  it->second = 0;
+      // if we have at least 8 bytes, we can send an ICMP.
+      if ( packet->GetSize () > 8 )
+        {
+          Ptr<Icmpv4L4Protocol> icmp = GetIcmp ();
+          icmp->SendTimeExceededTtl (timeout.ipHeader, packet);
+        }
+      m_dropTrace (timeout.ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), timeout.iif);
+    }
 
-  m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
+  if (!m_fragmentsTimeouts.empty ())
+    {
+      m_fragmentsTimer = Simulator::Schedule (m_fragmentsTimeouts.front ().expiration - now,
+                                              &Ipv4L3Protocol::HandleFragmentsTimeout, this);
+    }
 }
 
 } // namespace ns3
@@ -34,6 +34,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
+#include "ns3/hash-map.h"
 
 namespace ns3 {
 
@@ -368,12 +369,10 @@ private:
   bool ProcessFragment (Ptr<Packet>& packet, Ipv4Header & ipHeader, uint32_t iif);
 
   /**
-   * \brief Process the timeout for packet fragments
-   * \param key representing the packet fragments
-   * \param ipHeader the IP header of the original packet
-   * \param iif Input Interface
+   * \brief Drop the packets whose fragments have expired, and wait for
+   * the next expiration.
    */
-  void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
+  void HandleFragmentsTimeout (void);
 
   /**
    * \brief Container of the IPv4 Interfaces.
@@ -417,9 +416,43 @@ private:
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
+  /// Key of the fragments of a packet: (src+dst addr, identification+proto)
+  typedef std::pair<uint64_t, uint32_t> FragmentsKey_t;
+
+  /**
+   * \brief Hash of a FragmentsKey_t
+   */
+  struct FragmentsKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator () (const FragmentsKey_t &key) const;
+  };
+
+  /**
+   * \brief The expiration of the fragments of a packet
+   */
+  struct FragmentsTimeout
+  {
+    Time expiration;      //!< Time at which the fragments are dropped
+    FragmentsKey_t key;   //!< Key of the fragments
+    Ipv4Header ipHeader;  //!< IP header of the first fragment received
+    uint32_t iif;         //!< Input interface of the first fragment received
+  };
+
+  /// Expirations of the fragmented packets, by expiration time
+  typedef std::list<FragmentsTimeout> FragmentsTimeoutList_t;
+
   /**
    * \class Fragments
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
+   *
+   * The fragments are kept without overlap, the bytes received first being
+   * kept, and the ranges of bytes still missing are tracked as a list of
+   * holes (RFC 815), so that adding a fragment only looks at the holes it
+   * fills and the packet is assembled once, when the last hole is filled.
    */
   class Fragments : public SimpleRefCount<Fragments>
   {
@@ -460,27 +493,56 @@ public:
      */
     Ptr<Packet> GetPartialPacket () const;
 
+    /**
+     * \brief Set the expiration of the fragments.
+     * \param timeout the expiration, in the list of expirations
+     */
+    void SetTimeout (FragmentsTimeoutList_t::iterator timeout);
+
+    /**
+     * \brief Get the expiration of the fragments.
+     * \return the expiration, in the list of expirations
+     */
+    FragmentsTimeoutList_t::iterator GetTimeout (void) const;
+
 private:
     /**
-     * \brief True if other fragments will be sent.
+     * \brief A range of bytes not received yet, from first to last excluded.
      */
-    bool m_moreFragment;
+    struct Hole
+    {
+      uint32_t first; //!< First byte of the hole
+      uint32_t last;  //!< Byte following the hole
+    };
 
     /**
-     * \brief The current fragments.
+     * \brief The size of the packet, known once the last fragment is received.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    uint32_t m_size;
 
+    /**
+     * \brief The holes, by offset.
+     */
+    std::list<Hole> m_holes;
+
+    /**
+     * \brief The current fragments, by offset, without overlap.
+     */
+    std::map<uint32_t, Ptr<Packet> > m_fragments;
+
+    /**
+     * \brief The expiration of the fragments.
+     */
+    FragmentsTimeoutList_t::iterator m_timeout;
   };
 
-  /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
-  typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  /// Container of fragment timeout event, stored as pairs(src+dst addr, src+dst port) / EventId
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
+  /// Container of fragments, stored as pairs(src+dst addr, identification+proto) / fragment
+  typedef HashMap<FragmentsKey_t, Ptr<Fragments>, FragmentsKeyHash> MapFragments_t;
 
   MapFragments_t       m_fragments; //!< Fragmented packets.
   Time                 m_fragmentExpirationTimeout; //!< Expiration timeout
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Expiration events.
+  FragmentsTimeoutList_t m_fragmentsTimeouts; //!< Expirations of the fragmented packets.
+  EventId              m_fragmentsTimer; //!< Expiration event of the first fragmented packet.
 
 };
 
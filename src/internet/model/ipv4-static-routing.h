@@ -23,6 +23,7 @@
 #define IPV4_STATIC_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <utility>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
@@ -31,6 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "prefix-trie.h"
 
 namespace ns3 {
 
@@ -399,6 +401,38 @@ private:
   /// Iterator for container for the multicast routes
   typedef std::list<Ipv4MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /**
+   * \brief A network route in the lookup index, with its metric and its
+   * position in m_networkRoutes.
+   */
+  struct IndexedRoute
+  {
+    IndexedRoute (Ipv4RoutingTableEntry *route, uint32_t metric, uint64_t order)
+      : m_route (route),
+        m_metric (metric),
+        m_order (order)
+    {
+    }
+    bool operator == (IndexedRoute const &o) const
+    {
+      return m_route == o.m_route;
+    }
+    bool operator < (IndexedRoute const &o) const
+    {
+      return m_order < o.m_order;
+    }
+    Ipv4RoutingTableEntry *m_route;
+    uint32_t m_metric;
+    uint64_t m_order;
+  };
+
+  /**
+   * \brief Append a route to the forwarding table and its lookup index.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void AddRoute (Ipv4RoutingTableEntry *route, uint32_t metric);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -430,6 +464,22 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief prefix index of the routes of m_networkRoutes with a
+   * contiguous mask.
+   */
+  PrefixTrie<uint32_t, IndexedRoute> m_networkIndex;
+
+  /**
+   * \brief the routes of m_networkRoutes with any other mask.
+   */
+  std::vector<IndexedRoute> m_irregularRoutes;
+
+  /**
+   * \brief position of the next route added to m_networkRoutes.
+   */
+  uint64_t m_nextOrder;
+
   /**
    * \brief the forwarding table for multicast.
    */
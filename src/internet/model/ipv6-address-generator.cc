@@ -17,7 +17,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <list>
+#include <map>
 #include "ns3/abort.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
@@ -173,16 +173,20 @@ public:
 
   /**
    * \internal
-   * \brief This class holds the allocated addresses
+   * \brief The allocated addresses, as disjoint and non-adjacent ranges:
+   * the highest address of each range, indexed by its lowest address
    */
-  class Entry
-  {
-public:
-    uint8_t addrLow[16];  //!< /internal the lowest allocated address
-    uint8_t addrHigh[16]; //!< /internal the highest allocated address
-  };
+  typedef std::map<Ipv6Address, Ipv6Address> Entries;
+
+  /**
+   * \internal
+   * \param a an address
+   * \param b another address
+   * \returns true if b is the address following a
+   */
+  static bool IsSuccessor (const Ipv6Address &a, const Ipv6Address &b);
 
-  std::list<Entry> m_entries; //!< /internal contained of allocated addresses
+  Entries m_entries; //!< /internal contained of allocated addresses
   Ipv6Address m_base; //!< /internal base address
   bool m_test; //!< /internal test mode (if true)
 };
@@ -474,115 +478,78 @@ Ipv6AddressGeneratorImpl::AddAllocated (const Ipv6Address address)
 {
   NS_LOG_FUNCTION (this << address);
 
-  uint8_t addr[16];
-  address.GetBytes (addr);
-
-  std::list<Entry>::iterator i;
-
-  for (i = m_entries.begin (); i != m_entries.end (); ++i)
+  //
+  // The first block starting above the new address, and the block before
+  // it, which is the only one that may hold the new address.
+  //
+  Entries::iterator next = m_entries.upper_bound (address);
+  Entries::iterator prev = next;
+  bool hasPrev = next != m_entries.begin ();
+  if (hasPrev)
     {
-      NS_LOG_LOGIC ("examine entry: " << Ipv6Address ((*i).addrLow) <<
-                    " to " << Ipv6Address ((*i).addrHigh));
+      --prev;
+      NS_LOG_LOGIC ("examine entry: " << prev->first << " to " << prev->second);
       //
       // First things first.  Is there an address collision -- that is, does the
       // new address fall in a previously allocated block of addresses.
       //
-      if (!(Ipv6Address (addr) < Ipv6Address ((*i).addrLow))
-          && ((Ipv6Address (addr) < Ipv6Address ((*i).addrHigh))
-              || (Ipv6Address (addr) == Ipv6Address ((*i).addrHigh))))
+      if (!(prev->second < address))
         {
-          NS_LOG_LOGIC ("Ipv6AddressGeneratorImpl::Add(): Address Collision: " << Ipv6Address (addr));
+          NS_LOG_LOGIC ("Ipv6AddressGeneratorImpl::Add(): Address Collision: " << address);
           if (!m_test)
             {
-              NS_FATAL_ERROR ("Ipv6AddressGeneratorImpl::Add(): Address Collision: " << Ipv6Address (addr));
+              NS_FATAL_ERROR ("Ipv6AddressGeneratorImpl::Add(): Address Collision: " << address);
             }
           return false;
         }
-      //
-      // If the new address is less than the lowest address in the current
-      // block and can't be merged into to the current block, then insert it
-      // as a new block before the current block.
-      //
-      uint8_t taddr[16];
-      for (uint32_t j = 0; j < 16; j++)
-        {
-          taddr[j] = (*i).addrLow[j];
-        }
-      taddr[15] -= 1;
-      if (Ipv6Address (addr) < Ipv6Address (taddr))
-        {
-          break;
-        }
-      //
-      // If the new address fits at the end of the block, look ahead to the next
-      // block and make sure it's not a collision there.  If we won't overlap,
-      // then just extend the current block by one address.  We expect that
-      // completely filled network ranges will be a fairly rare occurrence,
-      // so we don't worry about collapsing address range blocks.
-      //
-      for (uint32_t j = 0; j < 16; j++)
-        {
-          taddr[j] = (*i).addrLow[j];
-        }
-      taddr[15] += 1;
-      if (Ipv6Address (addr) == Ipv6Address (taddr))
-        {
-          std::list<Entry>::iterator j = i;
-          ++j;
-
-          if (j != m_entries.end ())
-            {
-              if (Ipv6Address (addr) == Ipv6Address ((*j).addrLow))
-                {
-                  NS_LOG_LOGIC ("Ipv6AddressGeneratorImpl::Add(): "
-                                "Address Collision: " << Ipv6Address (addr));
-                  if (!m_test)
-                    {
-                      NS_FATAL_ERROR ("Ipv6AddressGeneratorImpl::Add(): Address Collision: " << Ipv6Address (addr));
-                    }
-                  return false;
-                }
-            }
-
-          NS_LOG_LOGIC ("New addrHigh = " << Ipv6Address (addr));
-          for (uint32_t j = 0; j < 16; j++)
-            {
-              (*i).addrHigh[j] = addr[j];
-            }
-          return true;
-        }
-      //
-      // If we get here, we know that the next lower block of addresses
-      // couldn't have been extended to include this new address since the
-      // code immediately above would have been executed and that next lower
-      // block extended upward.  So we know it's safe to extend the current
-      // block down to includ the new address.
-      //
-      for (uint32_t j = 0; j < 16; j++)
-        {
-          taddr[j] = (*i).addrLow[j];
-        }
-      taddr[15] -= 1;
-      if ((Ipv6Address (addr) == Ipv6Address (taddr)))
-        {
-          NS_LOG_LOGIC ("New addrLow = " << Ipv6Address (addr));
-          for (uint32_t j = 0; j < 16; j++)
-            {
-              (*i).addrLow[j] = addr[j];
-            }
-          return true;
-        }
     }
-
-  Entry entry;
-  for (uint32_t j = 0; j < 16; j++)
+  //
+  // Otherwise extend the neighbouring blocks to the new address, merging
+  // them if it was the only address between them, or start a new block.
+  //
+  bool extendsPrev = hasPrev && IsSuccessor (prev->second, address);
+  bool extendsNext = next != m_entries.end () && IsSuccessor (address, next->first);
+  if (extendsPrev && extendsNext)
+    {
+      NS_LOG_LOGIC ("Merge blocks at " << address);
+      prev->second = next->second;
+      m_entries.erase (next);
+    }
+  else if (extendsPrev)
+    {
+      NS_LOG_LOGIC ("New addrHigh = " << address);
+      prev->second = address;
+    }
+  else if (extendsNext)
     {
-      entry.addrLow[j] = entry.addrHigh[j] = addr[j];
+      NS_LOG_LOGIC ("New addrLow = " << address);
+      Ipv6Address high = next->second;
+      m_entries.erase (next++);
+      m_entries.insert (next, std::make_pair (address, high));
+    }
+  else
+    {
+      m_entries.insert (prev, std::make_pair (address, address));
     }
-  m_entries.insert (i, entry);
   return true;
 }
 
+bool
+Ipv6AddressGeneratorImpl::IsSuccessor (const Ipv6Address &a, const Ipv6Address &b)
+{
+  uint8_t buf[16];
+  a.GetBytes (buf);
+  // Add one, propagating the carry from the last byte
+  for (int32_t j = 15; j >= 0; j--)
+    {
+      if (++buf[j] != 0)
+        {
+          return Ipv6Address (buf) == b;
+        }
+    }
+  return false;
+}
+
 void
 Ipv6AddressGeneratorImpl::TestMode (void)
 {
@@ -18,6 +18,7 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -27,10 +28,38 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux")
   ;
 
+Ipv6EndPointDemux::Key::Key (uint16_t localPort, Ipv6Address localAddress,
+                             uint16_t peerPort, Ipv6Address peerAddress)
+  : m_localPort (localPort),
+    m_localAddress (localAddress),
+    m_peerPort (peerPort),
+    m_peerAddress (peerAddress)
+{
+}
+
+bool Ipv6EndPointDemux::Key::operator< (const Key &o) const
+{
+  if (m_localPort != o.m_localPort)
+    {
+      return m_localPort < o.m_localPort;
+    }
+  if (m_localAddress != o.m_localAddress)
+    {
+      return m_localAddress < o.m_localAddress;
+    }
+  if (m_peerPort != o.m_peerPort)
+    {
+      return m_peerPort < o.m_peerPort;
+    }
+  return m_peerAddress < o.m_peerAddress;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_ephemeralUsed (m_portFirst, m_portLast),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -38,39 +67,79 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv6EndPoint *>::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv6EndPoint *endPoint = *i;
+      Ipv6EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demuxOrder = m_nextOrder++;
+  m_endPoints[endPoint->m_demuxOrder] = endPoint;
+  Index (endPoint);
+  endPoint->m_demux = this;
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Key key (endPoint->GetLocalPort (), endPoint->GetLocalAddress (),
+           endPoint->GetPeerPort (), endPoint->GetPeerAddress ());
+  m_index[key].push_back (endPoint);
+  m_ephemeralUsed.SetUsed (key.m_localPort, true);
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Key key (endPoint->GetLocalPort (), endPoint->GetLocalAddress (),
+           endPoint->GetPeerPort (), endPoint->GetPeerAddress ());
+  EndPointIndex::iterator i = m_index.find (key);
+  NS_ASSERT_MSG (i != m_index.end (), "End point " << endPoint << " not indexed");
+  i->second.remove (endPoint);
+  if (i->second.empty ())
     {
-      if ((*i)->GetLocalPort  () == port)
+      m_index.erase (i);
+      if (!LookupPortLocal (key.m_localPort))
         {
-          return true;
+          m_ephemeralUsed.SetUsed (key.m_localPort, false);
         }
     }
-  return false;
 }
 
-bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+void Ipv6EndPointDemux::AddCandidates (const Key &key, Candidates &candidates) const
 {
-  NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  EndPointIndex::const_iterator i = m_index.find (key);
+  if (i == m_index.end ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
-        {
-          return true;
-        }
+      return;
+    }
+  for (EndPoints::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+      candidates.push_back (std::make_pair ((*j)->m_demuxOrder, *j));
     }
-  return false;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  /* the wildcards sort first, so the first key with this port, if any,
+     follows them */
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (port, Ipv6Address::GetAny (), 0, Ipv6Address::GetAny ()));
+  return i != m_index.end () && i->first.m_localPort == port;
+}
+
+bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << addr << port);
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (port, addr, 0, Ipv6Address::GetAny ()));
+  return i != m_index.end () && i->first.m_localPort == port && i->first.m_localAddress == addr;
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -83,7 +152,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -98,7 +167,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -119,7 +188,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -128,21 +197,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (m_index.find (Key (localPort, localAddress, peerPort, peerAddress)) != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -152,15 +215,14 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (endPoint->m_demuxOrder);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -180,9 +242,28 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* Only the end points with the local port, a wildcard or exact local
+     address, and a wildcard or exact peer may match.  They are looked at
+     in the order they were allocated. */
+  Ipv6Address any = Ipv6Address::GetAny ();
+  Candidates candidates;
+  for (uint32_t k = 0; k < 8; k++)
     {
-      Ipv6EndPoint* endP = *i;
+      Ipv6Address localAddress = (k & 1) ? daddr : any;
+      uint16_t peerPort = (k & 2) ? sport : 0;
+      Ipv6Address peerAddress = (k & 4) ? saddr : any;
+      if (((k & 1) && daddr == any) || ((k & 2) && sport == 0) || ((k & 4) && saddr == any))
+        {
+          continue;
+        }
+      AddCandidates (Key (dport, localAddress, peerPort, peerAddress), candidates);
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  for (Candidates::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ipv6EndPoint* endP = i->second;
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
                                                  << " sport=" << endP->GetPeerPort ()
@@ -281,39 +362,42 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  Candidates candidates;
+  AddCandidates (Key (dport, dst, sport, src), candidates);
+  if (!candidates.empty ())
+    {
+      /* this is an exact match. */
+      return std::min_element (candidates.begin (), candidates.end ())->second;
+    }
+
+  /* otherwise the first allocated of the least generic end points with
+     the local port */
   uint32_t genericity = 3;
+  uint64_t order = 0;
   Ipv6EndPoint *generic = 0;
-
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  EndPointIndex::const_iterator i = m_index.lower_bound (Key (dport, Ipv6Address::GetAny (), 0, Ipv6Address::GetAny ()));
+  for (; i != m_index.end () && i->first.m_localPort == dport; i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (i->first.m_localAddress == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (i->first.m_peerAddress == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if (tmp < genericity)
+      for (EndPoints::const_iterator j = i->second.begin (); j != i->second.end (); j++)
         {
-          generic = (*i);
-          genericity = tmp;
+          if (tmp < genericity || (tmp == genericity && (*j)->m_demuxOrder < order))
+            {
+              generic = (*j);
+              genericity = tmp;
+              order = (*j)->m_demuxOrder;
+            }
         }
     }
   return generic;
@@ -322,28 +406,25 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
 uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do
+  // Same order as counting up from the last port allocated, as in
+  // netinet/in_pcb.c, without probing the ports in use one by one.
+  uint16_t port = m_ephemeralUsed.FindFree (m_ephemeral);
+  if (port == 0)
     {
-      if (count-- < 0)
-        {
-          return 0;
-        }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
-        {
-          port = m_portFirst;
-        }
+      return 0;
     }
-  while (LookupPortLocal (port));
   m_ephemeral = port;
   return port;
 }
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (std::map<uint64_t, Ipv6EndPoint *>::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    {
+      ret.push_back (i->second);
+    }
+  return ret;
 }
 
 } /* namespace ns3 */
@@ -33,6 +33,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \brief A representation of an internet IPv6 endpoint/connection
@@ -234,6 +235,18 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+  friend class Ipv6EndPointDemux;
+
+  /**
+   * \brief The demux indexing this end point, told when its addresses
+   * or ports change (0 if none).
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  /**
+   * \brief The rank of the allocation of this end point by its demux.
+   */
+  uint64_t m_demuxOrder;
 };
 
 } /* namespace ns3 */
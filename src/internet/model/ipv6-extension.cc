@@ -20,6 +20,7 @@
 
 #include <list>
 #include <ctime>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/assert.h"
@@ -315,12 +316,9 @@ void Ipv6ExtensionFragment::DoDispose ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (MapFragments_t::iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-    {
-      it->second = 0;
-    }
-
+  m_fragmentsTimer.Cancel ();
   m_fragments.clear ();
+  m_fragmentsTimeouts.clear ();
   Ipv6Extension::DoDispose ();
 }
 
@@ -351,21 +349,28 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet, uint8_t offset, Ipv
   uint32_t identification = fragmentHeader.GetIdentification ();
   Ipv6Address src = ipv6Header.GetSourceAddress ();
 
-  std::pair<Ipv6Address, uint32_t> fragmentsId = std::pair<Ipv6Address, uint32_t> (src, identification);
+  FragmentsKey_t fragmentsId = FragmentsKey_t (src, identification);
   Ptr<Fragments> fragments;
 
-  Ipv6Header ipHeader = ipv6Header;
-  ipHeader.SetNextHeader (fragmentHeader.GetNextHeader ());
-
   MapFragments_t::iterator it = m_fragments.find (fragmentsId);
   if (it == m_fragments.end ())
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (fragmentsId, fragments));
-      EventId timeout = Simulator::Schedule (Seconds (60),
-                                             &Ipv6ExtensionFragment::HandleFragmentsTimeout, this,
-                                             fragmentsId, ipHeader);
-      fragments->SetTimeoutEventId (timeout);
+
+      // The timeout is constant: the expirations are appended in order,
+      // and one event waits for the first of them.
+      FragmentsTimeout timeout;
+      timeout.expiration = Simulator::Now () + Seconds (60);
+      timeout.key = fragmentsId;
+      timeout.ipHeader = ipv6Header;
+      timeout.ipHeader.SetNextHeader (fragmentHeader.GetNextHeader ());
+      fragments->SetTimeout (m_fragmentsTimeouts.insert (m_fragmentsTimeouts.end (), timeout));
+      if (m_fragmentsTimeouts.size () == 1)
+        {
+          m_fragmentsTimer = Simulator::Schedule (Seconds (60),
+                                                  &Ipv6ExtensionFragment::HandleFragmentsTimeout, this);
+        }
     }
   else
     {
@@ -384,8 +389,12 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet, uint8_t offset, Ipv
   if (fragments->IsEntire ())
     {
       packet = fragments->GetPacket ();
-      fragments->CancelTimeout ();
+      m_fragmentsTimeouts.erase (fragments->GetTimeout ());
       m_fragments.erase (fragmentsId);
+      if (m_fragmentsTimeouts.empty ())
+        {
+          m_fragmentsTimer.Cancel ();
+        }
       isDropped = false;
     }
   else
@@ -573,34 +582,57 @@ void Ipv6ExtensionFragment::GetFragments (Ptr<Packet> packet, uint32_t maxFragme
 }
 
 
-void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> fragmentsId,
-                                                    Ipv6Header & ipHeader)
+void Ipv6ExtensionFragment::HandleFragmentsTimeout (void)
 {
-  Ptr<Fragments> fragments;
-
-  MapFragments_t::iterator it = m_fragments.find (fragmentsId);
-  NS_ASSERT_MSG(it != m_fragments.end (), "IPv6 Fragment timeout reached for non-existent fragment");
-  fragments = it->second;
+  NS_LOG_FUNCTION (this);
 
-  Ptr<Packet> packet = fragments->GetPartialPacket ();
+  Time now = Simulator::Now ();
+  while (!m_fragmentsTimeouts.empty () && m_fragmentsTimeouts.front ().expiration <= now)
+    {
+      FragmentsTimeout timeout = m_fragmentsTimeouts.front ();
+      m_fragmentsTimeouts.pop_front ();
+      MapFragments_t::iterator it = m_fragments.find (timeout.key);
+      NS_ASSERT_MSG (it != m_fragments.end (), "IPv6 Fragment timeout reached for non-existent fragment");
+      Ptr<Packet> packet = it->second->GetPartialPacket ();
+      // clear the buffers
+      m_fragments.erase (it);
+
+      // without the first fragment, there is nothing to send back in an ICMP.
+      bool firstFragment = (packet != 0);
+      if (!firstFragment)
+        {
+          packet = Create<Packet> ();
+        }
+      packet->AddHeader (timeout.ipHeader);
 
-  packet->AddHeader (ipHeader);
+      // if we have at least 8 bytes, we can send an ICMP.
+      if ( firstFragment && packet->GetSize () > 8 )
+        {
+          Ptr<Icmpv6L4Protocol> icmp = GetNode ()->GetObject<Icmpv6L4Protocol> ();
+          icmp->SendErrorTimeExceeded (packet, timeout.ipHeader.GetSourceAddress (), Icmpv6Header::ICMPV6_FRAGTIME);
+        }
+      m_dropTrace (packet);
+    }
 
-  // if we have at least 8 bytes, we can send an ICMP.
-  if ( packet->GetSize () > 8 )
+  if (!m_fragmentsTimeouts.empty ())
     {
-      Ptr<Icmpv6L4Protocol> icmp = GetNode ()->GetObject<Icmpv6L4Protocol> ();
-      icmp->SendErrorTimeExceeded (packet, ipHeader.GetSourceAddress (), Icmpv6Header::ICMPV6_FRAGTIME);
+      m_fragmentsTimer = Simulator::Schedule (m_fragmentsTimeouts.front ().expiration - now,
+                                              &Ipv6ExtensionFragment::HandleFragmentsTimeout, this);
     }
-  m_dropTrace (packet);
+}
 
-  // clear the buffers
-  m_fragments.erase (fragmentsId);
+size_t Ipv6ExtensionFragment::FragmentsKeyHash::operator () (const FragmentsKey_t &key) const
+{
+  return Ipv6AddressHash () (key.first) ^ (key.second * 2654435761U);
 }
 
 Ipv6ExtensionFragment::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_size (0xffffffff)
 {
+  Hole hole;
+  hole.first = 0;
+  hole.last = m_size;
+  m_holes.push_back (hole);
 }
 
 Ipv6ExtensionFragment::Fragments::~Fragments ()
@@ -609,22 +641,69 @@ Ipv6ExtensionFragment::Fragments::~Fragments ()
 
 void Ipv6ExtensionFragment::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
 {
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  uint32_t first = fragmentOffset;
+  uint32_t last = first + fragment->GetSize ();
 
-  for (it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  if (!moreFragment && m_size == 0xffffffff)
     {
-      if (it->second > fragmentOffset)
+      // The last fragment gives the size of the fragmentable part: forget
+      // the holes past its end.
+      m_size = last;
+      std::list<Hole>::iterator hole = m_holes.begin ();
+      while (hole != m_holes.end ())
         {
-          break;
+          if (hole->first >= m_size)
+            {
+              hole = m_holes.erase (hole);
+            }
+          else
+            {
+              hole->last = std::min (hole->last, m_size);
+              hole++;
+            }
         }
     }
-
-  if (it == m_packetFragments.end ())
+  if (first == last)
     {
-      m_moreFragment = moreFragment;
+      return;
     }
 
-  m_packetFragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  // Fill the holes the fragment overlaps, keeping the bytes already received.
+  std::list<Hole>::iterator hole = m_holes.begin ();
+  while (hole != m_holes.end () && hole->first < last)
+    {
+      if (hole->last <= first)
+        {
+          hole++;
+          continue;
+        }
+      uint32_t start = std::max (first, hole->first);
+      uint32_t end = std::min (last, hole->last);
+      if (start == first && end == last)
+        {
+          m_packetFragments[start] = fragment;
+        }
+      else
+        {
+          m_packetFragments[start] = fragment->CreateFragment (start - first, end - start);
+        }
+      if (hole->first < start)
+        {
+          Hole before;
+          before.first = hole->first;
+          before.last = start;
+          m_holes.insert (hole, before);
+        }
+      if (end < hole->last)
+        {
+          hole->first = end;
+          hole++;
+        }
+      else
+        {
+          hole = m_holes.erase (hole);
+        }
+    }
 }
 
 void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfragmentablePart)
@@ -634,34 +713,25 @@ void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfrag
 
 bool Ipv6ExtensionFragment::Fragments::IsEntire () const
 {
-  bool ret = !m_moreFragment && m_packetFragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-        {
-          if (lastEndOffset != it->second)
-            {
-              ret = false;
-              break;
-            }
-
-          lastEndOffset += it->first->GetSize ();
-        }
-    }
-
-  return ret;
+  return m_holes.empty () && m_unfragmentable != 0;
 }
 
 Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPacket () const
 {
   Ptr<Packet> p =  m_unfragmentable->Copy ();
 
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  // The fragments do not overlap: they are appended as they are.
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin ();
+       it != m_packetFragments.end () && it->first < m_size; it++)
     {
-      p->AddAtEnd (it->first);
+      if (it->first + it->second->GetSize () > m_size)
+        {
+          p->AddAtEnd (it->second->CreateFragment (0, m_size - it->first));
+        }
+      else
+        {
+          p->AddAtEnd (it->second);
+        }
     }
 
   return p;
@@ -680,31 +750,25 @@ Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPartialPacket () const
       return p;
     }
 
-  uint16_t lastEndOffset = 0;
-
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  // The complete part of the packet ends at the first hole.
+  uint32_t end = m_holes.empty () ? m_size : m_holes.front ().first;
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin ();
+       it != m_packetFragments.end () && it->first < end; it++)
     {
-      if (lastEndOffset != it->second)
-        {
-          break;
-        }
-      p->AddAtEnd (it->first);
-      lastEndOffset += it->first->GetSize ();
+      p->AddAtEnd (it->second);
     }
 
   return p;
 }
 
-void Ipv6ExtensionFragment::Fragments::SetTimeoutEventId (EventId event)
+void Ipv6ExtensionFragment::Fragments::SetTimeout (FragmentsTimeoutList_t::iterator timeout)
 {
-  m_timeoutEventId = event;
-  return;
+  m_timeout = timeout;
 }
 
-void Ipv6ExtensionFragment::Fragments::CancelTimeout ()
+Ipv6ExtensionFragment::FragmentsTimeoutList_t::iterator Ipv6ExtensionFragment::Fragments::GetTimeout (void) const
 {
-  m_timeoutEventId.Cancel ();
-  return;
+  return m_timeout;
 }
 
 
@@ -34,6 +34,9 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/hash-map.h"
 
 
 namespace ns3 {
@@ -296,9 +299,44 @@ protected:
   virtual void DoDispose ();
 
 private:
+  /**
+   * \brief Key of the fragments of a packet: source address and identification.
+   */
+  typedef std::pair<Ipv6Address, uint32_t> FragmentsKey_t;
+
+  /**
+   * \brief Hash of a FragmentsKey_t
+   */
+  struct FragmentsKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator () (const FragmentsKey_t &key) const;
+  };
+
+  /**
+   * \brief The expiration of the fragments of a packet
+   */
+  struct FragmentsTimeout
+  {
+    Time expiration;      //!< Time at which the fragments are dropped
+    FragmentsKey_t key;   //!< Key of the fragments
+    Ipv6Header ipHeader;  //!< IPv6 header of the first fragment received
+  };
+
+  /**
+   * \brief Expirations of the fragmented packets, by expiration time.
+   */
+  typedef std::list<FragmentsTimeout> FragmentsTimeoutList_t;
+
   /**
    * \class Fragments
    * \brief A Set of Fragment
+   *
+   * As in Ipv4L3Protocol, the fragments are kept without overlap and the
+   * missing ranges of bytes are tracked as a list of holes (RFC 815).
    */
   class Fragments : public SimpleRefCount<Fragments>
   {
@@ -346,25 +384,41 @@ public:
     Ptr<Packet> GetPartialPacket () const;
 
     /**
-     * \brief Set the Timeout EventId.
+     * \brief Set the expiration of the fragments.
+     * \param timeout the expiration, in the list of expirations
      */
-    void SetTimeoutEventId (EventId event);
+    void SetTimeout (FragmentsTimeoutList_t::iterator timeout);
 
     /**
-     * \brief Cancel the timeout event
+     * \brief Get the expiration of the fragments.
+     * \return the expiration, in the list of expirations
      */
-    void CancelTimeout ();
+    FragmentsTimeoutList_t::iterator GetTimeout (void) const;
 
 private:
     /**
-     * \brief If other fragments will be sent.
+     * \brief A range of bytes not received yet, from first to last excluded.
+     */
+    struct Hole
+    {
+      uint32_t first; //!< First byte of the hole
+      uint32_t last;  //!< Byte following the hole
+    };
+
+    /**
+     * \brief The size of the fragmentable part, known once the last fragment is received.
      */
-    bool m_moreFragment;
+    uint32_t m_size;
 
     /**
-     * \brief The current fragments.
+     * \brief The holes, by offset.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_packetFragments;
+    std::list<Hole> m_holes;
+
+    /**
+     * \brief The current fragments, by offset, without overlap.
+     */
+    std::map<uint32_t, Ptr<Packet> > m_packetFragments;
 
     /**
      * \brief The unfragmentable part.
@@ -372,17 +426,16 @@ private:
     Ptr<Packet> m_unfragmentable;
 
     /**
-     * \brief Timeout handler event
+     * \brief The expiration of the fragments.
      */
-    EventId m_timeoutEventId;
+    FragmentsTimeoutList_t::iterator m_timeout;
   };
 
   /**
-   * \brief Process the timeout for packet fragments
-   * \param key representing the packet fragments
-   * \param ipHeader the IP header of the original packet
+   * \brief Drop the packets whose fragments have expired, and wait for
+   * the next expiration.
    */
-  void HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> key, Ipv6Header & ipHeader);
+  void HandleFragmentsTimeout (void);
 
   /**
    * \brief Get the packet parts so far received.
@@ -403,12 +456,22 @@ private:
   /**
    * \brief Container for the packet fragments.
    */
-  typedef std::map<std::pair<Ipv6Address, uint32_t>, Ptr<Fragments> > MapFragments_t;
+  typedef HashMap<FragmentsKey_t, Ptr<Fragments>, FragmentsKeyHash> MapFragments_t;
 
   /**
    * \brief The hash of fragmented packets.
    */
   MapFragments_t m_fragments;
+
+  /**
+   * \brief The expirations of the fragmented packets.
+   */
+  FragmentsTimeoutList_t m_fragmentsTimeouts;
+
+  /**
+   * \brief The expiration event of the first fragmented packet.
+   */
+  EventId m_fragmentsTimer;
 };
 
 /**
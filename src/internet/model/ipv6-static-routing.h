@@ -24,12 +24,14 @@
 #include <stdint.h>
 
 #include <list>
+#include <vector>
 
 #include "ns3/ptr.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-routing-protocol.h"
+#include "prefix-trie.h"
 
 namespace ns3 {
 
@@ -275,6 +277,44 @@ private:
   /// Iterator for container for the multicast routes
   typedef std::list<Ipv6MulticastRoutingTableEntry *>::iterator MulticastRoutesI;
 
+  /**
+   * \brief A network route in the lookup index, with its metric and its
+   * position in m_networkRoutes.
+   */
+  struct IndexedRoute
+  {
+    IndexedRoute (Ipv6RoutingTableEntry *route, uint32_t metric, uint64_t order)
+      : m_route (route),
+        m_metric (metric),
+        m_order (order)
+    {
+    }
+    bool operator == (IndexedRoute const &o) const
+    {
+      return m_route == o.m_route;
+    }
+    bool operator < (IndexedRoute const &o) const
+    {
+      return m_order < o.m_order;
+    }
+    Ipv6RoutingTableEntry *m_route;
+    uint32_t m_metric;
+    uint64_t m_order;
+  };
+
+  /**
+   * \brief Append a route to the forwarding table and its lookup index.
+   * \param route the route
+   * \param metric metric of the route
+   */
+  void AddRoute (Ipv6RoutingTableEntry *route, uint32_t metric);
+
+  /**
+   * \brief Remove a route of the forwarding table from the lookup index.
+   * \param route the route
+   */
+  void UnindexRoute (Ipv6RoutingTableEntry *route);
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -305,6 +345,22 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief prefix index of the routes of m_networkRoutes with a
+   * contiguous prefix.
+   */
+  PrefixTrie<Ipv6Address, IndexedRoute> m_networkIndex;
+
+  /**
+   * \brief the routes of m_networkRoutes with any other prefix.
+   */
+  std::vector<IndexedRoute> m_irregularRoutes;
+
+  /**
+   * \brief position of the next route added to m_networkRoutes.
+   */
+  uint64_t m_nextOrder;
+
   /**
    * \brief the forwarding table for multicast.
    */
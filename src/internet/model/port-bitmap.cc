@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "port-bitmap.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+static const uint64_t ALL_ONES = ~static_cast<uint64_t> (0);
+
+static uint32_t
+CountTrailingZeros (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll (x);
+#else
+  uint32_t n = 0;
+  while ((x & 1) == 0)
+    {
+      x >>= 1;
+      n++;
+    }
+  return n;
+#endif
+}
+
+PortBitmap::PortBitmap (uint16_t first, uint16_t last)
+  : m_first (first),
+    m_last (last)
+{
+  NS_ASSERT (first != 0 && first <= last);
+  uint32_t ports = last - first + 1;
+  uint32_t words = (ports + 63) / 64;
+  m_used.resize (words, 0);
+  m_full.resize ((words + 63) / 64, 0);
+  // The bits past the end of the range read as used, and the words
+  // past the end as full, so that they are never picked.
+  if (ports % 64 != 0)
+    {
+      m_used[words - 1] = ALL_ONES << (ports % 64);
+    }
+  if (words % 64 != 0)
+    {
+      m_full[m_full.size () - 1] = ALL_ONES << (words % 64);
+    }
+}
+
+void
+PortBitmap::SetUsed (uint16_t port, bool used)
+{
+  if (port < m_first || port > m_last)
+    {
+      return;
+    }
+  uint32_t i = port - m_first;
+  uint32_t w = i / 64;
+  uint64_t bit = static_cast<uint64_t> (1) << (i % 64);
+  if (used)
+    {
+      m_used[w] |= bit;
+    }
+  else
+    {
+      m_used[w] &= ~bit;
+    }
+  bit = static_cast<uint64_t> (1) << (w % 64);
+  if (m_used[w] == ALL_ONES)
+    {
+      m_full[w / 64] |= bit;
+    }
+  else
+    {
+      m_full[w / 64] &= ~bit;
+    }
+}
+
+bool
+PortBitmap::IsUsed (uint16_t port) const
+{
+  if (port < m_first || port > m_last)
+    {
+      return false;
+    }
+  uint32_t i = port - m_first;
+  return (m_used[i / 64] >> (i % 64)) & 1;
+}
+
+uint32_t
+PortBitmap::FindClear (const std::vector<uint64_t> &bits, uint32_t from, uint32_t to)
+{
+  while (from < to)
+    {
+      uint64_t clear = ~bits[from / 64] & (ALL_ONES << (from % 64));
+      if (clear != 0)
+        {
+          uint32_t i = from - from % 64 + CountTrailingZeros (clear);
+          return i < to ? i : to;
+        }
+      from += 64 - from % 64;
+    }
+  return to;
+}
+
+uint16_t
+PortBitmap::FindFree (uint16_t after) const
+{
+  uint32_t start = (after < m_first || after >= m_last) ? 0 : after - m_first + 1;
+  uint32_t words = m_used.size ();
+  uint32_t w = start / 64;
+  // In the order of a linear probe from start: the rest of its word,
+  // the next words up to the end of the range, the words from the
+  // beginning of the range, and the start of its own word.
+  uint64_t clear = ~m_used[w] & (ALL_ONES << (start % 64));
+  if (clear == 0)
+    {
+      uint32_t next = FindClear (m_full, w + 1, words);
+      if (next == words)
+        {
+          next = FindClear (m_full, 0, w);
+        }
+      clear = ~m_used[next];
+      w = next;
+    }
+  if (clear == 0)
+    {
+      return 0;
+    }
+  return m_first + w * 64 + CountTrailingZeros (clear);
+}
+
+} // namespace ns3
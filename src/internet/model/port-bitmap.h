@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PORT_BITMAP_H
+#define PORT_BITMAP_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief The ports in use in a range of ports, one bit per port.
+ *
+ * A second level of bits records which 64-port words of the range are
+ * full, so that finding a free port looks at a handful of words
+ * however many ports are in use.
+ */
+class PortBitmap
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param first the first port of the range
+   * \param last the last port of the range
+   */
+  PortBitmap (uint16_t first, uint16_t last);
+
+  /**
+   * \brief Mark a port as used or free.  Ports out of the range are
+   * ignored.
+   * \param port the port
+   * \param used true if the port is in use
+   */
+  void SetUsed (uint16_t port, bool used);
+
+  /**
+   * \param port the port
+   * \returns true if the port is in the range and in use
+   */
+  bool IsUsed (uint16_t port) const;
+
+  /**
+   * \brief Find the first free port after a port, wrapping around
+   * from the last port of the range to the first one.
+   * \param after the port to start after
+   * \returns the free port, or 0 if every port of the range is in use
+   */
+  uint16_t FindFree (uint16_t after) const;
+
+private:
+  /**
+   * \param bits a bitmap
+   * \param from the first bit to look at
+   * \param to the bit to stop at
+   * \returns the first clear bit in [from, to), or to if there is none
+   */
+  static uint32_t FindClear (const std::vector<uint64_t> &bits, uint32_t from, uint32_t to);
+
+  uint16_t m_first;               //!< first port of the range
+  uint16_t m_last;                //!< last port of the range
+  std::vector<uint64_t> m_used;   //!< one bit per port, set if used
+  std::vector<uint64_t> m_full;   //!< one bit per word of m_used, set if full
+};
+
+} // namespace ns3
+
+#endif /* PORT_BITMAP_H */
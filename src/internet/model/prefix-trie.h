@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+/**
+ * \brief Bit level operations on the keys of a PrefixTrie.
+ *
+ * Specializations must provide BITS, the length of a key in bits, and:
+ * - GetBit (key, i): bit i of the key, counting from the most significant;
+ * - CommonLength (a, b): the number of leading bits a and b have in
+ *   common, BITS if they are equal;
+ * - Mask (key, length): the key with all but its first length bits cleared.
+ */
+template <typename Key>
+struct PrefixTrieKeyTraits;
+
+/**
+ * \brief Key traits for IPv4 addresses, in host byte order.
+ */
+template <>
+struct PrefixTrieKeyTraits<uint32_t>
+{
+  static const uint32_t BITS = 32;
+
+  static bool GetBit (uint32_t key, uint32_t i)
+  {
+    return (key >> (31 - i)) & 1;
+  }
+
+  static uint32_t CommonLength (uint32_t a, uint32_t b)
+  {
+    uint32_t x = a ^ b;
+    if (x == 0)
+      {
+        return 32;
+      }
+#ifdef __GNUC__
+    return __builtin_clz (x);
+#else
+    uint32_t n = 0;
+    while ((x & 0x80000000) == 0)
+      {
+        x <<= 1;
+        n++;
+      }
+    return n;
+#endif
+  }
+
+  static uint32_t Mask (uint32_t key, uint32_t length)
+  {
+    return length == 0 ? 0 : key & (0xffffffff << (32 - length));
+  }
+};
+
+/**
+ * \brief Key traits for IPv6 addresses.
+ */
+template <>
+struct PrefixTrieKeyTraits<Ipv6Address>
+{
+  static const uint32_t BITS = 128;
+
+  static bool GetBit (Ipv6Address const &key, uint32_t i)
+  {
+    uint8_t buf[16];
+    key.GetBytes (buf);
+    return (buf[i / 8] >> (7 - i % 8)) & 1;
+  }
+
+  static uint32_t CommonLength (Ipv6Address const &a, Ipv6Address const &b)
+  {
+    uint8_t bufA[16];
+    uint8_t bufB[16];
+    a.GetBytes (bufA);
+    b.GetBytes (bufB);
+    for (uint32_t i = 0; i < 16; i++)
+      {
+        uint8_t x = bufA[i] ^ bufB[i];
+        if (x != 0)
+          {
+            uint32_t n = i * 8;
+            while ((x & 0x80) == 0)
+              {
+                x <<= 1;
+                n++;
+              }
+            return n;
+          }
+      }
+    return 128;
+  }
+
+  static Ipv6Address Mask (Ipv6Address const &key, uint32_t length)
+  {
+    uint8_t buf[16];
+    key.GetBytes (buf);
+    if (length < 128)
+      {
+        buf[length / 8] &= ~(0xff >> (length % 8));
+        std::memset (buf + length / 8 + 1, 0, 15 - length / 8);
+      }
+    return Ipv6Address (buf);
+  }
+};
+
+/**
+ * \brief A path-compressed binary trie mapping prefixes to lists of values.
+ *
+ * This is the index behind the routing table lookups: each prefix (a key
+ * and a length in bits) holds the values inserted for it, in insertion
+ * order, and Lookup () returns the values of every prefix matching a key,
+ * from the shortest prefix to the longest.  Chains of nodes with a single
+ * child and no values are collapsed, so a lookup visits at most one node
+ * per distinct prefix length on its path, whatever the size of the table.
+ *
+ * Values are compared with operator== on removal, so that they may carry
+ * data (e.g. an insertion order) which does not identify them.
+ */
+template <typename Key, typename Value, typename Traits = PrefixTrieKeyTraits<Key> >
+class PrefixTrie
+{
+public:
+  PrefixTrie ()
+    : m_root (0),
+      m_size (0)
+  {
+  }
+
+  ~PrefixTrie ()
+  {
+    Clear ();
+  }
+
+  /**
+   * \param key the prefix; bits beyond length are ignored.
+   * \param length the length of the prefix, in bits.
+   * \param value the value to append to those of the prefix.
+   */
+  void Insert (Key key, uint32_t length, Value const &value)
+  {
+    key = Traits::Mask (key, length);
+    m_size++;
+    Node **link = &m_root;
+    while (*link != 0)
+      {
+        Node *n = *link;
+        uint32_t common = std::min (std::min (Traits::CommonLength (n->m_key, key), n->m_length), length);
+        if (common == n->m_length)
+          {
+            if (length == n->m_length)
+              {
+                n->m_values.push_back (value);
+                return;
+              }
+            link = &n->m_child[Traits::GetBit (key, n->m_length)];
+            continue;
+          }
+        // The paths diverge (or the new prefix ends) above n: insert a
+        // node for the common part.
+        Node *branch = new Node (Traits::Mask (key, common), common);
+        branch->m_child[Traits::GetBit (n->m_key, common)] = n;
+        *link = branch;
+        if (common == length)
+          {
+            branch->m_values.push_back (value);
+          }
+        else
+          {
+            Node *leaf = new Node (key, length);
+            leaf->m_values.push_back (value);
+            branch->m_child[Traits::GetBit (key, common)] = leaf;
+          }
+        return;
+      }
+    *link = new Node (key, length);
+    (*link)->m_values.push_back (value);
+  }
+
+  /**
+   * \param key the prefix; bits beyond length are ignored.
+   * \param length the length of the prefix, in bits.
+   * \param value a value equal to the one to remove.
+   * \return true if the value was found (and removed).
+   */
+  bool Remove (Key key, uint32_t length, Value const &value)
+  {
+    key = Traits::Mask (key, length);
+    Node **parent = 0;
+    Node **link = &m_root;
+    while (*link != 0)
+      {
+        Node *n = *link;
+        if (n->m_length > length || Traits::Mask (key, n->m_length) != n->m_key)
+          {
+            return false;
+          }
+        if (n->m_length == length)
+          {
+            typename std::vector<Value>::iterator i = std::find (n->m_values.begin (), n->m_values.end (), value);
+            if (i == n->m_values.end ())
+              {
+                return false;
+              }
+            n->m_values.erase (i);
+            m_size--;
+            if (n->m_values.empty () && Prune (link) && parent != 0)
+              {
+                // n is gone, which may leave its parent a useless branch
+                Prune (parent);
+              }
+            return true;
+          }
+        parent = link;
+        link = &n->m_child[Traits::GetBit (key, n->m_length)];
+      }
+    return false;
+  }
+
+  /**
+   * \param key the key to look up.
+   * \param matches the values of all the prefixes of key are appended
+   * to this vector, shortest prefix first.
+   */
+  void Lookup (Key key, std::vector<Value> &matches) const
+  {
+    Node const *n = m_root;
+    while (n != 0 && Traits::Mask (key, n->m_length) == n->m_key)
+      {
+        matches.insert (matches.end (), n->m_values.begin (), n->m_values.end ());
+        if (n->m_length == Traits::BITS)
+          {
+            break;
+          }
+        n = n->m_child[Traits::GetBit (key, n->m_length)];
+      }
+  }
+
+  /**
+   * \return the number of values in the trie.
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_size;
+  }
+
+  /**
+   * \brief Remove everything.
+   */
+  void Clear (void)
+  {
+    Delete (m_root);
+    m_root = 0;
+    m_size = 0;
+  }
+
+private:
+  struct Node
+  {
+    Node (Key key, uint32_t length)
+      : m_key (key),
+        m_length (length)
+    {
+      m_child[0] = 0;
+      m_child[1] = 0;
+    }
+    Key m_key;                    //!< the prefix, masked to m_length bits
+    uint32_t m_length;            //!< the length of the prefix
+    Node *m_child[2];             //!< subtrees, by the bit following the prefix
+    std::vector<Value> m_values;  //!< values of this exact prefix
+  };
+
+  PrefixTrie (PrefixTrie const &);
+  PrefixTrie &operator = (PrefixTrie const &);
+
+  /**
+   * Remove the node at *link if it holds no value and has at most one
+   * child, which then takes its place.
+   * \return true if the node was removed.
+   */
+  static bool Prune (Node **link)
+  {
+    Node *n = *link;
+    if (!n->m_values.empty () || (n->m_child[0] != 0 && n->m_child[1] != 0))
+      {
+        return false;
+      }
+    *link = n->m_child[0] != 0 ? n->m_child[0] : n->m_child[1];
+    delete n;
+    return true;
+  }
+
+  static void Delete (Node *n)
+  {
+    if (n != 0)
+      {
+        Delete (n->m_child[0]);
+        Delete (n->m_child[1]);
+        delete n;
+      }
+  }
+
+  Node *m_root;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* PREFIX_TRIE_H */
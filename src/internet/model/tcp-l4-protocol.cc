@@ -18,6 +18,8 @@
  * Author: Raj Bhattacharjea <raj.b@gatech.edu>
  */
 
+#include <algorithm>
+
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/nstime.h"
@@ -601,7 +603,8 @@ TcpL4Protocol::Send (Ptr<Packet> packet,
 
 void
 TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
-                           Ipv4Address saddr, Ipv4Address daddr, Ptr<NetDevice> oif)
+                           Ipv4Address saddr, Ipv4Address daddr, Ptr<NetDevice> oif,
+                           uint32_t segmentSize)
 {
   NS_LOG_LOGIC ("TcpL4Protocol " << this
                                  << " sending seq " << outgoing.GetSequenceNumber ()
@@ -621,7 +624,8 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
     }
   outgoingHeader.InitializeChecksum (saddr, daddr, PROT_NUMBER);
 
-  packet->AddHeader (outgoingHeader);
+  std::vector<Ptr<Packet> > segments;
+  Segment (packet, outgoingHeader, segmentSize, segments);
 
   Ptr<Ipv4> ipv4 = 
     m_node->GetObject<Ipv4> ();
@@ -634,14 +638,17 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
       Ptr<Ipv4Route> route;
       if (ipv4->GetRoutingProtocol () != 0)
         {
-          route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+          route = ipv4->GetRoutingProtocol ()->RouteOutput (segments.front (), header, oif, errno_);
         }
       else
         {
           NS_LOG_ERROR ("No IPV4 Routing Protocol");
           route = 0;
         }
-      m_downTarget (packet, saddr, daddr, PROT_NUMBER, route);
+      for (std::vector<Ptr<Packet> >::const_iterator i = segments.begin (); i != segments.end (); ++i)
+        {
+          m_downTarget (*i, saddr, daddr, PROT_NUMBER, route);
+        }
     }
   else
     NS_FATAL_ERROR ("Trying to use Tcp on a node without an Ipv4 interface");
@@ -649,7 +656,8 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
 
 void
 TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
-                           Ipv6Address saddr, Ipv6Address daddr, Ptr<NetDevice> oif)
+                           Ipv6Address saddr, Ipv6Address daddr, Ptr<NetDevice> oif,
+                           uint32_t segmentSize)
 {
   NS_LOG_LOGIC ("TcpL4Protocol " << this
                                  << " sending seq " << outgoing.GetSequenceNumber ()
@@ -661,7 +669,7 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
 
   if (daddr.IsIpv4MappedAddress ())
     {
-      return (SendPacket (packet, outgoing, saddr.GetIpv4MappedAddress(), daddr.GetIpv4MappedAddress(), oif));
+      return (SendPacket (packet, outgoing, saddr.GetIpv4MappedAddress(), daddr.GetIpv4MappedAddress(), oif, segmentSize));
     }
   TcpHeader outgoingHeader = outgoing;
   outgoingHeader.SetLength (5); //header length in units of 32bit words
@@ -673,7 +681,8 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
     }
   outgoingHeader.InitializeChecksum (saddr, daddr, PROT_NUMBER);
 
-  packet->AddHeader (outgoingHeader);
+  std::vector<Ptr<Packet> > segments;
+  Segment (packet, outgoingHeader, segmentSize, segments);
 
   Ptr<Ipv6L3Protocol> ipv6 = m_node->GetObject<Ipv6L3Protocol> ();
   if (ipv6 != 0)
@@ -686,19 +695,50 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
       Ptr<Ipv6Route> route;
       if (ipv6->GetRoutingProtocol () != 0)
         {
-          route = ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+          route = ipv6->GetRoutingProtocol ()->RouteOutput (segments.front (), header, oif, errno_);
         }
       else
         {
           NS_LOG_ERROR ("No IPV6 Routing Protocol");
           route = 0;
         }
-      m_downTarget6 (packet, saddr, daddr, PROT_NUMBER, route);
+      for (std::vector<Ptr<Packet> >::const_iterator i = segments.begin (); i != segments.end (); ++i)
+        {
+          m_downTarget6 (*i, saddr, daddr, PROT_NUMBER, route);
+        }
     }
   else
     NS_FATAL_ERROR ("Trying to use Tcp on a node without an Ipv6 interface");
 }
 
+void
+TcpL4Protocol::Segment (Ptr<Packet> packet, const TcpHeader &header,
+                        uint32_t segmentSize, std::vector<Ptr<Packet> > &segments) const
+{
+  NS_LOG_FUNCTION (packet << segmentSize);
+  uint32_t size = packet->GetSize ();
+  if (segmentSize == 0 || size <= segmentSize)
+    {
+      packet->AddHeader (header);
+      segments.push_back (packet);
+      return;
+    }
+  NS_LOG_LOGIC ("Large send of " << size << " bytes in segments of " << segmentSize);
+  for (uint32_t offset = 0; offset < size; offset += segmentSize)
+    {
+      uint32_t length = std::min (segmentSize, size - offset);
+      Ptr<Packet> segment = packet->CreateFragment (offset, length);
+      TcpHeader segmentHeader = header;
+      segmentHeader.SetSequenceNumber (header.GetSequenceNumber () + SequenceNumber32 (offset));
+      if (offset + length < size)
+        { // Only the last segment closes or pushes
+          segmentHeader.SetFlags (header.GetFlags () & ~(TcpHeader::FIN | TcpHeader::PSH));
+        }
+      segment->AddHeader (segmentHeader);
+      segments.push_back (segment);
+    }
+}
+
 void
 TcpL4Protocol::SetDownTarget (IpL4Protocol::DownTargetCallback callback)
 {
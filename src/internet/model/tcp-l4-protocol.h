@@ -22,6 +22,7 @@
 #define TCP_L4_PROTOCOL_H
 
 #include <stdint.h>
+#include <vector>
 
 #include "ns3/packet.h"
 #include "ns3/ipv4-address.h"
@@ -234,10 +235,52 @@ private:
   TypeId m_socketTypeId; //!< The socket TypeId
 private:
   friend class TcpSocketBase;
-  void SendPacket (Ptr<Packet>, const TcpHeader &,
-                   Ipv4Address, Ipv4Address, Ptr<NetDevice> oif = 0);
-  void SendPacket (Ptr<Packet>, const TcpHeader &,
-                   Ipv6Address, Ipv6Address, Ptr<NetDevice> oif = 0);
+  /**
+   * \brief Send a packet via TCP (IPv4)
+   *
+   * If segmentSize is not zero and the payload is larger, the payload is
+   * a large send: it is cut into consecutive segments of at most
+   * segmentSize bytes, sharing the payload and a single route lookup,
+   * which are handed to IP back to back.
+   *
+   * \param packet the payload
+   * \param outgoing the TCP header of the first segment
+   * \param saddr the source address
+   * \param daddr the destination address
+   * \param oif the output interface
+   * \param segmentSize the maximum segment size, or 0
+   */
+  void SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
+                   Ipv4Address saddr, Ipv4Address daddr, Ptr<NetDevice> oif = 0,
+                   uint32_t segmentSize = 0);
+  /**
+   * \brief Send a packet via TCP (IPv6)
+   *
+   * \see SendPacket (Ptr<Packet>, const TcpHeader &, Ipv4Address, Ipv4Address, Ptr<NetDevice>, uint32_t)
+   *
+   * \param packet the payload
+   * \param outgoing the TCP header of the first segment
+   * \param saddr the source address
+   * \param daddr the destination address
+   * \param oif the output interface
+   * \param segmentSize the maximum segment size, or 0
+   */
+  void SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
+                   Ipv6Address saddr, Ipv6Address daddr, Ptr<NetDevice> oif = 0,
+                   uint32_t segmentSize = 0);
+
+  /**
+   * \brief Cut a payload into segments and add their TCP headers
+   *
+   * Only the last segment keeps the FIN and PSH flags of the header.
+   *
+   * \param packet the payload
+   * \param header the TCP header of the first segment
+   * \param segmentSize the maximum segment size, or 0 for a single segment
+   * \param segments the segments, with their headers
+   */
+  void Segment (Ptr<Packet> packet, const TcpHeader &header,
+                uint32_t segmentSize, std::vector<Ptr<Packet> > &segments) const;
 
   /**
    * \brief Copy constructor
@@ -18,6 +18,8 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -152,8 +154,13 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet, starting from the last packet
+  // beginning at or before headSeq, the first one which may overlap
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -195,18 +202,11 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
-    {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+  std::map<SequenceNumber32, SequenceNumber32>::iterator block = AddBlock (headSeq, tailSeq);
+  if (block->first <= m_nextRxSeq && m_nextRxSeq < block->second)
+    { // The hole at the head is filled: everything up to the next hole is available
+      m_availBytes += block->second - m_nextRxSeq.Get ();
+      m_nextRxSeq = block->second;
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -227,6 +227,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   NS_ASSERT (m_data.size ()); // At least we have something to extract
   Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
   BufIterator i;
+  RemoveFromBlocks (extractSize);
   while (extractSize)
     { // Check the buffered data for delivery
       i = m_data.begin ();
@@ -261,4 +262,61 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   return outPkt;
 }
 
+std::vector<TcpRxBuffer::Range>
+TcpRxBuffer::GetHoles (void) const
+{
+  std::vector<Range> holes;
+  SequenceNumber32 seq = m_nextRxSeq;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_blocks.upper_bound (seq);
+  for (; i != m_blocks.end (); ++i)
+    {
+      holes.push_back (Range (seq, i->first));
+      seq = i->second;
+    }
+  return holes;
+}
+
+std::map<SequenceNumber32, SequenceNumber32>::iterator
+TcpRxBuffer::AddBlock (const SequenceNumber32& head, const SequenceNumber32& tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+  // Merge with the blocks overlapping or adjacent to [head, tail)
+  SequenceNumber32 first = head;
+  SequenceNumber32 last = tail;
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_blocks.upper_bound (head);
+  if (i != m_blocks.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator previous = i;
+      --previous;
+      if (previous->second >= head)
+        {
+          i = previous;
+        }
+    }
+  while (i != m_blocks.end () && i->first <= tail)
+    {
+      first = std::min (first, i->first);
+      last = std::max (last, i->second);
+      m_blocks.erase (i++);
+    }
+  return m_blocks.insert (std::make_pair (first, last)).first;
+}
+
+void
+TcpRxBuffer::RemoveFromBlocks (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  // The extracted bytes are the head of the first block
+  NS_ASSERT (!m_blocks.empty ());
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_blocks.begin ();
+  SequenceNumber32 first = i->first + SequenceNumber32 (size);
+  SequenceNumber32 last = i->second;
+  NS_ASSERT (first <= last);
+  m_blocks.erase (i);
+  if (first < last)
+    {
+      m_blocks.insert (std::make_pair (first, last));
+    }
+}
+
 } //namepsace ns3
@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,6 +37,11 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * Besides the segments, the buffer keeps the ranges of sequence numbers it
+ * holds, merged into blocks, so that the holes left by reordering or losses
+ * are known without scanning the segments, and both the overlaps of an
+ * incoming segment and the advance of RCV.NXT are found in logarithmic time.
  */
 class TcpRxBuffer : public Object
 {
@@ -124,6 +130,33 @@ public:
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /// A range of sequence numbers, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> Range;
+
+  /**
+   * \brief Get the holes in the received data, i.e. the ranges of sequence
+   * numbers between RCV.NXT and the last byte buffered which are still
+   * missing, in increasing order.
+   *
+   * These are the gaps between the blocks which a SACK option would report.
+   *
+   * \returns the holes
+   */
+  std::vector<Range> GetHoles (void) const;
+private:
+  /**
+   * \brief Record that the range [head, tail) is buffered
+   * \param head first sequence number of the range
+   * \param tail sequence number past the range
+   * \returns the block holding the range, merged with its neighbours
+   */
+  std::map<SequenceNumber32, SequenceNumber32>::iterator AddBlock (const SequenceNumber32& head, const SequenceNumber32& tail);
+  /**
+   * \brief Record that bytes are extracted from the head of the buffer
+   * \param size number of bytes extracted
+   */
+  void RemoveFromBlocks (uint32_t size);
 public:
   /// container for data stored in the buffer
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
@@ -134,6 +167,7 @@ public:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::map<SequenceNumber32, SequenceNumber32> m_blocks; //!< Contiguous ranges of m_data: first and past the last sequence number
 };
 
 } //namepsace ns3
@@ -38,6 +38,7 @@
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/trace-source-accessor.h"
 #include "tcp-socket-base.h"
@@ -76,6 +77,21 @@ TcpSocketBase::GetTypeId (void)
                    UintegerValue (65535),
                    MakeUintegerAccessor (&TcpSocketBase::m_maxWinSize),
                    MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("LargeSendSegments",
+                   "Maximum number of full segments sent at once as a large send, "
+                   "which is cut into segments only below the socket, sharing one "
+                   "route lookup (1 disables large sends)",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_largeSendSegments),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CoalesceAcks",
+                   "Acknowledge in-sequence segments received at the same time, "
+                   "e.g. the segments of a large send over a link without delay, "
+                   "with a single ACK once they are all processed, as receive "
+                   "offload would",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_coalesceAcks),
+                   MakeBooleanChecker ())
     .AddAttribute ("IcmpCallback", "Callback invoked whenever an icmp error is received on this socket.",
                    CallbackValue (),
                    MakeCallbackAccessor (&TcpSocketBase::m_icmpCallback),
@@ -140,6 +156,8 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_delAckCount (0),
     m_delAckMaxCount (sock.m_delAckMaxCount),
     m_noDelay (sock.m_noDelay),
+    m_largeSendSegments (sock.m_largeSendSegments),
+    m_coalesceAcks (sock.m_coalesceAcks),
     m_cnRetries (sock.m_cnRetries),
     m_delAckTimeout (sock.m_delAckTimeout),
     m_persistTimeout (sock.m_persistTimeout),
@@ -1906,17 +1924,27 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
   NS_LOG_LOGIC ("Send packet via TcpL4Protocol with flags 0x" << std::hex << static_cast<uint32_t> (flags) << std::dec);
+  // A large send is cut into segments by TcpL4Protocol
+  uint32_t segmentSize = sz > m_segmentSize ? m_segmentSize : 0;
   if (m_endPoint)
     {
       m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), m_boundnetdevice);
+                         m_endPoint->GetPeerAddress (), m_boundnetdevice, segmentSize);
     }
   else
     {
       m_tcp->SendPacket (p, header, m_endPoint6->GetLocalAddress (),
-                         m_endPoint6->GetPeerAddress (), m_boundnetdevice);
+                         m_endPoint6->GetPeerAddress (), m_boundnetdevice, segmentSize);
+    }
+  // Notify the RTT of each segment, so that a large send is sampled per segment
+  uint32_t offset = 0;
+  do
+    {
+      uint32_t length = std::min (sz - offset, m_segmentSize);
+      m_rtt->SentSeq (seq + SequenceNumber32 (offset), length);
+      offset += length;
     }
-  m_rtt->SentSeq (seq, sz);       // notify the RTT
+  while (offset < sz);
   // Notify the application of the data being sent unless this is a retransmit
   if (seq == m_nextTxSequence)
     {
@@ -1970,6 +1998,10 @@ TcpSocketBase::SendPendingData (bool withAck)
           break;
         }
       uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
+      if (m_largeSendSegments > 1 && w >= m_segmentSize)
+        { // Large send: as many full segments as the window allows
+          s = std::min (w / m_segmentSize, m_largeSendSegments) * m_segmentSize;
+        }
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -2038,7 +2070,18 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      bool sameTime = m_coalesceAcks && m_lastInSequenceRx == Simulator::Now ();
+      m_lastInSequenceRx = Simulator::Now ();
+      if (++m_delAckCount >= m_delAckMaxCount && sameTime)
+        { // Another segment came at the same time: send the ACK once all
+          // the segments received now are processed
+          if (!m_delAckEvent.IsRunning () || !Simulator::GetDelayLeft (m_delAckEvent).IsZero ())
+            {
+              m_delAckEvent.Cancel ();
+              m_delAckEvent = Simulator::ScheduleNow (&TcpSocketBase::DelAckTimeout, this);
+            }
+        }
+      else if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
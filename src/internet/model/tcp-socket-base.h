@@ -560,6 +560,9 @@ protected:
   uint32_t          m_delAckCount;     //!< Delayed ACK counter
   uint32_t          m_delAckMaxCount;  //!< Number of packet to fire an ACK before delay timeout
   bool              m_noDelay;         //!< Set to true to disable Nagle's algorithm
+  uint32_t          m_largeSendSegments; //!< Maximum number of segments handed down at once
+  bool              m_coalesceAcks;    //!< Send one ACK for all the segments received at the same time
+  Time              m_lastInSequenceRx; //!< Time at which the last in-sequence segment was received
   uint32_t          m_cnCount;         //!< Count of remaining connection retries
   uint32_t          m_cnRetries;       //!< Number of connection retries before giving up
   TracedValue<Time> m_rto;             //!< Retransmit timeout
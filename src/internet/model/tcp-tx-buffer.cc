@@ -53,7 +53,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_firstByteOffset (0)
 {
 }
 
@@ -107,7 +107,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          Chunk chunk;
+          chunk.m_offset = m_firstByteOffset + m_size;
+          chunk.m_packet = p;
+          m_data.push_back (chunk);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -138,60 +141,35 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     {
       return Create<Packet> (); // Empty packet returned
     }
-  if (m_data.size () == 0)
-    { // No actual data, just return dummy-data packet of correct size
-      return Create<Packet> (s);
-    }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
+  uint64_t offset = m_firstByteOffset + static_cast<uint32_t> (seq - m_firstByteSeq.Get ());
+  BufIterator i = FindChunk (offset);
+  uint32_t chunkOffset = offset - i->m_offset;
+  if (chunkOffset + s <= i->m_packet->GetSize ())
+    { // Data to be copied falls entirely in this chunk
+      NS_LOG_LOGIC ("Fragment of chunk at buffer offset " << i->m_offset << ", len=" << i->m_packet->GetSize ());
+      return i->m_packet->CreateFragment (chunkOffset, s);
+    }
+  // Zero-filled payloads, as from BulkSendApplication, stay unwritten
+  // when the fragments are aggregated
   Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  for (uint32_t remaining = s; remaining > 0; ++i)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
-        { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+      NS_ASSERT (i != m_data.end ());
+      uint32_t fragmentLength = std::min (remaining, i->m_packet->GetSize () - chunkOffset);
+      Ptr<Packet> fragment = i->m_packet->CreateFragment (chunkOffset, fragmentLength);
+      if (outPacket == 0)
+        {
+          outPacket = fragment;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (fragment);
         }
-      count += pktSize;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+      remaining -= fragmentLength;
+      chunkOffset = 0;
     }
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
@@ -213,31 +191,16 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
+  // Advance the head, and drop the chunks which are wholly behind it
+  uint32_t offset = std::min<uint32_t> (seq - m_firstByteSeq.Get (), m_size);  // Number of bytes to remove
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  m_size -= offset;
+  m_firstByteSeq += offset;
+  m_firstByteOffset += offset;
+  while (!m_data.empty () && m_data.front ().m_offset + m_data.front ().m_packet->GetSize () <= m_firstByteOffset)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
-        }
+      NS_LOG_LOGIC ("Removed one chunk of size " << m_data.front ().m_packet->GetSize ());
+      m_data.pop_front ();
     }
   // Catching the case of ACKing a FIN
   if (m_size == 0)
@@ -249,4 +212,27 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+TcpTxBuffer::BufIterator
+TcpTxBuffer::FindChunk (uint64_t offset) const
+{
+  NS_ASSERT (!m_data.empty () && m_data.front ().m_offset <= offset);
+  // Binary search for the last chunk starting at or before offset
+  uint32_t low = 0;
+  uint32_t high = m_data.size ();
+  while (high - low > 1)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (m_data[middle].m_offset <= offset)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  NS_ASSERT (offset < m_data[low].m_offset + m_data[low].m_packet->GetSize ());
+  return m_data.begin () + low;
+}
+
 } // namepsace ns3
@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,12 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets given by the application are kept as chunks indexed by their
+ * offset in the byte stream, so that the chunk holding a sequence number is
+ * found by a binary search.  A segment lying within one chunk is a fragment
+ * sharing the payload of that chunk, and acknowledged bytes are only cut off
+ * once their whole chunk is acknowledged.
  */
 class TcpTxBuffer : public Object
 {
@@ -128,13 +134,27 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
+  /// A packet of the application
+  struct Chunk
+  {
+    uint64_t m_offset;    //!< Offset in the byte stream of its first byte
+    Ptr<Packet> m_packet; //!< The packet
+  };
+
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::deque<Chunk>::const_iterator BufIterator;
+
+  /**
+   * \param offset an offset in the byte stream, within the buffer
+   * \return the chunk holding that byte
+   */
+  BufIterator FindChunk (uint64_t offset) const;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_firstByteOffset;                   //!< Offset in the byte stream of the first byte in data
+  std::deque<Chunk> m_data;                     //!< Corresponding data, by offset; the first chunk may start before m_firstByteOffset
 };
 
 } // namepsace ns3
@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-end-point.h"
+
+using namespace ns3;
+
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux lookup precedence and re-keyed end points")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4EndPoint *wildcard = demux.Allocate (80);
+  Ipv4EndPoint *local = demux.Allocate (Ipv4Address ("10.0.0.1"), 80);
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.3"), 1234), local,
+                         "Simple lookup did not prefer the least generic end point");
+  Ipv4EndPoint *full = demux.Allocate (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1234);
+  NS_TEST_ASSERT_MSG_EQ ((full != 0), true, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ ((demux.Allocate (Ipv4Address ("10.0.0.1"), 80) == 0), true, "Duplicate local end point allocated");
+  NS_TEST_EXPECT_MSG_EQ ((demux.Allocate (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1234) == 0), true,
+                         "Duplicate connected end point allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Port 80 not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (81), false, "Port 81 found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv4Address ("10.0.0.1"), 80), true, "Local end point not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv4Address ("10.0.0.2"), 80), false, "Wrong local end point found");
+
+  Ipv4EndPointDemux::EndPoints found;
+  found = demux.Lookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1234, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Exact match not unique");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), full, "Exact match not preferred");
+  found = demux.Lookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.3"), 1234, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Local match not unique");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), local, "Local address match not preferred");
+  found = demux.Lookup (Ipv4Address ("10.0.0.9"), 80, Ipv4Address ("10.0.0.3"), 1234, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Wildcard match not unique");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), wildcard, "Wildcard not matched");
+
+  // A subnet-directed broadcast is delivered to the wildcard and to the
+  // end point bound to the interface address, in allocation order
+  found = demux.Lookup (Ipv4Address ("10.0.0.255"), 80, Ipv4Address ("10.0.0.3"), 1234, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 2, "Broadcast not delivered to both end points");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), wildcard, "Allocation order lost");
+  NS_TEST_EXPECT_MSG_EQ (found.back (), local, "Allocation order lost");
+
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1234), full,
+                         "Simple lookup missed the exact match");
+
+  // End points whose addresses change after allocation are found by
+  // their new four-tuple only
+  Ipv4EndPoint *connected = demux.Allocate (Ipv4Address ("10.0.0.1"), 81);
+  connected->SetPeer (Ipv4Address ("10.0.0.3"), 99);
+  found = demux.Lookup (Ipv4Address ("10.0.0.1"), 81, Ipv4Address ("10.0.0.3"), 99, interface);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == connected), true, "Re-keyed end point not found");
+  found = demux.Lookup (Ipv4Address ("10.0.0.1"), 81, Ipv4Address ("10.0.0.4"), 99, interface);
+  NS_TEST_EXPECT_MSG_EQ (found.empty (), true, "Re-keyed end point found by its old four-tuple");
+  connected->SetLocalAddress (Ipv4Address ("10.0.0.7"));
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv4Address ("10.0.0.1"), 81), false, "Old local address still indexed");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (Ipv4Address ("10.0.0.7"), 81), true, "New local address not indexed");
+
+  demux.DeAllocate (full);
+  found = demux.Lookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1234, interface);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == local), true, "Deallocated end point still found");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 3, "Wrong number of end points");
+}
+
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux lookup precedence and re-keyed end points")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address a ("2001:db8::1");
+  Ipv6Address b ("2001:db8::2");
+  Ipv6Address c ("2001:db8::3");
+
+  Ipv6EndPoint *wildcard = demux.Allocate (80);
+  Ipv6EndPoint *local = demux.Allocate (a, 80);
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (a, 80, c, 1234), local, "Simple lookup did not prefer the least generic end point");
+  Ipv6EndPoint *full = demux.Allocate (a, 80, b, 1234);
+  NS_TEST_ASSERT_MSG_EQ ((full != 0), true, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ ((demux.Allocate (a, 80, b, 1234) == 0), true, "Duplicate connected end point allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Port 80 not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupLocal (b, 80), false, "Wrong local end point found");
+
+  Ipv6EndPointDemux::EndPoints found;
+  found = demux.Lookup (a, 80, b, 1234, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == full), true, "Exact match not preferred");
+  found = demux.Lookup (a, 80, c, 1234, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == local), true, "Local address match not preferred");
+  found = demux.Lookup (c, 80, b, 1234, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == wildcard), true, "Wildcard not matched");
+
+  Ipv6EndPoint *moved = demux.Allocate (a, 81);
+  moved->SetLocalPort (82);
+  moved->SetPeer (c, 99);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (81), false, "Old local port still indexed");
+  found = demux.Lookup (a, 82, c, 99, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == moved), true, "Re-keyed end point not found");
+
+  demux.DeAllocate (full);
+  found = demux.Lookup (a, 80, b, 1234, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == local), true, "Deallocated end point still found");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 3, "Wrong number of end points");
+}
+
+class EphemeralPortTestCase : public TestCase
+{
+public:
+  EphemeralPortTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+EphemeralPortTestCase::EphemeralPortTestCase ()
+  : TestCase ("Ephemeral ports are allocated in order, skipping the ports in use")
+{
+}
+
+void
+EphemeralPortTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  demux.Allocate (49153);
+  demux.Allocate (49155);
+  // A port stays in use as long as one end point is bound to it
+  demux.Allocate (Ipv4Address ("10.0.0.1"), 49157);
+  demux.DeAllocate (demux.Allocate (Ipv4Address ("10.0.0.2"), 49157));
+
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49154, "First free port not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49156, "Port in use allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49158, "Port still bound allocated");
+
+  // Fill the range: the allocation wraps around to the first port
+  Ipv4EndPoint *endPoint = 0;
+  Ipv4EndPoint *second = 0;
+  Ipv4EndPoint *middle = 0;
+  for (uint32_t port = 49159; port <= 65535 + 1; port++)
+    {
+      uint16_t expected = port <= 65535 ? port : 49152;
+      endPoint = demux.Allocate ();
+      NS_TEST_ASSERT_MSG_EQ ((endPoint != 0), true, "Allocation failed with free ports");
+      NS_TEST_ASSERT_MSG_EQ (endPoint->GetLocalPort (), expected, "Ports out of order");
+      if (port == 50000)
+        {
+          middle = endPoint;
+        }
+      if (port == 65000)
+        {
+          second = endPoint;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((demux.Allocate () == 0), true, "Allocation succeeded with every port in use");
+
+  // Freed ports are handed out again, counting up from the last one
+  demux.DeAllocate (second);
+  demux.DeAllocate (middle);
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 50000, "Freed port not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 65000, "Freed port not found");
+  NS_TEST_EXPECT_MSG_EQ ((demux.Allocate () == 0), true, "Allocation succeeded with every port in use");
+
+  // The IPv6 demux keeps its own ports, and follows end points whose
+  // port changes after allocation
+  Ipv6EndPointDemux demux6;
+  Ipv6EndPoint *moved = demux6.Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (moved->GetLocalPort (), 49153, "First port not allocated");
+  demux6.Allocate (49154);
+  moved->SetLocalPort (49155);
+  NS_TEST_EXPECT_MSG_EQ (demux6.Allocate ()->GetLocalPort (), 49156, "Port in use allocated");
+  for (uint32_t port = 49157; port <= 65535; port++)
+    {
+      demux6.Allocate ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux6.Allocate ()->GetLocalPort (), 49152, "Allocation did not wrap around");
+  NS_TEST_EXPECT_MSG_EQ (demux6.Allocate ()->GetLocalPort (), 49153, "Port released by the end point not reused");
+  NS_TEST_EXPECT_MSG_EQ ((demux6.Allocate () == 0), true, "Allocation succeeded with every port in use");
+}
+
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new EphemeralPortTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
@@ -41,10 +41,10 @@ public:
   static TypeId GetTypeId (void);
   ErrorChannel ();
 
-  void Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
+  virtual void Send (Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from,
 	     Ptr<SimpleNetDevice> sender);
 
-  void Add (Ptr<SimpleNetDevice> device);
+  virtual void Add (Ptr<SimpleNetDevice> device);
 
   // inherited from ns3::Channel
   virtual uint32_t GetNDevices (void) const;
@@ -26,7 +26,28 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/packet.h"
+#include <algorithm>
 #include <cstdlib> // for rand()
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -213,6 +234,387 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   // does not crash
 }
 
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue ordering and DecreaseKey")
+{
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  std::vector<SPFVertex *> vertices;
+
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetVertexType (SPFVertex::VertexRouter);
+      v->SetVertexId (Ipv4Address (i + 1));
+      v->SetDistanceFromRoot (100 + std::rand () % 100);
+      candidate.Push (v);
+      vertices.push_back (v);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 100, "Wrong queue size");
+
+  // Move a few vertices up front; ties go to the one decreased first
+  vertices[10]->SetDistanceFromRoot (5);
+  candidate.DecreaseKey (vertices[10]);
+  vertices[20]->SetDistanceFromRoot (5);
+  candidate.DecreaseKey (vertices[20]);
+  vertices[30]->SetDistanceFromRoot (50);
+  candidate.DecreaseKey (vertices[30]);
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (31)), vertices[30], "Lost a vertex after DecreaseKey");
+
+  SPFVertex *v = candidate.Pop ();
+  NS_TEST_EXPECT_MSG_EQ (v, vertices[10], "Wrong vertex at the top");
+  delete v;
+  v = candidate.Pop ();
+  NS_TEST_EXPECT_MSG_EQ (v, vertices[20], "Wrong vertex at the top");
+  delete v;
+  v = candidate.Pop ();
+  NS_TEST_EXPECT_MSG_EQ (v, vertices[30], "Wrong vertex at the top");
+  delete v;
+
+  uint32_t last = 0;
+  while (!candidate.Empty ())
+    {
+      v = candidate.Pop ();
+      bool ordered = v->GetDistanceFromRoot () >= last;
+      NS_TEST_EXPECT_MSG_EQ (ordered, true, "Vertices popped out of order");
+      NS_TEST_EXPECT_MSG_EQ (candidate.Find (v->GetVertexId ()), 0, "Popped vertex still indexed");
+      last = v->GetDistanceFromRoot ();
+      delete v;
+    }
+}
+
+class GlobalRouteManagerSpfThreadsTestCase : public TestCase
+{
+public:
+  GlobalRouteManagerSpfThreadsTestCase ();
+  virtual void DoRun (void);
+private:
+  std::vector<std::string> DumpRoutes (NodeContainer nodes);
+};
+
+GlobalRouteManagerSpfThreadsTestCase::GlobalRouteManagerSpfThreadsTestCase ()
+  : TestCase ("Routes computed by SPF threads match the sequential ones")
+{
+}
+
+std::vector<std::string>
+GlobalRouteManagerSpfThreadsTestCase::DumpRoutes (NodeContainer nodes)
+{
+  std::vector<std::string> tables;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::ostringstream oss;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); ++j)
+        {
+          oss << *routing->GetRoute (j) << std::endl;
+        }
+      tables.push_back (oss.str ());
+    }
+  return tables;
+}
+
+void
+GlobalRouteManagerSpfThreadsTestCase::DoRun (void)
+{
+  // A ring of eight nodes, each link a two-node broadcast network, with a
+  // chord so that there are both equal and unequal cost paths.
+  NodeContainer nodes;
+  nodes.Create (8);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i <= nodes.GetN (); ++i)
+    {
+      Ptr<Node> a = nodes.Get (i % nodes.GetN ());
+      Ptr<Node> b = nodes.Get (i == nodes.GetN () ? 4 : (i + 1) % nodes.GetN ());
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      Ptr<SimpleNetDevice> da = CreateObject<SimpleNetDevice> ();
+      da->SetAddress (Mac48Address::Allocate ());
+      da->SetChannel (channel);
+      a->AddDevice (da);
+      devices.Add (da);
+      Ptr<SimpleNetDevice> db = CreateObject<SimpleNetDevice> ();
+      db->SetAddress (Mac48Address::Allocate ());
+      db->SetChannel (channel);
+      b->AddDevice (db);
+      devices.Add (db);
+      address.Assign (devices);
+      address.NewNetwork ();
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> sequential = DumpRoutes (nodes);
+  NS_TEST_ASSERT_MSG_NE (sequential[0], "", "No route computed");
+
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> threaded = DumpRoutes (nodes);
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (1));
+
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (threaded[i], sequential[i], "Routes of node " << i << " differ");
+    }
+
+  Simulator::Destroy ();
+}
+
+class GlobalRouteManagerIncrementalTestCase : public TestCase
+{
+public:
+  GlobalRouteManagerIncrementalTestCase (bool equalCosts);
+  virtual void DoRun (void);
+private:
+  std::vector<std::string> DumpRoutes (NodeContainer nodes);
+  void CheckUpdate (NodeContainer nodes, std::string change);
+  uint16_t GetMetric (uint32_t link) const;
+  bool m_equalCosts;
+};
+
+GlobalRouteManagerIncrementalTestCase::GlobalRouteManagerIncrementalTestCase (bool equalCosts)
+  : TestCase (equalCosts ? "Routes updated incrementally match the recomputed ones, with equal cost paths"
+              : "Routes updated incrementally match the recomputed ones"),
+    m_equalCosts (equalCosts)
+{
+}
+
+uint16_t
+GlobalRouteManagerIncrementalTestCase::GetMetric (uint32_t link) const
+{
+  // With equal costs, every link has metric 1, so that many routers have
+  // several equal cost paths; otherwise each link has its own power of two
+  // as metric, so that no two paths have the same cost.
+  return m_equalCosts ? 1 : 1 << link;
+}
+
+std::vector<std::string>
+GlobalRouteManagerIncrementalTestCase::DumpRoutes (NodeContainer nodes)
+{
+  // Replaced routes move to the end of the table, so compare the tables
+  // as sets of routes
+  std::vector<std::string> tables;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::vector<std::string> routes;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); ++j)
+        {
+          std::ostringstream oss;
+          oss << *routing->GetRoute (j);
+          routes.push_back (oss.str ());
+        }
+      std::sort (routes.begin (), routes.end ());
+      std::ostringstream oss;
+      for (uint32_t j = 0; j < routes.size (); ++j)
+        {
+          oss << routes[j] << std::endl;
+        }
+      tables.push_back (oss.str ());
+    }
+  return tables;
+}
+
+void
+GlobalRouteManagerIncrementalTestCase::CheckUpdate (NodeContainer nodes, std::string change)
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally ();
+  std::vector<std::string> incremental = DumpRoutes (nodes);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> recomputed = DumpRoutes (nodes);
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (incremental[i], recomputed[i], "Routes of node " << i << " differ after " << change);
+    }
+  // Start the next update from the incremental state again
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally ();
+}
+
+void
+GlobalRouteManagerIncrementalTestCase::DoRun (void)
+{
+  // The ring with a chord of the SPF threads test, plus a stub node hanging
+  // off node 2.
+  NodeContainer nodes;
+  nodes.Create (9);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.2.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i <= 9; ++i)
+    {
+      Ptr<Node> a = nodes.Get (i < 8 ? i : (i == 8 ? 0 : 2));
+      Ptr<Node> b = nodes.Get (i < 8 ? (i + 1) % 8 : (i == 8 ? 4 : 8));
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      Ptr<SimpleNetDevice> da = CreateObject<SimpleNetDevice> ();
+      da->SetAddress (Mac48Address::Allocate ());
+      da->SetChannel (channel);
+      a->AddDevice (da);
+      devices.Add (da);
+      Ptr<SimpleNetDevice> db = CreateObject<SimpleNetDevice> ();
+      db->SetAddress (Mac48Address::Allocate ());
+      db->SetChannel (channel);
+      b->AddDevice (db);
+      devices.Add (db);
+      Ipv4InterfaceContainer interfaces = address.Assign (devices);
+      address.NewNetwork ();
+      for (uint32_t j = 0; j < interfaces.GetN (); ++j)
+        {
+          interfaces.Get (j).first->SetMetric (interfaces.Get (j).second, GetMetric (i));
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally ();
+
+  // Interface 1 of node 6 is on the link to node 5 (interface 0 is the
+  // loopback)
+  Ptr<Ipv4> ipv4 = nodes.Get (6)->GetObject<Ipv4> ();
+  ipv4->SetDown (1);
+  CheckUpdate (nodes, "a link went down");
+  ipv4->SetUp (1);
+  CheckUpdate (nodes, "a link came back up");
+  ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  // With equal costs, the chord then costs as much as either half of the
+  // ring
+  ipv4->SetMetric (ipv4->GetNInterfaces () - 1, m_equalCosts ? 4 : 1 << 10);
+  CheckUpdate (nodes, "the metric of the chord changed");
+  ipv4->SetMetric (ipv4->GetNInterfaces () - 1, GetMetric (8));
+  CheckUpdate (nodes, "the metric of the chord changed back");
+  ipv4 = nodes.Get (8)->GetObject<Ipv4> ();
+  ipv4->SetDown (1);
+  CheckUpdate (nodes, "the stub node was cut off");
+  ipv4->SetUp (1);
+  CheckUpdate (nodes, "the stub node came back");
+
+  Simulator::Destroy ();
+}
+
+class GlobalRouteManagerSharedTablesTestCase : public TestCase
+{
+public:
+  GlobalRouteManagerSharedTablesTestCase ();
+  virtual void DoRun (void);
+private:
+  std::vector<std::string> DumpLookups (NodeContainer nodes);
+};
+
+GlobalRouteManagerSharedTablesTestCase::GlobalRouteManagerSharedTablesTestCase ()
+  : TestCase ("Shared routing tables route like the listed ones")
+{
+}
+
+std::vector<std::string>
+GlobalRouteManagerSharedTablesTestCase::DumpLookups (NodeContainer nodes)
+{
+  // The route each node picks to every address of every other node
+  std::vector<std::string> lookups;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::ostringstream oss;
+      for (uint32_t j = 0; j < nodes.GetN (); ++j)
+        {
+          Ptr<Ipv4> ipv4 = nodes.Get (j)->GetObject<Ipv4> ();
+          for (uint32_t k = 1; k < ipv4->GetNInterfaces (); ++k)
+            {
+              Ipv4Header header;
+              header.SetDestination (ipv4->GetAddress (k, 0).GetLocal ());
+              Socket::SocketErrno err;
+              Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, 0, err);
+              oss << header.GetDestination () << " ";
+              if (route)
+                {
+                  oss << route->GetGateway () << " " << route->GetOutputDevice ()->GetIfIndex ();
+                }
+              oss << std::endl;
+            }
+        }
+      lookups.push_back (oss.str ());
+    }
+  return lookups;
+}
+
+void
+GlobalRouteManagerSharedTablesTestCase::DoRun (void)
+{
+  // The ring with a chord and a stub node of the incremental test
+  NodeContainer nodes;
+  nodes.Create (9);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.3.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i <= 9; ++i)
+    {
+      Ptr<Node> a = nodes.Get (i < 8 ? i : (i == 8 ? 0 : 2));
+      Ptr<Node> b = nodes.Get (i < 8 ? (i + 1) % 8 : (i == 8 ? 4 : 8));
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      Ptr<SimpleNetDevice> da = CreateObject<SimpleNetDevice> ();
+      da->SetAddress (Mac48Address::Allocate ());
+      da->SetChannel (channel);
+      a->AddDevice (da);
+      devices.Add (da);
+      Ptr<SimpleNetDevice> db = CreateObject<SimpleNetDevice> ();
+      db->SetAddress (Mac48Address::Allocate ());
+      db->SetChannel (channel);
+      b->AddDevice (db);
+      devices.Add (db);
+      Ipv4InterfaceContainer interfaces = address.Assign (devices);
+      address.NewNetwork ();
+      for (uint32_t j = 0; j < interfaces.GetN (); ++j)
+        {
+          interfaces.Get (j).first->SetMetric (interfaces.Get (j).second, 1 << i);
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> listed = DumpLookups (nodes);
+
+  GlobalValue::Bind ("GlobalRoutingSharedTables", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> shared = DumpLookups (nodes);
+  NS_TEST_EXPECT_MSG_EQ (nodes.Get (0)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->HasSharedRoutes (),
+                         true, "No shared routes computed");
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (shared[i], listed[i], "Lookups of node " << i << " differ");
+    }
+
+  // Incremental updates keep the shared tables right
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally ();
+  Ptr<Ipv4> ipv4 = nodes.Get (6)->GetObject<Ipv4> ();
+  ipv4->SetDown (1);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTablesIncrementally ();
+  std::vector<std::string> incremental = DumpLookups (nodes);
+  GlobalValue::Bind ("GlobalRoutingSharedTables", BooleanValue (false));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  listed = DumpLookups (nodes);
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (incremental[i], listed[i], "Lookups of node " << i << " differ after a link went down");
+    }
+
+  Simulator::Destroy ();
+}
 
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
@@ -221,5 +623,10 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new GlobalRouteManagerSpfThreadsTestCase (), TestCase::QUICK);
+    AddTestCase (new GlobalRouteManagerIncrementalTestCase (false), TestCase::QUICK);
+    AddTestCase (new GlobalRouteManagerIncrementalTestCase (true), TestCase::QUICK);
+    AddTestCase (new GlobalRouteManagerSharedTablesTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
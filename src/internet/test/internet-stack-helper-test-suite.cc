@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/node-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/icmpv6-l4-protocol.h"
+
+using namespace ns3;
+
+class InternetStackHelperJitterTestCase : public TestCase
+{
+public:
+  InternetStackHelperJitterTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<RandomVariableStream> GetJitter (Ptr<Object> protocol, std::string name);
+};
+
+InternetStackHelperJitterTestCase::InternetStackHelperJitterTestCase ()
+  : TestCase ("Nodes installed with the ARP and NS and RS jitter disabled have no jitter")
+{
+}
+
+Ptr<RandomVariableStream>
+InternetStackHelperJitterTestCase::GetJitter (Ptr<Object> protocol, std::string name)
+{
+  PointerValue jitter;
+  protocol->GetAttribute (name, jitter);
+  return jitter.Get<RandomVariableStream> ();
+}
+
+void
+InternetStackHelperJitterTestCase::DoRun (void)
+{
+  // Nodes 0 to 3 are installed as a container, node 4 on its own
+  NodeContainer nodes;
+  nodes.Create (5);
+  InternetStackHelper internet;
+  internet.SetIpv4ArpJitter (false);
+  internet.SetIpv6NsRsJitter (false);
+  internet.Install (NodeContainer (nodes.Get (0), nodes.Get (1), nodes.Get (2), nodes.Get (3)));
+  internet.Install (nodes.Get (4));
+
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<RandomVariableStream> arp = GetJitter (nodes.Get (i)->GetObject<ArpL3Protocol> (), "RequestJitter");
+      Ptr<RandomVariableStream> icmpv6 = GetJitter (nodes.Get (i)->GetObject<Icmpv6L4Protocol> (), "SolicitationJitter");
+      NS_TEST_ASSERT_MSG_NE (arp, 0, "No ARP jitter variable on node " << i);
+      NS_TEST_ASSERT_MSG_NE (icmpv6, 0, "No NS/RS jitter variable on node " << i);
+      for (uint32_t j = 0; j < 10; ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (arp->GetValue (), 0, "ARP jitter on node " << i);
+          NS_TEST_EXPECT_MSG_EQ (icmpv6->GetValue (), 0, "NS/RS jitter on node " << i);
+        }
+    }
+
+  // With the jitter enabled again, each node draws its own
+  NodeContainer jittered;
+  jittered.Create (2);
+  internet.SetIpv4ArpJitter (true);
+  internet.SetIpv6NsRsJitter (true);
+  internet.Install (jittered);
+  Ptr<RandomVariableStream> arp0 = GetJitter (jittered.Get (0)->GetObject<ArpL3Protocol> (), "RequestJitter");
+  Ptr<RandomVariableStream> arp1 = GetJitter (jittered.Get (1)->GetObject<ArpL3Protocol> (), "RequestJitter");
+  NS_TEST_EXPECT_MSG_NE (arp0->GetObject<UniformRandomVariable> (), 0, "The ARP jitter should be uniform");
+  NS_TEST_EXPECT_MSG_NE (arp0, arp1, "The nodes should not share their ARP jitter");
+
+  Simulator::Destroy ();
+}
+
+class InternetStackHelperStreamTestCase : public TestCase
+{
+public:
+  InternetStackHelperStreamTestCase ();
+  virtual void DoRun (void);
+private:
+  uint64_t CountStreams (bool jitter);
+};
+
+InternetStackHelperStreamTestCase::InternetStackHelperStreamTestCase ()
+  : TestCase ("Disabling the jitter creates one more random variable per node and jitter")
+{
+}
+
+uint64_t
+InternetStackHelperStreamTestCase::CountStreams (bool jitter)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.SetIpv4ArpJitter (jitter);
+  internet.SetIpv6NsRsJitter (jitter);
+  uint64_t first = RngSeedManager::GetNextStreamIndex ();
+  internet.Install (nodes);
+  return RngSeedManager::GetNextStreamIndex () - first - 1;
+}
+
+void
+InternetStackHelperStreamTestCase::DoRun (void)
+{
+  // The disabled jitter used to be replaced on each node after the
+  // protocols were created: the automatically assigned stream indices
+  // of the random variables created afterwards depend on it
+  uint64_t jittered = CountStreams (true);
+  uint64_t constant = CountStreams (false);
+  NS_TEST_EXPECT_MSG_EQ (constant, jittered + 2 * 3, "Wrong number of streams allocated without jitter");
+
+  Simulator::Destroy ();
+}
+
+static class InternetStackHelperTestSuite : public TestSuite
+{
+public:
+  InternetStackHelperTestSuite ()
+    : TestSuite ("internet-stack-helper", UNIT)
+  {
+    AddTestCase (new InternetStackHelperJitterTestCase (), TestCase::QUICK);
+    AddTestCase (new InternetStackHelperStreamTestCase (), TestCase::QUICK);
+  }
+} g_internetStackHelperTestSuite;
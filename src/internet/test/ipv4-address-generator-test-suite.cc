@@ -301,6 +301,54 @@ AddressCollisionTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (added, false, "404");
 }
 
+class ManyAddressesTestCase : public TestCase
+{
+public:
+  ManyAddressesTestCase ();
+private:
+  void DoRun (void);
+  void DoTeardown (void);
+};
+
+ManyAddressesTestCase::ManyAddressesTestCase ()
+  : TestCase ("Make sure that the collision detection scales to many addresses.")
+{
+}
+
+void
+ManyAddressesTestCase::DoTeardown (void)
+{
+  Ipv4AddressGenerator::Reset ();
+  Simulator::Destroy ();
+}
+void
+ManyAddressesTestCase::DoRun (void)
+{
+  // One address in two, in decreasing order, then the ones in between,
+  // so that every other allocation merges two blocks
+  uint32_t n = 200000;
+  for (uint32_t i = n; i > 0; i -= 2)
+    {
+      Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + i));
+    }
+  for (uint32_t i = 1; i < n; i += 2)
+    {
+      Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + i));
+    }
+
+  Ipv4AddressGenerator::TestMode ();
+  bool added = Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + 1));
+  NS_TEST_EXPECT_MSG_EQ (added, false, "500");
+  added = Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + n / 2));
+  NS_TEST_EXPECT_MSG_EQ (added, false, "501");
+  added = Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + n));
+  NS_TEST_EXPECT_MSG_EQ (added, false, "502");
+  added = Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000 + n + 1));
+  NS_TEST_EXPECT_MSG_EQ (added, true, "503");
+  added = Ipv4AddressGenerator::AddAllocated (Ipv4Address (0x0a000000));
+  NS_TEST_EXPECT_MSG_EQ (added, true, "504");
+}
+
 
 static class Ipv4AddressGeneratorTestSuite : public TestSuite
 {
@@ -313,5 +361,6 @@ public:
     AddTestCase (new NetworkAndAddressTestCase (), TestCase::QUICK);
     AddTestCase (new ExampleAddressGeneratorTestCase (), TestCase::QUICK);
     AddTestCase (new AddressCollisionTestCase (), TestCase::QUICK);
+    AddTestCase (new ManyAddressesTestCase (), TestCase::QUICK);
   }
 } g_ipv4AddressGeneratorTestSuite;
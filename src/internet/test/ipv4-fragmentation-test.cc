@@ -82,6 +82,8 @@ class Ipv4FragmentationTest: public TestCase
   Ptr<Packet> m_sentPacketClient;
   Ptr<Packet> m_receivedPacketClient;
   Ptr<Packet> m_receivedPacketServer;
+  uint32_t m_receivedPacketsServer;
+  uint32_t m_receivedBytesServer;
 
 
   Ptr<Socket> m_socketServer;
@@ -116,6 +118,8 @@ Ipv4FragmentationTest::Ipv4FragmentationTest ()
   : TestCase ("Verify the IPv4 layer 3 protocol fragmentation and reassembly")
 {
   m_socketServer = 0;
+  m_receivedPacketsServer = 0;
+  m_receivedBytesServer = 0;
   m_data = 0;
   m_dataSize = 0;
 }
@@ -165,6 +169,8 @@ Ipv4FragmentationTest::HandleReadServer (Ptr<Socket> socket)
           packet->RemoveAllByteTags ();
 
           m_receivedPacketServer = packet->Copy();
+          m_receivedPacketsServer++;
+          m_receivedBytesServer += packet->GetSize ();
         }
     }
 }
@@ -366,9 +372,25 @@ Ipv4FragmentationTest::DoRun (void)
       NS_TEST_EXPECT_MSG_EQ (memcmp(m_data, recvBuffer, m_receivedPacketServer->GetSize ()),
                              0, "Packet content differs");
     }
+
+  // Third test: two packets sent at once, with delays each 2 packets.
+  // The fragments of both packets are interleaved, and each packet should
+  // be reassembled from its own fragments.
+  SetFill (fillData, 78, 5000);
+  m_receivedPacketsServer = 0;
+  m_receivedBytesServer = 0;
+  Simulator::ScheduleWithContext (m_socketClient->GetNode ()->GetId (), Seconds (0),
+                                  &Ipv4FragmentationTest::SendClient, this);
+  Simulator::ScheduleWithContext (m_socketClient->GetNode ()->GetId (), Seconds (0),
+                                  &Ipv4FragmentationTest::SetFill, this, fillData, 78, 3000);
+  Simulator::ScheduleWithContext (m_socketClient->GetNode ()->GetId (), Seconds (0),
+                                  &Ipv4FragmentationTest::SendClient, this);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketsServer, 2, "Interleaved packets not received");
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytesServer, 8000, "Interleaved packets sizes not correct");
   channel->SetJumpingMode(false);
 
-  // Third test: normal channel, some errors, no delays.
+  // Fourth test: normal channel, some errors, no delays.
   // The reassembly procedure should fire a timeout after 30 seconds (as specified in the RFCs).
   // Upon the timeout, the fragments received so far are discarded and an ICMP should be sent back
   // to the sender (if the first fragment has been received).
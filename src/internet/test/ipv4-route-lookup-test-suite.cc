@@ -0,0 +1,410 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/prefix-trie.h"
+#include "ns3/global-route-prefixes.h"
+
+using namespace ns3;
+
+// Random prefixes and removals, with every lookup checked against a scan
+// of all the prefixes
+class PrefixTrieTestCase : public TestCase
+{
+public:
+  PrefixTrieTestCase ();
+
+private:
+  struct Prefix
+  {
+    uint32_t m_key;
+    uint32_t m_length;
+    uint32_t m_value;
+  };
+
+  virtual void DoRun (void);
+  uint32_t Random (void);
+  void Check (PrefixTrie<uint32_t, uint32_t> const &trie, std::vector<Prefix> const &prefixes, uint32_t key);
+
+  uint32_t m_state;
+};
+
+PrefixTrieTestCase::PrefixTrieTestCase ()
+  : TestCase ("PrefixTrie matches a linear scan"),
+    m_state (1)
+{
+}
+
+uint32_t
+PrefixTrieTestCase::Random (void)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return m_state >> 8;
+}
+
+void
+PrefixTrieTestCase::Check (PrefixTrie<uint32_t, uint32_t> const &trie, std::vector<Prefix> const &prefixes, uint32_t key)
+{
+  std::vector<uint32_t> found;
+  trie.Lookup (key, found);
+  std::vector<uint32_t> expected;
+  for (std::vector<Prefix>::const_iterator i = prefixes.begin (); i != prefixes.end (); i++)
+    {
+      if (PrefixTrieKeyTraits<uint32_t>::Mask (key, i->m_length) == PrefixTrieKeyTraits<uint32_t>::Mask (i->m_key, i->m_length))
+        {
+          expected.push_back (i->m_value);
+        }
+    }
+  std::sort (found.begin (), found.end ());
+  std::sort (expected.begin (), expected.end ());
+  NS_TEST_EXPECT_MSG_EQ ((found == expected), true, "Wrong matches for " << Ipv4Address (key));
+}
+
+void
+PrefixTrieTestCase::DoRun (void)
+{
+  PrefixTrie<uint32_t, uint32_t> trie;
+  std::vector<Prefix> prefixes;
+
+  // Keys share their first byte so that the paths overlap a lot.
+  for (uint32_t value = 0; value < 2000; value++)
+    {
+      Prefix prefix;
+      prefix.m_key = 0x0a000000 | (Random () & 0x00ffffff);
+      prefix.m_length = Random () % 33;
+      prefix.m_value = value;
+      prefixes.push_back (prefix);
+      trie.Insert (prefix.m_key, prefix.m_length, value);
+    }
+  NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), 2000U, "Wrong size");
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      Check (trie, prefixes, prefixes[i].m_key);
+      Check (trie, prefixes, 0x0a000000 | (Random () & 0x00ffffff));
+    }
+
+  // remove half of the prefixes, in random order
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint32_t index = Random () % prefixes.size ();
+      Prefix prefix = prefixes[index];
+      prefixes.erase (prefixes.begin () + index);
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefix.m_key, prefix.m_length, prefix.m_value), true, "Prefix not found");
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefix.m_key, prefix.m_length, prefix.m_value), false, "Prefix removed twice");
+    }
+  NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), 1000U, "Wrong size");
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      Check (trie, prefixes, prefixes[i].m_key);
+      Check (trie, prefixes, 0x0a000000 | (Random () & 0x00ffffff));
+    }
+
+  trie.Clear ();
+  prefixes.clear ();
+  Check (trie, prefixes, 0x0a000001);
+}
+
+// A node with three interfaces, 10.1.0.1/16, 10.2.0.1/16 and 10.3.0.1/16,
+// on which to check which route the routing protocols pick
+class RouteLookupTestCase : public TestCase
+{
+public:
+  RouteLookupTestCase (std::string name);
+
+protected:
+  void CreateNode (void);
+  Ptr<Ipv4Route> Lookup (Ptr<Ipv4RoutingProtocol> routing, std::string dest);
+
+  Ptr<Node> m_node;
+  Ptr<Ipv4> m_ipv4;
+};
+
+RouteLookupTestCase::RouteLookupTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+RouteLookupTestCase::CreateNode (void)
+{
+  m_node = CreateObject<Node> ();
+  Ptr<Ipv4L3Protocol> ipv4 = CreateObject<Ipv4L3Protocol> ();
+  m_node->AggregateObject (ipv4);
+  m_ipv4 = ipv4;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      m_node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      Ipv4Address address (0x0a000001 | (i << 16));
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.0.0")));
+    }
+}
+
+Ptr<Ipv4Route>
+RouteLookupTestCase::Lookup (Ptr<Ipv4RoutingProtocol> routing, std::string dest)
+{
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address (dest.c_str ()));
+  Socket::SocketErrno err;
+  return routing->RouteOutput (Create<Packet> (), header, 0, err);
+}
+
+class Ipv4StaticRoutingLookupTestCase : public RouteLookupTestCase
+{
+public:
+  Ipv4StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ipv4Address Gateway (Ptr<Ipv4StaticRouting> routing, std::string dest);
+};
+
+Ipv4StaticRoutingLookupTestCase::Ipv4StaticRoutingLookupTestCase ()
+  : RouteLookupTestCase ("Ipv4StaticRouting picks the longest prefix, then the lowest metric, then the last route")
+{
+}
+
+Ipv4Address
+Ipv4StaticRoutingLookupTestCase::Gateway (Ptr<Ipv4StaticRouting> routing, std::string dest)
+{
+  Ptr<Ipv4Route> route = Lookup (routing, dest);
+  return route == 0 ? Ipv4Address::GetAny () : route->GetGateway ();
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4StaticRouting> routing = CreateObject<Ipv4StaticRouting> ();
+  m_ipv4->SetRoutingProtocol (routing);
+
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.0.1"), Ipv4Address::GetAny (), "Route without any entry");
+
+  routing->SetDefaultRoute (Ipv4Address ("10.1.0.2"), 1, 10);
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.2.0.2"), 2, 5);
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.3.0.2"), 3, 20);
+  routing->AddHostRouteTo (Ipv4Address ("192.168.1.7"), Ipv4Address ("10.1.0.3"), 1, 30);
+
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "172.16.0.1"), Ipv4Address ("10.1.0.2"), "Default route not used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.2.1"), Ipv4Address ("10.2.0.2"), "Wrong /16 route");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.1"), Ipv4Address ("10.3.0.2"), "Longer prefix with higher metric not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.7"), Ipv4Address ("10.1.0.3"), "Host route not preferred");
+
+  // same prefix: the lower metric wins, and the last route on a tie
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.2.0.3"), 2, 15);
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.1"), Ipv4Address ("10.2.0.3"), "Lower metric not preferred");
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.3.0.3"), 3, 15);
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.1"), Ipv4Address ("10.3.0.3"), "Last route not preferred on a tie");
+
+  // a non contiguous mask still matches, and is as long as GetPrefixLength
+  // says: 32 here
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.0.9"), Ipv4Mask ("255.255.0.255"), Ipv4Address ("10.1.0.4"), 1, 0);
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.2.9"), Ipv4Address ("10.1.0.4"), "Irregular mask not matched");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.2.8"), Ipv4Address ("10.2.0.2"), "Irregular mask matched wrongly");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.9"), Ipv4Address ("10.1.0.4"), "Irregular mask not preferred");
+
+  // removing routes updates the lookups
+  for (uint32_t i = 0; i < routing->GetNRoutes (); )
+    {
+      Ipv4RoutingTableEntry route = routing->GetRoute (i);
+      if (route.GetDestNetwork () == Ipv4Address ("192.168.1.0") || route.GetDestNetwork () == Ipv4Address ("192.168.0.9"))
+        {
+          routing->RemoveRoute (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.1"), Ipv4Address ("10.2.0.2"), "Removed route still used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.9"), Ipv4Address ("10.2.0.2"), "Removed route still used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway (routing, "192.168.1.7"), Ipv4Address ("10.1.0.3"), "Host route lost");
+
+  m_node->Dispose ();
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingLookupTestCase : public RouteLookupTestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : RouteLookupTestCase ("Ipv4GlobalRouting prefers host, then network, then external routes, each in table order")
+{
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  m_ipv4->SetRoutingProtocol (routing);
+
+  routing->AddASExternalRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), Ipv4Address ("10.1.0.9"), 1);
+  routing->AddASExternalRouteTo (Ipv4Address ("172.16.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.2.0.9"), 2);
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.3.0.2"), 3);
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.2.0.2"), 2);
+  routing->AddHostRouteTo (Ipv4Address ("192.168.1.7"), Ipv4Address ("10.1.0.3"), 1);
+  routing->AddHostRouteTo (Ipv4Address ("192.168.1.7"), Ipv4Address ("10.2.0.3"), 2);
+
+  // the first matching route of each kind is used when ECMP is off
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.7")->GetGateway (), Ipv4Address ("10.1.0.3"), "Wrong host route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.1")->GetGateway (), Ipv4Address ("10.3.0.2"), "Wrong network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.2.1")->GetGateway (), Ipv4Address ("10.2.0.2"), "Wrong network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.16.0.1")->GetGateway (), Ipv4Address ("10.1.0.9"), "Wrong external route");
+
+  // all the equal cost host routes are used with random ECMP
+  routing->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  bool seen[2] = { false, false };
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ipv4Address gateway = Lookup (routing, "192.168.1.7")->GetGateway ();
+      seen[0] = seen[0] || gateway == Ipv4Address ("10.1.0.3");
+      seen[1] = seen[1] || gateway == Ipv4Address ("10.2.0.3");
+    }
+  NS_TEST_EXPECT_MSG_EQ ((seen[0] && seen[1]), true, "ECMP routes not all used");
+  routing->SetAttribute ("RandomEcmpRouting", BooleanValue (false));
+
+  // routes 0 and 1 are the host routes, 2 and 3 the network routes, 4 the
+  // default external route
+  routing->RemoveRoute (4);
+  routing->RemoveRoute (2);
+  routing->RemoveRoute (0);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.7")->GetGateway (), Ipv4Address ("10.2.0.3"), "Removed host route still used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.1")->GetGateway (), Ipv4Address ("10.2.0.2"), "Removed network route still used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.16.0.1")->GetGateway (), Ipv4Address ("10.2.0.9"), "Wrong external route");
+  NS_TEST_EXPECT_MSG_EQ ((Lookup (routing, "10.9.0.1") == 0), true, "Removed external route still used");
+
+  m_node->Dispose ();
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingSharedLookupTestCase : public RouteLookupTestCase
+{
+public:
+  Ipv4GlobalRoutingSharedLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void AddShared (Ptr<Ipv4GlobalRouting> routing, uint32_t prefix, std::string gateway, uint32_t interface);
+};
+
+Ipv4GlobalRoutingSharedLookupTestCase::Ipv4GlobalRoutingSharedLookupTestCase ()
+  : RouteLookupTestCase ("Ipv4GlobalRouting shared routes are looked up like the listed ones")
+{
+}
+
+void
+Ipv4GlobalRoutingSharedLookupTestCase::AddShared (Ptr<Ipv4GlobalRouting> routing, uint32_t prefix,
+                                                  std::string gateway, uint32_t interface)
+{
+  std::vector<Ipv4GlobalRouting::NextHop_t> nextHops;
+  nextHops.push_back (Ipv4GlobalRouting::NextHop_t (Ipv4Address (gateway.c_str ()), interface));
+  routing->AddSharedRoutes (prefix, nextHops);
+}
+
+void
+Ipv4GlobalRoutingSharedLookupTestCase::DoRun (void)
+{
+  CreateNode ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  m_ipv4->SetRoutingProtocol (routing);
+
+  Ptr<GlobalRoutePrefixes> prefixes = Create<GlobalRoutePrefixes> ();
+  uint32_t host1 = prefixes->Add (GlobalRoutePrefixes::HOST, Ipv4Address ("192.168.1.7"), Ipv4Mask::GetOnes ());
+  uint32_t host2 = prefixes->Add (GlobalRoutePrefixes::HOST, Ipv4Address ("192.168.2.5"), Ipv4Mask::GetOnes ());
+  uint32_t net24 = prefixes->Add (GlobalRoutePrefixes::NETWORK, Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"));
+  uint32_t net16 = prefixes->Add (GlobalRoutePrefixes::NETWORK, Ipv4Address ("192.168.0.0"), Ipv4Mask ("255.255.0.0"));
+  uint32_t ext = prefixes->Add (GlobalRoutePrefixes::EXTERNAL, Ipv4Address ("172.16.0.0"), Ipv4Mask ("255.255.0.0"));
+  NS_TEST_EXPECT_MSG_EQ (prefixes->Add (GlobalRoutePrefixes::NETWORK, Ipv4Address ("192.168.1.9"), Ipv4Mask ("255.255.255.0")),
+                         net24, "Destination numbered twice");
+  NS_TEST_EXPECT_MSG_EQ (prefixes->Find (GlobalRoutePrefixes::HOST, Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0")),
+                         GlobalRoutePrefixes::NONE, "Destination of another kind found");
+
+  routing->BeginSharedRoutes (prefixes);
+  AddShared (routing, net24, "10.3.0.2", 3);
+  AddShared (routing, net16, "10.2.0.2", 2);
+  AddShared (routing, host1, "10.1.0.3", 1);
+  AddShared (routing, host2, "10.2.0.2", 2);
+  AddShared (routing, ext, "10.1.0.9", 1);
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 5, "Wrong number of shared routes");
+  routing->EndSharedRoutes ();
+  // the host route to 192.168.2.5 goes the way of its /16 network
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 4, "Host route not collapsed");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetRoute (0)->GetDest (), Ipv4Address ("192.168.1.7"), "Wrong first shared route");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.7")->GetGateway (), Ipv4Address ("10.1.0.3"), "Wrong host route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.2.5")->GetGateway (), Ipv4Address ("10.2.0.2"), "Wrong collapsed host route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.1")->GetGateway (), Ipv4Address ("10.3.0.2"), "Most specific network not used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.2.1")->GetGateway (), Ipv4Address ("10.2.0.2"), "Wrong network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "172.16.0.1")->GetGateway (), Ipv4Address ("10.1.0.9"), "Wrong external route");
+  NS_TEST_EXPECT_MSG_EQ ((Lookup (routing, "10.9.0.1") == 0), true, "Route to an unknown destination");
+
+  // listed routes come first, and are removed with the shared ones
+  routing->AddNetworkRouteTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.1.0.5"), 1);
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 5, "Listed route not counted");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.1")->GetGateway (), Ipv4Address ("10.1.0.5"), "Listed route not preferred");
+  routing->RemoveNetworkRoutesTo (Ipv4Address ("192.168.1.0"), Ipv4Mask ("255.255.255.0"));
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 3, "Routes to the network not all removed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.1")->GetGateway (), Ipv4Address ("10.2.0.2"), "Removed route still used");
+
+  // the external route is the last one
+  routing->RemoveRoute (routing->GetNRoutes () - 1);
+  NS_TEST_EXPECT_MSG_EQ ((Lookup (routing, "172.16.0.1") == 0), true, "Removed external route still used");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.7")->GetGateway (), Ipv4Address ("10.1.0.3"), "Host route lost");
+
+  routing->ClearSharedRoutes ();
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNRoutes (), 0, "Shared routes not cleared");
+
+  m_node->Dispose ();
+  Simulator::Destroy ();
+}
+
+class Ipv4RouteLookupTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteLookupTestSuite ();
+};
+
+Ipv4RouteLookupTestSuite::Ipv4RouteLookupTestSuite ()
+  : TestSuite ("ipv4-route-lookup", UNIT)
+{
+  AddTestCase (new PrefixTrieTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4StaticRoutingLookupTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingLookupTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingSharedLookupTestCase, TestCase::QUICK);
+}
+
+static Ipv4RouteLookupTestSuite g_ipv4RouteLookupTestSuite;
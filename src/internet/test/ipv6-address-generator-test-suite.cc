@@ -270,6 +270,18 @@ AddressCollision6TestCase::DoRun (void)
 
   added = Ipv6AddressGenerator::AddAllocated ("0::0:21");
   NS_TEST_EXPECT_MSG_EQ (added, false, "address should not get allocated");
+
+  // Blocks merged across a carry into the next byte
+  Ipv6AddressGenerator::AddAllocated ("0::1:ff");
+  Ipv6AddressGenerator::AddAllocated ("0::1:101");
+  added = Ipv6AddressGenerator::AddAllocated ("0::1:100");
+  NS_TEST_EXPECT_MSG_EQ (added, true, "address should get allocated");
+  added = Ipv6AddressGenerator::AddAllocated ("0::1:100");
+  NS_TEST_EXPECT_MSG_EQ (added, false, "address should not get allocated");
+  added = Ipv6AddressGenerator::AddAllocated ("0::1:ff");
+  NS_TEST_EXPECT_MSG_EQ (added, false, "address should not get allocated");
+  added = Ipv6AddressGenerator::AddAllocated ("0::1:102");
+  NS_TEST_EXPECT_MSG_EQ (added, true, "address should get allocated");
 }
 
 
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-routing-table-entry.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/prefix-trie.h"
+
+using namespace ns3;
+
+// Random IPv6 prefixes and removals, with every lookup checked against a
+// scan of all the prefixes
+class Ipv6PrefixTrieTestCase : public TestCase
+{
+public:
+  Ipv6PrefixTrieTestCase ();
+
+private:
+  struct Prefix
+  {
+    Ipv6Address m_key;
+    uint32_t m_length;
+    uint32_t m_value;
+  };
+
+  virtual void DoRun (void);
+  uint32_t Random (void);
+  Ipv6Address RandomAddress (void);
+  void Check (PrefixTrie<Ipv6Address, uint32_t> const &trie, std::vector<Prefix> const &prefixes, Ipv6Address key);
+
+  uint32_t m_state;
+};
+
+Ipv6PrefixTrieTestCase::Ipv6PrefixTrieTestCase ()
+  : TestCase ("PrefixTrie of IPv6 addresses matches a linear scan"),
+    m_state (1)
+{
+}
+
+uint32_t
+Ipv6PrefixTrieTestCase::Random (void)
+{
+  m_state = m_state * 1103515245 + 12345;
+  return m_state >> 8;
+}
+
+Ipv6Address
+Ipv6PrefixTrieTestCase::RandomAddress (void)
+{
+  // Addresses share their first 32 bits, and only a few bits are random
+  // further on, so that the paths overlap a lot down to the host bits.
+  uint8_t buf[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+  for (uint32_t i = 4; i < 16; i++)
+    {
+      buf[i] = Random () & (i % 4 == 0 ? 0xff : 0x81);
+    }
+  return Ipv6Address (buf);
+}
+
+void
+Ipv6PrefixTrieTestCase::Check (PrefixTrie<Ipv6Address, uint32_t> const &trie, std::vector<Prefix> const &prefixes, Ipv6Address key)
+{
+  std::vector<uint32_t> found;
+  trie.Lookup (key, found);
+  std::vector<uint32_t> expected;
+  for (std::vector<Prefix>::const_iterator i = prefixes.begin (); i != prefixes.end (); i++)
+    {
+      if (Ipv6Prefix (i->m_length).IsMatch (key, i->m_key))
+        {
+          expected.push_back (i->m_value);
+        }
+    }
+  std::sort (found.begin (), found.end ());
+  std::sort (expected.begin (), expected.end ());
+  NS_TEST_EXPECT_MSG_EQ ((found == expected), true, "Wrong matches for " << key);
+}
+
+void
+Ipv6PrefixTrieTestCase::DoRun (void)
+{
+  PrefixTrie<Ipv6Address, uint32_t> trie;
+  std::vector<Prefix> prefixes;
+
+  for (uint32_t value = 0; value < 2000; value++)
+    {
+      Prefix prefix;
+      prefix.m_key = RandomAddress ();
+      prefix.m_length = Random () % 129;
+      prefix.m_value = value;
+      prefixes.push_back (prefix);
+      trie.Insert (prefix.m_key, prefix.m_length, value);
+    }
+  NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), 2000U, "Wrong size");
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Check (trie, prefixes, prefixes[i].m_key);
+      Check (trie, prefixes, RandomAddress ());
+    }
+
+  // remove half of the prefixes, in random order
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint32_t index = Random () % prefixes.size ();
+      Prefix prefix = prefixes[index];
+      prefixes.erase (prefixes.begin () + index);
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefix.m_key, prefix.m_length, prefix.m_value), true, "Prefix not found");
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (prefix.m_key, prefix.m_length, prefix.m_value), false, "Prefix removed twice");
+    }
+  NS_TEST_ASSERT_MSG_EQ (trie.GetSize (), 1000U, "Wrong size");
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Check (trie, prefixes, prefixes[i].m_key);
+      Check (trie, prefixes, RandomAddress ());
+    }
+}
+
+// A node with three interfaces, 2001:1::1/64, 2001:2::1/64 and
+// 2001:3::1/64, on which to check which route is picked
+class Ipv6StaticRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv6StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ipv6Address Gateway (std::string dest);
+
+  Ptr<Ipv6StaticRouting> m_routing;
+};
+
+Ipv6StaticRoutingLookupTestCase::Ipv6StaticRoutingLookupTestCase ()
+  : TestCase ("Ipv6StaticRouting picks the longest prefix, then the lowest metric, then the last route")
+{
+}
+
+Ipv6Address
+Ipv6StaticRoutingLookupTestCase::Gateway (std::string dest)
+{
+  Ipv6Header header;
+  header.SetDestinationAddress (Ipv6Address (dest.c_str ()));
+  Socket::SocketErrno err;
+  Ptr<Ipv6Route> route = m_routing->RouteOutput (Create<Packet> (), header, 0, err);
+  return route == 0 ? Ipv6Address::GetAny () : route->GetGateway ();
+}
+
+void
+Ipv6StaticRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Ipv6L3Protocol> ipv6 = CreateObject<Ipv6L3Protocol> ();
+  m_routing = CreateObject<Ipv6StaticRouting> ();
+  ipv6->SetRoutingProtocol (m_routing);
+  node->AggregateObject (ipv6);
+  node->AggregateObject (CreateObject<Icmpv6L4Protocol> ());
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv6->AddInterface (device);
+      uint8_t address[16] = { 0x20, 0x01, 0, (uint8_t)i, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+      ipv6->AddAddress (interface, Ipv6InterfaceAddress (Ipv6Address (address), Ipv6Prefix (64)));
+      ipv6->SetUp (interface);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8::1"), Ipv6Address::GetAny (), "Route without any entry");
+
+  m_routing->SetDefaultRoute (Ipv6Address ("2001:1::2"), 1, Ipv6Address::GetZero (), 10);
+  m_routing->AddNetworkRouteTo (Ipv6Address ("2001:db8::"), Ipv6Prefix (32), Ipv6Address ("2001:2::2"), 2, 5);
+  m_routing->AddNetworkRouteTo (Ipv6Address ("2001:db8:1::"), Ipv6Prefix (48), Ipv6Address ("2001:3::2"), 3, 20);
+  m_routing->AddHostRouteTo (Ipv6Address ("2001:db8:1::7"), Ipv6Address ("2001:1::3"), 1, Ipv6Address::GetZero (), 30);
+
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:dead::1"), Ipv6Address ("2001:1::2"), "Default route not used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:2::1"), Ipv6Address ("2001:2::2"), "Wrong /32 route");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::1"), Ipv6Address ("2001:3::2"), "Longer prefix with higher metric not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::7"), Ipv6Address ("2001:1::3"), "Host route not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:2::9"), Ipv6Address::GetZero (), "Interface route not used");
+
+  // same prefix: the lower metric wins, and the last route on a tie
+  m_routing->AddNetworkRouteTo (Ipv6Address ("2001:db8:1::"), Ipv6Prefix (48), Ipv6Address ("2001:2::3"), 2, 15);
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::1"), Ipv6Address ("2001:2::3"), "Lower metric not preferred");
+  m_routing->AddNetworkRouteTo (Ipv6Address ("2001:db8:1::"), Ipv6Prefix (48), Ipv6Address ("2001:3::3"), 3, 15);
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::1"), Ipv6Address ("2001:3::3"), "Last route not preferred on a tie");
+
+  // a non contiguous prefix still matches, and is as long as GetPrefixLength
+  // says: 48 here
+  m_routing->AddNetworkRouteTo (Ipv6Address ("2001:db8:0:9::"), Ipv6Prefix ("ffff:ffff:0:ffff::"), Ipv6Address ("2001:1::4"), 1, 0);
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1:9::1"), Ipv6Address ("2001:1::4"), "Irregular prefix not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:2:9::1"), Ipv6Address ("2001:1::4"), "Irregular prefix not matched");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:2:8::1"), Ipv6Address ("2001:2::2"), "Irregular prefix matched wrongly");
+
+  // removing routes updates the lookups
+  for (uint32_t i = 0; i < m_routing->GetNRoutes (); )
+    {
+      Ipv6RoutingTableEntry route = m_routing->GetRoute (i);
+      if (route.GetDestNetwork () == Ipv6Address ("2001:db8:1::") || route.GetDestNetwork () == Ipv6Address ("2001:db8:0:9::"))
+        {
+          m_routing->RemoveRoute (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::1"), Ipv6Address ("2001:2::2"), "Removed route still used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1:9::1"), Ipv6Address ("2001:2::2"), "Removed route still used");
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:db8:1::7"), Ipv6Address ("2001:1::3"), "Host route lost");
+  m_routing->RemoveRoute (Ipv6Address ("::"), Ipv6Prefix::GetZero (), 1, Ipv6Address::GetZero ());
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:dead::1"), Ipv6Address::GetAny (), "Removed default route still used");
+
+  // taking an interface down removes its routes
+  ipv6->SetDown (2);
+  NS_TEST_EXPECT_MSG_EQ (Gateway ("2001:2::9"), Ipv6Address::GetAny (), "Route of a down interface still used");
+
+  node->Dispose ();
+  Simulator::Destroy ();
+}
+
+class Ipv6StaticRoutingTestSuite : public TestSuite
+{
+public:
+  Ipv6StaticRoutingTestSuite ();
+};
+
+Ipv6StaticRoutingTestSuite::Ipv6StaticRoutingTestSuite ()
+  : TestSuite ("ipv6-static-routing", UNIT)
+{
+  AddTestCase (new Ipv6PrefixTrieTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6StaticRoutingLookupTestCase, TestCase::QUICK);
+}
+
+static Ipv6StaticRoutingTestSuite g_ipv6StaticRoutingTestSuite;
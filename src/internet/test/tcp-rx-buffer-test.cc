@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+
+using namespace ns3;
+
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Add the bytes [from, to) of the stream, whose byte at sequence
+   * number 1000 + i is i modulo 256.
+   * \param buffer the buffer
+   * \param from first byte
+   * \param to byte past the last one
+   * \returns the result of TcpRxBuffer::Add
+   */
+  bool AddRange (TcpRxBuffer &buffer, uint32_t from, uint32_t to);
+  /**
+   * \param p a packet
+   * \param first the expected value of its first byte
+   * \return true if the bytes of the packet count up from first
+   */
+  bool CheckBytes (Ptr<Packet> p, uint8_t first);
+  uint8_t m_data[1000]; //!< the bytes of the stream
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("TcpRxBuffer reassembly of reordered and overlapping segments")
+{
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      m_data[i] = i;
+    }
+}
+
+bool
+TcpRxBufferTestCase::AddRange (TcpRxBuffer &buffer, uint32_t from, uint32_t to)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (1000 + from));
+  return buffer.Add (Create<Packet> (m_data + from, to - from), header);
+}
+
+bool
+TcpRxBufferTestCase::CheckBytes (Ptr<Packet> p, uint8_t first)
+{
+  uint8_t *bytes = new uint8_t [p->GetSize ()];
+  p->CopyData (bytes, p->GetSize ());
+  bool ok = true;
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      ok = ok && (bytes[i] == (uint8_t)(first + i));
+    }
+  delete [] bytes;
+  return ok;
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  TcpRxBuffer buffer (1000);
+  buffer.SetMaxBufferSize (10000);
+
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 300, 400), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 100, 200), true, "Add failed");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Available (), 0, "Data available before the head arrived");
+  std::vector<TcpRxBuffer::Range> holes = buffer.GetHoles ();
+  NS_TEST_ASSERT_MSG_EQ (holes.size (), 2, "Wrong number of holes");
+  NS_TEST_EXPECT_MSG_EQ (holes[0].first, SequenceNumber32 (1000), "Wrong first hole");
+  NS_TEST_EXPECT_MSG_EQ (holes[0].second, SequenceNumber32 (1100), "Wrong first hole");
+  NS_TEST_EXPECT_MSG_EQ (holes[1].first, SequenceNumber32 (1200), "Wrong second hole");
+  NS_TEST_EXPECT_MSG_EQ (holes[1].second, SequenceNumber32 (1300), "Wrong second hole");
+
+  // Duplicates are dropped, overlaps are trimmed
+  NS_TEST_EXPECT_MSG_EQ (AddRange (buffer, 120, 180), false, "Duplicate buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 150, 320), true, "Add failed");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 300, "Overlap not trimmed");
+  holes = buffer.GetHoles ();
+  NS_TEST_ASSERT_MSG_EQ (holes.size (), 1, "Hole not filled");
+
+  // Filling the head makes everything available
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 0, 100), true, "Add failed");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Available (), 400, "Wrong available bytes");
+  NS_TEST_EXPECT_MSG_EQ (buffer.NextRxSequence (), SequenceNumber32 (1400), "Wrong RCV.NXT");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetHoles ().empty (), true, "Holes left");
+
+  Ptr<Packet> p = buffer.Extract (60);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 60, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 0), true, "Wrong bytes");
+  p = buffer.Extract (40);
+  NS_TEST_EXPECT_MSG_EQ ((p->GetSize () == 40 && CheckBytes (p, 60)), true, "Wrong rest of a segment");
+  p = buffer.Extract (250);
+  NS_TEST_EXPECT_MSG_EQ ((p->GetSize () == 250 && CheckBytes (p, 100)), true, "Wrong bytes across segments");
+
+  // A hole behind the remaining data
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 500, 600), true, "Add failed");
+  holes = buffer.GetHoles ();
+  NS_TEST_ASSERT_MSG_EQ (holes.size (), 1, "Wrong number of holes");
+  NS_TEST_EXPECT_MSG_EQ (holes[0].first, SequenceNumber32 (1400), "Wrong hole");
+  NS_TEST_EXPECT_MSG_EQ (holes[0].second, SequenceNumber32 (1500), "Wrong hole");
+  p = buffer.Extract (1000);
+  NS_TEST_EXPECT_MSG_EQ ((p->GetSize () == 50 && CheckBytes (p, 350 % 256)), true, "Extracted beyond the hole");
+  NS_TEST_EXPECT_MSG_EQ ((buffer.Extract (1000) == 0), true, "Extracted from a hole");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (buffer, 400, 500), true, "Add failed");
+  p = buffer.Extract (1000);
+  NS_TEST_EXPECT_MSG_EQ ((p->GetSize () == 200 && CheckBytes (p, 144)), true, "Wrong bytes after the hole is filled");
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 0, "Data left");
+
+  // Each Extract creates exactly one new packet, which keeps the global
+  // packet UID sequence, and leaves the packet tags of the segments behind
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (1600));
+  Ptr<Packet> segment = Create<Packet> (m_data, 100);
+  segment->AddPacketTag (SocketIpTtlTag ());
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (segment, header), true, "Add failed");
+  uint64_t uid = Create<Packet> ()->GetUid ();
+  p = buffer.Extract (60);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 60, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (Create<Packet> ()->GetUid (), uid + 2, "Partial segment not extracted into a new packet");
+  SocketIpTtlTag tag;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (tag), false, "Packet tag of the segment extracted");
+  uid = Create<Packet> ()->GetUid ();
+  p = buffer.Extract (40);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 40, "Wrong extracted size");
+  NS_TEST_EXPECT_MSG_EQ (Create<Packet> ()->GetUid (), uid + 2, "Whole segment not extracted into a new packet");
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (tag), false, "Packet tag of the segment extracted");
+}
+
+class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite ();
+};
+
+TcpRxBufferTestSuite::TcpRxBufferTestSuite ()
+  : TestSuite ("tcp-rx-buffer", UNIT)
+{
+  AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+}
+
+static TcpRxBufferTestSuite g_tcpRxBufferTestSuite;
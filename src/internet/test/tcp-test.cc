@@ -36,6 +36,7 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 
 #include "ns3/ipv4-end-point.h"
@@ -46,6 +47,10 @@
 #include "ns3/icmpv6-l4-protocol.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/rtt-estimator.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
 
 #include <string>
 
@@ -61,7 +66,8 @@ public:
                uint32_t sourceReadSize,
                uint32_t serverWriteSize,
                uint32_t serverReadSize,
-               bool useIpv6);
+               bool useIpv6,
+               bool largeSend = false);
 private:
   virtual void DoRun (void);
   virtual void DoTeardown (void);
@@ -77,6 +83,7 @@ private:
   void ServerHandleSend (Ptr<Socket> sock, uint32_t available);
   void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
   void SourceHandleRecv (Ptr<Socket> sock);
+  void SetupSockets (Ptr<Socket> server, Ptr<Socket> source);
 
   uint32_t m_totalBytes;
   uint32_t m_sourceWriteSize;
@@ -92,6 +99,7 @@ private:
   uint8_t* m_serverRxPayload;
 
   bool m_useIpv6;
+  bool m_largeSend;
 };
 
 static std::string Name (std::string str, uint32_t totalStreamSize,
@@ -99,12 +107,17 @@ static std::string Name (std::string str, uint32_t totalStreamSize,
                          uint32_t serverReadSize,
                          uint32_t serverWriteSize,
                          uint32_t sourceReadSize,
-                         bool useIpv6)
+                         bool useIpv6,
+                         bool largeSend)
 {
   std::ostringstream oss;
   oss << str << " total=" << totalStreamSize << " sourceWrite=" << sourceWriteSize 
       << " sourceRead=" << sourceReadSize << " serverRead=" << serverReadSize
       << " serverWrite=" << serverWriteSize << " useIpv6=" << useIpv6;
+  if (largeSend)
+    {
+      oss << " largeSend";
+    }
   return oss.str ();
 }
 
@@ -122,20 +135,23 @@ TcpTestCase::TcpTestCase (uint32_t totalStreamSize,
                           uint32_t sourceReadSize,
                           uint32_t serverWriteSize,
                           uint32_t serverReadSize,
-                          bool useIpv6)
+                          bool useIpv6,
+                          bool largeSend)
   : TestCase (Name ("Send string data from client to server and back", 
                     totalStreamSize, 
                     sourceWriteSize,
                     serverReadSize,
                     serverWriteSize,
                     sourceReadSize,
-                    useIpv6)),
+                    useIpv6,
+                    largeSend)),
     m_totalBytes (totalStreamSize),
     m_sourceWriteSize (sourceWriteSize),
     m_sourceReadSize (sourceReadSize),
     m_serverWriteSize (serverWriteSize),
     m_serverReadSize (serverReadSize),
-    m_useIpv6 (useIpv6)
+    m_useIpv6 (useIpv6),
+    m_largeSend (largeSend)
 {
 }
 
@@ -312,6 +328,19 @@ TcpTestCase::AddSimpleNetDevice (Ptr<Node> node, const char* ipaddr, const char*
   return dev;
 }
 
+void
+TcpTestCase::SetupSockets (Ptr<Socket> server, Ptr<Socket> source)
+{
+  if (m_largeSend)
+    {
+      // Accepted sockets are forked from the listening one and inherit these
+      server->SetAttribute ("LargeSendSegments", UintegerValue (4));
+      server->SetAttribute ("CoalesceAcks", BooleanValue (true));
+      source->SetAttribute ("LargeSendSegments", UintegerValue (4));
+      source->SetAttribute ("CoalesceAcks", BooleanValue (true));
+    }
+}
+
 void
 TcpTestCase::SetupDefaultSim (void)
 {
@@ -344,6 +373,7 @@ TcpTestCase::SetupDefaultSim (void)
 
   source->SetRecvCallback (MakeCallback (&TcpTestCase::SourceHandleRecv, this));
   source->SetSendCallback (MakeCallback (&TcpTestCase::SourceHandleSend, this));
+  SetupSockets (server, source);
 
   source->Connect (serverremoteaddr);
 }
@@ -380,6 +410,7 @@ TcpTestCase::SetupDefaultSim6 (void)
 
   source->SetRecvCallback (MakeCallback (&TcpTestCase::SourceHandleRecv, this));
   source->SetSendCallback (MakeCallback (&TcpTestCase::SourceHandleSend, this));
+  SetupSockets (server, source);
 
   source->Connect (serverremoteaddr);
 }
@@ -425,6 +456,198 @@ TcpTestCase::AddSimpleNetDevice6 (Ptr<Node> node, Ipv6Address ipaddr, Ipv6Prefix
   return dev;
 }
 
+/**
+ * RTT estimator counting the samples it is given
+ */
+class TcpCountingRttEstimator : public RttMeanDeviation
+{
+public:
+  TcpCountingRttEstimator ()
+    : m_samples (0)
+  {
+  }
+  void Measurement (Time measure)
+  {
+    m_samples++;
+    RttMeanDeviation::Measurement (measure);
+  }
+  uint32_t m_samples;
+};
+
+/**
+ * Check with counters that large sends hand several segments down at once,
+ * that coalescing cuts the ACKs of the segments received at the same time,
+ * and that the RTT is still sampled per segment.
+ */
+class TcpLargeSendTestCase : public TestCase
+{
+public:
+  TcpLargeSendTestCase ();
+private:
+  /// What was seen during one transfer
+  struct Counters
+  {
+    uint32_t rxBytes;        //!< Bytes received by the server
+    uint32_t dataSent;       //!< DataSent notifications of the source
+    uint32_t maxDataSent;    //!< Largest amount notified at once
+    uint32_t maxTxSize;      //!< Largest IP packet sent by the source
+    uint32_t acks;           //!< IP packets sent by the server
+    uint32_t rttSamples;     //!< RTT samples taken by the source
+  };
+  virtual void DoRun (void);
+  Counters Transfer (uint32_t largeSendSegments, bool coalesceAcks);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void SourceDataSent (Ptr<Socket> sock, uint32_t size);
+  void ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  void SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  void ServerTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  uint32_t m_totalBytes;
+  uint32_t m_sentBytes;
+  Counters m_counters;
+};
+
+TcpLargeSendTestCase::TcpLargeSendTestCase ()
+  : TestCase ("Large sends and coalesced ACKs happen and keep per segment RTT samples"),
+    m_totalBytes (200000)
+{
+}
+
+void
+TcpLargeSendTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () > 0 && m_sentBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_totalBytes - m_sentBytes, sock->GetTxAvailable ());
+      int sent = sock->Send (Create<Packet> (toSend));
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_sentBytes += sent;
+    }
+  if (m_sentBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+TcpLargeSendTestCase::SourceDataSent (Ptr<Socket> sock, uint32_t size)
+{
+  m_counters.dataSent++;
+  m_counters.maxDataSent = std::max (m_counters.maxDataSent, size);
+}
+
+void
+TcpLargeSendTestCase::ServerHandleConnectionCreated (Ptr<Socket> s, const Address & addr)
+{
+  s->SetRecvCallback (MakeCallback (&TcpLargeSendTestCase::ServerHandleRecv, this));
+}
+
+void
+TcpLargeSendTestCase::ServerHandleRecv (Ptr<Socket> sock)
+{
+  Ptr<Packet> p;
+  while ((p = sock->Recv ()) && p->GetSize () > 0)
+    {
+      m_counters.rxBytes += p->GetSize ();
+    }
+}
+
+void
+TcpLargeSendTestCase::SourceTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_counters.maxTxSize = std::max (m_counters.maxTxSize, p->GetSize ());
+}
+
+void
+TcpLargeSendTestCase::ServerTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_counters.acks++;
+}
+
+TcpLargeSendTestCase::Counters
+TcpLargeSendTestCase::Transfer (uint32_t largeSendSegments, bool coalesceAcks)
+{
+  m_sentBytes = 0;
+  m_counters.rxBytes = 0;
+  m_counters.dataSent = 0;
+  m_counters.maxDataSent = 0;
+  m_counters.maxTxSize = 0;
+  m_counters.acks = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  // The channel has no delay, so that the segments of a large send all
+  // arrive at the same time
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetChannel (channel);
+      nodes.Get (i)->AddDevice (dev);
+      devices.Add (dev);
+    }
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpLargeSendTestCase::SourceTx, this));
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpLargeSendTestCase::ServerTx, this));
+
+  uint16_t port = 50000;
+  Ptr<Socket> server = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  Ptr<Socket> source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  server->SetAttribute ("CoalesceAcks", BooleanValue (coalesceAcks));
+  source->SetAttribute ("LargeSendSegments", UintegerValue (largeSendSegments));
+  Ptr<TcpCountingRttEstimator> rtt = CreateObject<TcpCountingRttEstimator> ();
+  DynamicCast<TcpSocketBase> (source)->SetRtt (rtt);
+
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr< Socket >, const Address &> (),
+                             MakeCallback (&TcpLargeSendTestCase::ServerHandleConnectionCreated, this));
+  source->SetSendCallback (MakeCallback (&TcpLargeSendTestCase::SourceHandleSend, this));
+  source->SetDataSentCallback (MakeCallback (&TcpLargeSendTestCase::SourceDataSent, this));
+  source->Connect (InetSocketAddress (interfaces.GetAddress (1), port));
+
+  Simulator::Run ();
+  m_counters.rttSamples = rtt->m_samples;
+  Simulator::Destroy ();
+  return m_counters;
+}
+
+void
+TcpLargeSendTestCase::DoRun (void)
+{
+  Counters plain = Transfer (1, false);
+  Counters large = Transfer (4, false);
+  Counters coalesced = Transfer (4, true);
+
+  NS_TEST_EXPECT_MSG_EQ (plain.rxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (large.rxBytes, m_totalBytes, "Server received all bytes with large sends");
+  NS_TEST_EXPECT_MSG_EQ (coalesced.rxBytes, m_totalBytes, "Server received all bytes with coalesced ACKs");
+
+  // Large sends hand several segments down at once, but IP still sends
+  // segments no larger than without them
+  NS_TEST_EXPECT_MSG_EQ (plain.maxDataSent, 536, "Segments handed down one by one");
+  NS_TEST_EXPECT_MSG_GT (large.maxDataSent, 536, "Several segments handed down at once");
+  NS_TEST_EXPECT_MSG_LT (large.maxDataSent, 4 * 536 + 1, "At most four segments handed down at once");
+  NS_TEST_EXPECT_MSG_LT (large.dataSent, plain.dataSent / 2, "Fewer sends with large sends");
+  NS_TEST_EXPECT_MSG_EQ (large.maxTxSize, plain.maxTxSize, "IP packets no larger with large sends");
+
+  // The segments of a large send arrive at the same time and get one ACK
+  NS_TEST_EXPECT_MSG_LT (coalesced.acks, large.acks / 2, "Fewer ACKs when coalescing");
+
+  // The RTT is sampled per segment acknowledged, not per large send
+  NS_TEST_EXPECT_MSG_GT (large.rttSamples, plain.rttSamples * 9 / 10, "RTT sampled per segment");
+}
+
 static class TcpTestSuite : public TestSuite
 {
 public:
@@ -442,6 +665,11 @@ public:
     AddTestCase (new TcpTestCase (13, 200, 200, 200, 200, true), TestCase::QUICK);
     AddTestCase (new TcpTestCase (13, 1, 1, 1, 1, true), TestCase::QUICK);
     AddTestCase (new TcpTestCase (100000, 100, 50, 100, 20, true), TestCase::QUICK);
+
+    // Large sends cut below the socket, and coalesced ACKs
+    AddTestCase (new TcpTestCase (100000, 5000, 3000, 5000, 700, false, true), TestCase::QUICK);
+    AddTestCase (new TcpTestCase (100000, 5000, 3000, 5000, 700, true, true), TestCase::QUICK);
+    AddTestCase (new TcpLargeSendTestCase, TestCase::QUICK);
   }
 
 } g_tcpTestSuite;
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+
+using namespace ns3;
+
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param p a packet
+   * \param first the expected value of its first byte
+   * \return true if the bytes of the packet count up from first
+   */
+  bool CheckBytes (Ptr<Packet> p, uint8_t first);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("TcpTxBuffer segments spanning real and zero-filled chunks")
+{
+}
+
+bool
+TcpTxBufferTestCase::CheckBytes (Ptr<Packet> p, uint8_t first)
+{
+  uint8_t *bytes = new uint8_t [p->GetSize ()];
+  p->CopyData (bytes, p->GetSize ());
+  bool ok = true;
+  for (uint32_t i = 0; i < p->GetSize (); i++)
+    {
+      ok = ok && (bytes[i] == (uint8_t)(first + i));
+    }
+  delete [] bytes;
+  return ok;
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  TcpTxBuffer buffer (1000);
+  buffer.SetMaxBufferSize (10000);
+
+  // Three packets of counting bytes, 0 to 299
+  uint8_t data[300];
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      data[i] = i;
+    }
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer.Add (Create<Packet> (data + 100 * i, 100)), true, "Add failed");
+    }
+  // Then zero-filled packets, as sent by BulkSendApplication
+  Ptr<Packet> zeroFilled = Create<Packet> (500);
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (zeroFilled), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (Create<Packet> (500)), true, "Add failed");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Size (), 1300, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (Create<Packet> (9000)), false, "Add beyond the maximum size accepted");
+  NS_TEST_ASSERT_MSG_EQ (buffer.TailSequence (), SequenceNumber32 (2300), "Wrong tail");
+
+  Ptr<Packet> p = buffer.CopyFromSequence (50, SequenceNumber32 (1120));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 50, "Wrong size of a segment within a chunk");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 120), true, "Wrong bytes of a segment within a chunk");
+  p = buffer.CopyFromSequence (150, SequenceNumber32 (1080));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 150, "Wrong size of a segment across chunks");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 80), true, "Wrong bytes of a segment across chunks");
+  p = buffer.CopyFromSequence (100, SequenceNumber32 (1250));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 100, "Wrong size of a segment ending with zeros");
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p->CreateFragment (0, 50), 250), true, "Wrong real bytes");
+  uint8_t zeros[50];
+  p->CreateFragment (50, 50)->CopyData (zeros, 50);
+  uint32_t nonZero = 0;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      nonZero += zeros[i] != 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nonZero, 0, "Zero-filled bytes are not zero");
+
+  // Segments are fragments of the application packets, and the zeros
+  // they carry are not written even across packets
+  p = buffer.CopyFromSequence (100, SequenceNumber32 (1400));
+  NS_TEST_EXPECT_MSG_EQ (p->GetUid (), zeroFilled->GetUid (), "Segment is not a fragment of the application packet");
+  p = buffer.CopyFromSequence (1000, SequenceNumber32 (1300));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1000, "Wrong size of a zero-filled segment");
+  NS_TEST_EXPECT_MSG_EQ (p->GetUid (), zeroFilled->GetUid (), "Segment is not a fragment of the application packet");
+  NS_TEST_EXPECT_MSG_LT (p->GetSerializedSize (), 200, "Zero-filled payload written");
+  p = buffer.CopyFromSequence (1000, SequenceNumber32 (2000));
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 300, "Segment not limited to the end of the data");
+
+  // Acknowledge part of a chunk, then the real data and part of the zeros
+  buffer.DiscardUpTo (SequenceNumber32 (1150));
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 1150, "Wrong size after a partial ACK");
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (1150), "Wrong head after a partial ACK");
+  p = buffer.CopyFromSequence (100, SequenceNumber32 (1150));
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 150), true, "Wrong bytes after a partial ACK");
+  buffer.DiscardUpTo (SequenceNumber32 (1700));
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 600, "Wrong size after the real data is acknowledged");
+  NS_TEST_ASSERT_MSG_EQ (buffer.Add (Create<Packet> (data, 10)), true, "Add failed");
+  p = buffer.CopyFromSequence (20, SequenceNumber32 (2300));
+  NS_TEST_EXPECT_MSG_EQ (CheckBytes (p, 0), true, "Wrong bytes after zeros");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 10, "Wrong size at the tail");
+
+  // Acknowledging a FIN moves the head past the data
+  buffer.DiscardUpTo (SequenceNumber32 (2311));
+  NS_TEST_EXPECT_MSG_EQ (buffer.Size (), 0, "Data left after the FIN is acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (2311), "Wrong head after the FIN");
+}
+
+class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite ();
+};
+
+TcpTxBufferTestSuite::TcpTxBufferTestSuite ()
+  : TestSuite ("tcp-tx-buffer", UNIT)
+{
+  AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+}
+
+static TcpTxBufferTestSuite g_tcpTxBufferTestSuite;
@@ -28,6 +28,7 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/pcapng-file.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +36,12 @@ NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
 namespace ns3 {
 
+//
+// The pcapng file shared by all traces created while EnablePcapNg is in
+// effect.  Each attached PcapFileWrapper holds its own reference.
+//
+static Ptr<PcapNgFile> g_pcapNgFile;
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -56,6 +63,19 @@ PcapHelper::CreateFile (
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
   Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+
+  if (g_pcapNgFile != 0)
+    {
+      std::string name = filename;
+      std::string::size_type dot = name.rfind (".pcap");
+      if (dot != std::string::npos && dot + 5 == name.size ())
+        {
+          name.erase (dot);
+        }
+      file->Attach (g_pcapNgFile, dataLinkType, snapLen, name);
+      return file;
+    }
+
   file->Open (filename, filemode);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
 
@@ -76,6 +96,36 @@ PcapHelper::CreateFile (
   return file;
 }
 
+void
+PcapHelper::EnablePcapNg (std::string filename, bool async)
+{
+  NS_LOG_FUNCTION (filename << async);
+  Ptr<PcapNgFile> file = Create<PcapNgFile> ();
+  file->Open (filename);
+  NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename);
+  if (async)
+    {
+      file->EnableAsyncWrite ();
+    }
+
+  if (g_pcapNgFile == 0)
+    {
+      //
+      // Don't keep the file open past the end of the simulation just because
+      // of this static reference.
+      //
+      Simulator::ScheduleDestroy (&PcapHelper::DisablePcapNg);
+    }
+  g_pcapNgFile = file;
+}
+
+void
+PcapHelper::DisablePcapNg (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_pcapNgFile = 0;
+}
+
 std::string
 PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
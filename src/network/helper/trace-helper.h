@@ -79,9 +79,31 @@ public:
 
   /**
    * @brief Create and initialize a pcap file.
+   *
+   * If EnablePcapNg is in effect, no file is created; the returned wrapper
+   * writes to a new interface of the shared pcapng file instead, named after
+   * filename.  Set the ns3::PcapFileWrapper::AsyncWrite attribute to have the
+   * packets written from a background thread.
    */
   Ptr<PcapFileWrapper> CreateFile (std::string filename, std::ios::openmode filemode,
                                    uint32_t dataLinkType,  uint32_t snapLen = 65535, int32_t tzCorrection = 0);
+
+  /**
+   * @brief Multiplex all pcap traces subsequently created by CreateFile into
+   * a single pcapng file, one interface per trace.
+   *
+   * @param filename The name of the pcapng file to create.
+   * @param async Write the pcapng file from a background thread.
+   */
+  static void EnablePcapNg (std::string filename, bool async = false);
+
+  /**
+   * @brief Go back to creating one pcap file per trace.  Traces already
+   * attached to the pcapng file keep writing to it; the file is closed when
+   * the last of them is.
+   */
+  static void DisablePcapNg (void);
+
   /**
    * @brief Hook a trace source to the default trace sink
    */
@@ -20,6 +20,7 @@
 
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/hash-murmur3.h"
 #include "address.h"
 #include <cstring>
 #include <iostream>
@@ -232,6 +233,15 @@ bool operator < (const Address &a, const Address &b)
   return false;
 }
 
+size_t AddressHash::operator () (Address const &x) const
+{
+  // The length and the bytes: operator == may match different types
+  uint8_t buf[Address::MAX_SIZE + 2];
+  uint32_t size = x.CopyAllTo (buf, sizeof (buf));
+  Hash::Function::Murmur3 hasher;
+  return hasher.GetHash32 ((const char *)buf + 1, size - 1);
+}
+
 std::ostream& operator<< (std::ostream& os, const Address & address)
 {
   os.setf (std::ios::hex, std::ios::basefield);
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <functional>
 #include "ns3/attribute.h"
 #include "ns3/attribute-helper.h"
 #include "ns3/tag-buffer.h"
@@ -232,6 +233,21 @@ bool operator < (const Address &a, const Address &b);
 std::ostream& operator<< (std::ostream& os, const Address & address);
 std::istream& operator>> (std::istream& is, Address & address);
 
+/**
+ * \class AddressHash
+ * \brief Hash function class for addresses, consistent with
+ * operator == (the length and bytes of the address).
+ */
+class AddressHash : public std::unary_function<Address, size_t>
+{
+public:
+  /**
+   * \param x address to hash
+   * \returns the Murmur3 hash of the address
+   */
+  size_t operator () (Address const &x) const;
+};
+
 
 } // namespace ns3
 
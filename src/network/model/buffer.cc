@@ -411,6 +411,36 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
+  if ((m_data->m_count > 1 || m_end != m_data->m_dirtyEnd) &&
+      m_end == m_zeroAreaEnd &&
+      o.m_start == o.m_zeroAreaStart &&
+      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0 &&
+      o.m_end == o.m_zeroAreaEnd)
+    {
+      /**
+       * Our data is shared, as in a fragment of another buffer, and
+       * we append a zero area alone: move the bytes before our zero
+       * area to data of our own, without writing the zero area, so
+       * that the optimization below applies.
+       */
+      struct Buffer::Data *newData = Buffer::Create (GetInternalSize ());
+      memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
+      m_data->m_count--;
+      if (m_data->m_count == 0)
+        {
+          Buffer::Recycle (m_data);
+        }
+      m_data = newData;
+
+      int32_t delta = -m_start;
+      m_zeroAreaStart += delta;
+      m_zeroAreaEnd += delta;
+      m_end += delta;
+      m_start += delta;
+
+      m_data->m_dirtyStart = m_start;
+      m_data->m_dirtyEnd = m_end;
+    }
   if (m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
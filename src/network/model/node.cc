@@ -31,6 +31,7 @@
 #include "ns3/global-value.h"
 #include "ns3/boolean.h"
 #include "ns3/simulator.h"
+#include <set>
 
 NS_LOG_COMPONENT_DEFINE ("Node");
 
@@ -74,7 +75,9 @@ Node::GetTypeId (void)
 
 Node::Node()
   : m_id (0),
-    m_sid (0)
+    m_sid (0),
+    m_dispatchDirty (false),
+    m_receiveDepth (0)
 {
   NS_LOG_FUNCTION (this);
   Construct ();
@@ -82,7 +85,9 @@ Node::Node()
 
 Node::Node(uint32_t sid)
   : m_id (0),
-    m_sid (sid)
+    m_sid (sid),
+    m_dispatchDirty (false),
+    m_receiveDepth (0)
 { 
   NS_LOG_FUNCTION (this << sid);
   Construct ();
@@ -123,6 +128,7 @@ Node::AddDevice (Ptr<NetDevice> device)
   device->SetNode (this);
   device->SetIfIndex (index);
   device->SetReceiveCallback (MakeCallback (&Node::NonPromiscReceiveFromDevice, this));
+  m_dispatchDirty = true;
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &NetDevice::Initialize, device);
   NotifyDeviceAdded (device);
@@ -175,6 +181,8 @@ Node::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_deviceAdditionListeners.clear ();
   m_handlers.clear ();
+  m_dispatch[0].clear ();
+  m_dispatch[1].clear ();
   for (std::vector<Ptr<NetDevice> >::iterator i = m_devices.begin ();
        i != m_devices.end (); i++)
     {
@@ -245,6 +253,7 @@ Node::RegisterProtocolHandler (ProtocolHandler handler,
     }
 
   m_handlers.push_back (entry);
+  m_dispatchDirty = true;
 }
 
 void
@@ -257,6 +266,7 @@ Node::UnregisterProtocolHandler (ProtocolHandler handler)
       if (i->handler.IsEqual (handler))
         {
           m_handlers.erase (i);
+          m_dispatchDirty = true;
           break;
         }
     }
@@ -298,8 +308,39 @@ Node::ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16
   NS_LOG_DEBUG ("Node " << GetId () << " ReceiveFromDevice:  dev "
                         << device->GetIfIndex () << " (type=" << device->GetInstanceTypeId ().GetName ()
                         << ") Packet UID " << packet->GetUid ());
-  bool found = false;
+  // The dispatch table is only rebuilt outside of any handler, so that
+  // the handler lists being iterated stay valid. A handler registered or
+  // unregistered from a handler falls back to the list of handlers.
+  if (m_dispatchDirty && m_receiveDepth == 0)
+    {
+      BuildDispatchTable ();
+    }
+  uint32_t index = device->GetIfIndex ();
+  const DispatchTable &table = m_dispatch[promiscuous ? 1 : 0];
+  if (!m_dispatchDirty && index < table.size () && m_devices[index] == device)
+    {
+      const DeviceDispatchEntry &entry = table[index];
+      const HandlerList *handlers = &entry.others;
+      for (std::vector<struct ProtocolDispatchEntry>::const_iterator i = entry.protocols.begin ();
+           i != entry.protocols.end () && i->protocol <= protocol; i++)
+        {
+          if (i->protocol == protocol)
+            {
+              handlers = &i->handlers;
+              break;
+            }
+        }
+      m_receiveDepth++;
+      for (HandlerList::const_iterator i = handlers->begin (); i != handlers->end (); i++)
+        {
+          (*i) (device, packet, protocol, from, to, packetType);
+        }
+      m_receiveDepth--;
+      return !handlers->empty ();
+    }
 
+  bool found = false;
+  m_receiveDepth++;
   for (ProtocolHandlerList::iterator i = m_handlers.begin ();
        i != m_handlers.end (); i++)
     {
@@ -317,8 +358,66 @@ Node::ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16
             }
         }
     }
+  m_receiveDepth--;
   return found;
 }
+
+void
+Node::BuildDispatchTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t j = 0; j < 2; j++)
+    {
+      bool promiscuous = (j == 1);
+      DispatchTable &table = m_dispatch[j];
+      table.clear ();
+      table.resize (m_devices.size ());
+      for (uint32_t index = 0; index < m_devices.size (); index++)
+        {
+          DeviceDispatchEntry &entry = table[index];
+          std::set<uint16_t> protocols;
+          for (ProtocolHandlerList::const_iterator i = m_handlers.begin ();
+               i != m_handlers.end (); i++)
+            {
+              if (i->promiscuous == promiscuous && i->protocol != 0 &&
+                  (i->device == 0 || i->device == m_devices[index]))
+                {
+                  protocols.insert (i->protocol);
+                }
+            }
+          entry.protocols.resize (protocols.size ());
+          uint32_t k = 0;
+          for (std::set<uint16_t>::const_iterator i = protocols.begin (); i != protocols.end (); i++, k++)
+            {
+              entry.protocols[k].protocol = *i;
+            }
+          // Keep the registration order of the handlers, whether they are
+          // attached to one protocol number or to all of them.
+          for (ProtocolHandlerList::const_iterator i = m_handlers.begin ();
+               i != m_handlers.end (); i++)
+            {
+              if (i->promiscuous != promiscuous ||
+                  (i->device != 0 && i->device != m_devices[index]))
+                {
+                  continue;
+                }
+              for (std::vector<struct ProtocolDispatchEntry>::iterator l = entry.protocols.begin ();
+                   l != entry.protocols.end (); l++)
+                {
+                  if (i->protocol == 0 || i->protocol == l->protocol)
+                    {
+                      l->handlers.push_back (i->handler);
+                    }
+                }
+              if (i->protocol == 0)
+                {
+                  entry.others.push_back (i->handler);
+                }
+            }
+        }
+    }
+  m_dispatchDirty = false;
+}
 void 
 Node::RegisterDeviceAdditionListener (DeviceAdditionListener listener)
 {
@@ -210,6 +210,10 @@ private:
                                  const Address &from, const Address &to, NetDevice::PacketType packetType);
   bool ReceiveFromDevice (Ptr<NetDevice> device, Ptr<const Packet>, uint16_t protocol,
                           const Address &from, const Address &to, NetDevice::PacketType packetType, bool promisc);
+  /**
+   * Rebuild m_dispatch from m_handlers and m_devices.
+   */
+  void BuildDispatchTable (void);
 
   void Construct (void);
 
@@ -220,6 +224,25 @@ private:
     bool promiscuous;
   };
   typedef std::vector<struct Node::ProtocolHandlerEntry> ProtocolHandlerList;
+  typedef std::vector<ProtocolHandler> HandlerList;
+  /**
+   * The handlers invoked for one protocol number, in registration
+   * order. This includes the handlers registered for all protocols.
+   */
+  struct ProtocolDispatchEntry {
+    uint16_t protocol;
+    HandlerList handlers;
+  };
+  /**
+   * The handlers of one device: one entry per protocol number with a
+   * handler of its own, sorted by protocol number, and the handlers
+   * registered for all protocols, invoked for the other protocol numbers.
+   */
+  struct DeviceDispatchEntry {
+    std::vector<struct ProtocolDispatchEntry> protocols;
+    HandlerList others;
+  };
+  typedef std::vector<struct DeviceDispatchEntry> DispatchTable;
   typedef std::vector<DeviceAdditionListener> DeviceAdditionListenerList;
 
   uint32_t    m_id;         // Node id for this node
@@ -227,6 +250,9 @@ private:
   std::vector<Ptr<NetDevice> > m_devices;
   std::vector<Ptr<Application> > m_applications;
   ProtocolHandlerList m_handlers;
+  DispatchTable m_dispatch[2];  // per device index, non-promiscuous and promiscuous handlers
+  bool m_dispatchDirty;         // m_dispatch must be rebuilt before the next receive
+  uint32_t m_receiveDepth;      // number of nested ReceiveFromDevice calls
   DeviceAdditionListenerList m_deviceAdditionListeners;
 };
 
@@ -302,6 +302,21 @@ BufferTest::DoRun (void)
   i.Write (buffer.Begin (), buffer.End ());
   ENSURE_WRITTEN_BYTES (other, 9, 0x1, 0x2, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3, 0x4);
 
+  // appending zero areas to a fragment does not write the zeros
+  buffer = Buffer (1000);
+  buffer.AddAtStart (2);
+  i = buffer.Begin ();
+  i.WriteU8 (0x01);
+  i.WriteU8 (0x02);
+  frag0 = buffer.CreateFragment (0, 502);
+  frag0.AddAtEnd (Buffer (1000));
+  frag0.AddAtEnd (buffer.CreateFragment (2, 1000));
+  NS_TEST_EXPECT_MSG_EQ (frag0.GetSize (), 2502, "Wrong size of the aggregated zero areas");
+  NS_TEST_EXPECT_MSG_LT (frag0.GetSerializedSize (), 100, "Zero areas written while aggregated");
+  ENSURE_WRITTEN_BYTES (frag0.CreateFragment (0, 4), 4, 0x01, 0x02, 0x00, 0x00);
+  ENSURE_WRITTEN_BYTES (frag0.CreateFragment (2498, 4), 4, 0x00, 0x00, 0x00, 0x00);
+  ENSURE_WRITTEN_BYTES (buffer.CreateFragment (0, 4), 4, 0x01, 0x02, 0x00, 0x00);
+
   /// \internal See \bugid{1001}
   std::string ct ("This is the next content of the buffer.");
   buffer = Buffer ();
@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/crc32.h"
+
+using namespace ns3;
+
+// Bit at a time reference implementation of the 802.3 crc
+static uint32_t
+ReferenceCrc32 (const uint8_t *data, int length)
+{
+  uint32_t crc = 0xffffffff;
+  while (length--)
+    {
+      crc ^= *data++;
+      for (int k = 0; k < 8; k++)
+        {
+          crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+  return ~crc;
+}
+
+class Crc32TestCase : public TestCase
+{
+public:
+  Crc32TestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Crc32TestCase::Crc32TestCase ()
+  : TestCase ("Check CRC32Calculate against known values and a reference implementation")
+{
+}
+
+void
+Crc32TestCase::DoRun (void)
+{
+  const uint8_t check[] = "123456789";
+  NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (check, 9), 0xCBF43926, "Wrong crc of the standard check string");
+  NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (check, 0), 0, "Wrong crc of an empty buffer");
+
+  std::vector<uint8_t> buffer (4096 + 16);
+  uint32_t state = 12345;
+  for (uint32_t i = 0; i < buffer.size (); i++)
+    {
+      state = state * 1103515245 + 12345;
+      buffer[i] = state >> 16;
+    }
+
+  // every length around the block sizes of the faster paths, at every
+  // alignment, then a few larger frames
+  for (uint32_t offset = 0; offset < 16; offset++)
+    {
+      for (int length = 0; length <= 300; length++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (&buffer[offset], length),
+                                 ReferenceCrc32 (&buffer[offset], length),
+                                 "Wrong crc for length " << length << " at offset " << offset);
+        }
+      for (int length = 1500; length <= 4096; length += 649)
+        {
+          NS_TEST_ASSERT_MSG_EQ (CRC32Calculate (&buffer[offset], length),
+                                 ReferenceCrc32 (&buffer[offset], length),
+                                 "Wrong crc for length " << length << " at offset " << offset);
+        }
+    }
+}
+
+class Crc32TestSuite : public TestSuite
+{
+public:
+  Crc32TestSuite ();
+};
+
+Crc32TestSuite::Crc32TestSuite ()
+  : TestSuite ("crc32", UNIT)
+{
+  AddTestCase (new Crc32TestCase, TestCase::QUICK);
+}
+
+static Crc32TestSuite g_crc32TestSuite;
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -77,6 +79,77 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((p == 0), true, "There are really no packets in there");
 }
 
+class DropTailQueueRingTestCase : public TestCase
+{
+public:
+  DropTailQueueRingTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueRingTestCase::DropTailQueueRingTestCase ()
+  : TestCase ("Check FIFO order across ring wrap-around and growth")
+{
+}
+void
+DropTailQueueRingTestCase::DoRun (void)
+{
+  //
+  // Packet mode: keep the queue partly full so that head and tail wrap
+  // around the ring many times.
+  //
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (5));
+
+  std::vector<Ptr<Packet> > sent;
+  uint32_t next = 0;
+  for (uint32_t round = 0; round < 20; ++round)
+    {
+      while (queue->GetNPackets () < 4)
+        {
+          Ptr<Packet> p = Create<Packet> (round + 1);
+          sent.push_back (p);
+          NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p), true, "Enqueue below MaxPackets must succeed");
+        }
+      for (uint32_t i = 0; i < 3; ++i)
+        {
+          Ptr<const Packet> peeked = queue->Peek ();
+          Ptr<Packet> p = queue->Dequeue ();
+          NS_TEST_EXPECT_MSG_EQ (p->GetUid (), sent[next]->GetUid (), "Packets must come out in FIFO order");
+          NS_TEST_EXPECT_MSG_EQ (peeked->GetUid (), p->GetUid (), "Peek must return the next packet");
+          ++next;
+        }
+    }
+
+  //
+  // Byte mode: the ring has to grow well past its initial size.
+  //
+  queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("Mode", EnumValue (DropTailQueue::QUEUE_MODE_BYTES));
+  queue->SetAttribute ("MaxBytes", UintegerValue (100000));
+
+  sent.clear ();
+  for (uint32_t i = 0; i < 7; ++i)
+    {
+      queue->Enqueue (Create<Packet> (10));
+      queue->Dequeue ();
+    }
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (10);
+      sent.push_back (p);
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p), true, "Enqueue below MaxBytes must succeed");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 1000, "All packets should be in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 10000, "All bytes should be in there");
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Ptr<Packet> p = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (p->GetUid (), sent[i]->GetUid (), "Packets must come out in FIFO order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "The queue should be empty");
+  NS_TEST_EXPECT_MSG_EQ ((queue->Dequeue () == 0), true, "There are really no packets in there");
+}
+
 static class DropTailQueueTestSuite : public TestSuite
 {
 public:
@@ -84,5 +157,6 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueRingTestCase (), TestCase::QUICK);
   }
 } g_dropTailQueueTestSuite;
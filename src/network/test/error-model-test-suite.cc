@@ -39,6 +39,9 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/rng-seed-manager.h"
+#include "ns3/boolean.h"
+#include <cmath>
+#include <list>
 
 using namespace ns3;
 
@@ -224,6 +227,164 @@ BurstErrorModelSimple::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_drops, 260 , "Wrong number of drops.");
 }
 
+// Check that the skip-ahead mode of the RateErrorModel corrupts packets
+// with the same probability as the per-packet mode, for all three units
+class RateErrorModelSkipAhead : public TestCase
+{
+public:
+  RateErrorModelSkipAhead ();
+  virtual ~RateErrorModelSkipAhead ();
+
+private:
+  virtual void DoRun (void);
+  uint32_t CountDrops (bool skipAhead, std::string unit, double rate,
+                       uint32_t size, uint32_t n, int64_t stream);
+  void Check (std::string unit, double rate, uint32_t size, uint32_t n);
+};
+
+RateErrorModelSkipAhead::RateErrorModelSkipAhead ()
+  : TestCase ("RateErrorModel skip-ahead mode matches the per-packet drop probability")
+{
+}
+
+RateErrorModelSkipAhead::~RateErrorModelSkipAhead ()
+{
+}
+
+uint32_t
+RateErrorModelSkipAhead::CountDrops (bool skipAhead, std::string unit, double rate,
+                                     uint32_t size, uint32_t n, int64_t stream)
+{
+  Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+  em->SetAttribute ("ErrorRate", DoubleValue (rate));
+  em->SetAttribute ("ErrorUnit", StringValue (unit));
+  em->SetAttribute ("SkipAhead", BooleanValue (skipAhead));
+  em->AssignStreams (stream);
+
+  uint32_t drops = 0;
+  Ptr<Packet> p = Create<Packet> (size);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (em->IsCorrupt (p))
+        {
+          drops++;
+        }
+    }
+  return drops;
+}
+
+void
+RateErrorModelSkipAhead::Check (std::string unit, double rate, uint32_t size, uint32_t n)
+{
+  uint32_t units = 1;
+  if (unit == "ERROR_UNIT_BYTE")
+    {
+      units = size;
+    }
+  else if (unit == "ERROR_UNIT_BIT")
+    {
+      units = 8 * size;
+    }
+  double per = 1 - std::pow (1.0 - rate, static_cast<double> (units));
+  double expected = per * n;
+  // five standard deviations of the binomial count for each mode, and of
+  // the difference of two independent counts between them
+  double sigma = std::sqrt (n * per * (1 - per));
+
+  uint32_t perPacket = CountDrops (false, unit, rate, size, n, 10);
+  uint32_t skipAhead = CountDrops (true, unit, rate, size, n, 20);
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (perPacket, expected, 5 * sigma, "Per-packet drops off for " << unit);
+  NS_TEST_EXPECT_MSG_EQ_TOL (skipAhead, expected, 5 * sigma, "Skip-ahead drops off for " << unit);
+  NS_TEST_EXPECT_MSG_EQ_TOL (static_cast<double> (skipAhead), static_cast<double> (perPacket),
+                             5 * std::sqrt (2.0) * sigma, "Modes disagree for " << unit);
+}
+
+void
+RateErrorModelSkipAhead::DoRun (void)
+{
+  RngSeedManager::SetSeed (7);
+  RngSeedManager::SetRun (2);
+
+  Check ("ERROR_UNIT_PACKET", 0.01, 1000, 100000);
+  Check ("ERROR_UNIT_BYTE", 1e-4, 1000, 50000);
+  Check ("ERROR_UNIT_BIT", 1e-5, 1000, 50000);
+  // a rate high enough to make several errors fall in most packets
+  Check ("ERROR_UNIT_BYTE", 2e-3, 1000, 20000);
+
+  // the limits never draw a variate
+  NS_TEST_EXPECT_MSG_EQ (CountDrops (true, "ERROR_UNIT_BIT", 0.0, 1000, 1000, 30), 0, "Rate 0 drops nothing");
+  NS_TEST_EXPECT_MSG_EQ (CountDrops (true, "ERROR_UNIT_BIT", 1.0, 1000, 1000, 30), 1000, "Rate 1 drops everything");
+}
+
+// Check ListErrorModel and ReceiveListErrorModel lookups against unsorted,
+// duplicated lists
+class ListErrorModelLookup : public TestCase
+{
+public:
+  ListErrorModelLookup ();
+  virtual ~ListErrorModelLookup ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ListErrorModelLookup::ListErrorModelLookup ()
+  : TestCase ("ListErrorModel and ReceiveListErrorModel lookups")
+{
+}
+
+ListErrorModelLookup::~ListErrorModelLookup ()
+{
+}
+
+void
+ListErrorModelLookup::DoRun (void)
+{
+  std::list<uint32_t> sequence;
+  sequence.push_back (7);
+  sequence.push_back (2);
+  sequence.push_back (11);
+  sequence.push_back (2);
+
+  Ptr<ReceiveListErrorModel> rem = CreateObject<ReceiveListErrorModel> ();
+  rem->SetList (sequence);
+  NS_TEST_ASSERT_MSG_EQ ((rem->GetList () == sequence), true, "List not kept as given");
+  Ptr<Packet> p = Create<Packet> (100);
+  for (uint32_t i = 0; i < 15; i++)
+    {
+      bool expected = (i == 2 || i == 7 || i == 11);
+      NS_TEST_EXPECT_MSG_EQ (rem->IsCorrupt (p), expected, "Wrong decision for reception " << i);
+    }
+  // a new list only applies to the receptions still to come
+  std::list<uint32_t> more;
+  more.push_back (16);
+  more.push_back (3);
+  rem->SetList (more);
+  NS_TEST_EXPECT_MSG_EQ (rem->IsCorrupt (p), false, "Wrong decision for reception 15");
+  NS_TEST_EXPECT_MSG_EQ (rem->IsCorrupt (p), true, "Wrong decision for reception 16");
+
+  std::list<Ptr<Packet> > packets;
+  std::list<uint32_t> uids;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      packets.push_back (Create<Packet> (100));
+      if (i % 3 == 0)
+        {
+          uids.push_front (packets.back ()->GetUid ());
+        }
+    }
+  Ptr<ListErrorModel> lem = CreateObject<ListErrorModel> ();
+  lem->SetList (uids);
+  uint32_t i = 0;
+  for (std::list<Ptr<Packet> >::const_iterator it = packets.begin (); it != packets.end (); ++it, ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (lem->IsCorrupt (*it), (i % 3 == 0), "Wrong decision for packet " << i);
+    }
+  lem->Reset ();
+  NS_TEST_EXPECT_MSG_EQ (lem->IsCorrupt (packets.front ()), false, "Reset did not clear the list");
+}
+
 // This is the start of an error model test suite.  For starters, this is
 // just testing that the SimpleNetDevice is working but this can be
 // extended to many more test cases in the future
@@ -238,6 +399,8 @@ ErrorModelTestSuite::ErrorModelTestSuite ()
 {
   AddTestCase (new ErrorModelSimple, TestCase::QUICK);
   AddTestCase (new BurstErrorModelSimple, TestCase::QUICK);
+  AddTestCase (new RateErrorModelSkipAhead, TestCase::QUICK);
+  AddTestCase (new ListErrorModelLookup, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-net-device.h"
+
+namespace ns3 {
+
+/**
+ * Protocol handler appending its tag to a log of the handlers invoked
+ */
+class ProtocolHandlerRecorder
+{
+public:
+  ProtocolHandlerRecorder (std::string *log, char tag)
+    : m_log (log),
+      m_tag (tag)
+  {
+  }
+  void Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType packetType)
+  {
+    *m_log += m_tag;
+  }
+private:
+  std::string *m_log;
+  char m_tag;
+};
+
+/**
+ * Check which protocol handlers are invoked, and in which order,
+ * depending on the device, the protocol number and the promiscuous mode
+ */
+class NodeProtocolHandlerTestCase : public TestCase
+{
+public:
+  NodeProtocolHandlerTestCase ();
+private:
+  virtual void DoRun (void);
+  std::string Deliver (Ptr<SimpleNetDevice> device, uint16_t protocol);
+  Ptr<Node> m_node;
+  std::string m_log;
+};
+
+NodeProtocolHandlerTestCase::NodeProtocolHandlerTestCase ()
+  : TestCase ("Protocol handlers dispatch")
+{
+}
+
+std::string
+NodeProtocolHandlerTestCase::Deliver (Ptr<SimpleNetDevice> device, uint16_t protocol)
+{
+  m_log = "";
+  Simulator::ScheduleWithContext (m_node->GetId (), Seconds (0), &SimpleNetDevice::Receive, device,
+                                  Create<Packet> (100), protocol, Mac48Address::GetBroadcast (),
+                                  Mac48Address::Allocate ());
+  Simulator::Run ();
+  return m_log;
+}
+
+void
+NodeProtocolHandlerTestCase::DoRun (void)
+{
+  m_node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> dev0 = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> dev1 = CreateObject<SimpleNetDevice> ();
+  dev0->SetAddress (Mac48Address::Allocate ());
+  dev1->SetAddress (Mac48Address::Allocate ());
+  m_node->AddDevice (dev0);
+  m_node->AddDevice (dev1);
+
+  ProtocolHandlerRecorder a (&m_log, 'A');
+  ProtocolHandlerRecorder b (&m_log, 'B');
+  ProtocolHandlerRecorder c (&m_log, 'C');
+  ProtocolHandlerRecorder p (&m_log, 'P');
+  ProtocolHandlerRecorder q (&m_log, 'Q');
+  Node::ProtocolHandler handlerA = MakeCallback (&ProtocolHandlerRecorder::Receive, &a);
+  m_node->RegisterProtocolHandler (handlerA, 0, 0);
+  m_node->RegisterProtocolHandler (MakeCallback (&ProtocolHandlerRecorder::Receive, &b), 0x0800, dev0);
+  m_node->RegisterProtocolHandler (MakeCallback (&ProtocolHandlerRecorder::Receive, &c), 0x0806, 0);
+  m_node->RegisterProtocolHandler (MakeCallback (&ProtocolHandlerRecorder::Receive, &p), 0, dev1, true);
+  m_node->RegisterProtocolHandler (MakeCallback (&ProtocolHandlerRecorder::Receive, &q), 0x0800, 0, true);
+
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev0, 0x0800), "ABQ", "Wrong handlers for IPv4 on device 0");
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev0, 0x0806), "AC", "Wrong handlers for ARP on device 0");
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev0, 0x86dd), "A", "Wrong handlers for IPv6 on device 0");
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev1, 0x0800), "APQ", "Wrong handlers for IPv4 on device 1");
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev1, 0x0806), "ACP", "Wrong handlers for ARP on device 1");
+
+  m_node->UnregisterProtocolHandler (handlerA);
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev0, 0x0800), "BQ", "Wrong handlers after unregistering");
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev0, 0x86dd), "", "Wrong handlers after unregistering");
+
+  // A device added after the handlers gets the handlers of all devices
+  Ptr<SimpleNetDevice> dev2 = CreateObject<SimpleNetDevice> ();
+  dev2->SetAddress (Mac48Address::Allocate ());
+  m_node->AddDevice (dev2);
+  NS_TEST_EXPECT_MSG_EQ (Deliver (dev2, 0x0806), "C", "Wrong handlers for a new device");
+
+  m_node->Dispose ();
+  m_node = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * Node test suite
+ */
+class NodeTestSuite : public TestSuite
+{
+public:
+  NodeTestSuite ();
+};
+
+NodeTestSuite::NodeTestSuite ()
+  : TestSuite ("node", UNIT)
+{
+  AddTestCase (new NodeProtocolHandlerTestCase, QUICK);
+}
+
+static NodeTestSuite g_nodeTestSuite;
+
+}  // namespace ns3
@@ -21,10 +21,13 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <fstream>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcapng-file.h"
 
 using namespace ns3;
 
@@ -1120,6 +1123,243 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that asynchronous writes produce the same file as
+// plain ones, including when the writer thread falls a whole ring behind.
+// ===========================================================================
+class AsyncWriteTestCase : public TestCase
+{
+public:
+  AsyncWriteTestCase ();
+  virtual ~AsyncWriteTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  std::string m_syncFilename;
+  std::string m_asyncFilename;
+};
+
+AsyncWriteTestCase::AsyncWriteTestCase ()
+  : TestCase ("Check that asynchronous writes produce the same file as plain ones")
+{
+}
+
+AsyncWriteTestCase::~AsyncWriteTestCase ()
+{
+}
+
+void
+AsyncWriteTestCase::DoSetup (void)
+{
+  m_syncFilename = CreateTempDirFilename ("async-write-sync.pcap");
+  m_asyncFilename = CreateTempDirFilename ("async-write-async.pcap");
+}
+
+void
+AsyncWriteTestCase::DoTeardown (void)
+{
+  remove (m_syncFilename.c_str ());
+  remove (m_asyncFilename.c_str ());
+}
+
+void
+AsyncWriteTestCase::DoRun (void)
+{
+  const uint32_t nPackets = 2000;
+  const uint32_t snapLen = 1000;
+  uint8_t buffer[1500];
+
+  PcapFile syncFile;
+  PcapFile asyncFile;
+
+  syncFile.Open (m_syncFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (syncFile.Fail (), false, "Open (" << m_syncFilename << ", \"std::ios::out\") returns error");
+  syncFile.Init (1, snapLen);
+
+  asyncFile.Open (m_asyncFilename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (asyncFile.Fail (), false, "Open (" << m_asyncFilename << ", \"std::ios::out\") returns error");
+  asyncFile.Init (1, snapLen);
+  //
+  // Ask for tiny buffers: they are enlarged to hold one record at the snap
+  // length, so the ring wraps around many times.
+  //
+  asyncFile.EnableAsyncWrite (1);
+  NS_TEST_ASSERT_MSG_EQ (asyncFile.Fail (), false, "EnableAsyncWrite () returns error");
+
+  uint64_t expectedSize = 24;
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      uint32_t size = (i * 37) % sizeof (buffer);
+      for (uint32_t j = 0; j < size; ++j)
+        {
+          buffer[j] = (i + j) & 0xff;
+        }
+      syncFile.Write (i / 1000, i % 1000, buffer, size);
+      asyncFile.Write (i / 1000, i % 1000, buffer, size);
+      expectedSize += 16 + std::min (size, snapLen);
+    }
+  NS_TEST_ASSERT_MSG_EQ (asyncFile.Fail (), false, "Write () returns error");
+
+  syncFile.Close ();
+  asyncFile.Close ();
+  NS_TEST_ASSERT_MSG_EQ (asyncFile.Fail (), false, "Close () returns error");
+
+  NS_TEST_ASSERT_MSG_EQ (CheckFileLength (m_asyncFilename, expectedSize), true,
+                         "Asynchronously written file has the wrong length");
+
+  uint32_t sec (0), usec (0);
+  bool diff = PcapFile::Diff (m_syncFilename, m_asyncFilename, sec, usec, snapLen);
+  NS_TEST_ASSERT_MSG_EQ (diff, false, "Asynchronously written file differs at " << sec << "." << usec);
+}
+
+// ===========================================================================
+// Test case to make sure that a pcapng file multiplexing several interfaces
+// has the expected block structure.
+// ===========================================================================
+class PcapNgWriteTestCase : public TestCase
+{
+public:
+  PcapNgWriteTestCase (bool async);
+  virtual ~PcapNgWriteTestCase ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  uint32_t Read32 (std::ifstream &f);
+  uint16_t Read16 (std::ifstream &f);
+
+  bool m_async;
+  std::string m_testFilename;
+};
+
+PcapNgWriteTestCase::PcapNgWriteTestCase (bool async)
+  : TestCase (async ? "Check pcapng block structure with asynchronous writes"
+              : "Check pcapng block structure"),
+    m_async (async)
+{
+}
+
+PcapNgWriteTestCase::~PcapNgWriteTestCase ()
+{
+}
+
+void
+PcapNgWriteTestCase::DoSetup (void)
+{
+  m_testFilename = CreateTempDirFilename (m_async ? "pcapng-async.pcapng" : "pcapng.pcapng");
+}
+
+void
+PcapNgWriteTestCase::DoTeardown (void)
+{
+  remove (m_testFilename.c_str ());
+}
+
+uint32_t
+PcapNgWriteTestCase::Read32 (std::ifstream &f)
+{
+  uint32_t v = 0;
+  f.read ((char *)&v, sizeof (v));
+  return v;
+}
+
+uint16_t
+PcapNgWriteTestCase::Read16 (std::ifstream &f)
+{
+  uint16_t v = 0;
+  f.read ((char *)&v, sizeof (v));
+  return v;
+}
+
+void
+PcapNgWriteTestCase::DoRun (void)
+{
+  PcapNgFile ng;
+  ng.Open (m_testFilename);
+  NS_TEST_ASSERT_MSG_EQ (ng.Fail (), false, "Open (" << m_testFilename << ") returns error");
+  if (m_async)
+    {
+      ng.EnableAsyncWrite ();
+    }
+
+  uint32_t if0 = ng.AddInterface (9, 100, "n0-d1");
+  uint32_t if1 = ng.AddInterface (1, 8, "");
+  NS_TEST_ASSERT_MSG_EQ (if0, 0, "First interface must have index 0");
+  NS_TEST_ASSERT_MSG_EQ (if1, 1, "Second interface must have index 1");
+  NS_TEST_ASSERT_MSG_EQ (ng.GetNInterfaces (), 2, "Two interfaces expected");
+  NS_TEST_ASSERT_MSG_EQ (ng.GetSnapLen (if1), 8, "Wrong snap length");
+
+  uint8_t data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  ng.Write (if0, 5000000001ULL, data, 10);
+  ng.Write (if1, 7, data, 10);
+  ng.Close ();
+  NS_TEST_ASSERT_MSG_EQ (ng.Fail (), false, "Close () returns error");
+
+  //
+  // SHB 28, IDB 0 with name (20 + 4 + 8 + 8 + 4), IDB 1 without (20 + 8 + 4),
+  // EPB 0 with 10 bytes padded to 12, EPB 1 truncated to 8.
+  //
+  NS_TEST_ASSERT_MSG_EQ (CheckFileLength (m_testFilename, 28 + 44 + 32 + 44 + 40), true,
+                         "pcapng file has the wrong length");
+
+  std::ifstream f (m_testFilename.c_str (), std::ios::in | std::ios::binary);
+
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::SECTION_HEADER_BLOCK, "Bad SHB type");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 28, "Bad SHB length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::BYTE_ORDER_MAGIC, "Bad byte order magic");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 1, "Bad major version");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 0, "Bad minor version");
+  f.seekg (28, std::ios::beg);
+
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::INTERFACE_DESCRIPTION_BLOCK, "Bad IDB type");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 44, "Bad IDB length");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 9, "Bad link type");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 0, "Bad reserved field");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 100, "Bad snap length");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 2, "Expected if_name option");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 5, "Bad if_name length");
+  char name[8];
+  f.read (name, 8);
+  NS_TEST_ASSERT_MSG_EQ (std::string (name, 5), "n0-d1", "Bad if_name");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 9, "Expected if_tsresol option");
+  NS_TEST_ASSERT_MSG_EQ (Read16 (f), 1, "Bad if_tsresol length");
+  NS_TEST_ASSERT_MSG_EQ ((Read32 (f) & 0xff), 9, "Bad if_tsresol value");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 0, "Expected end of options");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 44, "Bad IDB trailing length");
+
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::INTERFACE_DESCRIPTION_BLOCK, "Bad IDB type");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 32, "Bad IDB length");
+  f.seekg (28 + 44 + 32, std::ios::beg);
+
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::ENHANCED_PACKET_BLOCK, "Bad EPB type");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 44, "Bad EPB length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 0, "Bad interface id");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 1, "Bad timestamp (high)");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 705032705, "Bad timestamp (low)");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 10, "Bad captured length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 10, "Bad original length");
+  uint8_t readData[12];
+  f.read ((char *)readData, 12);
+  NS_TEST_ASSERT_MSG_EQ (std::memcmp (readData, data, 10), 0, "Bad packet data");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 44, "Bad EPB trailing length");
+
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), PcapNgFile::ENHANCED_PACKET_BLOCK, "Bad EPB type");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 40, "Bad EPB length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 1, "Bad interface id");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 0, "Bad timestamp (high)");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 7, "Bad timestamp (low)");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 8, "Bad captured length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 10, "Bad original length");
+  f.seekg (8, std::ios::cur);
+  NS_TEST_ASSERT_MSG_EQ (Read32 (f), 40, "Bad EPB trailing length");
+  NS_TEST_ASSERT_MSG_EQ (f.fail (), false, "Unexpected end of pcapng file");
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1137,6 +1377,9 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new AsyncWriteTestCase, TestCase::QUICK);
+  AddTestCase (new PcapNgWriteTestCase (false), TestCase::QUICK);
+  AddTestCase (new PcapNgWriteTestCase (true), TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
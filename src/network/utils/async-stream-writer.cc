@@ -0,0 +1,331 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "async-stream-writer.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/callback.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif /* HAVE_PTHREAD_H */
+
+NS_LOG_COMPONENT_DEFINE ("AsyncStreamWriter");
+
+namespace ns3 {
+
+#ifdef HAVE_PTHREAD_H
+//
+// Upper bound on how long either side sleeps before looking at the ring
+// again.  SystemCondition only remembers the last Signal, so we never rely
+// on a wakeup alone.
+//
+static const uint64_t WAIT_NS = 1000000;
+#endif /* HAVE_PTHREAD_H */
+
+AsyncStreamWriter::AsyncStreamWriter (std::ostream *os, bool async,
+                                      uint32_t chunkSize, uint32_t nChunks)
+  : m_os (os),
+    m_chunkSize (chunkSize),
+    m_head (0),
+    m_tail (0),
+    m_offset (0),
+    m_async (false),
+    m_fail (false),
+    m_closed (false)
+{
+  NS_LOG_FUNCTION (this << os << async << chunkSize << nChunks);
+  NS_ASSERT (chunkSize > 0 && nChunks > 0);
+
+#ifdef HAVE_PTHREAD_H
+  m_async = async;
+  m_stop = false;
+  m_mutex = 0;
+  m_dataReady = 0;
+  m_spaceReady = 0;
+#endif /* HAVE_PTHREAD_H */
+
+  //
+  // Inline writes only ever need the one chunk being filled.
+  //
+  m_chunks.resize (m_async ? nChunks : 1);
+  for (std::vector<Chunk>::iterator i = m_chunks.begin (); i != m_chunks.end (); ++i)
+    {
+      i->m_data = new uint8_t [m_chunkSize];
+      i->m_size = 0;
+    }
+
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      m_mutex = new SystemMutex;
+      m_dataReady = new SystemCondition;
+      m_spaceReady = new SystemCondition;
+      m_thread = Create<SystemThread> (MakeCallback (&AsyncStreamWriter::Run, this));
+      m_thread->Start ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+AsyncStreamWriter::~AsyncStreamWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+
+#ifdef HAVE_PTHREAD_H
+  m_thread = 0;
+  delete m_mutex;
+  delete m_dataReady;
+  delete m_spaceReady;
+#endif /* HAVE_PTHREAD_H */
+
+  for (std::vector<Chunk>::iterator i = m_chunks.begin (); i != m_chunks.end (); ++i)
+    {
+      delete [] i->m_data;
+    }
+}
+
+bool
+AsyncStreamWriter::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      CriticalSection cs (*m_mutex);
+      return m_fail;
+    }
+#endif /* HAVE_PTHREAD_H */
+  return m_fail;
+}
+
+bool
+AsyncStreamWriter::IsAsync (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_async;
+}
+
+uint32_t
+AsyncStreamWriter::GetChunkSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_chunkSize;
+}
+
+uint8_t *
+AsyncStreamWriter::Reserve (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT_MSG (!m_closed, "AsyncStreamWriter::Reserve(): writer is closed");
+  NS_ASSERT_MSG (size <= m_chunkSize, "AsyncStreamWriter::Reserve(): " << size << " bytes do not fit in a chunk");
+
+  if (m_offset + size > m_chunkSize)
+    {
+      Submit ();
+    }
+  uint8_t *start = m_chunks[m_head % m_chunks.size ()].m_data + m_offset;
+  m_offset += size;
+  return start;
+}
+
+void
+AsyncStreamWriter::Write (uint8_t const *data, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &data << size);
+  NS_ASSERT_MSG (!m_closed, "AsyncStreamWriter::Write(): writer is closed");
+
+  while (size > 0)
+    {
+      if (m_offset == m_chunkSize)
+        {
+          Submit ();
+        }
+      uint32_t toCopy = std::min (size, m_chunkSize - m_offset);
+      std::memcpy (m_chunks[m_head % m_chunks.size ()].m_data + m_offset, data, toCopy);
+      m_offset += toCopy;
+      data += toCopy;
+      size -= toCopy;
+    }
+}
+
+void
+AsyncStreamWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  if (m_offset > 0)
+    {
+      Submit ();
+    }
+
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      for (;;)
+        {
+          m_spaceReady->SetCondition (false);
+          {
+            CriticalSection cs (*m_mutex);
+            if (m_tail == m_head)
+              {
+                break;
+              }
+          }
+          m_spaceReady->TimedWait (WAIT_NS);
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
+
+  //
+  // The consumer is idle now that the ring is empty, so the stream is ours.
+  //
+  m_os->flush ();
+}
+
+void
+AsyncStreamWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  Flush ();
+
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      {
+        CriticalSection cs (*m_mutex);
+        m_stop = true;
+      }
+      m_dataReady->SetCondition (true);
+      m_dataReady->Signal ();
+      m_thread->Join ();
+    }
+#endif /* HAVE_PTHREAD_H */
+
+  m_closed = true;
+}
+
+void
+AsyncStreamWriter::Submit (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_async)
+    {
+      m_chunks[0].m_size = m_offset;
+      WriteChunk (m_chunks[0]);
+      m_offset = 0;
+      return;
+    }
+
+#ifdef HAVE_PTHREAD_H
+  m_chunks[m_head % m_chunks.size ()].m_size = m_offset;
+  m_offset = 0;
+  {
+    CriticalSection cs (*m_mutex);
+    ++m_head;
+  }
+  m_dataReady->SetCondition (true);
+  m_dataReady->Signal ();
+
+  //
+  // The next chunk to fill may still be queued for writing if the consumer
+  // has fallen a whole ring behind.
+  //
+  for (;;)
+    {
+      m_spaceReady->SetCondition (false);
+      {
+        CriticalSection cs (*m_mutex);
+        if (m_head - m_tail < m_chunks.size ())
+          {
+            break;
+          }
+      }
+      NS_LOG_LOGIC ("Ring full, waiting for the writer thread");
+      m_spaceReady->TimedWait (WAIT_NS);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+AsyncStreamWriter::WriteChunk (Chunk &chunk)
+{
+  m_os->write ((const char *)chunk.m_data, chunk.m_size);
+  if (m_os->fail ())
+    {
+#ifdef HAVE_PTHREAD_H
+      if (m_async)
+        {
+          CriticalSection cs (*m_mutex);
+          m_fail = true;
+          return;
+        }
+#endif /* HAVE_PTHREAD_H */
+      m_fail = true;
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+AsyncStreamWriter::Run (void)
+{
+  //
+  // Only m_head and m_stop are shared with the producer; m_tail is only
+  // ever written here.
+  //
+  for (;;)
+    {
+      m_dataReady->SetCondition (false);
+      bool pending;
+      bool stop;
+      {
+        CriticalSection cs (*m_mutex);
+        pending = m_tail != m_head;
+        stop = m_stop;
+      }
+      if (pending)
+        {
+          WriteChunk (m_chunks[m_tail % m_chunks.size ()]);
+          {
+            CriticalSection cs (*m_mutex);
+            ++m_tail;
+          }
+          m_spaceReady->SetCondition (true);
+          m_spaceReady->Signal ();
+          continue;
+        }
+      if (stop)
+        {
+          break;
+        }
+      m_dataReady->TimedWait (WAIT_NS);
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_STREAM_WRITER_H
+#define ASYNC_STREAM_WRITER_H
+
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "ns3/core-config.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+#ifdef HAVE_PTHREAD_H
+class SystemThread;
+class SystemMutex;
+class SystemCondition;
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \brief Batch writes to an output stream in large chunks, optionally
+ * draining them from a background thread.
+ *
+ * The writer owns a ring of fixed size chunks.  The producer (usually the
+ * simulation thread) serializes records straight into the chunk it currently
+ * owns, without any locking; only when a chunk is full is it handed over to
+ * the consumer and the next free chunk taken from the ring.  In asynchronous
+ * mode the consumer is a SystemThread which writes full chunks to the stream
+ * in the background; the producer only blocks if the whole ring is waiting
+ * to be written.  Without threading support (or if asynchronous mode is not
+ * requested) full chunks are written inline, which still turns many small
+ * writes into a few large ones.
+ *
+ * Once the writer is created, the stream must not be touched by anybody
+ * else until Close () returns.
+ */
+class AsyncStreamWriter
+{
+public:
+  static const uint32_t CHUNK_SIZE_DEFAULT = 1 << 20; /**< Default size of one chunk of the ring */
+  static const uint32_t N_CHUNKS_DEFAULT = 4;         /**< Default number of chunks in the ring */
+
+  /**
+   * \param os the stream to write to.
+   * \param async true if chunks should be written from a background thread.
+   * \param chunkSize the size of each chunk of the ring, in bytes.
+   * \param nChunks the number of chunks in the ring.
+   */
+  AsyncStreamWriter (std::ostream *os, bool async,
+                     uint32_t chunkSize = CHUNK_SIZE_DEFAULT,
+                     uint32_t nChunks = N_CHUNKS_DEFAULT);
+  ~AsyncStreamWriter ();
+
+  /**
+   * \return true if any write to the underlying stream has failed.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \return true if chunks are written by a background thread.
+   */
+  bool IsAsync (void) const;
+
+  /**
+   * \return the size of each chunk of the ring.  This is the largest
+   * value that can be passed to Reserve ().
+   */
+  uint32_t GetChunkSize (void) const;
+
+  /**
+   * \brief Get contiguous room for the next size bytes of output.
+   *
+   * The caller must fill all of the returned bytes before the next call
+   * to any other method of this writer.
+   *
+   * \param size number of bytes to reserve, at most GetChunkSize ().
+   * \return a pointer to size bytes owned by the caller.
+   */
+  uint8_t *Reserve (uint32_t size);
+
+  /**
+   * \brief Copy a buffer of any size to the output.
+   *
+   * \param data the bytes to write.
+   * \param size the number of bytes to write.
+   */
+  void Write (uint8_t const *data, uint32_t size);
+
+  /**
+   * \brief Hand the partially filled chunk over and wait until everything
+   * written so far has reached the underlying stream.
+   */
+  void Flush (void);
+
+  /**
+   * \brief Flush and stop the background thread, if any.  No write may
+   * be issued after this call.
+   */
+  void Close (void);
+
+private:
+  struct Chunk
+  {
+    uint8_t *m_data;
+    uint32_t m_size;
+  };
+
+  AsyncStreamWriter (const AsyncStreamWriter &);
+  AsyncStreamWriter &operator = (const AsyncStreamWriter &);
+
+  void Submit (void);
+  void WriteChunk (Chunk &chunk);
+#ifdef HAVE_PTHREAD_H
+  void Run (void);
+#endif /* HAVE_PTHREAD_H */
+
+  std::ostream *m_os;
+  std::vector<Chunk> m_chunks;
+  uint32_t m_chunkSize;
+  uint32_t m_head;      //!< chunks submitted by the producer
+  uint32_t m_tail;      //!< chunks written by the consumer
+  uint32_t m_offset;    //!< bytes used in the current chunk
+  bool m_async;
+  bool m_fail;
+  bool m_closed;
+#ifdef HAVE_PTHREAD_H
+  bool m_stop;
+  Ptr<SystemThread> m_thread;
+  SystemMutex *m_mutex;
+  SystemCondition *m_dataReady;
+  SystemCondition *m_spaceReady;
+#endif /* HAVE_PTHREAD_H */
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_STREAM_WRITER_H */
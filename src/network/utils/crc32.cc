@@ -26,10 +26,25 @@
  * code or tables extracted from it, as desired without restriction.
  */
 #include <stdint.h>
+#include "crc32.h"
+
+//
+// The carry-less multiplication path needs the PCLMULQDQ intrinsics to be
+// usable from a function with a target attribute, without building the
+// whole file with -mpclmul.  gcc supports this from 4.9 on, clang from 3.8.
+//
+#if (defined (__x86_64__) || defined (__i386__)) && \
+  ((defined (__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+  (!defined (__clang__) && defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define CRC32_PCLMUL 1
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
 
 namespace ns3 {
 
-static uint32_t crc32table[256] = {
+static const uint32_t crc32table[256] = {
 0x00000000,0x77073096,0xEE0E612C,0x990951BA,0x076DC419,0x706AF48F,0xE963A535,0x9E6495A3,
 0x0EDB8832,0x79DCB8A4,0xE0D5E91E,0x97D2D988,0x09B64C2B,0x7EB17CBD,0xE7B82D07,0x90BF1D91,
 0x1DB71064,0x6AB020F2,0xF3B97148,0x84BE41DE,0x1ADAD47D,0x6DDDE4EB,0xF4D4B551,0x83D385C7,
@@ -64,17 +79,175 @@ static uint32_t crc32table[256] = {
 0xB3667A2E,0xC4614AB8,0x5D681B02,0x2A6F2B94,0xB40BBE37,0xC30C8EA1,0x5A05DF1B,0x2D02EF8D 
 };
 
-uint32_t
-CRC32Calculate (const uint8_t *data, int length)
-{
-  uint32_t crc = 0xffffffff;
+//
+// Slicing-by-8: crc32slices[k][b] is the crc of byte b followed by k zero
+// bytes, which lets us fold eight bytes per iteration with independent
+// table lookups instead of a chain of eight dependent ones.
+//
+static uint32_t crc32slices[8][256];
 
+static uint32_t
+CRC32Bytes (uint32_t crc, const uint8_t *data, uint32_t length)
+{
   while (length--)
     {
       crc = (crc >> 8) ^ crc32table[(crc & 0xFF) ^ *data++];
     }
-  return ~crc;
+  return crc;
 }
 
-} // namespace ns3
+static uint32_t
+CRC32Slicing8 (uint32_t crc, const uint8_t *data, uint32_t length)
+{
+  while (length >= 8)
+    {
+      // Assembled byte by byte, so that neither alignment nor host byte
+      // order matter; compilers turn this into plain loads.
+      uint32_t one = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+      uint32_t two = data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+      crc = crc32slices[7][one & 0xFF] ^
+        crc32slices[6][(one >> 8) & 0xFF] ^
+        crc32slices[5][(one >> 16) & 0xFF] ^
+        crc32slices[4][one >> 24] ^
+        crc32slices[3][two & 0xFF] ^
+        crc32slices[2][(two >> 8) & 0xFF] ^
+        crc32slices[1][(two >> 16) & 0xFF] ^
+        crc32slices[0][two >> 24];
+      data += 8;
+      length -= 8;
+    }
+  return CRC32Bytes (crc, data, length);
+}
+
+#ifdef CRC32_PCLMUL
+//
+// Folding with carry-less multiplication, after Gopal et al., "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel,
+// 2009.  The constants are the bit-reflected x^n mod P(x) of the paper for
+// the 802.3 polynomial.  Note that the SSE4.2 crc32 instruction is of no
+// use here, as it implements the Castagnoli polynomial rather than 802.3.
+//
+static const uint32_t PCLMUL_MIN_LENGTH = 64;
+
+__attribute__ ((target ("pclmul,sse2")))
+static uint32_t
+CRC32Pclmul (uint32_t crc, const uint8_t *data, uint32_t length)
+{
+  if (length < PCLMUL_MIN_LENGTH)
+    {
+      return CRC32Slicing8 (crc, data, length);
+    }
+
+  const __m128i k1k2 = _mm_set_epi64x (0x01c6e41596LL, 0x0154442bd4LL);
+  const __m128i k3k4 = _mm_set_epi64x (0x00ccaa009eLL, 0x01751997d0LL);
+  const __m128i k5 = _mm_set_epi64x (0, 0x0163cd6124LL);
+  const __m128i poly = _mm_set_epi64x (0x01f7011641LL, 0x01db710641LL);
+  const __m128i mask32 = _mm_setr_epi32 (~0, 0, ~0, 0);
+
+  // four lanes of 16 bytes, the crc being folded into the first one
+  __m128i x1 = _mm_loadu_si128 ((const __m128i *)(data + 0x00));
+  __m128i x2 = _mm_loadu_si128 ((const __m128i *)(data + 0x10));
+  __m128i x3 = _mm_loadu_si128 ((const __m128i *)(data + 0x20));
+  __m128i x4 = _mm_loadu_si128 ((const __m128i *)(data + 0x30));
+  x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 (crc));
+  data += 64;
+  length -= 64;
+
+  while (length >= 64)
+    {
+      __m128i x5 = _mm_clmulepi64_si128 (x1, k1k2, 0x00);
+      __m128i x6 = _mm_clmulepi64_si128 (x2, k1k2, 0x00);
+      __m128i x7 = _mm_clmulepi64_si128 (x3, k1k2, 0x00);
+      __m128i x8 = _mm_clmulepi64_si128 (x4, k1k2, 0x00);
+      x1 = _mm_clmulepi64_si128 (x1, k1k2, 0x11);
+      x2 = _mm_clmulepi64_si128 (x2, k1k2, 0x11);
+      x3 = _mm_clmulepi64_si128 (x3, k1k2, 0x11);
+      x4 = _mm_clmulepi64_si128 (x4, k1k2, 0x11);
+      x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), _mm_loadu_si128 ((const __m128i *)(data + 0x00)));
+      x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), _mm_loadu_si128 ((const __m128i *)(data + 0x10)));
+      x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), _mm_loadu_si128 ((const __m128i *)(data + 0x20)));
+      x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), _mm_loadu_si128 ((const __m128i *)(data + 0x30)));
+      data += 64;
+      length -= 64;
+    }
+
+  // fold the four lanes into one
+  __m128i x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+
+  // then any remaining whole 16 byte blocks
+  while (length >= 16)
+    {
+      x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+      x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+      x1 = _mm_xor_si128 (_mm_xor_si128 (x1, _mm_loadu_si128 ((const __m128i *)data)), x5);
+      data += 16;
+      length -= 16;
+    }
+
+  // reduce 128 bits to 64
+  x2 = _mm_clmulepi64_si128 (x1, k3k4, 0x10);
+  x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+  x2 = _mm_srli_si128 (x1, 4);
+  x1 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), k5, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+
+  // and Barrett reduction to 32 bits
+  x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), poly, 0x10);
+  x2 = _mm_clmulepi64_si128 (_mm_and_si128 (x2, mask32), poly, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+  crc = _mm_cvtsi128_si32 (_mm_srli_si128 (x1, 4));
+
+  return CRC32Bytes (crc, data, length);
+}
+#endif /* CRC32_PCLMUL */
+
+typedef uint32_t (*CRC32Function)(uint32_t crc, const uint8_t *data, uint32_t length);
 
+static CRC32Function g_crc32Function = &CRC32Bytes;
+
+//
+// Build the slicing tables and pick the fastest implementation this CPU
+// supports, once, before main () runs.
+//
+static struct CRC32Init
+{
+  CRC32Init ()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        crc32slices[0][i] = crc32table[i];
+      }
+    for (uint32_t k = 1; k < 8; k++)
+      {
+        for (uint32_t i = 0; i < 256; i++)
+          {
+            uint32_t prev = crc32slices[k - 1][i];
+            crc32slices[k][i] = (prev >> 8) ^ crc32table[prev & 0xFF];
+          }
+      }
+    g_crc32Function = &CRC32Slicing8;
+#ifdef CRC32_PCLMUL
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid (1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (edx & bit_SSE2))
+      {
+        g_crc32Function = &CRC32Pclmul;
+      }
+#endif /* CRC32_PCLMUL */
+  }
+} g_crc32Init;
+
+uint32_t
+CRC32Calculate (const uint8_t *data, int length)
+{
+  return ~g_crc32Function (0xffffffff, data, length);
+}
+
+} // namespace ns3
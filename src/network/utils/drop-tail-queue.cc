@@ -16,6 +16,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
@@ -25,6 +26,14 @@ NS_LOG_COMPONENT_DEFINE ("DropTailQueue");
 
 namespace ns3 {
 
+//
+// Bounds on the ring size picked for the first packet: MaxPackets is often
+// set very large to get an "infinite" queue, and byte mode has no packet
+// count to go by.
+//
+static const uint32_t RING_SIZE_MIN = 16;
+static const uint32_t RING_SIZE_MAX_INITIAL = 1 << 16;
+
 NS_OBJECT_ENSURE_REGISTERED (DropTailQueue)
   ;
 
@@ -57,6 +66,8 @@ TypeId DropTailQueue::GetTypeId (void)
 DropTailQueue::DropTailQueue () :
   Queue (),
   m_packets (),
+  m_head (0),
+  m_count (0),
   m_bytesInQueue (0)
 {
   NS_LOG_FUNCTION (this);
@@ -81,29 +92,71 @@ DropTailQueue::GetMode (void)
   return m_mode;
 }
 
+void
+DropTailQueue::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = m_packets.size ();
+  uint32_t newSize;
+  if (size == 0)
+    {
+      newSize = RING_SIZE_MIN;
+      if (m_mode == QUEUE_MODE_PACKETS && m_maxPackets > newSize)
+        {
+          newSize = std::min (m_maxPackets, RING_SIZE_MAX_INITIAL);
+        }
+    }
+  else
+    {
+      newSize = 2 * size;
+    }
+  NS_LOG_LOGIC ("Ring size " << size << " -> " << newSize);
+
+  //
+  // Unroll the ring so that the oldest packet is at index 0 again.
+  //
+  std::vector<Ptr<Packet> > packets (newSize);
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      packets[i] = m_packets[(m_head + i) % size];
+    }
+  m_packets.swap (packets);
+  m_head = 0;
+}
+
 bool 
 DropTailQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () >= m_maxPackets))
+  if (m_mode == QUEUE_MODE_PACKETS && (m_count + GetBackgroundPackets () >= m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
       return false;
     }
 
-  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + p->GetSize () >= m_maxBytes))
+  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + GetBackgroundBytes () + p->GetSize () >= m_maxBytes))
     {
       NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
       Drop (p);
       return false;
     }
 
+  if (m_count == m_packets.size ())
+    {
+      Grow ();
+    }
+  uint32_t tail = m_head + m_count;
+  if (tail >= m_packets.size ())
+    {
+      tail -= m_packets.size ();
+    }
+  m_packets[tail] = p;
+  m_count++;
   m_bytesInQueue += p->GetSize ();
-  m_packets.push (p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return true;
@@ -114,19 +167,24 @@ DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_count == 0)
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
-  m_packets.pop ();
+  Ptr<Packet> p = m_packets[m_head];
+  m_packets[m_head] = 0;
+  if (++m_head == m_packets.size ())
+    {
+      m_head = 0;
+    }
+  m_count--;
   m_bytesInQueue -= p->GetSize ();
 
   NS_LOG_LOGIC ("Popped " << p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
@@ -137,15 +195,15 @@ DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_count == 0)
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
+  Ptr<Packet> p = m_packets[m_head];
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
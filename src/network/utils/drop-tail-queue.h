@@ -19,7 +19,7 @@
 #ifndef DROPTAIL_H
 #define DROPTAIL_H
 
-#include <queue>
+#include <vector>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
 
@@ -31,6 +31,11 @@ class TraceContainer;
  * \ingroup queue
  *
  * \brief A FIFO packet queue that drops tail-end packets on overflow
+ *
+ * Packets are kept in a contiguous ring buffer.  In packet mode the ring is
+ * sized from MaxPackets the first time a packet is enqueued, so a queue
+ * never allocates on the data path afterwards; in byte mode (or if
+ * MaxPackets is raised later) it grows by doubling.
  */
 class DropTailQueue : public Queue {
 public:
@@ -64,7 +69,14 @@ private:
   virtual Ptr<Packet> DoDequeue (void);
   virtual Ptr<const Packet> DoPeek (void) const;
 
-  std::queue<Ptr<Packet> > m_packets;
+  /**
+   * Make room in the ring for at least one more packet.
+   */
+  void Grow (void);
+
+  std::vector<Ptr<Packet> > m_packets; //!< ring buffer of queued packets
+  uint32_t m_head;                     //!< index of the oldest packet in m_packets
+  uint32_t m_count;                    //!< number of packets in m_packets
   uint32_t m_maxPackets;
   uint32_t m_maxBytes;
   uint32_t m_bytesInQueue;
@@ -61,6 +61,8 @@
  */
 
 #include <cmath>
+#include <limits>
+#include <algorithm>
 
 #include "error-model.h"
 
@@ -168,12 +170,23 @@ TypeId RateErrorModel::GetTypeId (void)
                    StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=1.0]"),
                    MakePointerAccessor (&RateErrorModel::m_ranvar),
                    MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("SkipAhead",
+                   "Draw the number of units until the next error once and count it down, "
+                   "instead of drawing one variate per packet.  The decision variable "
+                   "must then be Uniform(0,1).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RateErrorModel::m_skipAhead),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 
 RateErrorModel::RateErrorModel ()
+  : m_skipValid (false),
+    m_skip (0),
+    m_skipRate (0.0),
+    m_skipUnit (ERROR_UNIT_BYTE)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -234,6 +247,22 @@ RateErrorModel::DoCorrupt (Ptr<Packet> p)
     {
       return false;
     }
+  if (m_skipAhead)
+    {
+      switch (m_unit)
+        {
+        case ERROR_UNIT_PACKET:
+          return DoCorruptSkip (1);
+        case ERROR_UNIT_BYTE:
+          return DoCorruptSkip (p->GetSize ());
+        case ERROR_UNIT_BIT:
+          return DoCorruptSkip (8 * static_cast<uint64_t> (p->GetSize ()));
+        default:
+          NS_ASSERT_MSG (false, "m_unit not supported yet");
+          break;
+        }
+      return false;
+    }
   switch (m_unit) 
     {
     case ERROR_UNIT_PACKET:
@@ -274,11 +303,62 @@ RateErrorModel::DoCorruptBit (Ptr<Packet> p)
   return (m_ranvar->GetValue () < per);
 }
 
+bool
+RateErrorModel::DoCorruptSkip (uint64_t units)
+{
+  NS_LOG_FUNCTION (this << units);
+  if (!m_skipValid || m_skipRate != m_rate || m_skipUnit != m_unit)
+    {
+      // first packet, or the parameters have changed under us
+      m_skipRate = m_rate;
+      m_skipUnit = m_unit;
+      m_skip = DrawSkip ();
+      m_skipValid = true;
+    }
+  if (m_skip >= units)
+    {
+      m_skip -= units;
+      return false;
+    }
+  // The next error falls within this packet.  Whatever happens to its
+  // remaining units does not matter, and the process is memoryless, so
+  // the next gap is simply drawn from the start of the next packet.
+  m_skip = DrawSkip ();
+  return true;
+}
+
+uint64_t
+RateErrorModel::DrawSkip (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_rate >= 1.0)
+    {
+      return 0;
+    }
+  if (m_rate <= 0.0)
+    {
+      return std::numeric_limits<uint64_t>::max ();
+    }
+  // Inverse transform of the geometric distribution: the number of good
+  // units before an error is floor (ln (U) / ln (1 - p)), U in (0,1].
+  double u = 1.0 - m_ranvar->GetValue ();
+  if (u <= 0.0)
+    {
+      return 0;
+    }
+  double skip = std::floor (std::log (u) / log1p (-m_rate));
+  if (skip >= static_cast<double> (std::numeric_limits<uint64_t>::max ()))
+    {
+      return std::numeric_limits<uint64_t>::max ();
+    }
+  return static_cast<uint64_t> (skip);
+}
+
 void 
 RateErrorModel::DoReset (void) 
 { 
   NS_LOG_FUNCTION (this);
-  /* re-initialize any state; no-op for now */ 
+  m_skipValid = false;
 }
 
 
@@ -449,11 +529,10 @@ ListErrorModel::SetList (const std::list<uint32_t> &packetlist)
 { 
   NS_LOG_FUNCTION (this << &packetlist);
   m_packetList = packetlist;
+  m_sortedList.assign (packetlist.begin (), packetlist.end ());
+  std::sort (m_sortedList.begin (), m_sortedList.end ());
 }
 
-// When performance becomes a concern, the list provided could be 
-// converted to a dynamically-sized array of uint32_t to avoid 
-// list iteration below.
 bool 
 ListErrorModel::DoCorrupt (Ptr<Packet> p) 
 { 
@@ -462,16 +541,7 @@ ListErrorModel::DoCorrupt (Ptr<Packet> p)
     {
       return false;
     }
-  uint32_t uid = p->GetUid ();
-  for (PacketListCI i = m_packetList.begin (); 
-       i != m_packetList.end (); i++)
-    {
-      if (uid == *i)
-        {
-          return true;
-        }
-    }
-  return false;
+  return std::binary_search (m_sortedList.begin (), m_sortedList.end (), p->GetUid ());
 }
 
 void 
@@ -479,6 +549,7 @@ ListErrorModel::DoReset (void)
 { 
   NS_LOG_FUNCTION (this);
   m_packetList.clear ();
+  m_sortedList.clear ();
 }
 
 //
@@ -499,6 +570,7 @@ TypeId ReceiveListErrorModel::GetTypeId (void)
 
 
 ReceiveListErrorModel::ReceiveListErrorModel () :
+  m_next (0),
   m_timesInvoked (0)
 {
   NS_LOG_FUNCTION (this);
@@ -521,6 +593,11 @@ ReceiveListErrorModel::SetList (const std::list<uint32_t> &packetlist)
 { 
   NS_LOG_FUNCTION (this << &packetlist);
   m_packetList = packetlist;
+  m_sortedList.assign (packetlist.begin (), packetlist.end ());
+  std::sort (m_sortedList.begin (), m_sortedList.end ());
+  // skip the entries for the packets already received
+  m_next = std::lower_bound (m_sortedList.begin (), m_sortedList.end (), m_timesInvoked)
+    - m_sortedList.begin ();
 }
 
 bool 
@@ -531,16 +608,15 @@ ReceiveListErrorModel::DoCorrupt (Ptr<Packet> p)
     {
       return false;
     }
+  uint32_t index = m_timesInvoked;
   m_timesInvoked += 1;
-  for (PacketListCI i = m_packetList.begin (); 
-       i != m_packetList.end (); i++)
+  // Invocations are numbered in increasing order, so entries behind
+  // m_next can never match again.
+  while (m_next < m_sortedList.size () && m_sortedList[m_next] < index)
     {
-      if (m_timesInvoked - 1 == *i)
-        {
-          return true;
-        }
+      m_next++;
     }
-  return false;
+  return m_next < m_sortedList.size () && m_sortedList[m_next] == index;
 }
 
 void 
@@ -548,6 +624,8 @@ ReceiveListErrorModel::DoReset (void)
 { 
   NS_LOG_FUNCTION (this);
   m_packetList.clear ();
+  m_sortedList.clear ();
+  m_next = 0;
 }
 
 
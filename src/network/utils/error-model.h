@@ -64,6 +64,7 @@
 #define ERROR_MODEL_H
 
 #include <list>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 
@@ -224,11 +225,19 @@ private:
   virtual bool DoCorruptByte (Ptr<Packet> p);
   virtual bool DoCorruptBit (Ptr<Packet> p);
   virtual void DoReset (void);
+  bool DoCorruptSkip (uint64_t units);
+  uint64_t DrawSkip (void);
 
   enum ErrorUnit m_unit;
   double m_rate;
 
   Ptr<RandomVariableStream> m_ranvar;
+
+  bool m_skipAhead;                 //!< draw gaps between errors instead of one variate per packet
+  bool m_skipValid;                 //!< whether m_skip was drawn for m_skipRate and m_skipUnit
+  uint64_t m_skip;                  //!< good units left before the next error
+  double m_skipRate;                //!< rate m_skip was drawn with
+  enum ErrorUnit m_skipUnit;        //!< unit m_skip is counted in
 };
 
 
@@ -323,10 +332,9 @@ private:
  * \brief Provide a list of Packet uids to corrupt
  *
  * This object is used to flag packets as being lost/errored or not.
- * A note on performance:  the list is assumed to be unordered, and
- * in general, Packet uids received may be unordered.  Therefore,
- * each call to IsCorrupt() will result in a walk of the list with
- * the present underlying implementation.
+ * The list may be given in any order; a sorted copy of it is kept so
+ * that each call to IsCorrupt() costs a binary search rather than a
+ * walk of the list.
  * 
  * Note also that if one wants to target multiple packets from looking
  * at an (unerrored) trace file, the act of erroring a given packet may
@@ -367,6 +375,7 @@ private:
   typedef std::list<uint32_t>::const_iterator PacketListCI;
 
   PacketList m_packetList;
+  std::vector<uint32_t> m_sortedList;  //!< m_packetList, sorted for lookups
 
 };
 
@@ -376,7 +385,9 @@ private:
  * This model also processes a user-generated list of packets to
  * corrupt, except that the list corresponds to the sequence of
  * received packets as observed by this error model, and not the
- * Packet UID.
+ * Packet UID.  As the reception count only grows, the model walks a
+ * sorted copy of the list along with it, so each call to IsCorrupt()
+ * costs constant time on average.
  * 
  * Reset() on this model will clear the list
  *
@@ -408,6 +419,8 @@ private:
   typedef std::list<uint32_t>::const_iterator PacketListCI;
 
   PacketList m_packetList;
+  std::vector<uint32_t> m_sortedList;  //!< m_packetList, sorted
+  uint32_t m_next;                      //!< first entry of m_sortedList not yet reached
   uint32_t m_timesInvoked;
 
 };
@@ -378,11 +378,6 @@ Ipv4Address::GetLoopback (void)
   return loopback;
 }
 
-size_t Ipv4AddressHash::operator() (Ipv4Address const &x) const
-{ 
-  return x.Get ();
-}
-
 std::ostream& operator<< (std::ostream& os, Ipv4Address const& address)
 {
   address.Print (os);
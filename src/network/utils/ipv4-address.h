@@ -196,6 +196,7 @@ private:
   friend bool operator == (Ipv4Address const &a, Ipv4Address const &b);
   friend bool operator != (Ipv4Address const &a, Ipv4Address const &b);
   friend bool operator < (Ipv4Address const &addrA, Ipv4Address const &addrB);
+  friend class Ipv4AddressHash;
 };
 
 /**
@@ -308,11 +309,29 @@ inline bool operator < (const Ipv4Address &a, const Ipv4Address &b)
 }
 
 
+/**
+ * \class Ipv4AddressHash
+ * \brief Hash function class for IPv4 addresses.
+ */
 class Ipv4AddressHash : public std::unary_function<Ipv4Address, size_t> {
 public:
+  /**
+   * \param x IPv4 address to hash
+   * \returns the address itself, whose bits ns3::HashMap mixes
+   */
   size_t operator() (Ipv4Address const &x) const;
 };
 
+/*
+ * Inline, like the comparison operators: the hash tables call it on
+ * every lookup, where an out-of-line call costs more than the probe.
+ */
+inline size_t
+Ipv4AddressHash::operator() (Ipv4Address const &x) const
+{
+  return x.m_address;
+}
+
 bool operator == (Ipv4Mask const &a, Ipv4Mask const &b);
 bool operator != (Ipv4Mask const &a, Ipv4Mask const &b);
 
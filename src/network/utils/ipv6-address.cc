@@ -23,6 +23,7 @@
 
 #include "ns3/log.h"
 #include "ns3/assert.h"
+#include "ns3/hash-murmur3.h"
 
 #include "mac16-address.h"
 #include "mac48-address.h"
@@ -33,86 +34,6 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6Address");
 
 namespace ns3 {
 
-#ifdef __cplusplus
-extern "C"
-{ /* } */
-#endif
-
-/**
- * \brief Get a hash key.
- * \param k the key
- * \param length the length of the key
- * \param level the previous hash, or an arbitrary value
- * \return hash
- * \note Adapted from Jens Jakobsen implementation (chillispot).
- */
-static uint32_t lookuphash (unsigned char* k, uint32_t length, uint32_t level)
-{
-  NS_LOG_FUNCTION (k << length << level);
-#define mix(a, b, c) \
-  ({ \
-     (a) -= (b); (a) -= (c); (a) ^= ((c) >> 13); \
-     (b) -= (c); (b) -= (a); (b) ^= ((a) << 8);  \
-     (c) -= (a); (c) -= (b); (c) ^= ((b) >> 13); \
-     (a) -= (b); (a) -= (c); (a) ^= ((c) >> 12); \
-     (b) -= (c); (b) -= (a); (b) ^= ((a) << 16); \
-     (c) -= (a); (c) -= (b); (c) ^= ((b) >> 5);  \
-     (a) -= (b); (a) -= (c); (a) ^= ((c) >> 3);  \
-     (b) -= (c); (b) -= (a); (b) ^= ((a) << 10); \
-     (c) -= (a); (c) -= (b); (c) ^= ((b) >> 15); \
-   })
-
-  typedef uint32_t  ub4;   /* unsigned 4-byte quantities */
-  uint32_t a = 0;
-  uint32_t b = 0;
-  uint32_t c = 0;
-  uint32_t len = 0;
-
-  /* Set up the internal state */
-  len = length;
-  a = b = 0x9e3779b9;  /* the golden ratio; an arbitrary value */
-  c = level;           /* the previous hash value */
-
-  /* handle most of the key */
-  while (len >= 12)
-    {
-      a += (k[0] + ((ub4)k[1] << 8) + ((ub4)k[2] << 16) + ((ub4)k[3] << 24));
-      b += (k[4] + ((ub4)k[5] << 8) + ((ub4)k[6] << 16) + ((ub4)k[7] << 24));
-      c += (k[8] + ((ub4)k[9] << 8) + ((ub4)k[10] << 16) + ((ub4)k[11] << 24));
-      mix (a, b, c);
-      k += 12; 
-      len -= 12;
-    }
-
-  /* handle the last 11 bytes */
-  c += length;
-  switch (len) /* all the case statements fall through */
-    {
-    case 11: c += ((ub4)k[10] << 24);
-    case 10: c += ((ub4)k[9] << 16);
-    case 9: c += ((ub4)k[8] << 8);  /* the first byte of c is reserved for the length */
-    case 8: b += ((ub4)k[7] << 24);
-    case 7: b += ((ub4)k[6] << 16);
-    case 6: b += ((ub4)k[5] << 8);
-    case 5: b += k[4];
-    case 4: a += ((ub4)k[3] << 24);
-    case 3: a += ((ub4)k[2] << 16);
-    case 2: a += ((ub4)k[1] << 8);
-    case 1: a += k[0];
-      /* case 0: nothing left to add */
-    }
-  mix (a, b, c);
-
-#undef mix
-
-  /* report the result */
-  return c;
-}
-
-#ifdef __cplusplus
-}
-#endif
-
 /**
  * \brief Convert an IPv6 C-string into a 128-bit representation.
  *
@@ -926,7 +847,8 @@ size_t Ipv6AddressHash::operator () (Ipv6Address const &x) const
 
   x.GetBytes (buf);
 
-  return lookuphash (buf, sizeof (buf), 0);
+  Hash::Function::Murmur3 hasher;
+  return hasher.GetHash32 ((const char *)buf, sizeof (buf));
 }
 
 ATTRIBUTE_HELPER_CPP (Ipv6Address); /// Macro to make help make class an ns-3 attribute
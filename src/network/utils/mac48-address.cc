@@ -21,6 +21,7 @@
 #include "ns3/address.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/hash-murmur3.h"
 #include <iomanip>
 #include <iostream>
 #include <cstring>
@@ -241,6 +242,14 @@ Mac48Address Mac48Address::GetMulticast (Ipv6Address addr)
   return etherAddr;
 }
 
+size_t Mac48AddressHash::operator () (Mac48Address const &x) const
+{
+  uint8_t buf[6];
+  x.CopyTo (buf);
+  Hash::Function::Murmur3 hasher;
+  return hasher.GetHash32 ((const char *)buf, sizeof (buf));
+}
+
 std::ostream& operator<< (std::ostream& os, const Mac48Address & address)
 {
   uint8_t ad[6];
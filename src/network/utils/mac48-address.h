@@ -165,6 +165,20 @@ inline bool operator < (const Mac48Address &a, const Mac48Address &b)
 std::ostream& operator<< (std::ostream& os, const Mac48Address & address);
 std::istream& operator>> (std::istream& is, Mac48Address & address);
 
+/**
+ * \class Mac48AddressHash
+ * \brief Hash function class for MAC-48 addresses.
+ */
+class Mac48AddressHash : public std::unary_function<Mac48Address, size_t>
+{
+public:
+  /**
+   * \param x MAC-48 address to hash
+   * \returns the Murmur3 hash of the address
+   */
+  size_t operator () (Mac48Address const &x) const;
+};
+
 } // namespace ns3
 
 #endif /* MAC48_ADDRESS_H */
@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -35,6 +36,9 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * Instead of a file of its own, a wrapper can also be attached to one
+ * interface of a PcapNgFile shared with other wrappers (see Attach).
  */
 class PcapFileWrapper : public Object
 {
@@ -105,6 +109,22 @@ public:
              uint32_t snapLen = std::numeric_limits<uint32_t>::max (), 
              int32_t tzCorrection = PcapFile::ZONE_DEFAULT);
 
+  /**
+   * Write the packets of this wrapper to a new interface of a shared pcapng
+   * file rather than to a pcap file of its own.  This replaces Open and Init;
+   * the wrapper keeps a reference to the pcapng file until it is closed.
+   *
+   * \param file The open pcapng file to write to.
+   * \param dataLinkType A data link type as defined in the pcap library (see Init).
+   * \param snapLen An optional maximum size for packets written to the file.
+   * If not provided, the "CaptureSize" Attribute is used.
+   * \param name The name of the interface in the pcapng file.
+   */
+  void Attach (Ptr<PcapNgFile> file,
+               uint32_t dataLinkType,
+               uint32_t snapLen = std::numeric_limits<uint32_t>::max (),
+               std::string const &name = "");
+
   /**
    * \brief Write the next packet to file
    * 
@@ -180,7 +200,8 @@ public:
 
   /*
    * \brief Returns the max length of saved packets field of the pcap file as 
-   * defined by the snaplen field in the pcap global header.
+   * defined by the snaplen field in the pcap global header, or the snap
+   * length of the pcapng interface this wrapper is attached to.
    *
    * See http://wiki.wireshark.org/Development/LibpcapFileFormat
    */ 
@@ -188,7 +209,8 @@ public:
 
   /*
    * \brief Returns the data link type field of the pcap file as defined by the 
-   * network field in the pcap global header.
+   * network field in the pcap global header, or the data link type of the
+   * pcapng interface this wrapper is attached to.
    *
    * See http://wiki.wireshark.org/Development/LibpcapFileFormat
    */ 
@@ -197,6 +219,10 @@ public:
 private:
   PcapFile m_file;
   uint32_t m_snapLen;
+  bool m_asyncWrite;
+  uint32_t m_bufferSize;
+  Ptr<PcapNgFile> m_ngFile;
+  uint32_t m_ngInterface;
 };
 
 } // namespace ns3
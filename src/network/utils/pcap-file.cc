@@ -19,6 +19,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 #include "ns3/assert.h"
 #include "ns3/packet.h"
@@ -27,6 +28,7 @@
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "pcap-file.h"
+#include "async-stream-writer.h"
 #include "ns3/log.h"
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
@@ -48,7 +50,8 @@ const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pc
 
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_swapMode (false),
+    m_writer (0)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -66,6 +69,13 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      //
+      // The stream belongs to the writer thread until the writer is closed.
+      //
+      return m_writer->Fail ();
+    }
   return m_file.fail ();
 }
 bool 
@@ -86,6 +96,17 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      m_writer->Close ();
+      bool fail = m_writer->Fail ();
+      delete m_writer;
+      m_writer = 0;
+      if (fail)
+        {
+          m_file.setstate (std::ios::failbit);
+        }
+    }
   m_file.close ();
 }
 
@@ -400,10 +421,65 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   return inclLen;
 }
 
+void
+PcapFile::EnableAsyncWrite (uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << bufferSize);
+  NS_ASSERT (m_file.good ());
+  NS_ASSERT_MSG (m_writer == 0, "PcapFile::EnableAsyncWrite(): already enabled");
+
+  //
+  // Every record is reserved in one piece, so make sure the largest one
+  // allowed by the snap length fits in a buffer.
+  //
+  uint32_t recordMax = sizeof (PcapRecordHeader) + m_fileHeader.m_snapLen;
+  m_writer = new AsyncStreamWriter (&m_file, true, std::max (bufferSize, recordMax));
+}
+
+uint8_t *
+PcapFile::ReserveRecord (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint32_t &inclLen)
+{
+  NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
+  inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
+
+  PcapRecordHeader header;
+  header.m_tsSec = tsSec;
+  header.m_tsUsec = tsUsec;
+  header.m_inclLen = inclLen;
+  header.m_origLen = totalLen;
+
+  if (m_swapMode)
+    {
+      Swap (&header, &header);
+    }
+
+  //
+  // Same field by field layout as WritePacketHeader, but into memory.
+  //
+  uint8_t *start = m_writer->Reserve (sizeof (PcapRecordHeader) + inclLen);
+  uint8_t *p = start;
+  std::memcpy (p, &header.m_tsSec, sizeof(header.m_tsSec));
+  p += sizeof(header.m_tsSec);
+  std::memcpy (p, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  p += sizeof(header.m_tsUsec);
+  std::memcpy (p, &header.m_inclLen, sizeof(header.m_inclLen));
+  p += sizeof(header.m_inclLen);
+  std::memcpy (p, &header.m_origLen, sizeof(header.m_origLen));
+  p += sizeof(header.m_origLen);
+  return p;
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
+  if (m_writer != 0)
+    {
+      uint32_t inclLen;
+      uint8_t *record = ReserveRecord (tsSec, tsUsec, totalLen, inclLen);
+      std::memcpy (record, data, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
   m_file.write ((const char *)data, inclLen);
 }
@@ -412,6 +488,13 @@ void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
+  if (m_writer != 0)
+    {
+      uint32_t inclLen;
+      uint8_t *record = ReserveRecord (tsSec, tsUsec, p->GetSize (), inclLen);
+      p->CopyData (record, inclLen);
+      return;
+    }
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
   p->CopyData (&m_file, inclLen);
 }
@@ -422,11 +505,22 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Header &header, Ptr<const Pack
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &header << p);
   uint32_t headerSize = header.GetSerializedSize ();
   uint32_t totalSize = headerSize + p->GetSize ();
-  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
 
   Buffer headerBuffer;
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
+
+  if (m_writer != 0)
+    {
+      uint32_t inclLen;
+      uint8_t *record = ReserveRecord (tsSec, tsUsec, totalSize, inclLen);
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (record, toCopy);
+      p->CopyData (record + toCopy, inclLen - toCopy);
+      return;
+    }
+
+  uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalSize);
   uint32_t toCopy = std::min (headerSize, inclLen);
   headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
@@ -30,6 +30,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class AsyncStreamWriter;
 
 
 /**
@@ -44,6 +45,7 @@ class PcapFile
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t BUFFER_SIZE_DEFAULT = 1 << 20; /**< Default size of the buffers used by asynchronous writes */
 
 public:
   PcapFile ();
@@ -118,6 +120,21 @@ public:
              int32_t timeZoneCorrection = ZONE_DEFAULT,
              bool swapMode = false);
 
+  /**
+   * \brief Batch all further packet records in large buffers which are
+   * written to the file by a background thread.
+   *
+   * Writing a packet then only costs a copy into memory on the calling
+   * thread.  The file must have been opened for writing and initialized
+   * with Init ().  Without threading support, records are still batched
+   * but the buffers are written by the calling thread.  Buffered records
+   * reach the file on Close () at the latest.
+   *
+   * \param bufferSize Size of each of the buffers handed to the writer
+   * thread; enlarged if a single record at the snap length would not fit.
+   */
+  void EnableAsyncWrite (uint32_t bufferSize = BUFFER_SIZE_DEFAULT);
+
   /**
    * \brief Write next packet to file
    * 
@@ -286,12 +303,14 @@ private:
 
   void WriteFileHeader (void);
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
+  uint8_t *ReserveRecord (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen, uint32_t &inclLen);
   void ReadAndVerifyFileHeader (void);
 
   std::string    m_filename;
   std::fstream   m_file;
   PcapFileHeader m_fileHeader;
   bool m_swapMode;
+  AsyncStreamWriter *m_writer;
 };
 
 } // namespace ns3
@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "ns3/fatal-impl.h"
+#include "async-stream-writer.h"
+#include "pcapng-file.h"
+
+NS_LOG_COMPONENT_DEFINE ("PcapNgFile");
+
+namespace ns3 {
+
+const uint16_t NG_VERSION_MAJOR = 1;          /**< Major version of the pcapng format */
+const uint16_t NG_VERSION_MINOR = 0;          /**< Minor version of the pcapng format */
+
+const uint16_t OPT_ENDOFOPT = 0;              /**< End of options marker */
+const uint16_t OPT_IF_NAME = 2;               /**< Interface name option of the IDB */
+const uint16_t OPT_IF_TSRESOL = 9;            /**< Timestamp resolution option of the IDB */
+const uint8_t  TSRESOL_NSEC = 9;              /**< if_tsresol value for 10^-9 s */
+
+const uint32_t EPB_FIXED_LEN = 32;            /**< Enhanced Packet Block without packet data */
+
+static uint32_t
+Pad4 (uint32_t len)
+{
+  return (len + 3) & ~3U;
+}
+
+//
+// Blocks are always built in memory, so we use these to lay out fields one
+// by one regardless of alignment.
+//
+static uint8_t *
+Put16 (uint8_t *p, uint16_t v)
+{
+  std::memcpy (p, &v, sizeof (v));
+  return p + sizeof (v);
+}
+
+static uint8_t *
+Put32 (uint8_t *p, uint32_t v)
+{
+  std::memcpy (p, &v, sizeof (v));
+  return p + sizeof (v);
+}
+
+PcapNgFile::PcapNgFile ()
+  : m_file (),
+    m_writer (0),
+    m_bufferSize (BUFFER_SIZE_DEFAULT)
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::RegisterStream (&m_file);
+}
+
+PcapNgFile::~PcapNgFile ()
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::UnregisterStream (&m_file);
+  Close ();
+}
+
+bool
+PcapNgFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      return m_writer->Fail ();
+    }
+  return m_file.fail ();
+}
+
+void
+PcapNgFile::Open (std::string const &filename, uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (this << filename << bufferSize);
+  NS_ASSERT_MSG (m_writer == 0, "PcapNgFile::Open(): file already open");
+
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  if (m_file.fail ())
+    {
+      return;
+    }
+  m_bufferSize = bufferSize;
+  m_writer = new AsyncStreamWriter (&m_file, false, m_bufferSize);
+  m_interfaces.clear ();
+  WriteSectionHeader ();
+}
+
+void
+PcapNgFile::EnableAsyncWrite (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_writer != 0, "PcapNgFile::EnableAsyncWrite(): file not open");
+  if (m_writer->IsAsync ())
+    {
+      return;
+    }
+  m_writer->Close ();
+  delete m_writer;
+  m_writer = new AsyncStreamWriter (&m_file, true, m_bufferSize);
+}
+
+void
+PcapNgFile::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      m_writer->Close ();
+      bool fail = m_writer->Fail ();
+      delete m_writer;
+      m_writer = 0;
+      if (fail)
+        {
+          m_file.setstate (std::ios::failbit);
+        }
+    }
+  m_file.close ();
+}
+
+void
+PcapNgFile::WriteSectionHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  //
+  // Block type, total length, byte order magic, version and a section length
+  // of -1 (unknown, we never go back to patch it) with no options.
+  //
+  const uint32_t blockLen = 28;
+  uint8_t *p = m_writer->Reserve (blockLen);
+  p = Put32 (p, SECTION_HEADER_BLOCK);
+  p = Put32 (p, blockLen);
+  p = Put32 (p, BYTE_ORDER_MAGIC);
+  p = Put16 (p, NG_VERSION_MAJOR);
+  p = Put16 (p, NG_VERSION_MINOR);
+  p = Put32 (p, 0xffffffff);
+  p = Put32 (p, 0xffffffff);
+  Put32 (p, blockLen);
+}
+
+uint32_t
+PcapNgFile::AddInterface (uint32_t dataLinkType, uint32_t snapLen, std::string const &name)
+{
+  NS_LOG_FUNCTION (this << dataLinkType << snapLen << name);
+  NS_ASSERT_MSG (m_writer != 0, "PcapNgFile::AddInterface(): file not open");
+  NS_ABORT_MSG_IF (EPB_FIXED_LEN + Pad4 (snapLen) > m_writer->GetChunkSize (),
+                   "PcapNgFile::AddInterface(): snap length " << snapLen << " too large for buffers of "
+                                                              << m_writer->GetChunkSize () << " bytes");
+
+  //
+  // Interface Description Block: link type, reserved, snap length, then the
+  // if_name and if_tsresol options and the end of options marker.
+  //
+  uint32_t nameLen = name.size ();
+  uint32_t optionsLen = 4 + 4 + 4;
+  if (nameLen > 0)
+    {
+      optionsLen += 4 + Pad4 (nameLen);
+    }
+  uint32_t blockLen = 8 + 8 + optionsLen + 4;
+
+  std::vector<uint8_t> block (blockLen, 0);
+  uint8_t *p = &block[0];
+  p = Put32 (p, INTERFACE_DESCRIPTION_BLOCK);
+  p = Put32 (p, blockLen);
+  p = Put16 (p, dataLinkType);
+  p = Put16 (p, 0);
+  p = Put32 (p, snapLen);
+  if (nameLen > 0)
+    {
+      p = Put16 (p, OPT_IF_NAME);
+      p = Put16 (p, nameLen);
+      std::memcpy (p, name.data (), nameLen);
+      p += Pad4 (nameLen);
+    }
+  p = Put16 (p, OPT_IF_TSRESOL);
+  p = Put16 (p, 1);
+  *p = TSRESOL_NSEC;
+  p += 4;
+  p = Put16 (p, OPT_ENDOFOPT);
+  p = Put16 (p, 0);
+  Put32 (p, blockLen);
+  m_writer->Write (&block[0], blockLen);
+
+  Interface interface;
+  interface.m_dataLinkType = dataLinkType;
+  interface.m_snapLen = snapLen;
+  m_interfaces.push_back (interface);
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapNgFile::GetNInterfaces (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_interfaces.size ();
+}
+
+uint32_t
+PcapNgFile::GetDataLinkType (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_dataLinkType;
+}
+
+uint32_t
+PcapNgFile::GetSnapLen (uint32_t interface) const
+{
+  NS_LOG_FUNCTION (this << interface);
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].m_snapLen;
+}
+
+uint8_t *
+PcapNgFile::ReservePacketBlock (uint32_t interface, uint64_t ts, uint32_t totalLen, uint32_t &inclLen)
+{
+  NS_LOG_FUNCTION (this << interface << ts << totalLen);
+  NS_ASSERT_MSG (m_writer != 0, "PcapNgFile::Write(): file not open");
+  NS_ASSERT_MSG (interface < m_interfaces.size (), "PcapNgFile::Write(): unknown interface " << interface);
+
+  uint32_t snapLen = m_interfaces[interface].m_snapLen;
+  inclLen = totalLen > snapLen ? snapLen : totalLen;
+  uint32_t padded = Pad4 (inclLen);
+  uint32_t blockLen = EPB_FIXED_LEN + padded;
+
+  //
+  // The whole block is reserved at once; we fill in everything but the
+  // packet data, which the caller copies straight into place.
+  //
+  uint8_t *block = m_writer->Reserve (blockLen);
+  uint8_t *p = block;
+  p = Put32 (p, ENHANCED_PACKET_BLOCK);
+  p = Put32 (p, blockLen);
+  p = Put32 (p, interface);
+  p = Put32 (p, static_cast<uint32_t> (ts >> 32));
+  p = Put32 (p, static_cast<uint32_t> (ts & 0xffffffff));
+  p = Put32 (p, inclLen);
+  p = Put32 (p, totalLen);
+  std::memset (p + inclLen, 0, padded - inclLen);
+  Put32 (p + padded, blockLen);
+  return p;
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ts, uint8_t const *data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << ts << &data << totalLen);
+  uint32_t inclLen;
+  uint8_t *p = ReservePacketBlock (interface, ts, totalLen, inclLen);
+  std::memcpy (p, data, inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ts, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ts << p);
+  uint32_t inclLen;
+  uint8_t *data = ReservePacketBlock (interface, ts, p->GetSize (), inclLen);
+  p->CopyData (data, inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, uint64_t ts, Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << ts << &header << p);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t totalSize = headerSize + p->GetSize ();
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+
+  uint32_t inclLen;
+  uint8_t *data = ReservePacketBlock (interface, ts, totalSize, inclLen);
+  uint32_t toCopy = std::min (headerSize, inclLen);
+  headerBuffer.CopyData (data, toCopy);
+  p->CopyData (data + toCopy, inclLen - toCopy);
+}
+
+} // namespace ns3
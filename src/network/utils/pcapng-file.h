@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+class AsyncStreamWriter;
+
+/**
+ * \brief A class representing a pcapng file with many capture interfaces
+ *
+ * Where a classic pcap file holds the packets of one link, a pcapng file
+ * holds one section in which any number of interfaces are described by
+ * Interface Description Blocks, each with its own data link type, snap
+ * length and name; every packet is then stored in an Enhanced Packet Block
+ * tagged with the index of its interface.  This lets the traces of many
+ * devices share one file (and one writer).
+ *
+ * Timestamps are stored with nanosecond resolution (if_tsresol = 9).
+ * Blocks are written in the native byte order of the writing system, as
+ * allowed by the format; readers detect it from the byte order magic.
+ *
+ * Writes are always batched in large buffers, and can optionally be drained
+ * by a background thread (see EnableAsyncWrite).
+ *
+ * See http://www.winpcap.org/ntar/draft/PCAP-DumpFileFormat.html
+ */
+class PcapNgFile : public SimpleRefCount<PcapNgFile>
+{
+public:
+  static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t BUFFER_SIZE_DEFAULT = 1 << 20; /**< Default size of the write buffers */
+
+  static const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;   /**< Block type of a Section Header Block */
+  static const uint32_t INTERFACE_DESCRIPTION_BLOCK = 0x1;   /**< Block type of an Interface Description Block */
+  static const uint32_t ENHANCED_PACKET_BLOCK = 0x6;         /**< Block type of an Enhanced Packet Block */
+  static const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;       /**< Byte order magic of the Section Header Block */
+
+  PcapNgFile ();
+  ~PcapNgFile ();
+
+  /**
+   * \return true if the file could not be opened or a write has failed.
+   */
+  bool Fail (void) const;
+
+  /**
+   * \brief Create a new pcapng file and write its Section Header Block.
+   *
+   * \param filename String containing the name of the file.
+   * \param bufferSize Size of the buffers in which blocks are batched.
+   */
+  void Open (std::string const &filename, uint32_t bufferSize = BUFFER_SIZE_DEFAULT);
+
+  /**
+   * \brief Write the buffers out from a background thread from now on.
+   *
+   * Blocks written so far are flushed first.  Has no effect if threading
+   * is not supported.  Must be called after Open ().
+   */
+  void EnableAsyncWrite (void);
+
+  /**
+   * \brief Write out buffered blocks and close the underlying file.
+   */
+  void Close (void);
+
+  /**
+   * \brief Describe a new capture interface.
+   *
+   * \param dataLinkType A data link type as defined in the pcap library
+   * (see PcapFile::Init).
+   * \param snapLen Maximum number of octets saved per packet on this
+   * interface; longer packets are truncated.  A block holding that many
+   * octets must fit in one write buffer.
+   * \param name Name of the interface, stored in the if_name option.
+   *
+   * \return the interface index to pass to Write ().
+   */
+  uint32_t AddInterface (uint32_t dataLinkType, uint32_t snapLen = SNAPLEN_DEFAULT,
+                         std::string const &name = "");
+
+  /**
+   * \return the number of interfaces described so far.
+   */
+  uint32_t GetNInterfaces (void) const;
+
+  /**
+   * \param interface index returned by AddInterface ().
+   * \return the data link type of the interface.
+   */
+  uint32_t GetDataLinkType (uint32_t interface) const;
+
+  /**
+   * \param interface index returned by AddInterface ().
+   * \return the snap length of the interface.
+   */
+  uint32_t GetSnapLen (uint32_t interface) const;
+
+  /**
+   * \brief Write next packet of an interface to file
+   *
+   * \param interface   Index returned by AddInterface ()
+   * \param ts          Packet timestamp, nanoseconds
+   * \param data        Data buffer
+   * \param totalLen    Total packet length
+   */
+  void Write (uint32_t interface, uint64_t ts, uint8_t const *data, uint32_t totalLen);
+
+  /**
+   * \brief Write next packet of an interface to file
+   *
+   * \param interface   Index returned by AddInterface ()
+   * \param ts          Packet timestamp, nanoseconds
+   * \param p           Packet to write
+   */
+  void Write (uint32_t interface, uint64_t ts, Ptr<const Packet> p);
+
+  /**
+   * \brief Write next packet of an interface to file
+   *
+   * \param interface   Index returned by AddInterface ()
+   * \param ts          Packet timestamp, nanoseconds
+   * \param header      Header to write, in front of packet
+   * \param p           Packet to write
+   */
+  void Write (uint32_t interface, uint64_t ts, Header &header, Ptr<const Packet> p);
+
+private:
+  struct Interface
+  {
+    uint32_t m_dataLinkType;
+    uint32_t m_snapLen;
+  };
+
+  PcapNgFile (const PcapNgFile &);
+  PcapNgFile &operator = (const PcapNgFile &);
+
+  void WriteSectionHeader (void);
+  uint8_t *ReservePacketBlock (uint32_t interface, uint64_t ts, uint32_t totalLen, uint32_t &inclLen);
+
+  std::ofstream m_file;
+  AsyncStreamWriter *m_writer;
+  uint32_t m_bufferSize;
+  std::vector<Interface> m_interfaces;
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
@@ -48,7 +48,9 @@ Queue::Queue() :
   m_nPackets (0),
   m_nTotalReceivedPackets (0),
   m_nTotalDroppedBytes (0),
-  m_nTotalDroppedPackets (0)
+  m_nTotalDroppedPackets (0),
+  m_backgroundPackets (0),
+  m_backgroundBytes (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -70,8 +72,16 @@ Queue::Enqueue (Ptr<Packet> p)
   bool retval = DoEnqueue (p);
   if (retval)
     {
-      NS_LOG_LOGIC ("m_traceEnqueue (p)");
-      m_traceEnqueue (p);
+      //
+      // Every device hop goes through here: skip the trace call, which
+      // copies the Ptr argument and walks the list of sinks, when no
+      // sink is connected.
+      //
+      if (!m_traceEnqueue.IsEmpty ())
+        {
+          NS_LOG_LOGIC ("m_traceEnqueue (p)");
+          m_traceEnqueue (p);
+        }
 
       uint32_t size = p->GetSize ();
       m_nBytes += size;
@@ -92,14 +102,18 @@ Queue::Dequeue (void)
 
   if (packet != 0)
     {
-      NS_ASSERT (m_nBytes >= packet->GetSize ());
+      uint32_t size = packet->GetSize ();
+      NS_ASSERT (m_nBytes >= size);
       NS_ASSERT (m_nPackets > 0);
 
-      m_nBytes -= packet->GetSize ();
+      m_nBytes -= size;
       m_nPackets--;
 
-      NS_LOG_LOGIC ("m_traceDequeue (packet)");
-      m_traceDequeue (packet);
+      if (!m_traceDequeue.IsEmpty ())
+        {
+          NS_LOG_LOGIC ("m_traceDequeue (packet)");
+          m_traceDequeue (packet);
+        }
     }
   return packet;
 }
@@ -188,6 +202,28 @@ Queue::ResetStatistics (void)
   m_nTotalDroppedPackets = 0;
 }
 
+void
+Queue::SetBackgroundOccupancy (uint32_t packets, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << packets << bytes);
+  m_backgroundPackets = packets;
+  m_backgroundBytes = bytes;
+}
+
+uint32_t
+Queue::GetBackgroundPackets (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_backgroundPackets;
+}
+
+uint32_t
+Queue::GetBackgroundBytes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_backgroundBytes;
+}
+
 void
 Queue::Drop (Ptr<Packet> p)
 {
@@ -196,8 +232,11 @@ Queue::Drop (Ptr<Packet> p)
   m_nTotalDroppedPackets++;
   m_nTotalDroppedBytes += p->GetSize ();
 
-  NS_LOG_LOGIC ("m_traceDrop (p)");
-  m_traceDrop (p);
+  if (!m_traceDrop.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("m_traceDrop (p)");
+      m_traceDrop (p);
+    }
 }
 
 } // namespace ns3
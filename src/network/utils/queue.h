@@ -115,6 +115,25 @@ public:
    */
   void ResetStatistics (void);
 
+  /**
+   * Set the number of packets and bytes that background traffic, modelled
+   * outside of the queue (e.g., as a fluid flow), is expected to occupy
+   * in the queue.  Subclasses count this occupancy against their limits
+   * as if it was made of real packets.
+   *
+   * \param packets the number of background packets
+   * \param bytes the number of background bytes
+   */
+  void SetBackgroundOccupancy (uint32_t packets, uint32_t bytes);
+  /**
+   * \return The number of background packets set with SetBackgroundOccupancy
+   */
+  uint32_t GetBackgroundPackets (void) const;
+  /**
+   * \return The number of background bytes set with SetBackgroundOccupancy
+   */
+  uint32_t GetBackgroundBytes (void) const;
+
   /**
    * \brief Enumeration of the modes supported in the class.
    *
@@ -174,6 +193,8 @@ private:
   uint32_t m_nTotalReceivedPackets;
   uint32_t m_nTotalDroppedBytes;
   uint32_t m_nTotalDroppedPackets;
+  uint32_t m_backgroundPackets;
+  uint32_t m_backgroundBytes;
 };
 
 } // namespace ns3
@@ -225,12 +225,12 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
   if (GetMode () == QUEUE_MODE_BYTES)
     {
       NS_LOG_DEBUG ("Enqueue in bytes mode");
-      nQueued = m_bytesInQueue;
+      nQueued = m_bytesInQueue + GetBackgroundBytes ();
     }
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
       NS_LOG_DEBUG ("Enqueue in packets mode");
-      nQueued = m_packets.size ();
+      nQueued = m_packets.size () + GetBackgroundPackets ();
     }
 
   // simulate number of packets arrival during idle period
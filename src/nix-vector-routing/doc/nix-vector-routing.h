@@ -30,9 +30,10 @@
  * when dealing with a large number of nodes.
  *
  * Currently, the ns-3 model of nix-vector routing supports IPv4 p2p links 
- * as well as CSMA links.  It does not (yet) provide support for 
- * efficient adaptation to link failures.  It simply flushes all nix-vector 
- * routing caches. Finally, IPv6 is not supported.
+ * as well as CSMA links.  Upon a link failure, it flushes the
+ * nix-vector caches of the nodes whose breadth-first search tree
+ * reaches the link, and the Ipv4 route caches of all the nodes.
+ * Finally, IPv6 is not supported.
  *
  * \section api API and Usage
  *
@@ -56,7 +57,10 @@
  *
  * ns-3 nix-vector-routing performs on-demand route computation using 
  * a breadth-first search and an efficient route-storage data structure 
- * known as a nix-vector.  When a packet is generated at a node for 
+ * known as a nix-vector.  The first route a node asks for runs a 
+ * breadth-first search of the whole topology from that node; the 
+ * resulting tree, stored as an array of parent node ids, gives the 
+ * routes to all the other destinations.  When a packet is generated at a node for 
  * transmission, the route is calculated, and the nix-vector is built.  
  * The nix-vector stores an index for each hop along the path, which 
  * corresponds to the neighbor-index.  This index is used to determine 
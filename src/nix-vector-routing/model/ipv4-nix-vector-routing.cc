@@ -35,6 +35,19 @@ namespace ns3 {
 NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorRouting)
   ;
 
+const uint32_t Ipv4NixVectorRouting::NO_PARENT;
+
+/* node id of each Ipv4 address, shared by all the nodes; rebuilt
+ * after an address change, and cleared when the nodes are disposed */
+static std::map<Ipv4Address, uint32_t> g_addressToNode;
+static bool g_addressToNodeValid = false;
+
+/* false as long as no node has cached anything since the
+ * last global flush, so that the flushes upon the interface
+ * and address notifications of the topology setup do not
+ * walk all the nodes */
+static bool g_nixCachesUsed = false;
+
 TypeId 
 Ipv4NixVectorRouting::GetTypeId (void)
 {
@@ -73,6 +86,15 @@ Ipv4NixVectorRouting::DoDispose ()
 
   m_node = 0;
   m_ipv4 = 0;
+  m_nixCache.clear ();
+  m_ipv4RouteCache.clear ();
+  m_bfsParents.clear ();
+
+  // The nodes of this simulation are going away: do not let the next
+  // simulation in this process see their addresses
+  g_addressToNode.clear ();
+  g_addressToNodeValid = false;
+  g_nixCachesUsed = false;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -102,9 +124,107 @@ Ipv4NixVectorRouting::FlushGlobalNixRoutingCache ()
       NS_LOG_LOGIC ("Flushing Nix caches.");
       rp->FlushNixCache ();
       rp->FlushIpv4RouteCache ();
+      rp->m_bfsParents.clear ();
+    }
+  g_addressToNodeValid = false;
+  g_nixCachesUsed = false;
+}
+
+void
+Ipv4NixVectorRouting::FlushNixCachesReaching (uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+
+  if (m_node == 0 || m_ipv4 == 0)
+    {
+      FlushGlobalNixRoutingCache ();
+      return;
+    }
+  if (!g_nixCachesUsed)
+    {
+      return;
+    }
+
+  // A link going up or down can only change the BFS trees which
+  // reach one of its ends: this node, or its neighbors on that
+  // interface
+  std::vector<uint32_t> ends;
+  ends.push_back (m_node->GetId ());
+  Ptr<NetDevice> device = m_ipv4->GetNetDevice (interface);
+  Ptr<Channel> channel = device->GetChannel ();
+  if (channel != 0)
+    {
+      NetDeviceContainer netDeviceContainer;
+      GetAdjacentNetDevices (device, channel, netDeviceContainer);
+      for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+        {
+          ends.push_back ((*iter)->GetNode ()->GetId ());
+        }
+    }
+
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Ipv4NixVectorRouting> rp = (*i)->GetObject<Ipv4NixVectorRouting> ();
+      if (!rp)
+        {
+          continue;
+        }
+      // the Ipv4 routes are cached by destination only, whichever
+      // path the packets follow: they all go
+      rp->FlushIpv4RouteCache ();
+      if (rp->BfsTreeReaches (ends))
+        {
+          NS_LOG_LOGIC ("Flushing Nix caches of node " << (*i)->GetId ());
+          rp->FlushNixCache ();
+          rp->m_bfsParents.clear ();
+        }
+    }
+}
+
+void
+Ipv4NixVectorRouting::FlushNixCachesTo (Ipv4Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+
+  // The topology, hence the BFS trees, stay the same
+  g_addressToNodeValid = false;
+  if (!g_nixCachesUsed)
+    {
+      return;
+    }
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Ipv4NixVectorRouting> rp = (*i)->GetObject<Ipv4NixVectorRouting> ();
+      if (!rp)
+        {
+          continue;
+        }
+      rp->m_nixCache.erase (address);
+      rp->FlushIpv4RouteCache ();
     }
 }
 
+bool
+Ipv4NixVectorRouting::BfsTreeReaches (const std::vector<uint32_t> & nodes) const
+{
+  // nix-vectors may be cached without the tree, when an
+  // output interface was specified
+  if (m_bfsParents.empty ())
+    {
+      return true;
+    }
+  for (std::vector<uint32_t>::const_iterator i = nodes.begin (); i != nodes.end (); i++)
+    {
+      if (*i >= m_bfsParents.size () || m_bfsParents[*i] != NO_PARENT)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
 void
 Ipv4NixVectorRouting::FlushNixCache ()
 {
@@ -147,12 +267,28 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
   else
     {
       // otherwise proceed as normal 
-      // and build the nix vector
-      std::vector< Ptr<Node> > parentVector;
-
-      BFS (NodeList::GetNNodes (), source, destNode, parentVector, oif);
+      // and build the nix vector.  Without a specific output
+      // interface, one BFS of the whole topology from this node
+      // serves all the destinations
+      std::vector<uint32_t> parentVector;
+      const std::vector<uint32_t> *parents = &parentVector;
+      uint32_t numberOfNodes = NodeList::GetNNodes ();
+
+      if (oif || source != m_node)
+        {
+          BFS (numberOfNodes, source, destNode, parentVector, oif);
+        }
+      else
+        {
+          if (m_bfsParents.size () != numberOfNodes)
+            {
+              NS_LOG_LOGIC ("Building the BFS tree of node " << source->GetId ());
+              BFS (numberOfNodes, source, 0, m_bfsParents, 0);
+            }
+          parents = &m_bfsParents;
+        }
 
-      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector))
+      if (BuildNixVector (*parents, source->GetId (), destNode->GetId (), nixVector))
         {
           return nixVector;
         }
@@ -224,7 +360,7 @@ Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
 }
 
 bool
-Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
+Ipv4NixVectorRouting::BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -233,12 +369,24 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
       return true;
     }
 
-  if (parentVector.at (dest) == 0)
+  if (parentVector.at (dest) == NO_PARENT)
     {
       return false;
     }
 
-  Ptr<Node> parentNode = parentVector.at (dest);
+  // walk the path back from dest, adding the neighbor
+  // index of each hop to the nix vector
+  for (; dest != source; dest = parentVector.at (dest))
+    {
+      AddNixIndex (NodeList::GetNode (parentVector.at (dest)), dest, nixVector);
+    }
+  return true;
+}
+
+void
+Ipv4NixVectorRouting::AddNixIndex (Ptr<Node> parentNode, uint32_t dest, Ptr<NixVector> nixVector)
+{
+  NS_LOG_FUNCTION_NOARGS ();
 
   uint32_t numberOfDevices = parentNode->GetNDevices ();
   uint32_t destId = 0;
@@ -289,11 +437,6 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
   NS_LOG_LOGIC ("Adding Nix: " << destId << " with " 
                                << nixVector->BitCount (totalNeighbors) << " bits, for node " << parentNode->GetId ());
   nixVector->AddNeighborIndex (destId, nixVector->BitCount (totalNeighbors));
-
-  // recurse through parent vector, grabbing the path 
-  // and building the nix vector
-  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector);
-  return true;
 }
 
 void
@@ -341,27 +484,41 @@ Ipv4NixVectorRouting::GetNodeByIp (Ipv4Address dest)
 { 
   NS_LOG_FUNCTION_NOARGS ();
 
-  NodeContainer allNodes = NodeContainer::GetGlobal ();
-  Ptr<Node> destNode;
-
-  for (NodeContainer::Iterator i = allNodes.Begin (); i != allNodes.End (); ++i)
+  // The addresses of all the nodes are indexed on the first
+  // lookup after a change, and again when an address is not
+  // found, in case it was added to a node without nix-vector
+  // routing (which would not have told us)
+  std::map<Ipv4Address, uint32_t>::const_iterator found = g_addressToNode.find (dest);
+  if (!g_addressToNodeValid || found == g_addressToNode.end ())
     {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-      if (ipv4->GetInterfaceForAddress (dest) != -1)
+      g_addressToNode.clear ();
+      for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
         {
-          destNode = node;
-          break;
+          Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+          if (ipv4 == 0)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+            {
+              for (uint32_t k = 0; k < ipv4->GetNAddresses (j); k++)
+                {
+                  // the first node with the address wins
+                  g_addressToNode.insert (std::make_pair (ipv4->GetAddress (j, k).GetLocal (), (*i)->GetId ()));
+                }
+            }
         }
+      g_addressToNodeValid = true;
+      found = g_addressToNode.find (dest);
     }
 
-  if (!destNode)
+  if (found == g_addressToNode.end ())
     {
       NS_LOG_ERROR ("Couldn't find dest node given the IP" << dest);
       return 0;
     }
 
-  return destNode;
+  return NodeList::GetNode (found->second);
 }
 
 uint32_t
@@ -503,6 +660,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
       // cache it
       m_nixCache.insert (NixMap_t::value_type (header.GetDestination (), nixVectorInCache));
+      g_nixCachesUsed = true;
     }
 
   // path exists
@@ -581,6 +739,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
           // add rtentry to cache
           m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+          g_nixCachesUsed = true;
         }
 
       NS_LOG_LOGIC ("Nix-vector contents: " << *nixVectorInCache << " : Remaining bits: " << nixVectorForPacket->GetRemainingBits ());
@@ -646,6 +805,7 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
       // add rtentry to cache
       m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+      g_nixCachesUsed = true;
     }
 
   NS_LOG_LOGIC ("At Node " << m_node->GetId () << ", Extracting " << numberOfBits <<
@@ -708,42 +868,40 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4NixVectorRouting::NotifyInterfaceUp (uint32_t i)
 {
-  FlushGlobalNixRoutingCache ();
+  FlushNixCachesReaching (i);
 }
 void
 Ipv4NixVectorRouting::NotifyInterfaceDown (uint32_t i)
 {
-  FlushGlobalNixRoutingCache ();
+  FlushNixCachesReaching (i);
 }
 void
 Ipv4NixVectorRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
-  FlushGlobalNixRoutingCache ();
+  FlushNixCachesTo (address.GetLocal ());
 }
 void
 Ipv4NixVectorRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
-  FlushGlobalNixRoutingCache ();
+  FlushNixCachesTo (address.GetLocal ());
 }
 
 bool
 Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source, 
-                           Ptr<Node> dest, std::vector< Ptr<Node> > & parentVector,
+                           Ptr<Node> dest, std::vector<uint32_t> & parentVector,
                            Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << dest->GetId ());
+  NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << (dest ? dest->GetId () : NO_PARENT));
   std::queue< Ptr<Node> > greyNodeList;  // discovered nodes with unexplored children
 
   // reset the parent vector
-  parentVector.clear ();
-  parentVector.reserve (sizeof (Ptr<Node>)*numberOfNodes);
-  parentVector.insert (parentVector.begin (), sizeof (Ptr<Node>)*numberOfNodes, 0); // initialize to 0
+  parentVector.assign (numberOfNodes, NO_PARENT);
 
   // Add the source node to the queue, set its parent to itself 
   greyNodeList.push (source);
-  parentVector.at (source->GetId ()) = source;
+  parentVector.at (source->GetId ()) = source->GetId ();
 
   // BFS loop
   while (greyNodeList.size () != 0)
@@ -800,9 +958,9 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
               // by checking to see if it has a parent
               // if it doesn't (null or 0), then set its parent and 
               // push to the queue
-              if (parentVector.at (remoteNode->GetId ()) == 0)
+              if (parentVector.at (remoteNode->GetId ()) == NO_PARENT)
                 {
-                  parentVector.at (remoteNode->GetId ()) = currNode;
+                  parentVector.at (remoteNode->GetId ()) = currNode->GetId ();
                   greyNodeList.push (remoteNode);
                 }
             }
@@ -856,9 +1014,9 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
                   // by checking to see if it has a parent
                   // if it doesn't (null or 0), then set its parent and 
                   // push to the queue
-                  if (parentVector.at (remoteNode->GetId ()) == 0)
+                  if (parentVector.at (remoteNode->GetId ()) == NO_PARENT)
                     {
-                      parentVector.at (remoteNode->GetId ()) = currNode;
+                      parentVector.at (remoteNode->GetId ()) = currNode->GetId ();
                       greyNodeList.push (remoteNode);
                     }
                 }
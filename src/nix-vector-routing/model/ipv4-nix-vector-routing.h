@@ -22,6 +22,7 @@
 #define IPV4_NIX_VECTOR_ROUTING_H
 
 #include <map>
+#include <vector>
 
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
@@ -90,6 +91,20 @@ private:
    * reset to zero */
   void ResetTotalNeighbors (void);
 
+  /* upon an interface going up or down, flushes the
+   * BFS trees (and the nix-vectors built from them) which
+   * reach this node or its neighbors on that interface,
+   * and the Ipv4 route caches */
+  void FlushNixCachesReaching (uint32_t interface);
+
+  /* upon an address change, flushes the nix-vectors to
+   * that address and the Ipv4 route caches */
+  void FlushNixCachesTo (Ipv4Address address);
+
+  /* true if the BFS tree of this node is not known or
+   * reaches one of the given nodes */
+  bool BfsTreeReaches (const std::vector<uint32_t> & nodes) const;
+
   /*  takes in the source node and dest IP and calls GetNodeByIp,
    *  BFS, accounting for any output interface specified, and finally
    *  BuildNixVector to return the built nix-vector */
@@ -109,8 +124,13 @@ private:
    * corresponding to the given Ipv4Address */
   Ptr<Node> GetNodeByIp (Ipv4Address);
 
-  /* Recurses the parent vector, created by BFS and actually builds the nixvector */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+  /* Walks the parent vector, created by BFS, back from dest
+   * and actually builds the nixvector */
+  bool BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+
+  /* adds to the nixvector the neighbor index of dest among
+   * the neighbors of parentNode */
+  void AddNixIndex (Ptr<Node> parentNode, uint32_t dest, Ptr<NixVector> nixVector);
 
   /* special variation of BuildNixVector for when a node is sending to itself */
   bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
@@ -130,17 +150,21 @@ private:
   /* Breadth first search algorithm
    * Param1: total number of nodes
    * Param2: Source Node
-   * Param3: Dest Node
-   * Param4: (returned) Parent vector for retracing routes
+   * Param3: Dest Node, or null to search the whole topology
+   * Param4: (returned) Parent vector for retracing routes: the id of
+   *         the parent of each node, by node id, or NO_PARENT
    * Param5: specific output interface to use from source node, if not null
-   * Returns: false if dest not found, true o.w.
+   * Returns: false if dest not found (or null), true o.w.
    */
   bool BFS (uint32_t numberOfNodes,
             Ptr<Node> source,
             Ptr<Node> dest,
-            std::vector< Ptr<Node> > & parentVector,
+            std::vector<uint32_t> & parentVector,
             Ptr<NetDevice> oif);
 
+  /* parent of the nodes not reached by a BFS */
+  static const uint32_t NO_PARENT = 0xffffffff;
+
   void DoDispose (void);
 
   /* From Ipv4RoutingProtocol */
@@ -162,6 +186,11 @@ private:
   /* cache stores Ipv4Routes based on destination ip */
   Ipv4RouteMap_t m_ipv4RouteCache;
 
+  /* BFS tree of the whole topology rooted at this node, as
+   * a parent vector; built on the first route asked for, and
+   * shared by the nix-vectors to all destinations */
+  std::vector<uint32_t> m_bfsParents;
+
   Ptr<Ipv4> m_ipv4;
   Ptr<Node> m_node;
 
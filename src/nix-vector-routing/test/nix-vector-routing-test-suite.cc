@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * Nix-vector routing over a ring of four nodes (0-1-2-3-0) and a separate
+ * link between nodes 4 and 5.  Link i is network 10.1.i.0/24, where its
+ * first node has address .1 and its second node address .2.
+ */
+class NixVectorRoutingTestCase : public TestCase
+{
+public:
+  NixVectorRoutingTestCase (std::string name);
+protected:
+  void Build (bool nixRouting = true);
+  void InstallNixRouting (void);
+  Ptr<Ipv4Route> Route (uint32_t node, Ipv4Address destination);
+  bool HasNixVector (uint32_t node, Ipv4Address destination);
+  NodeContainer m_nodes;
+};
+
+NixVectorRoutingTestCase::NixVectorRoutingTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+NixVectorRoutingTestCase::Build (bool nixRouting)
+{
+  m_nodes = NodeContainer ();
+  m_nodes.Create (6);
+  InternetStackHelper internet;
+  if (nixRouting)
+    {
+      internet.SetRoutingHelper (Ipv4NixVectorHelper ());
+    }
+  internet.Install (m_nodes);
+
+  uint32_t ends[5][2] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 4, 5 } };
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (channel);
+          m_nodes.Get (ends[i][j])->AddDevice (device);
+          devices.Add (device);
+        }
+      address.Assign (devices);
+      address.NewNetwork ();
+    }
+}
+
+void
+NixVectorRoutingTestCase::InstallNixRouting (void)
+{
+  // Nix-vector routing installed this way is told about no address
+  Ipv4NixVectorHelper nixRouting;
+  for (uint32_t i = 0; i < m_nodes.GetN (); ++i)
+    {
+      Ptr<Node> node = m_nodes.Get (i);
+      node->GetObject<Ipv4> ()->SetRoutingProtocol (nixRouting.Create (node));
+    }
+}
+
+Ptr<Ipv4Route>
+NixVectorRoutingTestCase::Route (uint32_t node, Ipv4Address destination)
+{
+  Ptr<Ipv4RoutingProtocol> routing = m_nodes.Get (node)->GetObject<Ipv4NixVectorRouting> ();
+  Ipv4Header header;
+  header.SetDestination (destination);
+  Socket::SocketErrno err;
+  return routing->RouteOutput (Create<Packet> (), header, 0, err);
+}
+
+bool
+NixVectorRoutingTestCase::HasNixVector (uint32_t node, Ipv4Address destination)
+{
+  // The nix-vectors are listed before the Ipv4 routes, one per line
+  // starting with the destination
+  Ptr<Ipv4RoutingProtocol> routing = m_nodes.Get (node)->GetObject<Ipv4NixVectorRouting> ();
+  std::ostringstream oss;
+  routing->PrintRoutingTable (Create<OutputStreamWrapper> (&oss));
+  std::string table = oss.str ();
+  std::string nixCache = table.substr (0, table.find ("Ipv4RouteCache:"));
+  std::ostringstream line;
+  line << "\n" << destination << " ";
+  return nixCache.find (line.str ()) != std::string::npos;
+}
+
+class NixVectorRoutingInterfaceTestCase : public NixVectorRoutingTestCase
+{
+public:
+  NixVectorRoutingInterfaceTestCase ();
+  virtual void DoRun (void);
+};
+
+NixVectorRoutingInterfaceTestCase::NixVectorRoutingInterfaceTestCase ()
+  : NixVectorRoutingTestCase ("Routes are resolved again after an interface goes down and up")
+{
+}
+
+void
+NixVectorRoutingInterfaceTestCase::DoRun (void)
+{
+  Build ();
+  Ptr<Ipv4Route> route = Route (0, "10.1.1.2");
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to node 2");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.0.2"), "Node 0 should go through node 1");
+  NS_TEST_ASSERT_MSG_NE (Route (4, "10.1.4.2"), 0, "No route from node 4 to node 5");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (4, "10.1.4.2"), true, "Node 4 should have cached its nix-vector");
+
+  // Interface 1 of node 0 is on the link to node 1 (interface 0 is the
+  // loopback)
+  Ptr<Ipv4> ipv4 = m_nodes.Get (0)->GetObject<Ipv4> ();
+  ipv4->SetDown (1);
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (0, "10.1.1.2"), false, "The nix-vector of node 0 should be flushed");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (4, "10.1.4.2"), true, "Node 4 does not reach the link and should keep its nix-vector");
+  route = Route (0, "10.1.1.2");
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to node 2 with the link down");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.3.1"), "Node 0 should go through node 3");
+  NS_TEST_EXPECT_MSG_EQ (route->GetOutputDevice (), ipv4->GetNetDevice (2), "Node 0 should use the link to node 3");
+
+  ipv4->SetUp (1);
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (4, "10.1.4.2"), true, "Node 4 does not reach the link and should keep its nix-vector");
+  route = Route (0, "10.1.1.2");
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to node 2 with the link up");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.0.2"), "Node 0 should go through node 1 again");
+  NS_TEST_EXPECT_MSG_EQ (route->GetOutputDevice (), ipv4->GetNetDevice (1), "Node 0 should use the link to node 1 again");
+
+  Simulator::Destroy ();
+}
+
+class NixVectorRoutingAddressTestCase : public NixVectorRoutingTestCase
+{
+public:
+  NixVectorRoutingAddressTestCase ();
+  virtual void DoRun (void);
+};
+
+NixVectorRoutingAddressTestCase::NixVectorRoutingAddressTestCase ()
+  : NixVectorRoutingTestCase ("Routes are resolved again after an address moves to another node")
+{
+}
+
+void
+NixVectorRoutingAddressTestCase::DoRun (void)
+{
+  Build ();
+  Ipv4InterfaceAddress moving (Ipv4Address ("10.2.0.1"), Ipv4Mask ("255.255.255.255"));
+  Ptr<Ipv4> ipv4 = m_nodes.Get (2)->GetObject<Ipv4> ();
+  ipv4->AddAddress (1, moving);
+  Ptr<Ipv4Route> route = Route (0, moving.GetLocal ());
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to the address of node 2");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.0.2"), "Node 0 should go through node 1");
+  NS_TEST_ASSERT_MSG_NE (Route (0, "10.1.1.2"), 0, "No route from node 0 to node 2");
+  NS_TEST_ASSERT_MSG_NE (Route (4, "10.1.4.2"), 0, "No route from node 4 to node 5");
+
+  ipv4->RemoveAddress (1, moving.GetLocal ());
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (0, moving.GetLocal ()), false, "The nix-vector to the removed address should be flushed");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (0, "10.1.1.2"), true, "The nix-vectors to other addresses should be kept");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (4, "10.1.4.2"), true, "The nix-vectors of other nodes should be kept");
+
+  m_nodes.Get (3)->GetObject<Ipv4> ()->AddAddress (2, moving);
+  route = Route (0, moving.GetLocal ());
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to the address of node 3");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.3.1"), "Node 0 should go straight to node 3");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (0, "10.1.1.2"), true, "The nix-vectors to other addresses should be kept");
+  NS_TEST_EXPECT_MSG_EQ (HasNixVector (4, "10.1.4.2"), true, "The nix-vectors of other nodes should be kept");
+
+  Simulator::Destroy ();
+}
+
+class NixVectorRoutingNewSimulationTestCase : public NixVectorRoutingTestCase
+{
+public:
+  NixVectorRoutingNewSimulationTestCase ();
+  virtual void DoRun (void);
+};
+
+NixVectorRoutingNewSimulationTestCase::NixVectorRoutingNewSimulationTestCase ()
+  : NixVectorRoutingTestCase ("Routes of a new simulation ignore the addresses of the previous one")
+{
+}
+
+void
+NixVectorRoutingNewSimulationTestCase::DoRun (void)
+{
+  Ipv4InterfaceAddress moving (Ipv4Address ("10.2.0.1"), Ipv4Mask ("255.255.255.255"));
+
+  // First simulation: the address is on node 3
+  Build ();
+  m_nodes.Get (3)->GetObject<Ipv4> ()->AddAddress (2, moving);
+  Ptr<Ipv4Route> route = Route (0, moving.GetLocal ());
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to the address of node 3");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.3.1"), "Node 0 should go straight to node 3");
+  Simulator::Destroy ();
+
+  // Second simulation: the address is on node 2, and the routing
+  // protocols are not told about it
+  Build (false);
+  m_nodes.Get (2)->GetObject<Ipv4> ()->AddAddress (1, moving);
+  InstallNixRouting ();
+  route = Route (0, moving.GetLocal ());
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route from node 0 to the address of node 2");
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.1.0.2"), "Node 0 should go through node 1");
+
+  Simulator::Destroy ();
+}
+
+static class NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  NixVectorRoutingTestSuite ()
+    : TestSuite ("nix-vector-routing", UNIT)
+  {
+    AddTestCase (new NixVectorRoutingInterfaceTestCase (), TestCase::QUICK);
+    AddTestCase (new NixVectorRoutingAddressTestCase (), TestCase::QUICK);
+    AddTestCase (new NixVectorRoutingNewSimulationTestCase (), TestCase::QUICK);
+  }
+} g_nixVectorRoutingTestSuite;
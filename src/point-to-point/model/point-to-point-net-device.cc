@@ -29,6 +29,7 @@
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointNetDevice");
 
@@ -68,6 +69,13 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrainLength",
+                   "The largest number of queued packets sent back to back as one train.  "
+                   "Every packet of a train still leaves the queue, is traced and is received "
+                   "at its own time, so the value does not change the simulation.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_maxTrainLength),
+                   MakeUintegerChecker<uint32_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -149,6 +157,7 @@ PointToPointNetDevice::PointToPointNetDevice ()
   :
     m_txMachineState (READY),
     m_channel (0),
+    m_maxTrainLength (1),
     m_linkUp (false),
     m_currentPkt (0)
 {
@@ -204,6 +213,52 @@ PointToPointNetDevice::SetInterframeGap (Time t)
   m_tInterframeGap = t;
 }
 
+void
+PointToPointNetDevice::SetBackgroundDataRate (DataRate bps)
+{
+  NS_LOG_FUNCTION (this << bps);
+  NS_ASSERT_MSG (bps.GetBitRate () == 0 || bps < m_bps, "Background data rate must be lower than the device data rate");
+  m_backgroundBps = bps;
+}
+
+DataRate
+PointToPointNetDevice::GetBackgroundDataRate (void) const
+{
+  return m_backgroundBps;
+}
+
+void
+PointToPointNetDevice::SetBackgroundDelay (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_backgroundDelay = delay;
+}
+
+Time
+PointToPointNetDevice::GetBackgroundDelay (void) const
+{
+  return m_backgroundDelay;
+}
+
+Time
+PointToPointNetDevice::CalculateTxTime (uint32_t size) const
+{
+  if (m_backgroundBps.GetBitRate () == 0)
+    {
+      return Seconds (m_bps.CalculateTxTime (size));
+    }
+  DataRate residual (m_bps.GetBitRate () - m_backgroundBps.GetBitRate ());
+  return Seconds (residual.CalculateTxTime (size));
+}
+
+Time
+PointToPointNetDevice::DelayBehindBackground (Time txEnd)
+{
+  Time exit = std::max (Simulator::Now () + txEnd + m_backgroundDelay, m_lastBackgroundExit);
+  m_lastBackgroundExit = exit;
+  return exit - Simulator::Now ();
+}
+
 bool
 PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
 {
@@ -220,13 +275,13 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = Seconds (m_bps.CalculateTxTime (p->GetSize ()));
+  Time txTime = CalculateTxTime (p->GetSize ());
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
   Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
 
-  bool result = m_channel->TransmitStart (p, this, txTime);
+  bool result = m_channel->TransmitStart (p, this, DelayBehindBackground (txTime));
   if (result == false)
     {
       m_phyTxDropTrace (p);
@@ -54,6 +54,13 @@ class ErrorModel;
  * Key parameters or objects that can be specified for this device 
  * include a queue, data rate, and interframe transmission gap (the 
  * propagation delay is set in the PointToPointChannel).
+ *
+ * The MaxTrainLength attribute bounds the number of queued packets sent
+ * back to back as one train.  Each packet of a train leaves the queue when
+ * its own transmission starts, its traces fire when its own transmission
+ * starts and ends, and it is received when its own last bit arrives, so a
+ * train needs one transmit and one receive event per packet, as packets
+ * sent one by one do, and the simulation is the same for any value.
  */
 class PointToPointNetDevice : public NetDevice
 {
@@ -94,6 +101,36 @@ public:
    */
   void SetInterframeGap (Time t);
 
+  /**
+   * Set the part of the data rate consumed by background traffic that is
+   * not simulated packet by packet (e.g., fluid flows).  Packets are then
+   * transmitted at the residual data rate.
+   *
+   * @param bps the background data rate, lower than the device data rate
+   */
+  void SetBackgroundDataRate (DataRate bps);
+
+  /**
+   * @returns the background data rate
+   */
+  DataRate GetBackgroundDataRate (void) const;
+
+  /**
+   * Set the mean time packets wait behind the background traffic queued
+   * in front of them.  It is added to the time at which transmitted
+   * packets are received on the other end of the channel.  The link stays
+   * first in, first out: after the delay decreases, a packet is not
+   * received before the packets transmitted earlier.
+   *
+   * @param delay the background queueing delay
+   */
+  void SetBackgroundDelay (Time delay);
+
+  /**
+   * @returns the background queueing delay
+   */
+  Time GetBackgroundDelay (void) const;
+
   /**
    * Attach the device to a channel.
    *
@@ -238,6 +275,26 @@ private:
    */
   bool TransmitStart (Ptr<Packet> p);
 
+  /**
+   * Compute the time needed to transmit a packet at the data rate left
+   * by the background traffic.
+   *
+   * @param size the size of the packet, in bytes
+   * @returns the transmission time
+   */
+  Time CalculateTxTime (uint32_t size) const;
+
+  /**
+   * Add the background queueing delay to the time at which the last bit
+   * of a packet leaves the device, without letting the packet arrive
+   * before the previous one when the delay has decreased in between.
+   *
+   * @param txEnd the time from now at which the last bit leaves the device
+   * @returns the time from now at which the packet leaves the background
+   * queue
+   */
+  Time DelayBehindBackground (Time txEnd);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -276,6 +333,22 @@ private:
    */
   Time           m_tInterframeGap;
 
+  /**
+   * The part of m_bps consumed by background traffic
+   */
+  DataRate       m_backgroundBps;
+
+  /**
+   * The queueing delay caused by background traffic
+   */
+  Time           m_backgroundDelay;
+
+  /**
+   * The time at which the last packet transmitted leaves the background
+   * queue
+   */
+  Time           m_lastBackgroundExit;
+
   /**
    * The PointToPointChannel to which this PointToPointNetDevice has been
    * attached.
@@ -292,6 +365,11 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  /**
+   * The largest number of queued packets sent as a single train
+   */
+  uint32_t m_maxTrainLength;
+
   /**
    * Error model for receive packet events
    */
@@ -3,6 +3,9 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -55,7 +58,203 @@ PointToPointTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+// Saturate a short queue with and without trains, and check that the
+// queue, the transmit traces and the receiver see every packet at the
+// same time.
+class PointToPointTrainTest : public TestCase
+{
+public:
+  PointToPointTrainTest ();
+
+  virtual void DoRun (void);
+
+private:
+  struct Result
+  {
+    std::vector<Time> m_dequeueTimes;  // times at which packets left the queue
+    std::vector<Time> m_dropTimes;     // times at which the queue dropped packets
+    std::vector<Time> m_txBeginTimes;  // times of the PhyTxBegin traces
+    std::vector<Time> m_txEndTimes;    // times of the PhyTxEnd traces
+    std::vector<Time> m_rxTimes;       // times at which packets were received
+    std::vector<uint64_t> m_rxUids;    // uids of the received packets, in order
+  };
+
+  void Run (uint32_t maxTrainLength, Result &result);
+  void SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  static void Trace (std::vector<Time> *times, Ptr<const Packet> p);
+
+  Result *m_result;
+};
+
+PointToPointTrainTest::PointToPointTrainTest ()
+  : TestCase ("PointToPoint trains keep the per-packet timing")
+{
+}
+
+void
+PointToPointTrainTest::SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size)
+{
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointTrainTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_result->m_rxTimes.push_back (Simulator::Now ());
+  m_result->m_rxUids.push_back (p->GetUid ());
+  return true;
+}
+
+void
+PointToPointTrainTest::Trace (std::vector<Time> *times, Ptr<const Packet> p)
+{
+  times->push_back (Simulator::Now ());
+}
+
+void
+PointToPointTrainTest::Run (uint32_t maxTrainLength, Result &result)
+{
+  m_result = &result;
+
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MicroSeconds (50)));
+
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (10));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (queue);
+  devA->SetDataRate (DataRate ("10Mbps"));
+  devA->SetInterframeGap (MicroSeconds (1));
+  devA->SetAttribute ("MaxTrainLength", UintegerValue (maxTrainLength));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  devB->SetReceiveCallback (MakeCallback (&PointToPointTrainTest::Receive, this));
+  queue->TraceConnectWithoutContext ("Dequeue", MakeBoundCallback (&PointToPointTrainTest::Trace, &result.m_dequeueTimes));
+  queue->TraceConnectWithoutContext ("Drop", MakeBoundCallback (&PointToPointTrainTest::Trace, &result.m_dropTimes));
+  devA->TraceConnectWithoutContext ("PhyTxBegin", MakeBoundCallback (&PointToPointTrainTest::Trace, &result.m_txBeginTimes));
+  devA->TraceConnectWithoutContext ("PhyTxEnd", MakeBoundCallback (&PointToPointTrainTest::Trace, &result.m_txEndTimes));
+
+  // Packets of varying sizes every 200 us, on a link taking about 400 us
+  // per packet, so that the queue fills up and drops
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Simulator::Schedule (Seconds (1.0) + MicroSeconds (200 * i),
+                           &PointToPointTrainTest::SendPacket, this, devA, 400 + (i % 5) * 50);
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PointToPointTrainTest::DoRun (void)
+{
+  Result single;
+  Result train;
+  Run (1, single);
+  Run (8, train);
+
+  NS_TEST_ASSERT_MSG_GT (single.m_dropTimes.size (), 100, "The queue is not saturated");
+  NS_TEST_ASSERT_MSG_EQ (single.m_rxTimes.size () + single.m_dropTimes.size (), 300, "Packets lost");
+  NS_TEST_ASSERT_MSG_EQ (train.m_rxTimes.size (), single.m_rxTimes.size (), "Different number of packets received");
+  NS_TEST_EXPECT_MSG_EQ ((train.m_dequeueTimes == single.m_dequeueTimes), true, "Packets left the queue at other times");
+  NS_TEST_EXPECT_MSG_EQ ((train.m_dropTimes == single.m_dropTimes), true, "Packets dropped at other times");
+  NS_TEST_EXPECT_MSG_EQ ((train.m_txBeginTimes == single.m_txBeginTimes), true, "PhyTxBegin traced at other times");
+  NS_TEST_EXPECT_MSG_EQ ((train.m_txEndTimes == single.m_txEndTimes), true, "PhyTxEnd traced at other times");
+  NS_TEST_EXPECT_MSG_EQ ((train.m_rxTimes == single.m_rxTimes), true, "Packets received at other times");
+  for (uint32_t i = 1; i < train.m_rxUids.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_GT (train.m_rxUids[i], train.m_rxUids[i - 1], "Packet " << i << " out of order");
+    }
+}
+
 //-----------------------------------------------------------------------------
+// Send a packet behind a long background queueing delay, then a small
+// packet once the delay has dropped, and check that the link does not
+// deliver the second packet first.
+class PointToPointBackgroundDelayTest : public TestCase
+{
+public:
+  PointToPointBackgroundDelayTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size, Time backgroundDelay);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<uint32_t> m_sizes;
+  std::vector<Time> m_rxTimes;
+};
+
+PointToPointBackgroundDelayTest::PointToPointBackgroundDelayTest ()
+  : TestCase ("PointToPoint background delay keeps the packets in order")
+{
+}
+
+void
+PointToPointBackgroundDelayTest::SendPacket (Ptr<PointToPointNetDevice> device, uint32_t size, Time backgroundDelay)
+{
+  device->SetBackgroundDelay (backgroundDelay);
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointBackgroundDelayTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_sizes.push_back (p->GetSize ());
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointBackgroundDelayTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devA->SetDataRate (DataRate ("10Mbps"));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBackgroundDelayTest::Receive, this));
+
+  // 1000 bytes and the 2 byte PPP header take 801.6 us at 10 Mbps: the
+  // first packet leaves the background queue at 10.8016 ms, the second
+  // one would at about 1.9 ms
+  Simulator::Schedule (Seconds (0), &PointToPointBackgroundDelayTest::SendPacket, this,
+                       devA, 1000, MilliSeconds (10));
+  Simulator::Schedule (MilliSeconds (1), &PointToPointBackgroundDelayTest::SendPacket, this,
+                       devA, 100, MicroSeconds (800));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_sizes.size (), 2, "Packets lost");
+  NS_TEST_EXPECT_MSG_EQ (m_sizes[0], 1000, "The packets were reordered");
+  NS_TEST_EXPECT_MSG_EQ (m_sizes[1], 100, "The packets were reordered");
+  NS_TEST_EXPECT_MSG_EQ ((m_rxTimes[0] > MilliSeconds (10)), true, "The first packet should keep its delay");
+  NS_TEST_EXPECT_MSG_EQ (m_rxTimes[1], m_rxTimes[0], "The second packet should follow the first one");
+}
+
 class PointToPointTestSuite : public TestSuite
 {
 public:
@@ -66,6 +265,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointTrainTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBackgroundDelayTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite;
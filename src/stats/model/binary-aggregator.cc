@@ -0,0 +1,404 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <cstring>
+
+#include "binary-aggregator.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryAggregator")
+  ;
+
+NS_OBJECT_ENSURE_REGISTERED (BinaryAggregator)
+  ;
+
+namespace {
+
+/// The first bytes of a file, followed by the version of the format
+const char g_magic[] = "ns3binag";
+const uint8_t g_version = 1;
+
+/**
+ * \param buffer the buffer to append to
+ * \param value the integer to append
+ * \param size the number of bytes of the integer
+ */
+void
+PutUint (std::string &buffer, uint64_t value, uint32_t size)
+{
+  for (uint32_t i = 0; i < size; i++)
+    {
+      buffer.push_back (static_cast<char> ((value >> (8 * i)) & 0xff));
+    }
+}
+
+/**
+ * \param is the stream to read
+ * \param size the number of bytes of the integer
+ * \param value the integer read
+ * \returns false if the stream ended before the integer
+ */
+bool
+GetUint (std::istream &is, uint32_t size, uint64_t &value)
+{
+  value = 0;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      int c = is.get ();
+      if (c == EOF)
+        {
+          return false;
+        }
+      value |= static_cast<uint64_t> (c) << (8 * i);
+    }
+  return true;
+}
+
+uint64_t
+DoubleToBits (double value)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  return bits;
+}
+
+double
+BitsToDouble (uint64_t bits)
+{
+  double value;
+  std::memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+/// The encodings of a column
+enum ColumnEncoding
+{
+  XOR_PREVIOUS = 0,  //!< XOR with the bits of the previous value
+  DELTA_OF_DELTA = 1 //!< difference with the bits extrapolated from the two previous values
+};
+
+/**
+ * \param buffer the buffer to append to
+ * \param x the 64 bits to append
+ *
+ * Appends a control byte, with the number of leading zero bytes in its
+ * high nibble and of trailing zero bytes in its low nibble, then the
+ * other bytes, most significant first.
+ */
+void
+PutResidual (std::string &buffer, uint64_t x)
+{
+  if (x == 0)
+    {
+      buffer.push_back (static_cast<char> (8 << 4));
+      return;
+    }
+  uint32_t leading = 0;
+  while ((x >> (8 * (7 - leading))) == 0)
+    {
+      leading++;
+    }
+  uint32_t trailing = 0;
+  while (((x >> (8 * trailing)) & 0xff) == 0)
+    {
+      trailing++;
+    }
+  buffer.push_back (static_cast<char> ((leading << 4) | trailing));
+  for (int byte = 7 - leading; byte >= static_cast<int> (trailing); byte--)
+    {
+      buffer.push_back (static_cast<char> ((x >> (8 * byte)) & 0xff));
+    }
+}
+
+/**
+ * \param buffer the buffer to append to
+ * \param values the values of the rows
+ * \param nRows the number of rows
+ * \param stride the distance between two values of the column
+ * \param encoding how to encode the column
+ */
+void
+PutColumn (std::string &buffer, const double *values, uint32_t nRows, uint32_t stride,
+           enum ColumnEncoding encoding)
+{
+  buffer.push_back (static_cast<char> (encoding));
+  uint64_t previous = 0;
+  uint64_t delta = 0;
+  for (uint32_t row = 0; row < nRows; row++)
+    {
+      uint64_t bits = DoubleToBits (values[row * stride]);
+      if (encoding == XOR_PREVIOUS)
+        {
+          PutResidual (buffer, bits ^ previous);
+        }
+      else
+        {
+          // Zigzag, so that small negative residuals have leading zero bytes
+          uint64_t residual = bits - (previous + delta);
+          PutResidual (buffer, (residual << 1) ^ (0 - (residual >> 63)));
+          delta = bits - previous;
+        }
+      previous = bits;
+    }
+}
+
+} // anonymous namespace
+
+TypeId
+BinaryAggregator::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::BinaryAggregator")
+    .SetParent<DataCollectionObject> ()
+    .AddAttribute ("BlockSize",
+                   "The number of rows of a dataset buffered before they are compressed and written.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&BinaryAggregator::m_blockSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+
+  return tid;
+}
+
+BinaryAggregator::BinaryAggregator (const std::string &outputFileName)
+  : m_outputFileName (outputFileName)
+{
+  NS_LOG_FUNCTION (this << outputFileName);
+
+  m_file.open (m_outputFileName.c_str (), std::ios::out | std::ios::binary);
+  m_file.write (g_magic, sizeof (g_magic) - 1);
+  m_file.put (g_version);
+}
+
+BinaryAggregator::~BinaryAggregator ()
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+  m_file.close ();
+}
+
+void
+BinaryAggregator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Flush ();
+  DataCollectionObject::DoDispose ();
+}
+
+void
+BinaryAggregator::Write1d (std::string context,
+                           double v1)
+{
+  NS_LOG_FUNCTION (this << context << v1);
+  Write (context, &v1, 1);
+}
+
+void
+BinaryAggregator::Write2d (std::string context,
+                           double v1,
+                           double v2)
+{
+  NS_LOG_FUNCTION (this << context << v1 << v2);
+  double values[2] = {v1, v2};
+  Write (context, values, 2);
+}
+
+void
+BinaryAggregator::Write3d (std::string context,
+                           double v1,
+                           double v2,
+                           double v3)
+{
+  NS_LOG_FUNCTION (this << context << v1 << v2 << v3);
+  double values[3] = {v1, v2, v3};
+  Write (context, values, 3);
+}
+
+void
+BinaryAggregator::Write (const std::string &context, const double *values, uint8_t n)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+
+  std::map<std::string, Dataset>::iterator i = m_datasets.find (context);
+  if (i == m_datasets.end ())
+    {
+      NS_ABORT_MSG_IF (context.size () > 0xffff, "Dataset context too long: " << context);
+      Dataset dataset;
+      dataset.index = m_datasets.size ();
+      dataset.nColumns = n;
+      dataset.rows.reserve (m_blockSize * n);
+      i = m_datasets.insert (std::make_pair (context, dataset)).first;
+
+      m_buffer.clear ();
+      m_buffer.push_back ('D');
+      PutUint (m_buffer, dataset.index, 4);
+      PutUint (m_buffer, n, 1);
+      PutUint (m_buffer, context.size (), 2);
+      m_buffer += context;
+      m_file.write (m_buffer.data (), m_buffer.size ());
+    }
+  Dataset &dataset = i->second;
+  NS_ABORT_MSG_IF (n != dataset.nColumns, "Dataset " << context << " has "
+                   << (uint32_t) dataset.nColumns << " values per row, not " << (uint32_t) n);
+
+  dataset.rows.insert (dataset.rows.end (), values, values + n);
+  if (dataset.rows.size () >= static_cast<size_t> (m_blockSize) * n)
+    {
+      WriteBlock (dataset);
+    }
+}
+
+void
+BinaryAggregator::WriteBlock (Dataset &dataset)
+{
+  NS_LOG_FUNCTION (this << dataset.index);
+
+  uint32_t nRows = dataset.rows.size () / dataset.nColumns;
+  m_buffer.clear ();
+  m_buffer.push_back ('B');
+  PutUint (m_buffer, dataset.index, 4);
+  PutUint (m_buffer, nRows, 4);
+  for (uint32_t column = 0; column < dataset.nColumns; column++)
+    {
+      // Regularly spaced values, such as times, take less space as
+      // deltas of deltas, and step functions as XORs
+      const double *values = &dataset.rows[column];
+      m_xorColumn.clear ();
+      PutColumn (m_xorColumn, values, nRows, dataset.nColumns, XOR_PREVIOUS);
+      m_deltaColumn.clear ();
+      PutColumn (m_deltaColumn, values, nRows, dataset.nColumns, DELTA_OF_DELTA);
+      const std::string &encoded = m_xorColumn.size () <= m_deltaColumn.size () ? m_xorColumn : m_deltaColumn;
+      PutUint (m_buffer, encoded.size (), 4);
+      m_buffer += encoded;
+    }
+  m_file.write (m_buffer.data (), m_buffer.size ());
+  dataset.rows.clear ();
+}
+
+void
+BinaryAggregator::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<std::string, Dataset>::iterator i = m_datasets.begin (); i != m_datasets.end (); i++)
+    {
+      if (!i->second.rows.empty ())
+        {
+          WriteBlock (i->second);
+        }
+    }
+  m_file.flush ();
+}
+
+
+BinaryAggregatorReader::BinaryAggregatorReader (const std::string &inputFileName)
+{
+  NS_LOG_FUNCTION (this << inputFileName);
+
+  m_file.open (inputFileName.c_str (), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Cannot open " << inputFileName);
+  char magic[sizeof (g_magic)];
+  m_file.read (magic, sizeof (magic));
+  NS_ABORT_MSG_UNLESS (m_file && std::memcmp (magic, g_magic, sizeof (g_magic) - 1) == 0,
+                       inputFileName << " was not written by a BinaryAggregator");
+  NS_ABORT_MSG_UNLESS (static_cast<uint8_t> (magic[sizeof (g_magic) - 1]) == g_version,
+                       inputFileName << " has an unknown format version");
+}
+
+bool
+BinaryAggregatorReader::ReadBlock (std::string &context, std::vector<std::vector<double> > &columns)
+{
+  NS_LOG_FUNCTION (this);
+
+  int type;
+  while ((type = m_file.get ()) == 'D')
+    {
+      uint64_t index, nColumns, size;
+      NS_ABORT_MSG_UNLESS (GetUint (m_file, 4, index) && GetUint (m_file, 1, nColumns)
+                           && GetUint (m_file, 2, size), "Truncated dataset record");
+      NS_ABORT_MSG_UNLESS (index == m_contexts.size (), "Unexpected dataset index " << index);
+      std::string name (size, '\0');
+      m_file.read (&name[0], size);
+      NS_ABORT_MSG_UNLESS (m_file, "Truncated dataset context");
+      m_contexts.push_back (name);
+      m_nColumns.push_back (nColumns);
+    }
+  if (type == EOF)
+    {
+      return false;
+    }
+  NS_ABORT_MSG_UNLESS (type == 'B', "Unknown record type " << type);
+
+  uint64_t index, nRows;
+  NS_ABORT_MSG_UNLESS (GetUint (m_file, 4, index) && GetUint (m_file, 4, nRows), "Truncated block");
+  NS_ABORT_MSG_UNLESS (index < m_contexts.size (), "Block of unknown dataset " << index);
+  context = m_contexts[index];
+  columns.assign (m_nColumns[index], std::vector<double> ());
+  for (uint32_t column = 0; column < columns.size (); column++)
+    {
+      uint64_t size;
+      NS_ABORT_MSG_UNLESS (GetUint (m_file, 4, size), "Truncated block");
+      m_buffer.resize (size);
+      m_file.read (&m_buffer[0], size);
+      NS_ABORT_MSG_UNLESS (m_file, "Truncated block");
+
+      NS_ABORT_MSG_UNLESS (size > 0, "Truncated column");
+      uint8_t encoding = m_buffer[0];
+      NS_ABORT_MSG_UNLESS (encoding == XOR_PREVIOUS || encoding == DELTA_OF_DELTA,
+                           "Unknown column encoding " << (uint32_t) encoding);
+      std::vector<double> &values = columns[column];
+      values.reserve (nRows);
+      uint64_t previous = 0;
+      uint64_t delta = 0;
+      size_t pos = 1;
+      for (uint32_t row = 0; row < nRows; row++)
+        {
+          NS_ABORT_MSG_UNLESS (pos < size, "Truncated column");
+          uint8_t control = m_buffer[pos++];
+          uint32_t leading = control >> 4;
+          uint32_t trailing = control & 0xf;
+          NS_ABORT_MSG_UNLESS (leading + trailing <= 8 && pos + 8 - leading - trailing <= size,
+                               "Corrupted column");
+          uint64_t x = 0;
+          for (int byte = 7 - leading; byte >= static_cast<int> (trailing); byte--)
+            {
+              x |= static_cast<uint64_t> (static_cast<uint8_t> (m_buffer[pos++])) << (8 * byte);
+            }
+          uint64_t bits;
+          if (encoding == XOR_PREVIOUS)
+            {
+              bits = previous ^ x;
+            }
+          else
+            {
+              bits = previous + delta + ((x >> 1) ^ (0 - (x & 1)));
+              delta = bits - previous;
+            }
+          previous = bits;
+          values.push_back (BitsToDouble (bits));
+        }
+      NS_ABORT_MSG_UNLESS (pos == size, "Corrupted column");
+    }
+  return true;
+}
+
+} // namespace ns3
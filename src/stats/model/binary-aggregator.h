@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef BINARY_AGGREGATOR_H
+#define BINARY_AGGREGATOR_H
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/data-collection-object.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ *
+ * This aggregator writes the values it receives to a binary file,
+ * column by column, so that probes sampled at a high rate cost little
+ * more than a memory copy.
+ *
+ * Each dataset context has a fixed number of double columns.  The
+ * values of a dataset are buffered until BlockSize rows are collected,
+ * then each column of the block is compressed, by XORing the bits of
+ * every value with those of the previous value, or by subtracting from
+ * them the bits extrapolated from the two previous values, whichever
+ * is smaller, and writing only the bytes which are not zero.  The
+ * blocks of the different datasets are interleaved in the file, and
+ * are read back with BinaryAggregatorReader or with the
+ * read-binary-aggregator program in utils/.
+ *
+ * File format, all integers little endian:
+ *
+ * - the magic string "ns3binag" followed by the format version byte;
+ * - dataset records: 'D', dataset index (uint32), number of columns
+ *   (uint8), context length (uint16), context;
+ * - block records: 'B', dataset index (uint32), number of rows
+ *   (uint32), then for each column the size (uint32) and the bytes of
+ *   the compressed column: the encoding (0 for XOR, 1 for delta of
+ *   delta), then for each value the residual, i.e. the XOR, or the
+ *   difference with 2 * previous - before previous in zigzag encoding,
+ *   of the bits of the value as a uint64.  A residual takes one control
+ *   byte, whose high nibble is the number of leading zero bytes and low
+ *   nibble the number of trailing zero bytes of the residual, followed
+ *   by the remaining bytes, most significant first.  The values before
+ *   the first row of a block are 0.
+ */
+class BinaryAggregator : public DataCollectionObject
+{
+public:
+  static TypeId GetTypeId ();
+
+  /**
+   * \param outputFileName name of the file to write.
+   *
+   * Constructs a binary aggregator that will create a file named
+   * outputFileName.
+   */
+  BinaryAggregator (const std::string &outputFileName);
+
+  virtual ~BinaryAggregator ();
+
+  // Below are hooked to connectors exporting data
+  // They are not overloaded since it confuses the compiler when made
+  // into callbacks
+
+  /**
+   * \param context specifies the 1D dataset these values came from.
+   * \param v1 value for the new data point.
+   *
+   * \brief Writes 1 value to the file.
+   */
+  void Write1d (std::string context,
+                double v1);
+
+  /**
+   * \param context specifies the 2D dataset these values came from.
+   * \param v1 first value for the new data point.
+   * \param v2 second value for the new data point.
+   *
+   * \brief Writes 2 values to the file, e.g. the output of a
+   * TimeSeriesAdaptor.
+   */
+  void Write2d (std::string context,
+                double v1,
+                double v2);
+
+  /**
+   * \param context specifies the 3D dataset these values came from.
+   * \param v1 first value for the new data point.
+   * \param v2 second value for the new data point.
+   * \param v3 third value for the new data point.
+   *
+   * \brief Writes 3 values to the file.
+   */
+  void Write3d (std::string context,
+                double v1,
+                double v2,
+                double v3);
+
+  /**
+   * \brief Writes the rows buffered by all the datasets to the file.
+   *
+   * This is done when the aggregator is destroyed.
+   */
+  void Flush (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// The rows of a dataset not yet written
+  struct Dataset
+  {
+    uint32_t index; //!< the index of the dataset in the file
+    uint8_t nColumns; //!< the number of values of each row
+    std::vector<double> rows; //!< the values buffered, row by row
+  };
+
+  /**
+   * \brief Buffers a row of a dataset, and writes the dataset block
+   * when it is full.
+   * \param context the dataset context
+   * \param values the values of the row
+   * \param n the number of values
+   */
+  void Write (const std::string &context, const double *values, uint8_t n);
+
+  /**
+   * \brief Writes the buffered rows of a dataset as a block.
+   * \param dataset the dataset
+   */
+  void WriteBlock (Dataset &dataset);
+
+  std::string m_outputFileName; //!< the file name
+  std::ofstream m_file; //!< the file written
+  uint32_t m_blockSize; //!< the number of rows of a block
+  std::map<std::string, Dataset> m_datasets; //!< context --> dataset
+  std::string m_buffer; //!< the record being encoded
+  std::string m_xorColumn; //!< a column encoded as XORs
+  std::string m_deltaColumn; //!< a column encoded as deltas of deltas
+};
+
+/**
+ * \ingroup stats
+ *
+ * Reads back, block by block, the datasets written by a
+ * BinaryAggregator.
+ */
+class BinaryAggregatorReader
+{
+public:
+  /**
+   * \param inputFileName the file written by a BinaryAggregator.
+   */
+  BinaryAggregatorReader (const std::string &inputFileName);
+
+  /**
+   * \param context the context of the dataset of the block read.
+   * \param columns the values of the block read, column by column.
+   * \returns false at the end of the file.
+   *
+   * \brief Reads the next block of the file.
+   */
+  bool ReadBlock (std::string &context, std::vector<std::vector<double> > &columns);
+
+private:
+  std::ifstream m_file; //!< the file read
+  std::vector<std::string> m_contexts; //!< dataset index --> context
+  std::vector<uint8_t> m_nColumns; //!< dataset index --> number of columns
+  std::string m_buffer; //!< the column being decoded
+};
+
+} // namespace ns3
+
+#endif // BINARY_AGGREGATOR_H
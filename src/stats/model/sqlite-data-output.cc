@@ -96,6 +96,40 @@ SqliteDataOutput::Exec (std::string exe) {
   // end SqliteDataOutput::Exec
 }
 
+sqlite3_stmt *
+SqliteDataOutput::Prepare (std::string sql)
+{
+  sqlite3_stmt *stmt = 0;
+
+  NS_LOG_INFO ("preparing '" << sql << "'");
+
+  if (sqlite3_prepare_v2 (m_db, sql.c_str (), -1, &stmt, 0) != SQLITE_OK) {
+      NS_LOG_ERROR ("sqlite3 error: \"" << sqlite3_errmsg (m_db) << "\"");
+      sqlite3_finalize (stmt);
+      return 0;
+    }
+  return stmt;
+
+  // end SqliteDataOutput::Prepare
+}
+
+int
+SqliteDataOutput::Step (sqlite3_stmt *stmt)
+{
+  if (stmt == 0) {
+      return SQLITE_MISUSE;
+    }
+
+  int res = sqlite3_step (stmt);
+  if (res != SQLITE_DONE) {
+      NS_LOG_ERROR ("sqlite3 error: \"" << sqlite3_errmsg (m_db) << "\"");
+    }
+  sqlite3_reset (stmt);
+  return res;
+
+  // end SqliteDataOutput::Step
+}
+
 //----------------------------------------------
 void
 SqliteDataOutput::Output (DataCollector &dc)
@@ -112,31 +146,45 @@ SqliteDataOutput::Output (DataCollector &dc)
 
   std::string run = dc.GetRunLabel ();
 
+  // Without a write-ahead log, each transaction writes the database
+  // twice; without an explicit transaction, each insertion is one
+  Exec ("PRAGMA journal_mode=WAL");
+  Exec ("BEGIN");
+
   Exec ("create table if not exists Experiments (run, experiment, strategy, input, description text)");
-  Exec ("insert into Experiments (run,experiment,strategy,input,description) values ('" +
-        run + "', '" +
-        dc.GetExperimentLabel () + "', '" +
-        dc.GetStrategyLabel () + "', '" +
-        dc.GetInputLabel () + "', '" +
-        dc.GetDescription () + "')");
+  sqlite3_stmt *stmt = Prepare ("insert into Experiments (run,experiment,strategy,input,description) values (?, ?, ?, ?, ?)");
+  if (stmt != 0) {
+      std::string labels[] = { run, dc.GetExperimentLabel (), dc.GetStrategyLabel (),
+                               dc.GetInputLabel (), dc.GetDescription () };
+      for (int i = 0; i < 5; i++) {
+          sqlite3_bind_text (stmt, i + 1, labels[i].c_str (), -1, SQLITE_TRANSIENT);
+        }
+      Step (stmt);
+      sqlite3_finalize (stmt);
+    }
 
   Exec ("create table if not exists Metadata ( run text, key text, value)");
 
-  for (MetadataList::iterator i = dc.MetadataBegin ();
-       i != dc.MetadataEnd (); i++) {
-      std::pair<std::string, std::string> blob = (*i);
-      Exec ("insert into Metadata (run,key,value) values ('" +
-            run + "', '" +
-            blob.first + "', '" +
-            blob.second + "')");
+  stmt = Prepare ("insert into Metadata (run,key,value) values (?, ?, ?)");
+  if (stmt != 0) {
+      sqlite3_bind_text (stmt, 1, run.c_str (), -1, SQLITE_TRANSIENT);
+      for (MetadataList::iterator i = dc.MetadataBegin ();
+           i != dc.MetadataEnd (); i++) {
+          std::pair<std::string, std::string> blob = (*i);
+          sqlite3_bind_text (stmt, 2, blob.first.c_str (), -1, SQLITE_TRANSIENT);
+          sqlite3_bind_text (stmt, 3, blob.second.c_str (), -1, SQLITE_TRANSIENT);
+          Step (stmt);
+        }
+      sqlite3_finalize (stmt);
     }
 
-  Exec ("BEGIN");
-  SqliteOutputCallback callback (this, run);
-  for (DataCalculatorList::iterator i = dc.DataCalculatorBegin ();
-       i != dc.DataCalculatorEnd (); i++) {
-      (*i)->Output (callback);
-    }
+  {
+    SqliteOutputCallback callback (this, run);
+    for (DataCalculatorList::iterator i = dc.DataCalculatorBegin ();
+         i != dc.DataCalculatorEnd (); i++) {
+        (*i)->Output (callback);
+      }
+  }
   Exec ("COMMIT");
 
   sqlite3_close (m_db);
@@ -151,10 +199,34 @@ SqliteDataOutput::SqliteOutputCallback::SqliteOutputCallback
 {
 
   m_owner->Exec ("create table if not exists Singletons ( run text, name text, variable text, value )");
+  m_insert = m_owner->Prepare ("insert into Singletons (run,name,variable,value) values (?, ?, ?, ?)");
+  if (m_insert != 0) {
+      sqlite3_bind_text (m_insert, 1, m_runLabel.c_str (), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text (m_insert, 2, m_boundKey.c_str (), -1, SQLITE_TRANSIENT);
+    }
 
   // end SqliteDataOutput::SqliteOutputCallback::SqliteOutputCallback
 }
 
+SqliteDataOutput::SqliteOutputCallback::~SqliteOutputCallback ()
+{
+  sqlite3_finalize (m_insert);
+}
+
+void
+SqliteDataOutput::SqliteOutputCallback::Bind (const std::string &key,
+                                              const std::string &variable)
+{
+  if (m_insert == 0) {
+      return;
+    }
+  if (key != m_boundKey) {
+      m_boundKey = key;
+      sqlite3_bind_text (m_insert, 2, key.c_str (), -1, SQLITE_TRANSIENT);
+    }
+  sqlite3_bind_text (m_insert, 3, variable.c_str (), -1, SQLITE_TRANSIENT);
+}
+
 void
 SqliteDataOutput::SqliteOutputCallback::OutputStatistic (std::string key,
                                                          std::string variable,
@@ -179,15 +251,9 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
                                                          std::string variable,
                                                          int val)
 {
-
-  std::stringstream sstr;
-  sstr << "insert into Singletons (run,name,variable,value) values ('" <<
-  m_runLabel << "', '" <<
-  key << "', '" <<
-  variable << "', " <<
-  val << ")";
-  m_owner->Exec (sstr.str ());
-
+  Bind (key, variable);
+  sqlite3_bind_int (m_insert, 4, val);
+  m_owner->Step (m_insert);
   // end SqliteDataOutput::SqliteOutputCallback::OutputSingleton
 }
 void
@@ -195,13 +261,9 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
                                                          std::string variable,
                                                          uint32_t val)
 {
-  std::stringstream sstr;
-  sstr << "insert into Singletons (run,name,variable,value) values ('" <<
-  m_runLabel << "', '" <<
-  key << "', '" <<
-  variable << "', " <<
-  val << ")";
-  m_owner->Exec (sstr.str ());
+  Bind (key, variable);
+  sqlite3_bind_int64 (m_insert, 4, val);
+  m_owner->Step (m_insert);
   // end SqliteDataOutput::SqliteOutputCallback::OutputSingleton
 }
 void
@@ -209,13 +271,9 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
                                                          std::string variable,
                                                          double val)
 {
-  std::stringstream sstr;
-  sstr << "insert into Singletons (run,name,variable,value) values ('" <<
-  m_runLabel << "', '" <<
-  key << "', '" <<
-  variable << "', " <<
-  val << ")";
-  m_owner->Exec (sstr.str ());
+  Bind (key, variable);
+  sqlite3_bind_double (m_insert, 4, val);
+  m_owner->Step (m_insert);
   // end SqliteDataOutput::SqliteOutputCallback::OutputSingleton
 }
 void
@@ -223,13 +281,9 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
                                                          std::string variable,
                                                          std::string val)
 {
-  std::stringstream sstr;
-  sstr << "insert into Singletons (run,name,variable,value) values ('" <<
-  m_runLabel << "', '" <<
-  key << "', '" <<
-  variable << "', '" <<
-  val << "')";
-  m_owner->Exec (sstr.str ());
+  Bind (key, variable);
+  sqlite3_bind_text (m_insert, 4, val.c_str (), -1, SQLITE_TRANSIENT);
+  m_owner->Step (m_insert);
   // end SqliteDataOutput::SqliteOutputCallback::OutputSingleton
 }
 void
@@ -237,12 +291,8 @@ SqliteDataOutput::SqliteOutputCallback::OutputSingleton (std::string key,
                                                          std::string variable,
                                                          Time val)
 {
-  std::stringstream sstr;
-  sstr << "insert into Singletons (run,name,variable,value) values ('" <<
-  m_runLabel << "', '" <<
-  key << "', '" <<
-  variable << "', " <<
-  val.GetTimeStep () << ")";
-  m_owner->Exec (sstr.str ());
+  Bind (key, variable);
+  sqlite3_bind_int64 (m_insert, 4, val.GetTimeStep ());
+  m_owner->Step (m_insert);
   // end SqliteDataOutput::SqliteOutputCallback::OutputSingleton
 }
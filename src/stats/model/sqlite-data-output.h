@@ -28,6 +28,7 @@
 #define STATS_HAS_SQLITE3
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace ns3 {
 
@@ -37,6 +38,9 @@ namespace ns3 {
  * \ingroup stats
  * \class SqliteDataOutput
  * \brief Outputs data in a format compatible with SQLite
+ *
+ * All the data of a DataCollector are written in a single transaction,
+ * with prepared statements, to a database in write-ahead log mode.
  */
 class SqliteDataOutput : public DataOutputInterface {
 public:
@@ -77,9 +81,22 @@ public:
                           std::string variable,
                           Time val);
 
+    ~SqliteOutputCallback();
+
 private:
+    /**
+     * Binds the key and the variable of the next row of the Singletons
+     * table, the key only if it changed since the previous row, as the
+     * values of a DataCalculator share their key
+     * \param key Key value of a DataCalculator
+     * \param variable Name of the variable
+     */
+    void Bind (const std::string &key, const std::string &variable);
+
     Ptr<SqliteDataOutput> m_owner;
     std::string m_runLabel;
+    sqlite3_stmt *m_insert; //!< the insertion in the Singletons table
+    std::string m_boundKey; //!< the key bound to m_insert
 
     // end class SqliteOutputCallback
   };
@@ -87,6 +104,19 @@ private:
 
   sqlite3 *m_db;
   int Exec (std::string exe);
+  /**
+   * Prepares a statement
+   * \param sql the statement
+   * \returns the statement prepared, or 0 on error
+   */
+  sqlite3_stmt *Prepare (std::string sql);
+  /**
+   * Executes a prepared statement, then resets it so that it can be
+   * executed again with new values
+   * \param stmt the statement
+   * \returns the sqlite3 result code
+   */
+  int Step (sqlite3_stmt *stmt);
 
   // end class SqliteDataOutput
 };
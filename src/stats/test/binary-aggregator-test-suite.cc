@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/binary-aggregator.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+/**
+ * Write datasets spanning several blocks with a BinaryAggregator, and
+ * check that BinaryAggregatorReader reads back the same values, bit
+ * for bit
+ */
+class BinaryAggregatorTestCase : public TestCase
+{
+public:
+  BinaryAggregatorTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+BinaryAggregatorTestCase::BinaryAggregatorTestCase ()
+  : TestCase ("Round trip of the BinaryAggregator datasets")
+{
+}
+
+void
+BinaryAggregatorTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("binary-aggregator.bin");
+  std::map<std::string, std::vector<std::vector<double> > > written;
+  written["time-series"].resize (2);
+  written["special"].resize (1);
+  written["disabled"].resize (3);
+
+  Ptr<BinaryAggregator> aggregator = CreateObject<BinaryAggregator> (fileName);
+  aggregator->SetAttribute ("BlockSize", UintegerValue (100));
+  for (uint32_t i = 0; i < 1050; i++)
+    {
+      double time = i * 0.001;
+      double value = (i / 10) * 1.5;
+      aggregator->Write2d ("time-series", time, value);
+      written["time-series"][0].push_back (time);
+      written["time-series"][1].push_back (value);
+    }
+  double special[] = {0.0, -0.0, 1.0, std::numeric_limits<double>::infinity (),
+                      -std::numeric_limits<double>::max (), std::numeric_limits<double>::denorm_min (),
+                      std::numeric_limits<double>::quiet_NaN (), 1.0, 1.0};
+  for (uint32_t i = 0; i < sizeof (special) / sizeof (special[0]); i++)
+    {
+      aggregator->Write1d ("special", special[i]);
+      written["special"][0].push_back (special[i]);
+    }
+  aggregator->Disable ();
+  aggregator->Write3d ("disabled", 1, 2, 3);
+  aggregator->Dispose ();
+  aggregator = 0;
+
+  std::map<std::string, std::vector<std::vector<double> > > read;
+  std::map<std::string, uint32_t> blocks;
+  BinaryAggregatorReader reader (fileName);
+  std::string context;
+  std::vector<std::vector<double> > columns;
+  while (reader.ReadBlock (context, columns))
+    {
+      NS_TEST_ASSERT_MSG_EQ (written.count (context), 1, "Unknown dataset " << context);
+      NS_TEST_ASSERT_MSG_EQ (columns.size (), written[context].size (), "Wrong number of columns of " << context);
+      read[context].resize (columns.size ());
+      for (uint32_t column = 0; column < columns.size (); column++)
+        {
+          read[context][column].insert (read[context][column].end (), columns[column].begin (), columns[column].end ());
+        }
+      blocks[context]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (blocks["time-series"], 11, "Wrong number of blocks");
+  NS_TEST_EXPECT_MSG_EQ (blocks["special"], 1, "Wrong number of blocks");
+  NS_TEST_EXPECT_MSG_EQ (read.count ("disabled"), 0, "Values written while disabled");
+
+  const char *contexts[] = {"time-series", "special"};
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      std::vector<std::vector<double> > &expected = written[contexts[i]];
+      std::vector<std::vector<double> > &actual = read[contexts[i]];
+      for (uint32_t column = 0; column < expected.size (); column++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (actual[column].size (), expected[column].size (), "Wrong number of rows of " << contexts[i]);
+          NS_TEST_EXPECT_MSG_EQ (std::memcmp (&actual[column][0], &expected[column][0],
+                                              expected[column].size () * sizeof (double)), 0,
+                                 "Wrong values in column " << column << " of " << contexts[i]);
+        }
+    }
+
+  // The time series take much less than the 16 bytes of their rows
+  std::ifstream file (fileName.c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_EXPECT_MSG_LT (file.tellg (), 1050 * 16 / 2, "The time series are not compressed");
+}
+
+/**
+ * BinaryAggregator test suite
+ */
+class BinaryAggregatorTestSuite : public TestSuite
+{
+public:
+  BinaryAggregatorTestSuite ();
+};
+
+BinaryAggregatorTestSuite::BinaryAggregatorTestSuite ()
+  : TestSuite ("binary-aggregator", UNIT)
+{
+  AddTestCase (new BinaryAggregatorTestCase, QUICK);
+}
+
+static BinaryAggregatorTestSuite g_binaryAggregatorTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <cstdio>
+#include <sqlite3.h>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/data-collector.h"
+#include "ns3/basic-data-calculators.h"
+#include "ns3/time-data-calculators.h"
+#include "ns3/sqlite-data-output.h"
+
+namespace ns3 {
+
+/**
+ * Check the tables written by SqliteDataOutput for two runs
+ */
+class SqliteDataOutputTestCase : public TestCase
+{
+public:
+  SqliteDataOutputTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * \param sql a query returning one value
+   * \returns the value, as text
+   */
+  std::string Query (std::string sql);
+  sqlite3 *m_db;
+};
+
+SqliteDataOutputTestCase::SqliteDataOutputTestCase ()
+  : TestCase ("Tables written by SqliteDataOutput")
+{
+}
+
+std::string
+SqliteDataOutputTestCase::Query (std::string sql)
+{
+  sqlite3_stmt *stmt;
+  std::string value;
+  if (sqlite3_prepare_v2 (m_db, sql.c_str (), -1, &stmt, 0) == SQLITE_OK
+      && sqlite3_step (stmt) == SQLITE_ROW)
+    {
+      const unsigned char *text = sqlite3_column_text (stmt, 0);
+      value = text ? reinterpret_cast<const char *> (text) : "NULL";
+    }
+  sqlite3_finalize (stmt);
+  return value;
+}
+
+void
+SqliteDataOutputTestCase::DoRun (void)
+{
+  std::string prefix = CreateTempDirFilename ("sqlite-data-output");
+  std::remove ((prefix + ".db").c_str ());
+
+  for (uint32_t run = 0; run < 2; run++)
+    {
+      DataCollector data;
+      data.DescribeRun ("experiment", "strategy", "input", run ? "run-1" : "run-0", "the experimenter's run");
+      data.AddMetadata ("author", "somebody");
+      data.AddMetadata ("seed", 7u);
+
+      Ptr<MinMaxAvgTotalCalculator<double> > delay = CreateObject<MinMaxAvgTotalCalculator<double> > ();
+      delay->SetKey ("delay");
+      delay->SetContext ("node[0]");
+      delay->Update (1.5);
+      delay->Update (2.5);
+      data.AddDataCalculator (delay);
+
+      Ptr<CounterCalculator<> > packets = CreateObject<CounterCalculator<> > ();
+      packets->SetKey ("packets");
+      packets->SetContext ("node[0]");
+      packets->Update (3);
+      data.AddDataCalculator (packets);
+
+      Ptr<TimeMinMaxAvgTotalCalculator> time = CreateObject<TimeMinMaxAvgTotalCalculator> ();
+      time->SetKey ("time");
+      time->SetContext ("node[1]");
+      time->Update (NanoSeconds (10));
+      time->Update (NanoSeconds (30));
+      data.AddDataCalculator (time);
+
+      Ptr<SqliteDataOutput> output = CreateObject<SqliteDataOutput> ();
+      output->SetFilePrefix (prefix);
+      output->Output (data);
+      output->Dispose ();
+      data.Dispose ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (sqlite3_open ((prefix + ".db").c_str (), &m_db), SQLITE_OK, "Cannot open the database");
+  NS_TEST_EXPECT_MSG_EQ (Query ("PRAGMA journal_mode"), "wal", "The database is not in WAL mode");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select count(*) from Experiments"), "2", "Wrong number of experiments");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select description from Experiments where run = 'run-1'"),
+                         "the experimenter's run", "Wrong description");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select count(*) from Metadata"), "4", "Wrong number of metadata");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select value from Metadata where run = 'run-0' and key = 'author'"),
+                         "somebody", "Wrong metadata");
+  // 6 values of the statistic, 1 of the counter, 5 of the times, per run
+  NS_TEST_EXPECT_MSG_EQ (Query ("select count(*) from Singletons"), "24", "Wrong number of singletons");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select value from Singletons where run = 'run-1' and name = 'node[0]' "
+                                "and variable = 'delay-total'"), "4.0", "Wrong total of the statistic");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select count(*) from Singletons where run = 'run-0' and name = 'node[0]' "
+                                "and variable like 'delay-%'"), "6", "Wrong values of the statistic");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select value from Singletons where run = 'run-0' and name = 'node[0]' "
+                                "and variable = 'packets'"), "3", "Wrong counter");
+  NS_TEST_EXPECT_MSG_EQ (Query ("select value from Singletons where run = 'run-0' and name = 'node[1]' "
+                                "and variable = 'time-total'"), "40", "Wrong total time");
+  sqlite3_close (m_db);
+}
+
+/**
+ * SqliteDataOutput test suite
+ */
+class SqliteDataOutputTestSuite : public TestSuite
+{
+public:
+  SqliteDataOutputTestSuite ();
+};
+
+SqliteDataOutputTestSuite::SqliteDataOutputTestSuite ()
+  : TestSuite ("sqlite-data-output", UNIT)
+{
+  AddTestCase (new SqliteDataOutputTestCase, QUICK);
+}
+
+static SqliteDataOutputTestSuite g_sqliteDataOutputTestSuite;
+
+} // namespace ns3
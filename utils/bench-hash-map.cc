@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Lookup-heavy benchmark of the containers used by the ARP and
+// neighbor caches and by the bridge learning table: std::map, the
+// deprecated sgi::hash_map and ns3::HashMap.
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/hash-map.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/mac48-address.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+/**
+ * Insert the keys, then look up n keys, one in two of them missing.
+ *
+ * \param map the container
+ * \param keys the keys inserted, then looked up
+ * \param n the number of lookups
+ * \returns the number of keys found, so that the lookups are not
+ * optimized away
+ */
+template <typename Map, typename Key>
+static uint32_t
+Bench (Map &map, const std::vector<Key> &keys, uint32_t n)
+{
+  for (uint32_t i = 0; i < keys.size (); i += 2)
+    {
+      map[keys[i]] = i;
+    }
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      found += map.find (keys[i % keys.size ()]) != map.end ();
+    }
+  return found;
+}
+
+template <typename Map, typename Key>
+static void
+RunBench (const std::vector<Key> &keys, uint32_t n, char const *name)
+{
+  Map map;
+  SystemWallClockMs time;
+  time.Start ();
+  uint32_t found = Bench (map, keys, n);
+  uint64_t deltaMs = time.End ();
+  double ls = n;
+  ls *= 1000;
+  ls /= deltaMs ? deltaMs : 1;
+  std::cout << ls << " lookups/s"
+            << " (" << deltaMs << " ms elapsed, " << found << " found)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t keys = 1000;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--n="));
+          iss >> n;
+        }
+      if (strncmp ("--keys=", argv[0],strlen ("--keys=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--keys="));
+          iss >> keys;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0 || keys == 0)
+    {
+      std::cerr << "Error-- number of lookups must be specified " <<
+        "by command-line argument --n=(number of lookups)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-hash-map with n=" << n << " keys=" << keys << std::endl;
+
+  std::vector<Ipv4Address> ipv4;
+  std::vector<Mac48Address> mac;
+  for (uint32_t i = 0; i < keys; i++)
+    {
+      ipv4.push_back (Ipv4Address (0x0a000000 + i * 7));
+      mac.push_back (Mac48Address::Allocate ());
+    }
+
+  RunBench<std::map<Ipv4Address, uint32_t> > (ipv4, n, "Ipv4Address std::map");
+  RunBench<sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> > (ipv4, n, "Ipv4Address sgi::hash_map");
+  RunBench<HashMap<Ipv4Address, uint32_t, Ipv4AddressHash> > (ipv4, n, "Ipv4Address ns3::HashMap");
+  RunBench<std::map<Mac48Address, uint32_t> > (mac, n, "Mac48Address std::map");
+  RunBench<HashMap<Mac48Address, uint32_t, Mac48AddressHash> > (mac, n, "Mac48Address ns3::HashMap");
+
+  return 0;
+}
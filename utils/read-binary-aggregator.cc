@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+// Print the datasets written by a BinaryAggregator as text, one row
+// per line, like a space separated FileAggregator would have written
+// them.
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/binary-aggregator.h"
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string fileName = "";
+  std::string context = "";
+  std::string separator = " ";
+  bool list = false;
+  uint32_t precision = 6;
+
+  CommandLine cmd;
+  cmd.Usage ("Print the file written by a BinaryAggregator as text.\n"
+             "\n"
+             "Without --context, each line starts with the context of its dataset.");
+  cmd.AddValue ("file",      "file written by a BinaryAggregator",            fileName);
+  cmd.AddValue ("context",   "print only the dataset with this context",     context);
+  cmd.AddValue ("separator", "separator of the values (default a space)",    separator);
+  cmd.AddValue ("precision", "printed output precision (default 6)",         precision);
+  cmd.AddValue ("list",      "list the datasets and their number of rows",   list);
+  cmd.Parse (argc, argv);
+
+  if (fileName == "")
+    {
+      std::cerr << "Error-- the file must be specified by --file=<file name>" << std::endl;
+      return 1;
+    }
+
+  BinaryAggregatorReader reader (fileName);
+  std::cout << std::setprecision (precision);
+  std::string blockContext;
+  std::vector<std::vector<double> > columns;
+  std::vector<std::string> contexts;
+  std::map<std::string, std::pair<uint32_t, uint64_t> > datasets;
+  while (reader.ReadBlock (blockContext, columns))
+    {
+      if (list)
+        {
+          if (datasets.count (blockContext) == 0)
+            {
+              contexts.push_back (blockContext);
+              datasets[blockContext].first = columns.size ();
+            }
+          datasets[blockContext].second += columns.empty () ? 0 : columns[0].size ();
+          continue;
+        }
+      if (context != "" && blockContext != context)
+        {
+          continue;
+        }
+      uint32_t nRows = columns.empty () ? 0 : columns[0].size ();
+      for (uint32_t row = 0; row < nRows; row++)
+        {
+          if (context == "")
+            {
+              std::cout << blockContext << separator;
+            }
+          for (uint32_t column = 0; column < columns.size (); column++)
+            {
+              if (column > 0)
+                {
+                  std::cout << separator;
+                }
+              std::cout << columns[column][row];
+            }
+          std::cout << '\n';
+        }
+    }
+  for (std::vector<std::string>::const_iterator i = contexts.begin (); i != contexts.end (); i++)
+    {
+      std::cout << *i << ": " << datasets[*i].first << " columns, "
+                << datasets[*i].second << " rows" << std::endl;
+    }
+  return 0;
+}